@@ -1,6 +1,48 @@
 /**
  * @page history History/Changelog
  *
+ * <B>0.7 Alpha (in development)</B>
+ * - Added lazy loading option to ResFile so objects are only relocated when they are first used
+ * - Added hashed name index to ResFile and optional name index to ResEditor to speed up finding objects by name
+ * - Added component ID indices to ResWindow and ResMenu so finding gadgets, shortcuts and menu items does not walk every component
+ * - Fixed ResObject component erase and replace corrupting the object when the component size changed
+ * - Added batch editing to ResObject (begin_batch_edit/end_batch_edit and ResBatchEdit) so many text changes rebuild the string and message tables once
+ * - Added ResValidator class to check the structure of resource files and resvalidate test program to check many files at once on multiple threads.
+ * - Added compact binary format for TagDoc. It is detected automatically by the stream operator on reading. TagDoc::is_binary checks the whole header and version and read_binary rejects tags nested deeper than TagDoc::MAX_BINARY_DEPTH.
+ * - Fixed TagDoc::write_tag not moving on to the next attribute.
+ * - Added TagDoc storage options to allocate tags from an arena and index the children of tags with many children and the attributes of tags with many attributes.
+ * - TagDoc now deletes its tags when it is deleted and Tag::delete_child deletes the children of the tag.
+ * - Added TagReader class to read a tag file calling a TagReadHandler for each part instead of building a TagDoc.
+ * - Fixed reading a TagDoc losing text before a child tag, text after a child tag with an end tag and an attribute with no value that is followed by another attribute.
+ * - TagDoc::write_tag no longer adds the indent to the text of a tag with no children.
+ * - Fixed reading of tags without attributes closed with /&gt; and text being cleared by a following child tag.
+ * - ReportView now keeps the width of every cell when auto sizing so removing or changing rows no longer measures the whole report. The widths are kept in a balanced tree so inserting or removing rows does not move the widths after them.
+ * - Added variable_row_height option to ListView and ReportView to allow rows of different heights.
+ * - MultiSelection keeps its ranges in a balanced tree of gaps and lengths so finding a range, inserting or removing items and range operations only touch the ranges they affect. Added Selection::Cursor and selected_run for fast selection checks in redraw loops.
+ * - Added SelectionChangesListener to get all the changes from one selection action in a single sorted and merged event. ItemView uses it to redraw each block of changed items once.
+ * - Timers are now held in a binary heap. Added Application::add_one_shot_timer and a TimerHandle returned when adding a timer that can be used to remove it quickly. Fixed the monotonic time comparison functions which gave the wrong results.
+ * - Toolbox event listeners are now found with a hash table on the object id and event so dispatching events is quicker when an application has a lot of objects.
+ * - Added PollStats and Application::set_poll_stats to record how long each Wimp_Poll reason code, toolbox event and WIMP message takes to process.
+ * - Added a host build (Makefile.host) with a pluggable SWI backend and a Wimp/Toolbox simulator (tbx/host) so TBX code can be run and tested without RISC OS.
+ * - Added BackgroundJob and Application::add_background_job to run long tasks a step at a time on null events within a time budget, with priorities and progress reporting suitable for Hourglass::percentage. A job whose step throws is moved behind the other jobs of the same priority before the exception is passed on.
+ * - Added DeferredRedraw to collect and merge areas of a window to redraw and ask the WIMP to redraw them once before the next Wimp_Poll. ListView, ReportView, TileView and TextView now use it instead of calling Window::force_redraw for every change.
+ * - ListView and ReportView now move existing rows and columns with a window block copy when items or columns are inserted, removed or resized and only redraw the area uncovered (see BlockShift and DeferredRedraw::shift).
+ * - Added ItemRenderer::render_range so renderers can draw all the visible items of a view in one call. The WimpFont renderer only sets the font colours when the selection state changes, the sprite renderer only reads the scale factors and colour table when the sprite changes and the icon renderer sets up its icon painters once for the range. They still call render for each item.
+ * - DrawFile now finds and indexes the objects in the file when it is loaded. When render is given a clip box, only the objects that intersect it are passed to the DrawFile module. Added DrawFile::load from memory, object_count, object and objects_in.
+ * - Added DrawRasteriser to fill and stroke a DrawPath into a 32bpp buffer in memory without the Draw module. Added DrawFlatPath and DrawPath::flatten. Fixed DrawCapAndJoin::trailing_cap setting the leading cap.
+ * - DrawPath bounds, control_bounds, flattened, winding_number, contains and intersects calculate geometry natively and cache it until the path changes.
+ * - Added JPEGInfo to read the size, density, greyscale, progressive and orientation details from the JPEG header natively.
+ * - JPEG::load can defer reading the image data until it is first plotted.
+ * - Added SpritePixels and SpriteRow for direct access to sprite pixels and masks with fill, copy, lookup, mask from colour and format conversion operations.
+ * - Fixed ColourPalette size constructor and SpriteArea::get_bits_per_pixel for odd numbered modes.
+ * - Wimp message simulation and host tests (make -f Makefile.host test); fixed LoaderManager DataSaveAck overrunning its message block and Saver ignoring a returned DataSave/DataLoad.
+ * - Deferred redraws for a deleted window are discarded instead of stopping the poll with an error.
+ * - ItemRenderer::render_range overrides call render for each item so subclasses overriding render are not bypassed.
+ * - monotonic_lt, monotonic_le, monotonic_gt and monotonic_ge now compare the times as if they are less than half the unsigned range apart. Previously any time before the wrap around was treated as greater than any time after it, and monotonic_lt(3, 10) was false.
+ * - Resource object headers keep the 32 bit file layout in a 64 bit host build so resvalidate and the res classes can run in the host tests.
+ * - Resource string and message tables are saved with zero padding so an object saves the same bytes however it was edited.
+ * - Component indexes of ResWindow and ResMenu check a generation number of the resource implementation so a new implementation at the address of a deleted one is not mistaken for it.
+ *
  * <B>0.6 Alpha September 2012</B>
  * - Fixed incorrect return value from Font class string_width methods
  * - Add a few more methods to the WindowInfo class
@@ -202,6 +202,9 @@ void Application::remove_command(int command_id, Command *command)
 /**
  * Add a command to be run when no events are being received from the desktop.
  *
+ * The command is run on every null event, so it should return quickly.
+ * Use add_background_job for long running work.
+ *
  * @param command The command to add
  */
 void Application::add_idle_command(Command *command)
@@ -414,15 +417,35 @@ void Application::remove_palette_changed_listener(PaletteChangedListener *listen
  *
  * @param elapsed number of centiseconds between calls
  * @param timer - timer to add
+ * @returns handle that can be used to remove the timer
  */
-void Application::add_timer(int elapsed, Timer *timer)
+TimerHandle Application::add_timer(int elapsed, Timer *timer)
 {
-	event_router()->add_timer(elapsed, timer);
+	return event_router()->add_timer(elapsed, timer);
+}
+
+/**
+ * Add a timer to the application that will be called once
+ * after the given time.
+ *
+ * The timer is removed before it is called, so it can add itself
+ * again from its timer method if required.
+ *
+ * @param elapsed number of centiseconds before the timer is called
+ * @param timer - timer to add
+ * @returns handle that can be used to remove the timer before it is called
+ */
+TimerHandle Application::add_one_shot_timer(int elapsed, Timer *timer)
+{
+	return event_router()->add_one_shot_timer(elapsed, timer);
 }
 
 /**
  * Remove the given timer
  *
+ * If the timer has been added more than once only the first
+ * one found is removed.
+ *
  * @param timer Timer to remove
  */
 void Application::remove_timer(Timer *timer)
@@ -430,6 +453,88 @@ void Application::remove_timer(Timer *timer)
 	event_router()->remove_timer(timer);
 }
 
+/**
+ * Remove a timer using the handle returned when it was added.
+ *
+ * This is quicker than removing the timer with the Timer pointer
+ * and it is safe to call if the timer has already been removed.
+ *
+ * @param handle handle returned from add_timer or add_one_shot_timer
+ */
+void Application::remove_timer(TimerHandle handle)
+{
+	event_router()->remove_timer(handle);
+}
+
+/**
+ * Add a job that will be run a step at a time when there are no
+ * other events.
+ *
+ * Steps are run on null events until the time budget for the null
+ * event (see background_job_budget) is used up. Jobs with a higher
+ * priority are always stepped first, jobs with the same priority
+ * take turns a step at a time.
+ *
+ * The application only receives null events while there are
+ * jobs waiting to finish.
+ *
+ * @param job job to add. It is removed once its step method returns false.
+ * @param priority priority of the job, defaults to 0.
+ * @param listener listener to be told of the progress and completion
+ *        of the job or 0 (the default) for none.
+ */
+void Application::add_background_job(BackgroundJob *job, int priority /*= 0*/, BackgroundJobListener *listener /*= 0*/)
+{
+	event_router()->add_background_job(job, priority, listener);
+}
+
+/**
+ * Remove a background job before it has finished.
+ *
+ * The job listener is not called.
+ *
+ * @param job job to remove
+ */
+void Application::remove_background_job(BackgroundJob *job)
+{
+	event_router()->remove_background_job(job);
+}
+
+/**
+ * Check if a background job has not yet finished
+ *
+ * @param job job to check
+ * @returns true if the job is still waiting to finish
+ */
+bool Application::background_job_pending(BackgroundJob *job) const
+{
+	return event_router()->background_job_pending(job);
+}
+
+/**
+ * Set the maximum time to spend running background job steps on
+ * each null event.
+ *
+ * At least one step is always run. The default is 2 centiseconds.
+ *
+ * @param budget time in centiseconds
+ */
+void Application::background_job_budget(unsigned int budget)
+{
+	event_router()->background_job_budget(budget);
+}
+
+/**
+ * Get the maximum time to spend running background job steps on
+ * each null event.
+ *
+ * @returns time in centiseconds
+ */
+unsigned int Application::background_job_budget() const
+{
+	return event_router()->background_job_budget();
+}
+
 /**
  * Add a file opener.
  *
@@ -596,6 +701,21 @@ void Application::set_post_poll_listener(PostPollListener *listener)
    event_router()->_post_poll_listener = listener;
 }
 
+/**
+ * Set the object used to record the time taken to process
+ * the events returned from Wimp_Poll.
+ *
+ * This is provided to help find the events that are slowing
+ * down an application. Nothing is recorded unless this is set.
+ *
+ * @param stats PollStats object to record the times or 0 to stop recording.
+ * The application does not take ownership of the object.
+ */
+void Application::set_poll_stats(PollStats *stats)
+{
+   event_router()->_poll_stats = stats;
+}
+
 /**
  * Check if this application owns WIMP window/icon bar icon
  *
@@ -44,8 +44,12 @@ namespace tbx
 	class PaletteChangedListener;
 	class SpriteArea;
 	class Timer;
+	class TimerHandle;
+	class BackgroundJob;
+	class BackgroundJobListener;
 	class Loader;
 	class PostPollListener;
+	class PollStats;
 
 	namespace res
 	{
@@ -129,8 +133,16 @@ namespace tbx
 		void add_palette_changed_listener(PaletteChangedListener *listener);
 		void remove_palette_changed_listener(PaletteChangedListener *listener);
 
-		void add_timer(int elapsed, Timer *timer);
+		TimerHandle add_timer(int elapsed, Timer *timer);
+		TimerHandle add_one_shot_timer(int elapsed, Timer *timer);
 		void remove_timer(Timer *timer);
+		void remove_timer(TimerHandle handle);
+
+		void add_background_job(BackgroundJob *job, int priority = 0, BackgroundJobListener *listener = 0);
+		void remove_background_job(BackgroundJob *job);
+		bool background_job_pending(BackgroundJob *job) const;
+		void background_job_budget(unsigned int budget);
+		unsigned int background_job_budget() const;
 
 		void add_opener(Loader *loader, int file_type);
 		void remove_opener(Loader *loader, int file_type);
@@ -165,6 +177,7 @@ namespace tbx
 
 		void catch_poll_exceptions(bool on);
 		void set_post_poll_listener(PostPollListener *listener);
+		void set_poll_stats(PollStats *stats);
 
 		bool owns_window(WindowHandle window_handle, IconHandle icon_handle = 0);
 
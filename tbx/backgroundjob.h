@@ -0,0 +1,100 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_BACKGROUNDJOB_H_
+#define TBX_BACKGROUNDJOB_H_
+
+namespace tbx
+{
+	/**
+	 * A long running task that is carried out a step at a time
+	 * when the application is idle.
+	 *
+	 * Use app()->add_background_job to start the job. The step
+	 * method is then called on null events until it returns false.
+	 * Each call should do a small amount of work and save its position
+	 * so the next call can carry on from where it left off.
+	 *
+	 * The application stops calling steps on a null event once its
+	 * time budget has been used up, so the desktop stays responsive
+	 * while the job runs.
+	 */
+	class BackgroundJob
+	{
+	public:
+		BackgroundJob() {}
+		virtual ~BackgroundJob() {}
+
+		/**
+		 * Carry out the next step of the job
+		 *
+		 * If step throws an exception the job stays queued behind
+		 * any other jobs of the same priority and the exception is
+		 * passed on.
+		 *
+		 * @returns true if there is more work to do, false if the job has finished.
+		 */
+		virtual bool step() = 0;
+
+		/**
+		 * Return how much of the job has been done.
+		 *
+		 * The default returns -1 to show the progress is not known.
+		 *
+		 * @returns percentage complete (0 to 100) or -1 if not known.
+		 */
+		virtual int progress() const {return -1;}
+	};
+
+	/**
+	 * Listener for the progress and completion of a background job
+	 */
+	class BackgroundJobListener
+	{
+	public:
+		virtual ~BackgroundJobListener() {}
+
+		/**
+		 * Called after a step when the progress of a job has changed.
+		 *
+		 * The percentage is suitable for passing to Hourglass::percentage.
+		 *
+		 * @param job job that has progressed
+		 * @param percent percentage complete (0 to 100)
+		 */
+		virtual void job_progress(BackgroundJob *job, int percent) {}
+
+		/**
+		 * Called when a job has finished.
+		 *
+		 * The job has been removed from the application when this
+		 * is called so it can be deleted from here.
+		 *
+		 * @param job job that has finished
+		 */
+		virtual void job_finished(BackgroundJob *job) {}
+	};
+}
+
+#endif
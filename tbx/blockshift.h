@@ -0,0 +1,119 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_BLOCKSHIFT_H_
+#define TBX_BLOCKSHIFT_H_
+
+#include "bbox.h"
+
+namespace tbx
+{
+	/**
+	 * Calculates how to move part of a window work area horizontally
+	 * or vertically with a block copy.
+	 *
+	 * Given the area to move and how far to move it this works out
+	 * the block copy to do and the strip that is left uncovered
+	 * afterwards and must be redrawn.
+	 *
+	 * A copy is only used if the area moves in one direction and by
+	 * less than its own size, otherwise the whole of the area and its
+	 * destination needs redrawing.
+	 */
+	class BlockShift
+	{
+		BBox _source;
+		BBox _destination;
+		BBox _exposed;
+		bool _copy;
+
+	public:
+		/**
+		 * Calculate the shift
+		 *
+		 * @param moving area of the work area to move
+		 * @param dx distance to move right (negative for left)
+		 * @param dy distance to move up (negative for down)
+		 */
+		BlockShift(const BBox &moving, int dx, int dy) :
+			_source(moving),
+			_destination(moving),
+			_exposed(moving),
+			_copy(false)
+		{
+			_destination.move(dx, dy);
+			if (moving.min.x >= moving.max.x || moving.min.y >= moving.max.y
+				|| (dx == 0 && dy == 0))
+			{
+				_exposed = BBox(0,0,0,0);
+				return;
+			}
+
+			_exposed.cover(_destination);
+			if (dx != 0 && dy != 0) return;
+
+			if (dy < 0 && -dy < moving.height()) _exposed.min.y = _destination.max.y;
+			else if (dy > 0 && dy < moving.height()) _exposed.max.y = _destination.min.y;
+			else if (dx > 0 && dx < moving.width()) _exposed.max.x = _destination.min.x;
+			else if (dx < 0 && -dx < moving.width()) _exposed.min.x = _destination.max.x;
+			else return;
+
+			_copy = true;
+		}
+
+		/**
+		 * Check if a block copy should be used
+		 *
+		 * @returns true to copy source to destination then redraw exposed,
+		 * false to just redraw exposed.
+		 */
+		bool copy() const {return _copy;}
+
+		/**
+		 * Area to copy
+		 */
+		const BBox &source() const {return _source;}
+
+		/**
+		 * Area the source ends up in
+		 */
+		const BBox &destination() const {return _destination;}
+
+		/**
+		 * Position to copy the bottom left of the source to
+		 */
+		const Point &to() const {return _destination.min;}
+
+		/**
+		 * Area that needs to be redrawn.
+		 *
+		 * If a copy is used this is the part of the source that is not
+		 * covered by the destination, otherwise it covers both the
+		 * source and destination.
+		 */
+		const BBox &exposed() const {return _exposed;}
+	};
+}
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "deferredredraw.h"
+#include "eventrouter.h"
+#include "blockshift.h"
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+/**
+ * Area of a box
+ */
+static inline double bbox_area(const BBox &box)
+{
+	return (double)box.width() * box.height();
+}
+
+/**
+ * Check if two areas should be combined.
+ *
+ * They are combined if the box covering both contains no more than the
+ * two areas, so areas that overlap or are exactly next to each other
+ * are merged without redrawing anything extra.
+ */
+static bool should_merge(const BBox &a, const BBox &b)
+{
+	BBox both(a);
+	both.cover(b);
+	return bbox_area(both) <= bbox_area(a) + bbox_area(b);
+}
+//! @endcond
+
+/**
+ * Construct a deferred redraw for a window.
+ *
+ * @param window window to redraw
+ * @param max_areas maximum number of separate areas to collect before
+ * redrawing the whole window. Defaults to 8.
+ */
+DeferredRedraw::DeferredRedraw(Window window, unsigned int max_areas /*= 8*/) :
+	_window(window),
+	_max_areas(max_areas),
+	_all(false),
+	_queued(false),
+	_extent_pending(false)
+{
+}
+
+/**
+ * Destructor, anything not yet redrawn is discarded.
+ */
+DeferredRedraw::~DeferredRedraw()
+{
+	discard();
+}
+
+/**
+ * Add an area of the window to redraw.
+ *
+ * @param work_area area of the window to redraw in work area coordinates
+ */
+void DeferredRedraw::invalidate(const BBox &work_area)
+{
+	if (_all) return;
+	if (work_area.min.x >= work_area.max.x || work_area.min.y >= work_area.max.y) return;
+
+	BBox area(work_area);
+	unsigned int i = 0;
+	while (i < _areas.size())
+	{
+		if (should_merge(_areas[i], area))
+		{
+			// Merged area may now join up with areas already checked
+			area.cover(_areas[i]);
+			_areas.erase(_areas.begin() + i);
+			i = 0;
+		} else
+		{
+			i++;
+		}
+	}
+
+	if (_areas.size() >= _max_areas)
+	{
+		invalidate_all();
+	} else
+	{
+		_areas.push_back(area);
+		add_to_poll();
+	}
+}
+
+/**
+ * Redraw the whole window
+ */
+void DeferredRedraw::invalidate_all()
+{
+	_areas.clear();
+	_all = true;
+	add_to_poll();
+}
+
+/**
+ * Move part of the window horizontally or vertically.
+ *
+ * The area is moved at once with a block copy and only the area
+ * left uncovered is added to the areas to redraw.
+ *
+ * If any of the area to move is already waiting to be redrawn
+ * the area and its destination are added to the areas to redraw
+ * instead, so a series of changes to the same part of the window
+ * causes one redraw.
+ *
+ * @param moving area to move in work area coordinates
+ * @param dx distance to move right (negative for left)
+ * @param dy distance to move up (negative for down)
+ */
+void DeferredRedraw::shift(const BBox &moving, int dx, int dy)
+{
+	if (_all) return;
+
+	BlockShift block(moving, dx, dy);
+	if (block.copy() && !pending_in(moving))
+	{
+		_window.block_copy(block.source(), block.to());
+		invalidate(block.exposed());
+	} else
+	{
+		BBox both(block.source());
+		both.cover(block.destination());
+		invalidate(both);
+	}
+}
+
+/**
+ * Set the extent of the window before the next Wimp_Poll.
+ *
+ * The extent can not be changed while the window is being redrawn,
+ * so this is used when a redraw finds the size of the window has
+ * changed. It is set before any areas are redrawn.
+ *
+ * @param extent new extent of the window
+ */
+void DeferredRedraw::extent(const BBox &extent)
+{
+	_extent = extent;
+	_extent_pending = true;
+	add_to_poll();
+}
+
+/**
+ * Ask the WIMP to redraw the collected areas now.
+ *
+ * This is called automatically before the next Wimp_Poll
+ */
+void DeferredRedraw::flush()
+{
+	if (_queued)
+	{
+		event_router()->remove_deferred_redraw(this);
+		_queued = false;
+	}
+
+	if (_extent_pending)
+	{
+		_extent_pending = false;
+		_window.extent(_extent);
+	}
+
+	if (_all)
+	{
+		_all = false;
+		_window.force_redraw(_window.extent());
+	} else
+	{
+		std::vector<BBox> areas;
+		areas.swap(_areas);
+		for (std::vector<BBox>::iterator i = areas.begin(); i != areas.end(); ++i)
+		{
+			_window.force_redraw(*i);
+		}
+	}
+}
+
+/**
+ * Forget any areas waiting to be redrawn and any extent waiting to be set
+ */
+void DeferredRedraw::discard()
+{
+	_areas.clear();
+	_all = false;
+	_extent_pending = false;
+	if (_queued)
+	{
+		event_router()->remove_deferred_redraw(this);
+		_queued = false;
+	}
+}
+
+/**
+ * Check if any part of an area is waiting to be redrawn
+ */
+bool DeferredRedraw::pending_in(const BBox &area) const
+{
+	if (_all) return true;
+	for (std::vector<BBox>::const_iterator i = _areas.begin(); i != _areas.end(); ++i)
+	{
+		if (i->intersects(area)) return true;
+	}
+	return false;
+}
+
+/**
+ * Make sure this will be flushed before the next poll
+ */
+void DeferredRedraw::add_to_poll()
+{
+	if (!_queued)
+	{
+		event_router()->add_deferred_redraw(this);
+		_queued = true;
+	}
+}
+
+}
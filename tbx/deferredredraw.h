@@ -0,0 +1,98 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_DEFERREDREDRAW_H_
+#define TBX_DEFERREDREDRAW_H_
+
+#include <vector>
+#include "window.h"
+
+namespace tbx
+{
+	/**
+	 * Collects the areas of a window that need redrawing while events
+	 * are processed and asks the WIMP to redraw them just before the
+	 * application next calls Wimp_Poll.
+	 *
+	 * Areas that overlap or line up next to each other are merged as
+	 * they are added, so a series of small changes result in a few
+	 * calls to Window::force_redraw instead of one for each change.
+	 * If the number of separate areas goes over a limit the whole
+	 * window is redrawn instead.
+	 */
+	class DeferredRedraw
+	{
+	public:
+		DeferredRedraw(Window window, unsigned int max_areas = 8);
+		~DeferredRedraw();
+
+		/**
+		 * Get the window this redraws
+		 */
+		Window &window() {return _window;}
+
+		void invalidate(const BBox &work_area);
+		void invalidate_all();
+		void shift(const BBox &moving, int dx, int dy);
+		void extent(const BBox &extent);
+		void flush();
+		void discard();
+
+		/**
+		 * Check if there are areas waiting to be redrawn
+		 */
+		bool pending() const {return _all || !_areas.empty() || _extent_pending;}
+
+		/**
+		 * Check if a new extent is waiting to be set
+		 */
+		bool extent_pending() const {return _extent_pending;}
+
+		/**
+		 * Get the maximum number of separate areas collected before
+		 * the whole window is redrawn instead.
+		 */
+		unsigned int max_areas() const {return _max_areas;}
+		/**
+		 * Set the maximum number of separate areas collected before
+		 * the whole window is redrawn instead.
+		 */
+		void max_areas(unsigned int max_areas) {_max_areas = max_areas;}
+
+	private:
+		void add_to_poll();
+		bool pending_in(const BBox &area) const;
+
+	private:
+		Window _window;
+		std::vector<BBox> _areas;
+		unsigned int _max_areas;
+		bool _all;
+		bool _queued;
+		BBox _extent;
+		bool _extent_pending;
+	};
+}
+
+#endif
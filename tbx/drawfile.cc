@@ -33,9 +33,40 @@
 #include "kernel.h"
 #include <fstream>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
 namespace tbx {
 
+// Size of the draw file header before the first object
+static const int DRAW_HEADER_SIZE = 40;
+// Object types that are not added to the spatial index
+static const int DRAW_FONT_TABLE = 0;
+static const int DRAW_GROUP = 6;
+static const int DRAW_TAGGED = 7;
+static const int DRAW_OPTIONS = 11;
+// Maximum number of grid cells in each direction
+static const int DRAW_MAX_GRID = 1024;
+
+/**
+ * Read a word from the draw file data
+ */
+static inline int draw_word(const char *data)
+{
+	int value;
+	std::memcpy(&value, data, sizeof(int));
+	return value;
+}
+
+/**
+ * Check if two boxes overlap including their edges
+ */
+static inline bool draw_overlaps(const BBox &a, const BBox &b)
+{
+	return (a.min.x <= b.max.x && a.max.x >= b.min.x
+			&& a.min.y <= b.max.y && a.max.y >= b.min.y);
+}
+
 /**
  * Construct an unloaded draw file
  */
@@ -43,6 +74,9 @@ DrawFile::DrawFile()
 {
 	_data = 0;
 	_size = 0;
+	_grid_cols = _grid_rows = 0;
+	_cell_width = _cell_height = 1.0;
+	_query_mark = 0;
 }
 
 /**
@@ -50,17 +84,9 @@ DrawFile::DrawFile()
  */
 DrawFile::DrawFile(const DrawFile &other)
 {
-	delete [] _data;
-	if (other._data)
-	{
-		_data = new char[other._size];
-		_size = other._size;
-		std::memcpy(_data, other._data, _size);
-	} else
-	{
-		_data = 0;
-		_size = 0;
-	}
+	_data = 0;
+	_size = 0;
+	copy(other);
 }
 
 /**
@@ -75,6 +101,15 @@ DrawFile::~DrawFile()
  * Make into a copy of another draw file
  */
 DrawFile &DrawFile::operator=(const DrawFile &other)
+{
+	if (&other != this) copy(other);
+	return *this;
+}
+
+/**
+ * Copy the data and index from another draw file
+ */
+void DrawFile::copy(const DrawFile &other)
 {
 	delete [] _data;
 	if (other._data)
@@ -88,18 +123,31 @@ DrawFile &DrawFile::operator=(const DrawFile &other)
 		_size = 0;
 	}
 
-	return *this;
+	_objects = other._objects;
+	_shapes = other._shapes;
+	_fixed_objects = other._fixed_objects;
+	_grid_bounds = other._grid_bounds;
+	_grid_cols = other._grid_cols;
+	_grid_rows = other._grid_rows;
+	_cell_width = other._cell_width;
+	_cell_height = other._cell_height;
+	_cell_start = other._cell_start;
+	_cell_shapes = other._cell_shapes;
+	_large_shapes = other._large_shapes;
+	_query_marks.assign(_shapes.size(), 0);
+	_query_mark = 0;
+	_render_data.clear();
 }
 
 /**
- * Load JPEG from file
+ * Load draw file from file
  *
  * @param file_name name of file to load from
  * @returns true if load succeeded
  */
 bool DrawFile::load(const std::string &file_name)
 {
-	std::ifstream file(file_name.c_str());
+	std::ifstream file(file_name.c_str(), std::ios_base::in | std::ios_base::binary);
 	bool loaded = false;
 
 	if (file.is_open())
@@ -127,9 +175,327 @@ bool DrawFile::load(const std::string &file_name)
 		}
 	}
 
+	parse();
+
 	return loaded;
 }
 
+/**
+ * Load draw file from memory
+ *
+ * The data is copied so the memory can be freed after this call.
+ *
+ * @param data pointer to the draw file data
+ * @param size size of the data in bytes
+ * @returns true if load succeeded
+ */
+bool DrawFile::load(const void *data, int size)
+{
+	if (size <= 4 || draw_word(static_cast<const char *>(data)) != 0x77617244) // "Draw"
+	{
+		return false;
+	}
+
+	delete [] _data;
+	_data = new char[size];
+	_size = size;
+	std::memcpy(_data, data, size);
+
+	parse();
+
+	return true;
+}
+
+/**
+ * Find the objects in the loaded file and index them.
+ *
+ * If the file structure is not valid the objects are cleared and
+ * the file is always rendered in full.
+ *
+ * @returns true if the file was parsed
+ */
+bool DrawFile::parse()
+{
+	_objects.clear();
+	bool ok = false;
+	if (_data != 0 && _size >= DRAW_HEADER_SIZE)
+	{
+		ok = parse_objects(DRAW_HEADER_SIZE, _size, -1);
+		if (!ok) _objects.clear();
+	}
+	build_index();
+
+	return ok;
+}
+
+/**
+ * Add the objects in part of the draw file to the object list
+ *
+ * @param offset offset of the first object
+ * @param end offset of the end of the objects
+ * @param parent index of the containing object or -1 for the top level
+ * @returns false if the objects do not fit in the space given
+ */
+bool DrawFile::parse_objects(int offset, int end, int parent)
+{
+	while (offset + 8 <= end)
+	{
+		ObjectInfo info;
+		info.type = draw_word(_data + offset) & 0xFF;
+		info.offset = offset;
+		info.size = draw_word(_data + offset + 4);
+		info.parent = parent;
+
+		if (info.size < 8 || (info.size & 3) != 0 || info.size > end - offset) return false;
+		if (info.type == DRAW_FONT_TABLE)
+		{
+			info.bounds = BBox(0,0,0,0);
+		} else
+		{
+			if (info.size < 24) return false;
+			const char *bounds = _data + offset + 8;
+			info.bounds = BBox(draw_word(bounds), draw_word(bounds + 4),
+					draw_word(bounds + 8), draw_word(bounds + 12));
+		}
+
+		int index = (int)_objects.size();
+		_objects.push_back(info);
+
+		if (info.type == DRAW_GROUP)
+		{
+			// Header, bounding box and 12 character name then the objects
+			if (info.size < 36
+				|| !parse_objects(offset + 36, offset + info.size, index))
+			{
+				return false;
+			}
+		} else if (info.type == DRAW_TAGGED)
+		{
+			// Header, bounding box and tag then one object followed by extra data
+			if (info.size < 36) return false;
+			int child_size = draw_word(_data + offset + 32);
+			if (child_size < 8 || child_size > info.size - 28
+				|| !parse_objects(offset + 28, offset + 28 + child_size, index))
+			{
+				return false;
+			}
+		}
+
+		offset += info.size;
+	}
+
+	return (offset == end);
+}
+
+/**
+ * Build the spatial index for the objects that draw something.
+ *
+ * The index is a uniform grid over the bounds of the objects with
+ * the objects that cover a large number of cells kept in a separate list.
+ */
+void DrawFile::build_index()
+{
+	_shapes.clear();
+	_fixed_objects.clear();
+	_cell_start.clear();
+	_cell_shapes.clear();
+	_large_shapes.clear();
+	_grid_cols = _grid_rows = 0;
+
+	for (unsigned int index = 0; index < _objects.size(); index++)
+	{
+		const ObjectInfo &info = _objects[index];
+		switch(info.type)
+		{
+		case DRAW_FONT_TABLE:
+		case DRAW_OPTIONS:
+			if (info.parent == -1) _fixed_objects.push_back(index);
+			break;
+
+		case DRAW_GROUP:
+		case DRAW_TAGGED:
+			break;
+
+		default:
+			if (_shapes.empty()) _grid_bounds = info.bounds;
+			else _grid_bounds.cover(info.bounds);
+			_shapes.push_back(index);
+			break;
+		}
+	}
+
+	_query_marks.assign(_shapes.size(), 0);
+	_query_mark = 0;
+	if (_shapes.empty()) return;
+
+	// Size grid for a couple of objects per cell with roughly square cells
+	double width = double(_grid_bounds.max.x) - _grid_bounds.min.x + 1;
+	double height = double(_grid_bounds.max.y) - _grid_bounds.min.y + 1;
+	double cells = double(_shapes.size() / 2 + 1);
+	_grid_cols = (int)std::sqrt(cells * width / height);
+	if (_grid_cols < 1) _grid_cols = 1;
+	else if (_grid_cols > DRAW_MAX_GRID) _grid_cols = DRAW_MAX_GRID;
+	_grid_rows = (int)(cells / _grid_cols);
+	if (_grid_rows < 1) _grid_rows = 1;
+	else if (_grid_rows > DRAW_MAX_GRID) _grid_rows = DRAW_MAX_GRID;
+	_cell_width = width / _grid_cols;
+	_cell_height = height / _grid_rows;
+
+	int cell_count = _grid_cols * _grid_rows;
+	int large_cells = cell_count / 8;
+	if (large_cells < 16) large_cells = 16;
+
+	// Count the entries for each cell, then fill them in
+	_cell_start.assign(cell_count + 1, 0);
+	std::vector<unsigned int> in_cells;
+	in_cells.reserve(_shapes.size());
+	for (unsigned int s = 0; s < _shapes.size(); s++)
+	{
+		int c0, r0, c1, r1;
+		const BBox &b = _objects[_shapes[s]].bounds;
+		c0 = (int)((b.min.x - double(_grid_bounds.min.x)) / _cell_width);
+		c1 = (int)((b.max.x - double(_grid_bounds.min.x)) / _cell_width);
+		r0 = (int)((b.min.y - double(_grid_bounds.min.y)) / _cell_height);
+		r1 = (int)((b.max.y - double(_grid_bounds.min.y)) / _cell_height);
+		if (c1 >= _grid_cols) c1 = _grid_cols - 1;
+		if (r1 >= _grid_rows) r1 = _grid_rows - 1;
+		if (c0 > c1) c0 = c1;
+		if (r0 > r1) r0 = r1;
+
+		if ((c1 - c0 + 1) * (r1 - r0 + 1) > large_cells)
+		{
+			_large_shapes.push_back(s);
+		} else
+		{
+			in_cells.push_back(s);
+			for (int r = r0; r <= r1; r++)
+				for (int c = c0; c <= c1; c++)
+					_cell_start[r * _grid_cols + c + 1]++;
+		}
+	}
+
+	for (int cell = 0; cell < cell_count; cell++)
+		_cell_start[cell + 1] += _cell_start[cell];
+
+	_cell_shapes.resize(_cell_start[cell_count]);
+	std::vector<unsigned int> next(_cell_start.begin(), _cell_start.end() - 1);
+	for (std::vector<unsigned int>::iterator i = in_cells.begin(); i != in_cells.end(); ++i)
+	{
+		const BBox &b = _objects[_shapes[*i]].bounds;
+		int c0 = (int)((b.min.x - double(_grid_bounds.min.x)) / _cell_width);
+		int c1 = (int)((b.max.x - double(_grid_bounds.min.x)) / _cell_width);
+		int r0 = (int)((b.min.y - double(_grid_bounds.min.y)) / _cell_height);
+		int r1 = (int)((b.max.y - double(_grid_bounds.min.y)) / _cell_height);
+		if (c1 >= _grid_cols) c1 = _grid_cols - 1;
+		if (r1 >= _grid_rows) r1 = _grid_rows - 1;
+		if (c0 > c1) c0 = c1;
+		if (r0 > r1) r0 = r1;
+		for (int r = r0; r <= r1; r++)
+			for (int c = c0; c <= c1; c++)
+				_cell_shapes[next[r * _grid_cols + c]++] = *i;
+	}
+}
+
+/**
+ * Find the objects that draw something inside an area of the drawing.
+ *
+ * Groups, tagged objects and font tables are not returned, but the
+ * objects inside groups and tagged objects are.
+ *
+ * @param area area to check in draw units before any transform is applied.
+ * @param found updated to the indices of the objects whose bounding box
+ * intersects the area in the order they appear in the file.
+ */
+void DrawFile::objects_in(const BBox &area, std::vector<unsigned int> &found) const
+{
+	found.clear();
+	if (_shapes.empty()) return;
+
+	for (std::vector<unsigned int>::const_iterator i = _large_shapes.begin(); i != _large_shapes.end(); ++i)
+	{
+		if (draw_overlaps(_objects[_shapes[*i]].bounds, area)) found.push_back(_shapes[*i]);
+	}
+
+	if (draw_overlaps(_grid_bounds, area))
+	{
+		if (++_query_mark == 0)
+		{
+			std::fill(_query_marks.begin(), _query_marks.end(), 0);
+			_query_mark = 1;
+		}
+
+		int c0 = (area.min.x <= _grid_bounds.min.x) ? 0 : (int)((area.min.x - double(_grid_bounds.min.x)) / _cell_width);
+		int c1 = (int)((area.max.x - double(_grid_bounds.min.x)) / _cell_width);
+		int r0 = (area.min.y <= _grid_bounds.min.y) ? 0 : (int)((area.min.y - double(_grid_bounds.min.y)) / _cell_height);
+		int r1 = (int)((area.max.y - double(_grid_bounds.min.y)) / _cell_height);
+		if (c1 >= _grid_cols) c1 = _grid_cols - 1;
+		if (r1 >= _grid_rows) r1 = _grid_rows - 1;
+
+		for (int r = r0; r <= r1; r++)
+		{
+			for (int c = c0; c <= c1; c++)
+			{
+				int cell = r * _grid_cols + c;
+				for (unsigned int e = _cell_start[cell]; e < _cell_start[cell + 1]; e++)
+				{
+					unsigned int s = _cell_shapes[e];
+					if (_query_marks[s] != _query_mark)
+					{
+						_query_marks[s] = _query_mark;
+						if (draw_overlaps(_objects[_shapes[s]].bounds, area)) found.push_back(_shapes[s]);
+					}
+				}
+			}
+		}
+	}
+
+	std::sort(found.begin(), found.end());
+}
+
+/**
+ * Convert a clip rectangle to the area of the drawing it covers
+ *
+ * @param dt transform used to render the drawing or 0 for the identity
+ * @param clip clip rectangle after the transform
+ * @param area updated to an area in draw units before the transform that
+ * includes everything inside the clip rectangle
+ * @returns false if the transform can not be reversed
+ */
+bool DrawFile::clip_to_drawing(const DrawTransform *dt, const BBox &clip, BBox &area) const
+{
+	if (dt == 0)
+	{
+		area = clip;
+		return true;
+	}
+
+	double a = dt->a, b = dt->b, c = dt->c, d = dt->d;
+	double det = a * d - b * c;
+	if (std::fabs(det) < 1e-9) return false;
+
+	double xs[4] = {double(clip.min.x), double(clip.max.x), double(clip.min.x), double(clip.max.x)};
+	double ys[4] = {double(clip.min.y), double(clip.min.y), double(clip.max.y), double(clip.max.y)};
+	double min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		double dx = xs[i] - dt->e;
+		double dy = ys[i] - dt->f;
+		double x = (d * dx - c * dy) / det;
+		double y = (a * dy - b * dx) / det;
+		if (i == 0 || x < min_x) min_x = x;
+		if (i == 0 || x > max_x) max_x = x;
+		if (i == 0 || y < min_y) min_y = y;
+		if (i == 0 || y > max_y) max_y = y;
+	}
+
+	const double limit = 2147483000.0;
+	if (min_x < -limit || min_y < -limit || max_x > limit || max_y > limit) return false;
+	area = BBox((int)std::floor(min_x) - 1, (int)std::floor(min_y) - 1,
+			(int)std::ceil(max_x) + 1, (int)std::ceil(max_y) + 1);
+
+	return true;
+}
+
 /**
  * Plot draw file at given location
  *
@@ -160,17 +526,48 @@ void DrawFile::plot(const tbx::Point &pt) const
  *
  * @param dt DrawTransform to position, rotate and translate drawing
  *  or 0 for identity transform.
- * @param clip point to box to clip the drawing or 0 for no clip
+ * @param clip point to box to clip the drawing or 0 for no clip.
+ *  The clip box is in 256ths of an OS unit like the bounds. When it is
+ *  given only the objects whose bounding boxes intersect it are rendered.
  * @param flatness for curves or -1 if not specified.
  */
 void DrawFile::render(DrawTransform *dt /*= 0*/, BBox *clip /*= 0*/, int flatness /*= -1*/ ) const
 {
 	if (_data == 0) return;
 
+	const char *data = _data;
+	int size = _size;
+	BBox area;
+
+	if (clip && !_shapes.empty() && clip_to_drawing(dt, *clip, area))
+	{
+		std::vector<unsigned int> found;
+		objects_in(area, found);
+		if (found.empty()) return; // Nothing to draw
+		if (found.size() < _shapes.size())
+		{
+			// Render a copy of the file with only the objects that are needed
+			_render_data.assign(_data, _data + DRAW_HEADER_SIZE);
+			std::vector<unsigned int>::const_iterator i;
+			for (i = _fixed_objects.begin(); i != _fixed_objects.end(); ++i)
+			{
+				const ObjectInfo &info = _objects[*i];
+				_render_data.insert(_render_data.end(), _data + info.offset, _data + info.offset + info.size);
+			}
+			for (i = found.begin(); i != found.end(); ++i)
+			{
+				const ObjectInfo &info = _objects[*i];
+				_render_data.insert(_render_data.end(), _data + info.offset, _data + info.offset + info.size);
+			}
+			data = &_render_data[0];
+			size = (int)_render_data.size();
+		}
+	}
+
 	_kernel_swi_regs regs;
 	regs.r[0] = 0;
-	regs.r[1] = (int)_data;
-	regs.r[2] = _size;
+	regs.r[1] = (int)data;
+	regs.r[2] = size;
 	regs.r[3] = (int)dt;
 	regs.r[4] = (int)clip;
 	if (flatness > 0)
@@ -36,6 +36,7 @@
 #include "bbox.h"
 #include "drawtransform.h"
 #include <string>
+#include <vector>
 
 namespace tbx {
 
@@ -44,12 +45,68 @@ namespace tbx {
  *
  * This class uses the DrawFile module to render
  * the drawfile.
+ *
+ * The objects in the file are found when it is loaded and
+ * indexed by their bounding boxes, so when it is rendered with
+ * a clip rectangle only the objects inside the clip rectangle
+ * are passed to the DrawFile module.
  */
 class DrawFile : public Image
 {
+public:
+	/**
+	 * Information on an object in a draw file.
+	 */
+	struct ObjectInfo
+	{
+		/**
+		 * Draw file object type (e.g. 2 for a path, 6 for a group).
+		 */
+		int type;
+		/**
+		 * Offset of the object from the start of the file.
+		 */
+		int offset;
+		/**
+		 * Size of the object in bytes including its header.
+		 */
+		int size;
+		/**
+		 * Bounding box of the object in draw units.
+		 * Not set for font tables which do not have one.
+		 */
+		BBox bounds;
+		/**
+		 * Index of the group or tagged object that contains this
+		 * object or -1 if it is at the top level of the file.
+		 */
+		int parent;
+	};
+
 private:
 	char *_data;
 	int _size;
+	std::vector<ObjectInfo> _objects;
+	std::vector<unsigned int> _shapes;
+	std::vector<unsigned int> _fixed_objects;
+	BBox _grid_bounds;
+	int _grid_cols;
+	int _grid_rows;
+	double _cell_width;
+	double _cell_height;
+	std::vector<unsigned int> _cell_start;
+	std::vector<unsigned int> _cell_shapes;
+	std::vector<unsigned int> _large_shapes;
+	mutable std::vector<unsigned int> _query_marks;
+	mutable unsigned int _query_mark;
+	mutable std::vector<char> _render_data;
+
+	void copy(const DrawFile &other);
+	bool parse();
+	bool parse_objects(int offset, int end, int parent);
+	void build_index();
+	bool clip_to_drawing(const DrawTransform *dt, const BBox &clip, BBox &area) const;
+
 public:
 	DrawFile();
 	DrawFile(const DrawFile &other);
@@ -58,6 +115,7 @@ public:
 	DrawFile &operator=(const DrawFile &other);
 
 	bool load(const std::string &file_name);
+	bool load(const void *data, int size);
 
 	/**
 	 * Check if a draw file has been loaded.
@@ -72,6 +130,26 @@ public:
 	void bounds(BBox &bounds, DrawTransform *dt = 0) const;
 	void declare_fonts(bool download_fonts = true) const;
 
+	/**
+	 * Get the number of objects found in the file.
+	 *
+	 * This includes the objects inside groups and tagged objects.
+	 * It is zero if the file could not be parsed in which
+	 * case it is rendered without using the index.
+	 */
+	unsigned int object_count() const {return _objects.size();}
+
+	/**
+	 * Get information on an object in the file.
+	 *
+	 * Objects are numbered in the order they appear in the file
+	 * with a group or tagged object before the objects it contains.
+	 *
+	 * @param index index of the object from 0 to object_count()-1
+	 */
+	const ObjectInfo &object(unsigned int index) const {return _objects[index];}
+
+	void objects_in(const BBox &area, std::vector<unsigned int> &found) const;
 };
 
 }
@@ -28,6 +28,8 @@
 #include <stdexcept>
 #include <memory>
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 
 namespace tbx
 {
@@ -56,6 +58,7 @@ DrawPath::DrawPath(int capacity /*= 64*/)
 	_capacity = capacity;
 	_data = new int[_capacity];
 	_size = 0;
+	_flat_flatness = -1;
 }
 
 DrawPath::~DrawPath()
@@ -71,6 +74,7 @@ DrawPath::~DrawPath()
  */
 void DrawPath::add(const DrawElement &element)
 {
+	changed();
 	int el_size = DrawElement::size_in_words(element.type());
 	ensure_space(_size + el_size);
 	std::memcpy(_data + _size, &element._type, el_size * 4);
@@ -86,6 +90,7 @@ void DrawPath::add(const DrawElement &element)
  */
 void DrawPath::end_path()
 {
+	changed();
 	ensure_space(2);
 	_data[_size++] = DrawElement::END;
 	_data[_size] = (_capacity - _size) * 4;
@@ -99,6 +104,7 @@ void DrawPath::end_path()
  */
 void DrawPath::move(int x, int y)
 {
+	changed();
 	ensure_space(3);
 	_data[_size++] = DrawElement::MOVE;
 	_data[_size++] = x;
@@ -110,6 +116,7 @@ void DrawPath::move(int x, int y)
  */
 void DrawPath::close_gap()
 {
+	changed();
 	ensure_space(1);
 	_data[_size++] = DrawElement::CLOSE_GAP;
 }
@@ -119,6 +126,7 @@ void DrawPath::close_gap()
  */
 void DrawPath::close_line()
 {
+	changed();
 	ensure_space(1);
 	_data[_size++] = DrawElement::CLOSE_LINE;
 }
@@ -128,6 +136,7 @@ void DrawPath::close_line()
  */
 void DrawPath::bezier(int cx1, int cy1, int cx2, int cy2, int x, int y)
 {
+	changed();
 	ensure_space(7);
 	_data[_size++] = DrawElement::BEZIER;
 	_data[_size++] = cx1;
@@ -143,6 +152,7 @@ void DrawPath::bezier(int cx1, int cy1, int cx2, int cy2, int x, int y)
  */
 void DrawPath::gap(int x, int y)
 {
+	changed();
 	ensure_space(3);
 	_data[_size++] = DrawElement::GAP;
 	_data[_size++] = x;
@@ -154,6 +164,7 @@ void DrawPath::gap(int x, int y)
  */
 void DrawPath::line(int x, int y)
 {
+	changed();
 	ensure_space(3);
 	_data[_size++] = DrawElement::LINE;
 	_data[_size++] = x;
@@ -223,6 +234,621 @@ void DrawPath::circle(int x, int y, int radius)
 }
 
 
+/**
+ * Apply a transform to a point
+ */
+static inline Point transform_point(const DrawTransform *transform, int x, int y)
+{
+	if (transform == 0) return Point(x,y);
+	return Point(
+		(int)(((long long)transform->a.bits() * x + (long long)transform->c.bits() * y) >> 16) + transform->e,
+		(int)(((long long)transform->b.bits() * x + (long long)transform->d.bits() * y) >> 16) + transform->f
+		);
+}
+
+//! @cond INTERNAL
+/**
+ * Class to step through the elements of a path following
+ * any continuations.
+ */
+class DrawPathReader
+{
+	const int *_data;
+	const int *_end;
+	bool _in_data;
+
+public:
+	DrawPathReader(const int *data, int size) : _data(data), _end(data + size), _in_data(true) {}
+
+	/**
+	 * Get the next element
+	 *
+	 * @returns pointer to the element or 0 at the end of the path
+	 */
+	const int *next()
+	{
+		while (!_in_data || _data < _end)
+		{
+			const int *element = _data;
+			unsigned int type = (unsigned int)element[0];
+			if (type == DrawElement::END || type > DrawElement::LINE) return 0;
+			if (type == DrawElement::CONTINUATION)
+			{
+				// Size of continued path is not known so stop at end element
+				_data = reinterpret_cast<const int *>(element[1]);
+				_in_data = false;
+			} else
+			{
+				_data += DrawElement::size_in_words((DrawElement::ElementType)type);
+				return element;
+			}
+		}
+		return 0;
+	}
+};
+
+/**
+ * Class to find the extent of a set of points
+ */
+class DrawPathExtent
+{
+	bool _found;
+	double _min_x, _min_y, _max_x, _max_y;
+
+public:
+	DrawPathExtent() : _found(false), _min_x(0), _min_y(0), _max_x(0), _max_y(0) {}
+
+	void add(double x, double y)
+	{
+		if (!_found)
+		{
+			_min_x = _max_x = x;
+			_min_y = _max_y = y;
+			_found = true;
+		} else
+		{
+			if (x < _min_x) _min_x = x;
+			else if (x > _max_x) _max_x = x;
+			if (y < _min_y) _min_y = y;
+			else if (y > _max_y) _max_y = y;
+		}
+	}
+
+	void add(const Point &pt) {add(pt.x, pt.y);}
+
+	bool found() const {return _found;}
+
+	BBox bounds() const
+	{
+		if (!_found) return BBox(0,0,0,0);
+		return BBox((int)std::floor(_min_x), (int)std::floor(_min_y),
+				(int)std::ceil(_max_x), (int)std::ceil(_max_y));
+	}
+};
+//! @endcond
+
+/**
+ * Find the extremes of one coordinate of a bezier curve between its end points
+ *
+ * @param p0 start coordinate
+ * @param p1 first control coordinate
+ * @param p2 second control coordinate
+ * @param p3 end coordinate
+ * @param values array to receive up to two values
+ * @returns number of values
+ */
+static int bezier_extremes(double p0, double p1, double p2, double p3, double *values)
+{
+	// Solve for where the derivative is zero
+	double a = -p0 + 3 * p1 - 3 * p2 + p3;
+	double b = 2 * (p0 - 2 * p1 + p2);
+	double c = p1 - p0;
+	double ts[2];
+	int count = 0;
+
+	if (std::fabs(a) < 1e-12)
+	{
+		if (std::fabs(b) > 1e-12) ts[count++] = -c / b;
+	} else
+	{
+		double disc = b * b - 4 * a * c;
+		if (disc >= 0)
+		{
+			double root = std::sqrt(disc);
+			ts[count++] = (-b + root) / (2 * a);
+			ts[count++] = (-b - root) / (2 * a);
+		}
+	}
+
+	int found = 0;
+	for (int j = 0; j < count; j++)
+	{
+		double t = ts[j];
+		if (t > 0 && t < 1)
+		{
+			double mt = 1 - t;
+			values[found++] = mt * mt * mt * p0 + 3 * mt * mt * t * p1 + 3 * mt * t * t * p2 + t * t * t * p3;
+		}
+	}
+	return found;
+}
+
+/**
+ * Check if a line segment touches a box
+ */
+static bool segment_touches(double x0, double y0, double x1, double y1, const BBox &box)
+{
+	// Liang-Barsky clipping of the segment to the box
+	double t0 = 0, t1 = 1;
+	double dx = x1 - x0, dy = y1 - y0;
+	double p[4] = {-dx, dx, -dy, dy};
+	double q[4] = {x0 - box.min.x, box.max.x - x0, y0 - box.min.y, box.max.y - y0};
+	for (int j = 0; j < 4; j++)
+	{
+		if (p[j] == 0)
+		{
+			if (q[j] < 0) return false;
+		} else
+		{
+			double t = q[j] / p[j];
+			if (p[j] < 0)
+			{
+				if (t > t1) return false;
+				if (t > t0) t0 = t;
+			} else
+			{
+				if (t < t0) return false;
+				if (t < t1) t1 = t;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Check if a winding number is inside for a fill style
+ */
+static bool winding_inside(int winding, DrawFillStyle fill_style)
+{
+	switch(fill_style & 3)
+	{
+	case WINDING_NEGATIVE: return (winding < 0);
+	case WINDING_EVEN_ODD: return (winding & 1) != 0;
+	case WINDING_POSITIVE: return (winding > 0);
+	default: break;
+	}
+	return (winding != 0);
+}
+
+/**
+ * Flatten the path by replacing the bezier curves with straight lines.
+ *
+ * The curves are split into the number of lines needed to keep within
+ * the flatness of the curve.
+ *
+ * @param flat DrawFlatPath to receive the flattened path. It is cleared first.
+ * @param flatness maximum distance allowed from a bezier curve or 0 for the
+ * default of 128 (half an OS unit in draw units).
+ * @param transform transform to apply to the points before flattening or 0
+ * to leave them in user units. The flatness is measured after the transform.
+ */
+void DrawPath::flatten(DrawFlatPath &flat, int flatness /*= 0*/, const DrawTransform *transform /*= 0*/) const
+{
+	double tolerance = (flatness > 0) ? flatness : 128;
+	DrawPathReader reader(_data, _size);
+	const int *data;
+	Point current(0,0);
+	Point start(0,0);
+
+	flat.clear();
+	while ((data = reader.next()) != 0)
+	{
+		DrawElement::ElementType type = (DrawElement::ElementType)data[0];
+		switch(type)
+		{
+		case DrawElement::MOVE:
+		case DrawElement::MOVE_INTERNAL:
+			start = current = transform_point(transform, data[1], data[2]);
+			flat.move(current.x, current.y, type == DrawElement::MOVE_INTERNAL);
+			break;
+
+		case DrawElement::CLOSE_GAP:
+		case DrawElement::CLOSE_LINE:
+			flat.close(type == DrawElement::CLOSE_LINE);
+			current = start;
+			break;
+
+		case DrawElement::BEZIER:
+			{
+				// Number of lines from Wang's formula for the flatness
+				Point c1 = transform_point(transform, data[1], data[2]);
+				Point c2 = transform_point(transform, data[3], data[4]);
+				Point to = transform_point(transform, data[5], data[6]);
+				double x0 = current.x, y0 = current.y;
+				double x1 = c1.x, y1 = c1.y;
+				double x2 = c2.x, y2 = c2.y;
+				double x3 = to.x, y3 = to.y;
+				double ddx1 = x0 - 2 * x1 + x2, ddy1 = y0 - 2 * y1 + y2;
+				double ddx2 = x1 - 2 * x2 + x3, ddy2 = y1 - 2 * y2 + y3;
+				double dd = std::sqrt(std::max(ddx1 * ddx1 + ddy1 * ddy1, ddx2 * ddx2 + ddy2 * ddy2));
+				int lines = (int)std::ceil(std::sqrt(0.75 * dd / tolerance));
+				if (lines < 1) lines = 1;
+				else if (lines > 1024) lines = 1024;
+
+				for (int j = 1; j < lines; j++)
+				{
+					double t = double(j) / lines;
+					double mt = 1.0 - t;
+					double a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+					flat.line((int)std::floor(a * x0 + b * x1 + c * x2 + d * x3 + 0.5),
+						(int)std::floor(a * y0 + b * y1 + c * y2 + d * y3 + 0.5));
+				}
+				current = to;
+				flat.line(current.x, current.y);
+			}
+			break;
+
+		case DrawElement::GAP:
+		case DrawElement::LINE:
+			current = transform_point(transform, data[1], data[2]);
+			flat.line(current.x, current.y, type == DrawElement::LINE);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+/**
+ * Get the flattened path.
+ *
+ * The flattened path is kept until the path is changed or
+ * it is requested with a different flatness.
+ *
+ * @param flatness maximum distance allowed from a bezier curve in user units
+ * or 0 for the default of 128.
+ * @returns the path flattened without a transform
+ */
+const DrawFlatPath &DrawPath::flattened(int flatness /*= 0*/) const
+{
+	if (flatness < 0) flatness = 0;
+	if (_flat_flatness != flatness)
+	{
+		flatten(_flat, flatness);
+		_flat_flatness = flatness;
+	}
+	return _flat;
+}
+
+/**
+ * Get the exact bounding box of the path.
+ *
+ * The curves are included to their extremes rather than to their
+ * control points. The result is kept until the path or transform changes.
+ *
+ * @param box updated to the bounding box of the path
+ * @param transform transform to apply to the path or 0 for none.
+ * @returns false if the path has no points, in which case box is set to (0,0,0,0)
+ */
+bool DrawPath::bounds(BBox &box, const DrawTransform *transform /*= 0*/) const
+{
+	if (!_bounds_cache.matches(transform))
+	{
+		DrawPathExtent extent;
+		DrawPathReader reader(_data, _size);
+		const int *data;
+		Point current(0,0);
+		Point start(0,0);
+		double values[2];
+
+		while ((data = reader.next()) != 0)
+		{
+			switch(data[0])
+			{
+			case DrawElement::MOVE:
+			case DrawElement::MOVE_INTERNAL:
+				start = current = transform_point(transform, data[1], data[2]);
+				extent.add(current);
+				break;
+
+			case DrawElement::GAP:
+			case DrawElement::LINE:
+				current = transform_point(transform, data[1], data[2]);
+				extent.add(current);
+				break;
+
+			case DrawElement::CLOSE_GAP:
+			case DrawElement::CLOSE_LINE:
+				current = start;
+				break;
+
+			case DrawElement::BEZIER:
+				{
+					Point c1 = transform_point(transform, data[1], data[2]);
+					Point c2 = transform_point(transform, data[3], data[4]);
+					Point to = transform_point(transform, data[5], data[6]);
+					extent.add(to);
+					int count = bezier_extremes(current.x, c1.x, c2.x, to.x, values);
+					for (int j = 0; j < count; j++) extent.add(values[j], to.y);
+					count = bezier_extremes(current.y, c1.y, c2.y, to.y, values);
+					for (int j = 0; j < count; j++) extent.add(to.x, values[j]);
+					current = to;
+				}
+				break;
+			}
+		}
+		_bounds_cache.set(transform, extent.found(), extent.bounds());
+	}
+
+	box = _bounds_cache.bounds;
+	return _bounds_cache.found;
+}
+
+/**
+ * Get a bounding box of the path that includes the control points
+ * of the curves.
+ *
+ * This is quicker to calculate than the exact bounds and always contains
+ * them. The result is kept until the path or transform changes.
+ *
+ * @param box updated to the bounding box of the path and control points
+ * @param transform transform to apply to the path or 0 for none.
+ * @returns false if the path has no points, in which case box is set to (0,0,0,0)
+ */
+bool DrawPath::control_bounds(BBox &box, const DrawTransform *transform /*= 0*/) const
+{
+	if (!_control_bounds_cache.matches(transform))
+	{
+		DrawPathExtent extent;
+		DrawPathReader reader(_data, _size);
+		const int *data;
+
+		while ((data = reader.next()) != 0)
+		{
+			switch(data[0])
+			{
+			case DrawElement::BEZIER:
+				extent.add(transform_point(transform, data[1], data[2]));
+				extent.add(transform_point(transform, data[3], data[4]));
+				extent.add(transform_point(transform, data[5], data[6]));
+				break;
+
+			case DrawElement::MOVE:
+			case DrawElement::MOVE_INTERNAL:
+			case DrawElement::GAP:
+			case DrawElement::LINE:
+				extent.add(transform_point(transform, data[1], data[2]));
+				break;
+			}
+		}
+		_control_bounds_cache.set(transform, extent.found(), extent.bounds());
+	}
+
+	box = _control_bounds_cache.bounds;
+	return _control_bounds_cache.found;
+}
+
+/**
+ * Calculate the winding number of the path around a point.
+ *
+ * Subpaths started with MOVE_INTERNAL are ignored and open
+ * subpaths are treated as closed, as they are when the path is filled.
+ * Anticlockwise subpaths give positive winding numbers.
+ *
+ * @param pt point to test in user units
+ * @param flatness flatness used to flatten the curves or 0 for the default
+ * @returns winding number
+ */
+int DrawPath::winding_number(const Point &pt, int flatness /*= 0*/) const
+{
+	const DrawFlatPath &flat = flattened(flatness);
+	int winding = 0;
+
+	for (unsigned int s = 0; s < flat.subpath_count(); s++)
+	{
+		const DrawFlatPath::Subpath &sub = flat.subpath(s);
+		if (sub.internal || sub.count < 2) continue;
+
+		unsigned int last = sub.first + sub.count - 1;
+		for (unsigned int j = sub.first, k = last; j <= last; k = j++)
+		{
+			const Point &p0 = flat.point(k);
+			const Point &p1 = flat.point(j);
+			if ((p0.y <= pt.y && pt.y < p1.y) || (p1.y <= pt.y && pt.y < p0.y))
+			{
+				double x = p0.x + double(pt.y - p0.y) * (p1.x - p0.x) / (p1.y - p0.y);
+				if (x <= pt.x) winding += (p0.y > p1.y) ? 1 : -1;
+			}
+		}
+	}
+
+	return winding;
+}
+
+/**
+ * Check if a point is inside the filled path
+ *
+ * @param pt point to test in user units
+ * @param fill_style fill style with the winding rule to use. Default WINDING_NON_ZERO.
+ * @param flatness flatness used to flatten the curves or 0 for the default
+ * @returns true if the point would be filled
+ */
+bool DrawPath::contains(const Point &pt, DrawFillStyle fill_style /*= WINDING_NON_ZERO*/, int flatness /*= 0*/) const
+{
+	return winding_inside(winding_number(pt, flatness), fill_style);
+}
+
+/**
+ * Check if a box is entirely inside the filled path
+ *
+ * @param box box to test in user units
+ * @param fill_style fill style with the winding rule to use. Default WINDING_NON_ZERO.
+ * @param flatness flatness used to flatten the curves or 0 for the default
+ * @returns true if all of the box would be filled
+ */
+bool DrawPath::contains(const BBox &box, DrawFillStyle fill_style /*= WINDING_NON_ZERO*/, int flatness /*= 0*/) const
+{
+	const DrawFlatPath &flat = flattened(flatness);
+
+	// No part of the path can cross the box
+	for (unsigned int s = 0; s < flat.subpath_count(); s++)
+	{
+		const DrawFlatPath::Subpath &sub = flat.subpath(s);
+		if (sub.internal || sub.count < 2) continue;
+		unsigned int last = sub.first + sub.count - 1;
+		for (unsigned int j = sub.first, k = last; j <= last; k = j++)
+		{
+			const Point &p0 = flat.point(k);
+			const Point &p1 = flat.point(j);
+			if (segment_touches(p0.x, p0.y, p1.x, p1.y, box)) return false;
+		}
+	}
+
+	return contains(box.min, fill_style, flatness);
+}
+
+/**
+ * Check if any part of a box is inside the filled path
+ *
+ * The box is taken to intersect if a line of the path passes
+ * through it or it is entirely inside the filled path.
+ *
+ * @param box box to test in user units
+ * @param fill_style fill style with the winding rule to use. Default WINDING_NON_ZERO.
+ * @param flatness flatness used to flatten the curves or 0 for the default
+ * @returns true if some of the box would be filled
+ */
+bool DrawPath::intersects(const BBox &box, DrawFillStyle fill_style /*= WINDING_NON_ZERO*/, int flatness /*= 0*/) const
+{
+	BBox outer;
+	if (!control_bounds(outer) || !outer.intersects(box)) return false;
+
+	const DrawFlatPath &flat = flattened(flatness);
+	for (unsigned int s = 0; s < flat.subpath_count(); s++)
+	{
+		const DrawFlatPath::Subpath &sub = flat.subpath(s);
+		if (sub.internal || sub.count < 2) continue;
+		unsigned int last = sub.first + sub.count - 1;
+		for (unsigned int j = sub.first, k = last; j <= last; k = j++)
+		{
+			const Point &p0 = flat.point(k);
+			const Point &p1 = flat.point(j);
+			if (segment_touches(p0.x, p0.y, p1.x, p1.y, box)) return true;
+		}
+	}
+
+	return contains(box.min, fill_style, flatness);
+}
+
+/**
+ * Check if the bounds were calculated for a transform
+ */
+bool DrawPath::BoundsCache::matches(const DrawTransform *other) const
+{
+	if (!valid) return false;
+	if (other == 0) return !transformed;
+	return transformed
+		&& transform.a.bits() == other->a.bits() && transform.b.bits() == other->b.bits()
+		&& transform.c.bits() == other->c.bits() && transform.d.bits() == other->d.bits()
+		&& transform.e == other->e && transform.f == other->f;
+}
+
+/**
+ * Store the bounds calculated for a transform
+ */
+void DrawPath::BoundsCache::set(const DrawTransform *other, bool found_points, const BBox &box)
+{
+	valid = true;
+	transformed = (other != 0);
+	if (other) transform = *other;
+	found = found_points;
+	bounds = box;
+}
+
+/**
+ * Clear the cached geometry after the path has changed
+ */
+void DrawPath::changed()
+{
+	_flat_flatness = -1;
+	_bounds_cache.valid = false;
+	_control_bounds_cache.valid = false;
+}
+
+/**
+ * Remove all the subpaths
+ */
+void DrawFlatPath::clear()
+{
+	_points.clear();
+	_drawn.clear();
+	_subpaths.clear();
+	_open = false;
+}
+
+/**
+ * Start a new subpath
+ *
+ * @param x x coordinate of the start of the subpath
+ * @param y y coordinate of the start of the subpath
+ * @param internal true if the subpath does not affect winding numbers
+ */
+void DrawFlatPath::move(int x, int y, bool internal /*= false*/)
+{
+	Subpath sub;
+	sub.first = _points.size();
+	sub.count = 1;
+	sub.closed = false;
+	sub.close_line = false;
+	sub.internal = internal;
+	_subpaths.push_back(sub);
+	_points.push_back(Point(x,y));
+	_drawn.push_back(false);
+	_open = true;
+}
+
+/**
+ * Add a line or gap to the current subpath.
+ *
+ * If there is no current subpath, one is started from the start
+ * of the last subpath or (0,0) if there isn't one.
+ *
+ * @param x x coordinate of the end of the line
+ * @param y y coordinate of the end of the line
+ * @param drawn true for a line, false for a gap
+ */
+void DrawFlatPath::line(int x, int y, bool drawn /*= true*/)
+{
+	if (!_open)
+	{
+		if (_subpaths.empty()) move(0,0);
+		else
+		{
+			Point start = _points[_subpaths.back().first];
+			move(start.x, start.y);
+		}
+	}
+	_points.push_back(Point(x,y));
+	_drawn.push_back(drawn);
+	_subpaths.back().count++;
+}
+
+/**
+ * Close the current subpath
+ *
+ * @param line true to close with a line, false to close with a gap
+ */
+void DrawFlatPath::close(bool line)
+{
+	if (_open)
+	{
+		_subpaths.back().closed = true;
+		_subpaths.back().close_line = line;
+		_open = false;
+	}
+}
+
 /**
  * Set the capacity of the path
  *
@@ -236,6 +862,7 @@ void DrawPath::capacity(int new_cap)
 	std::memcpy(new_data, _data, _size * 4);
 	delete [] _data;
 	_data = new_data;
+	_capacity = new_cap;
 }
 
 
@@ -26,6 +26,9 @@
 #define TBX_DRAWPATH_H_
 
 #include "drawtransform.h"
+#include "point.h"
+#include "bbox.h"
+#include <vector>
 
 namespace tbx
 {
@@ -70,6 +73,7 @@ namespace tbx
 		int _trailing_tri_cap;
 
 		friend class DrawPath;
+		friend class DrawRasteriser;
 
 	public:
 		/**
@@ -143,7 +147,7 @@ namespace tbx
 		 * should also be set.
 		 * @param cap_style new trailing cap style
 		 */
-		void trailing_cap(CapStyle cap_style) { _leading_cap_style = cap_style;}
+		void trailing_cap(CapStyle cap_style) { _trailing_cap_style = cap_style;}
 		/**
 		 * Get the trailing cap style
 		 *
@@ -448,6 +452,74 @@ namespace tbx
 		int y;
 	};
 
+	/**
+	 * Path made of straight lines created by flattening a DrawPath.
+	 *
+	 * The points for all the subpaths are stored together in
+	 * the order they were added.
+	 */
+	class DrawFlatPath
+	{
+	public:
+		/**
+		 * Information on a subpath
+		 */
+		struct Subpath
+		{
+			unsigned int first; //!< Index of the first point of the subpath
+			unsigned int count; //!< Number of points in the subpath
+			bool closed;        //!< true if the subpath was closed
+			bool close_line;    //!< true if the subpath was closed with a line
+			bool internal;      //!< true if the subpath does not affect winding numbers
+		};
+
+	private:
+		std::vector<Point> _points;
+		std::vector<bool> _drawn;
+		std::vector<Subpath> _subpaths;
+		bool _open;
+
+	public:
+		DrawFlatPath() : _open(false) {}
+
+		void clear();
+		void move(int x, int y, bool internal = false);
+		void line(int x, int y, bool drawn = true);
+		void close(bool line);
+
+		/**
+		 * Check if the path has no subpaths
+		 */
+		bool empty() const {return _subpaths.empty();}
+		/**
+		 * Get the number of subpaths
+		 */
+		unsigned int subpath_count() const {return _subpaths.size();}
+		/**
+		 * Get information on a subpath
+		 *
+		 * @param index index of the subpath from 0 to subpath_count()-1
+		 */
+		const Subpath &subpath(unsigned int index) const {return _subpaths[index];}
+		/**
+		 * Get the total number of points in all the subpaths
+		 */
+		unsigned int point_count() const {return _points.size();}
+		/**
+		 * Get a point
+		 *
+		 * @param index index of the point from 0 to point_count()-1
+		 */
+		const Point &point(unsigned int index) const {return _points[index];}
+		/**
+		 * Check if the line to a point is drawn when the path is stroked
+		 *
+		 * @param index index of the point from 0 to point_count()-1
+		 * @returns false if the point starts a subpath or was reached by a gap
+		 */
+		bool drawn(unsigned int index) const {return _drawn[index];}
+	};
+
 	/**
 	 * Class to represent, display and manipulate a graphical
 	 * path used by the Draw RISC OS module.
@@ -468,10 +540,35 @@ namespace tbx
 		int _size;
 		int _capacity;
 
+		//! @cond INTERNAL
+		/**
+		 * Bounds calculated for the last transform used
+		 */
+		struct BoundsCache
+		{
+			bool valid;
+			bool transformed;
+			DrawTransform transform;
+			bool found;
+			BBox bounds;
+
+			BoundsCache() : valid(false) {}
+			bool matches(const DrawTransform *transform) const;
+			void set(const DrawTransform *transform, bool found, const BBox &bounds);
+		};
+		//! @endcond
+
+		// Geometry cached until the path is changed
+		mutable DrawFlatPath _flat;
+		mutable int _flat_flatness;
+		mutable BoundsCache _bounds_cache;
+		mutable BoundsCache _control_bounds_cache;
+
 		/**
 		 * Helper to ensure an element can be added
 		 */
 		void ensure_space(int needed) { if (_size + needed > _capacity) capacity(_size + needed + 8);}
+		void changed();
 
 	public:
 		DrawPath(int capacity = 64);
@@ -495,6 +592,26 @@ namespace tbx
 
 		void circle(int x, int y, int radius);
 
+		/**
+		 * Get the path data in the format used by the Draw module
+		 */
+		const int *data() const {return _data;}
+		/**
+		 * Get the size of the path data in words (1 word = 4 bytes)
+		 */
+		int size() const {return _size;}
+
+		void flatten(DrawFlatPath &flat, int flatness = 0, const DrawTransform *transform = 0) const;
+		const DrawFlatPath &flattened(int flatness = 0) const;
+
+		bool bounds(BBox &box, const DrawTransform *transform = 0) const;
+		bool control_bounds(BBox &box, const DrawTransform *transform = 0) const;
+
+		int winding_number(const Point &pt, int flatness = 0) const;
+		bool contains(const Point &pt, DrawFillStyle fill_style = WINDING_NON_ZERO, int flatness = 0) const;
+		bool contains(const BBox &box, DrawFillStyle fill_style = WINDING_NON_ZERO, int flatness = 0) const;
+		bool intersects(const BBox &box, DrawFillStyle fill_style = WINDING_NON_ZERO, int flatness = 0) const;
+
 		void fill(DrawFillStyle fill_style = WINDING_NON_ZERO, DrawTransform *transform = 0, int flatness = 0) const;
 		void stroke(DrawFillStyle fill_style = WINDING_NON_ZERO, DrawTransform *transform = 0, int flatness = 0,
 					  int thickness = 0, DrawCapAndJoin *cap_and_join = 0, DrawDashPattern *dashes = 0) const;
@@ -0,0 +1,765 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "drawrasteriser.h"
+#include <cmath>
+#include <algorithm>
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Point used while building the outline of a stroke
+ */
+struct StrokePoint
+{
+	double x;
+	double y;
+	StrokePoint() {}
+	StrokePoint(double ix, double iy) : x(ix), y(iy) {}
+};
+
+typedef std::vector<StrokePoint> StrokePolygon;
+
+/**
+ * Class to create the outline of a stroke as a set of polygons
+ * that all have the same orientation, so filling them with the
+ * non-zero winding rule plots their union.
+ */
+class StrokeOutline
+{
+	double _hw;
+	double _tolerance;
+	DrawCapAndJoin::JoinStyle _join;
+	DrawCapAndJoin::CapStyle _leading_cap;
+	DrawCapAndJoin::CapStyle _trailing_cap;
+	double _mitre_limit;
+	double _leading_tri_width, _leading_tri_length;
+	double _trailing_tri_width, _trailing_tri_length;
+	std::vector<StrokePolygon> &_polygons;
+
+public:
+	/**
+	 * Construct the outline builder
+	 *
+	 * @param thickness width of the line
+	 * @param tolerance maximum distance from a round join or cap
+	 * @param cj cap and join styles
+	 * @param mitre_limit mitre limit from the cap and join styles
+	 * @param polygons vector to receive the polygons
+	 */
+	StrokeOutline(double thickness, double tolerance, const DrawCapAndJoin &cj, double mitre_limit, std::vector<StrokePolygon> &polygons) :
+		_hw(thickness / 2), _tolerance(tolerance),
+		_join(cj.join()), _leading_cap(cj.leading_cap()), _trailing_cap(cj.trailing_cap()),
+		_mitre_limit(mitre_limit), _polygons(polygons)
+	{
+		_leading_tri_width = thickness * cj.leading_cap_width() / 256.0;
+		_leading_tri_length = thickness * cj.leading_cap_length() / 256.0;
+		_trailing_tri_width = thickness * cj.trailing_cap_width() / 256.0;
+		_trailing_tri_length = thickness * cj.trailing_cap_length() / 256.0;
+	}
+
+	void run(const StrokePolygon &line, bool closed);
+
+private:
+	void segment(const StrokePoint &a, const StrokePoint &b);
+	void join(const StrokePoint &a, const StrokePoint &v, const StrokePoint &b);
+	void cap(const StrokePoint &p, const StrokePoint &from, DrawCapAndJoin::CapStyle style, double tri_width, double tri_length);
+	void disc(const StrokePoint &c);
+	void add(StrokePolygon &polygon);
+};
+
+/**
+ * Add the outline of a line through a sequence of points
+ *
+ * @param line points on the line
+ * @param closed true if the last point joins to the first
+ */
+void StrokeOutline::run(const StrokePolygon &line, bool closed)
+{
+	StrokePolygon pts;
+	for (StrokePolygon::const_iterator i = line.begin(); i != line.end(); ++i)
+	{
+		if (pts.empty() || pts.back().x != i->x || pts.back().y != i->y) pts.push_back(*i);
+	}
+	if (closed && pts.size() > 1 && pts.back().x == pts.front().x && pts.back().y == pts.front().y)
+	{
+		pts.pop_back();
+	}
+	unsigned int n = pts.size();
+	if (n == 0) return;
+
+	if (n == 1)
+	{
+		// A dot is only visible with round or square caps
+		if (_leading_cap == DrawCapAndJoin::ROUND_CAPS) disc(pts[0]);
+		else if (_leading_cap == DrawCapAndJoin::SQUARE_CAPS)
+		{
+			StrokePolygon square;
+			square.push_back(StrokePoint(pts[0].x - _hw, pts[0].y - _hw));
+			square.push_back(StrokePoint(pts[0].x + _hw, pts[0].y - _hw));
+			square.push_back(StrokePoint(pts[0].x + _hw, pts[0].y + _hw));
+			square.push_back(StrokePoint(pts[0].x - _hw, pts[0].y + _hw));
+			add(square);
+		}
+		return;
+	}
+
+	for (unsigned int i = 0; i + 1 < n; i++) segment(pts[i], pts[i+1]);
+	for (unsigned int i = 1; i + 1 < n; i++) join(pts[i-1], pts[i], pts[i+1]);
+
+	if (closed && n > 2)
+	{
+		segment(pts[n-1], pts[0]);
+		join(pts[n-2], pts[n-1], pts[0]);
+		join(pts[n-1], pts[0], pts[1]);
+	} else
+	{
+		cap(pts[0], pts[1], _leading_cap, _leading_tri_width, _leading_tri_length);
+		cap(pts[n-1], pts[n-2], _trailing_cap, _trailing_tri_width, _trailing_tri_length);
+	}
+}
+
+/**
+ * Add the rectangle for one line segment
+ */
+void StrokeOutline::segment(const StrokePoint &a, const StrokePoint &b)
+{
+	double dx = b.x - a.x, dy = b.y - a.y;
+	double len = std::sqrt(dx * dx + dy * dy);
+	if (len == 0) return;
+	double nx = -dy * _hw / len, ny = dx * _hw / len;
+
+	StrokePolygon quad;
+	quad.push_back(StrokePoint(a.x + nx, a.y + ny));
+	quad.push_back(StrokePoint(b.x + nx, b.y + ny));
+	quad.push_back(StrokePoint(b.x - nx, b.y - ny));
+	quad.push_back(StrokePoint(a.x - nx, a.y - ny));
+	add(quad);
+}
+
+/**
+ * Add the join between the segments a to v and v to b
+ */
+void StrokeOutline::join(const StrokePoint &a, const StrokePoint &v, const StrokePoint &b)
+{
+	double d1x = v.x - a.x, d1y = v.y - a.y;
+	double d2x = b.x - v.x, d2y = b.y - v.y;
+	double l1 = std::sqrt(d1x * d1x + d1y * d1y);
+	double l2 = std::sqrt(d2x * d2x + d2y * d2y);
+	if (l1 == 0 || l2 == 0) return;
+	d1x /= l1; d1y /= l1;
+	d2x /= l2; d2y /= l2;
+
+	double cross = d1x * d2y - d1y * d2x;
+	double dot = d1x * d2x + d1y * d2y;
+	if (std::fabs(cross) < 1e-9 && dot > 0) return; // Straight on
+
+	if (_join == DrawCapAndJoin::ROUND_JOINS)
+	{
+		disc(v);
+		return;
+	}
+
+	// Only the outside of the corner needs filling
+	double side = (cross > 0) ? -_hw : _hw;
+	StrokePoint p1(v.x - d1y * side, v.y + d1x * side);
+	StrokePoint p2(v.x - d2y * side, v.y + d2x * side);
+	StrokePolygon corner;
+	corner.push_back(v);
+	corner.push_back(p1);
+	if (_join == DrawCapAndJoin::MITRED_JOINS && 1 + dot > 1e-9
+		&& std::sqrt(2 / (1 + dot)) <= _mitre_limit)
+	{
+		corner.push_back(StrokePoint(v.x + (p1.x - v.x + p2.x - v.x) / (1 + dot),
+				v.y + (p1.y - v.y + p2.y - v.y) / (1 + dot)));
+	}
+	corner.push_back(p2);
+	add(corner);
+}
+
+/**
+ * Add a cap to the end of a line
+ *
+ * @param p end point of the line
+ * @param from previous point on the line
+ */
+void StrokeOutline::cap(const StrokePoint &p, const StrokePoint &from, DrawCapAndJoin::CapStyle style, double tri_width, double tri_length)
+{
+	double dx = p.x - from.x, dy = p.y - from.y;
+	double len = std::sqrt(dx * dx + dy * dy);
+	if (len == 0) return;
+	dx /= len; dy /= len;
+	double nx = -dy, ny = dx;
+
+	StrokePolygon shape;
+	switch(style)
+	{
+	case DrawCapAndJoin::BUTT_CAPS:
+		return;
+
+	case DrawCapAndJoin::ROUND_CAPS:
+		disc(p);
+		return;
+
+	case DrawCapAndJoin::SQUARE_CAPS:
+		shape.push_back(StrokePoint(p.x + nx * _hw, p.y + ny * _hw));
+		shape.push_back(StrokePoint(p.x + (nx + dx) * _hw, p.y + (ny + dy) * _hw));
+		shape.push_back(StrokePoint(p.x + (dx - nx) * _hw, p.y + (dy - ny) * _hw));
+		shape.push_back(StrokePoint(p.x - nx * _hw, p.y - ny * _hw));
+		break;
+
+	case DrawCapAndJoin::TRIANGULAR_CAPS:
+		shape.push_back(StrokePoint(p.x + nx * tri_width, p.y + ny * tri_width));
+		shape.push_back(StrokePoint(p.x + dx * tri_length, p.y + dy * tri_length));
+		shape.push_back(StrokePoint(p.x - nx * tri_width, p.y - ny * tri_width));
+		break;
+	}
+	add(shape);
+}
+
+/**
+ * Add a circle with the diameter of the line
+ */
+void StrokeOutline::disc(const StrokePoint &c)
+{
+	int steps = 8;
+	if (_tolerance < _hw)
+	{
+		steps = (int)std::ceil(3.14159265358979 / std::acos(1 - _tolerance / _hw));
+		if (steps < 8) steps = 8;
+		else if (steps > 256) steps = 256;
+	}
+
+	StrokePolygon circle;
+	for (int j = 0; j < steps; j++)
+	{
+		double angle = j * 2 * 3.14159265358979 / steps;
+		circle.push_back(StrokePoint(c.x + _hw * std::cos(angle), c.y + _hw * std::sin(angle)));
+	}
+	add(circle);
+}
+
+/**
+ * Add a polygon to the outline making sure it is anticlockwise
+ */
+void StrokeOutline::add(StrokePolygon &polygon)
+{
+	double area = 0;
+	for (unsigned int j = 0, k = polygon.size() - 1; j < polygon.size(); k = j++)
+	{
+		area += polygon[k].x * polygon[j].y - polygon[j].x * polygon[k].y;
+	}
+	if (area < 0) std::reverse(polygon.begin(), polygon.end());
+	_polygons.push_back(polygon);
+}
+
+/**
+ * Split lines into the dashes of a dash pattern
+ *
+ * @param lines lines to split. They are replaced by the dashes.
+ * @param dashes dash pattern
+ * @param scale amount to scale the dash pattern by
+ */
+static void apply_dashes(std::vector<StrokePolygon> &lines, const DrawDashPattern &dashes, double scale)
+{
+	int count = dashes.count();
+	double total = 0;
+	for (int j = 0; j < count; j++) total += dashes[j] * scale;
+	if (count <= 0 || total <= 0) return;
+
+	std::vector<StrokePolygon> result;
+	for (std::vector<StrokePolygon>::const_iterator line = lines.begin(); line != lines.end(); ++line)
+	{
+		// Pattern restarts for each line
+		int index = 0;
+		bool on = true;
+		double remaining = dashes[0] * scale;
+		double skip = std::fmod(dashes.start() * scale, (count & 1) ? total * 2 : total);
+		while (skip > 0)
+		{
+			if (skip >= remaining)
+			{
+				skip -= remaining;
+				index = (index + 1) % count;
+				on = !on;
+				remaining = dashes[index] * scale;
+			} else
+			{
+				remaining -= skip;
+				skip = 0;
+			}
+		}
+
+		StrokePolygon dash;
+		if (on) dash.push_back(line->front());
+		for (unsigned int j = 1; j < line->size(); j++)
+		{
+			const StrokePoint &a = (*line)[j-1];
+			const StrokePoint &b = (*line)[j];
+			double dx = b.x - a.x, dy = b.y - a.y;
+			double len = std::sqrt(dx * dx + dy * dy);
+			double pos = 0;
+			while (len - pos > remaining)
+			{
+				pos += remaining;
+				StrokePoint pt(a.x + dx * pos / len, a.y + dy * pos / len);
+				if (on)
+				{
+					dash.push_back(pt);
+					result.push_back(dash);
+					dash.clear();
+				} else
+				{
+					dash.push_back(pt);
+				}
+				index = (index + 1) % count;
+				on = !on;
+				remaining = dashes[index] * scale;
+			}
+			remaining -= len - pos;
+			if (on) dash.push_back(b);
+		}
+		if (on && dash.size() > 1) result.push_back(dash);
+	}
+
+	lines.swap(result);
+}
+
+//! @endcond
+
+/**
+ * Construct a rasteriser for a buffer in memory.
+ *
+ * The eig factors default to 1 (2 OS units per pixel) and
+ * the origin to (0,0).
+ *
+ * @param pixels pointer to the top row of the buffer
+ * @param width width of the buffer in pixels
+ * @param height height of the buffer in pixels
+ * @param row_words number of words from the start of one row to the next
+ * or 0 if it is the same as the width.
+ */
+DrawRasteriser::DrawRasteriser(unsigned int *pixels, int width, int height, int row_words /*= 0*/) :
+	_pixels(pixels), _width(width), _height(height),
+	_row_words(row_words ? row_words : width),
+	_x_eig(1), _y_eig(1), _origin(0,0), _pixel(0xFF000000)
+{
+}
+
+/**
+ * Set the eig factors used to convert OS units to pixels
+ *
+ * @param x_eig number of OS units in a pixel horizontally as a power of 2
+ * @param y_eig number of OS units in a pixel vertically as a power of 2
+ */
+void DrawRasteriser::eig_factors(int x_eig, int y_eig)
+{
+	_x_eig = x_eig;
+	_y_eig = y_eig;
+}
+
+/**
+ * Set every pixel in the buffer to the same value
+ *
+ * @param value pixel value to write. Default 0.
+ */
+void DrawRasteriser::clear(unsigned int value /*= 0*/)
+{
+	unsigned int old_pixel = _pixel;
+	_pixel = value;
+	for (int y = 0; y < _height; y++) fill_span(_pixels + y * _row_words, 0, _width);
+	_pixel = old_pixel;
+}
+
+/**
+ * Fill the interior of a path.
+ *
+ * This is the equivalent of DrawPath::fill. Open subpaths are closed,
+ * subpaths started with a MOVE_INTERNAL element are ignored and the
+ * boundary plotting flags in the fill style are not used.
+ *
+ * @param path path to fill
+ * @param fill_style winding rule to use. Default is WINDING_NON_ZERO.
+ * @param transform transform from user units to draw units or 0 for the identity.
+ * @param flatness maximum distance allowed from a bezier curve in user units
+ * or 0 for half a pixel.
+ */
+void DrawRasteriser::fill(const DrawPath &path, DrawFillStyle fill_style /*= WINDING_NON_ZERO*/,
+		const DrawTransform *transform /*= 0*/, int flatness /*= 0*/)
+{
+	DrawFlatPath flat;
+	path.flatten(flat, draw_flatness(transform, flatness), transform);
+
+	_edges.clear();
+	for (unsigned int s = 0; s < flat.subpath_count(); s++)
+	{
+		const DrawFlatPath::Subpath &sub = flat.subpath(s);
+		if (sub.internal || sub.count < 3) continue;
+
+		double first_x, first_y, x0, y0, x1, y1;
+		to_pixels(flat.point(sub.first).x, flat.point(sub.first).y, 0, first_x, first_y);
+		x0 = first_x; y0 = first_y;
+		for (unsigned int p = sub.first + 1; p < sub.first + sub.count; p++)
+		{
+			to_pixels(flat.point(p).x, flat.point(p).y, 0, x1, y1);
+			add_edge(x0, y0, x1, y1);
+			x0 = x1; y0 = y1;
+		}
+		add_edge(x0, y0, first_x, first_y);
+	}
+
+	fill_edges(fill_style & 3);
+}
+
+/**
+ * Plot a line along a path.
+ *
+ * This is the equivalent of DrawPath::stroke. The outline of the
+ * line, caps and joins is always filled as one shape, so each pixel
+ * is only plotted once.
+ *
+ * @param path path to draw
+ * @param transform transform from user units to draw units or 0 for the identity.
+ * @param flatness maximum distance allowed from a bezier curve in user units
+ * or 0 for half a pixel.
+ * @param thickness line thickness in user units or 0 for lines a single pixel wide
+ * @param cap_and_join cap and join style or 0 for round caps and joins
+ * @param dashes dash pattern or 0 for a solid line
+ */
+void DrawRasteriser::stroke(const DrawPath &path, const DrawTransform *transform /*= 0*/, int flatness /*= 0*/,
+		int thickness /*= 0*/, const DrawCapAndJoin *cap_and_join /*= 0*/, const DrawDashPattern *dashes /*= 0*/)
+{
+	// The outline is created in draw units unless the transform would
+	// change the shape of the caps and joins
+	double scale = transform_scale(transform);
+	bool draw_units = (thickness == 0 || transform == 0
+		|| (transform->a.bits() == transform->d.bits() && transform->b.bits() == -transform->c.bits())
+		|| (transform->a.bits() == -transform->d.bits() && transform->b.bits() == transform->c.bits()));
+	double line_scale, tolerance;
+	DrawFlatPath flat;
+
+	if (draw_units)
+	{
+		int draw_flat = draw_flatness(transform, flatness);
+		path.flatten(flat, draw_flat, transform);
+		line_scale = scale;
+		tolerance = draw_flat;
+	} else
+	{
+		if (flatness == 0)
+		{
+			flatness = (int)(draw_flatness(transform, 0) / scale);
+			if (flatness < 1) flatness = 1;
+		}
+		path.flatten(flat, flatness);
+		line_scale = 1;
+		tolerance = flatness;
+	}
+
+	// Split the path into the lines that are drawn
+	std::vector<StrokePolygon> lines;
+	std::vector<bool> closed;
+	for (unsigned int s = 0; s < flat.subpath_count(); s++)
+	{
+		const DrawFlatPath::Subpath &sub = flat.subpath(s);
+		bool all_drawn = true;
+		StrokePolygon line;
+		for (unsigned int p = sub.first; p < sub.first + sub.count; p++)
+		{
+			const Point &pt = flat.point(p);
+			if (p > sub.first && !flat.drawn(p))
+			{
+				all_drawn = false;
+				if (line.size() > 1)
+				{
+					lines.push_back(line);
+					closed.push_back(false);
+				}
+				line.clear();
+			}
+			line.push_back(StrokePoint(pt.x, pt.y));
+		}
+		if (sub.close_line)
+		{
+			if (all_drawn && !dashes)
+			{
+				lines.push_back(line);
+				closed.push_back(true);
+				continue;
+			}
+			const Point &pt = flat.point(sub.first);
+			line.push_back(StrokePoint(pt.x, pt.y));
+		}
+		if (line.size() > 1 || sub.count == 1)
+		{
+			lines.push_back(line);
+			closed.push_back(false);
+		}
+	}
+
+	if (dashes)
+	{
+		apply_dashes(lines, *dashes, line_scale);
+		closed.assign(lines.size(), false);
+	}
+
+	std::vector<StrokePolygon> outline;
+	if (thickness > 0)
+	{
+		// Create outline then convert it to pixels
+		DrawCapAndJoin round;
+		const DrawCapAndJoin &cj = cap_and_join ? *cap_and_join : round;
+		StrokeOutline builder(thickness * line_scale, tolerance, cj, double(cj._mitre_limit), outline);
+		for (unsigned int j = 0; j < lines.size(); j++) builder.run(lines[j], closed[j]);
+
+		for (std::vector<StrokePolygon>::iterator poly = outline.begin(); poly != outline.end(); ++poly)
+		{
+			for (StrokePolygon::iterator pt = poly->begin(); pt != poly->end(); ++pt)
+			{
+				to_pixels(pt->x, pt->y, draw_units ? 0 : transform, pt->x, pt->y);
+			}
+		}
+	} else
+	{
+		// Single pixel lines are created in pixel coordinates
+		DrawCapAndJoin thin;
+		thin.join(DrawCapAndJoin::BEVELLED_JOINS);
+		thin.leading_cap(DrawCapAndJoin::SQUARE_CAPS);
+		thin.trailing_cap(DrawCapAndJoin::SQUARE_CAPS);
+		StrokeOutline builder(1.0, 0.25, thin, 1.0, outline);
+		for (unsigned int j = 0; j < lines.size(); j++)
+		{
+			for (StrokePolygon::iterator pt = lines[j].begin(); pt != lines[j].end(); ++pt)
+			{
+				to_pixels(pt->x, pt->y, 0, pt->x, pt->y);
+			}
+			builder.run(lines[j], closed[j]);
+		}
+	}
+
+	_edges.clear();
+	for (std::vector<StrokePolygon>::const_iterator poly = outline.begin(); poly != outline.end(); ++poly)
+	{
+		for (unsigned int j = 0, k = poly->size() - 1; j < poly->size(); k = j++)
+		{
+			add_edge((*poly)[k].x, (*poly)[k].y, (*poly)[j].x, (*poly)[j].y);
+		}
+	}
+
+	fill_edges(WINDING_NON_ZERO);
+}
+
+/**
+ * Get the largest amount a transform scales a distance by
+ */
+double DrawRasteriser::transform_scale(const DrawTransform *transform)
+{
+	if (transform == 0) return 1.0;
+	double a = transform->a, b = transform->b, c = transform->c, d = transform->d;
+	return std::max(std::sqrt(a * a + b * b), std::sqrt(c * c + d * d));
+}
+
+/**
+ * Get the flatness to use after the transform is applied
+ *
+ * @param transform transform applied or 0 for the identity
+ * @param flatness flatness in user units or 0 for half a pixel
+ * @returns flatness in draw units
+ */
+int DrawRasteriser::draw_flatness(const DrawTransform *transform, int flatness) const
+{
+	double draw_flat;
+	if (flatness) draw_flat = flatness * transform_scale(transform);
+	else draw_flat = double(128 << std::min(_x_eig, _y_eig));
+	return (draw_flat < 1) ? 1 : (int)draw_flat;
+}
+
+/**
+ * Convert a point to pixels
+ *
+ * The pixel coordinates have their origin at the bottom left of
+ * the buffer with the centre of the first pixel at (0.5,0.5).
+ *
+ * @param ux x coordinate to convert
+ * @param uy y coordinate to convert
+ * @param transform transform to draw units or 0 if the point is in draw units
+ * @param x updated to the pixel x coordinate
+ * @param y updated to the pixel y coordinate
+ */
+void DrawRasteriser::to_pixels(double ux, double uy, const DrawTransform *transform, double &x, double &y) const
+{
+	double dx = ux, dy = uy;
+	if (transform)
+	{
+		dx = (double(transform->a.bits()) * ux + double(transform->c.bits()) * uy) / 65536.0 + transform->e;
+		dy = (double(transform->b.bits()) * ux + double(transform->d.bits()) * uy) / 65536.0 + transform->f;
+	}
+	x = (dx - _origin.x * 256.0) / double(256 << _x_eig);
+	y = (dy - _origin.y * 256.0) / double(256 << _y_eig);
+}
+
+/**
+ * Add an edge to the edge table
+ */
+void DrawRasteriser::add_edge(double x0, double y0, double x1, double y1)
+{
+	if (y0 == y1) return; // Horizontal edges never cross a scan line
+
+	Edge edge;
+	if (y0 < y1)
+	{
+		edge.x0 = x0;
+		edge.y0 = y0;
+		edge.y1 = y1;
+		edge.dir = -1;
+	} else
+	{
+		edge.x0 = x1;
+		edge.y0 = y1;
+		edge.y1 = y0;
+		edge.dir = 1;
+	}
+	edge.dxdy = (x1 - x0) / (y1 - y0);
+	_edges.push_back(edge);
+}
+
+/**
+ * Fill the shape in the edge table using an active edge table
+ * to find the spans on each row.
+ *
+ * @param winding winding rule from the fill style
+ */
+void DrawRasteriser::fill_edges(int winding)
+{
+	if (_edges.empty()) return;
+
+	std::sort(_edges.begin(), _edges.end());
+	double max_y = _edges[0].y1;
+	for (std::vector<Edge>::const_iterator e = _edges.begin(); e != _edges.end(); ++e)
+	{
+		if (e->y1 > max_y) max_y = e->y1;
+	}
+
+	// Rows whose centre is inside the edges
+	int first_row = (int)std::ceil(_edges[0].y0 - 0.5);
+	int last_row = (int)std::ceil(max_y - 0.5) - 1;
+	if (first_row < 0) first_row = 0;
+	if (last_row >= _height) last_row = _height - 1;
+
+	std::vector<double> xs;
+	unsigned int next_edge = 0;
+	_active.clear();
+
+	for (int row = first_row; row <= last_row; row++)
+	{
+		double yc = row + 0.5;
+
+		// Add edges that start on or below this row and drop those that have ended
+		while (next_edge < _edges.size() && _edges[next_edge].y0 <= yc)
+		{
+			_active.push_back(&_edges[next_edge++]);
+		}
+		unsigned int keep = 0;
+		for (unsigned int j = 0; j < _active.size(); j++)
+		{
+			if (_active[j]->y1 > yc) _active[keep++] = _active[j];
+		}
+		_active.resize(keep);
+		if (keep == 0) continue;
+
+		// Find crossings and insertion sort them as they are nearly sorted from the last row
+		xs.resize(keep);
+		for (unsigned int j = 0; j < keep; j++)
+		{
+			const Edge *edge = _active[j];
+			double x = edge->x0 + (yc - edge->y0) * edge->dxdy;
+			unsigned int k = j;
+			while (k > 0 && xs[k-1] > x)
+			{
+				xs[k] = xs[k-1];
+				_active[k] = _active[k-1];
+				k--;
+			}
+			xs[k] = x;
+			_active[k] = edge;
+		}
+
+		unsigned int *row_pixels = _pixels + (_height - 1 - row) * _row_words;
+		int wind = 0;
+		double span_start = 0;
+		for (unsigned int j = 0; j < keep; j++)
+		{
+			bool was_inside, inside;
+			int new_wind = wind + _active[j]->dir;
+			switch(winding)
+			{
+			case WINDING_NEGATIVE: was_inside = (wind < 0); inside = (new_wind < 0); break;
+			case WINDING_EVEN_ODD: was_inside = (wind & 1); inside = (new_wind & 1); break;
+			case WINDING_POSITIVE: was_inside = (wind > 0); inside = (new_wind > 0); break;
+			default: was_inside = (wind != 0); inside = (new_wind != 0); break;
+			}
+			if (!was_inside && inside) span_start = xs[j];
+			else if (was_inside && !inside)
+			{
+				fill_span(row_pixels, (int)std::ceil(span_start - 0.5), (int)std::ceil(xs[j] - 0.5));
+			}
+			wind = new_wind;
+		}
+	}
+}
+
+/**
+ * Set the pixels in part of a row
+ *
+ * The loop writes four words at a time so the compiler can
+ * use multiple register or vector stores.
+ *
+ * @param row start of the row
+ * @param x0 first pixel to set
+ * @param x1 pixel after the last pixel to set
+ */
+void DrawRasteriser::fill_span(unsigned int *row, int x0, int x1) const
+{
+	if (x0 < 0) x0 = 0;
+	if (x1 > _width) x1 = _width;
+	if (x0 >= x1) return;
+
+	unsigned int value = _pixel;
+	unsigned int *p = row + x0;
+	unsigned int *end = row + x1;
+	while (end - p >= 4)
+	{
+		p[0] = value;
+		p[1] = value;
+		p[2] = value;
+		p[3] = value;
+		p += 4;
+	}
+	while (p < end) *p++ = value;
+}
+
+}
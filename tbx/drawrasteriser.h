@@ -0,0 +1,154 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_DRAWRASTERISER_H_
+#define TBX_DRAWRASTERISER_H_
+
+#include "drawpath.h"
+#include "colour.h"
+#include <vector>
+
+namespace tbx
+{
+	/**
+	 * Class to fill and stroke a DrawPath into a 32 bits per pixel
+	 * buffer in memory without using the Draw module.
+	 *
+	 * The buffer is laid out like the image of a 32bpp sprite, with
+	 * the top row first and each pixel a word in the format 0xAABBGGRR.
+	 * On a little endian machine this is the same as RGBA bytes.
+	 *
+	 * Paths are transformed to draw units (1/256th of an OS unit)
+	 * like the Draw module, then mapped to pixels using the origin
+	 * and eig factors. A pixel is plotted if its centre is inside
+	 * the shape being filled.
+	 */
+	class DrawRasteriser
+	{
+	public:
+		DrawRasteriser(unsigned int *pixels, int width, int height, int row_words = 0);
+
+		/**
+		 * Get the width of the buffer in pixels
+		 */
+		int width() const {return _width;}
+		/**
+		 * Get the height of the buffer in pixels
+		 */
+		int height() const {return _height;}
+		/**
+		 * Get the number of words between the start of each row in the buffer
+		 */
+		int row_words() const {return _row_words;}
+		/**
+		 * Get the pixel buffer
+		 */
+		unsigned int *pixels() const {return _pixels;}
+
+		void eig_factors(int x_eig, int y_eig);
+		/**
+		 * Get the x eig factor.
+		 *
+		 * @returns the number of OS units in a pixel as a power of 2
+		 */
+		int x_eig() const {return _x_eig;}
+		/**
+		 * Get the y eig factor.
+		 *
+		 * @returns the number of OS units in a pixel as a power of 2
+		 */
+		int y_eig() const {return _y_eig;}
+
+		/**
+		 * Set the position of the bottom left of the buffer
+		 *
+		 * @param pos position in OS units. Default (0,0).
+		 */
+		void origin(const Point &pos) {_origin = pos;}
+		/**
+		 * Get the position of the bottom left of the buffer
+		 *
+		 * @returns position in OS units
+		 */
+		const Point &origin() const {return _origin;}
+
+		/**
+		 * Set the word written to the buffer for each pixel plotted
+		 */
+		void pixel(unsigned int value) {_pixel = value;}
+		/**
+		 * Get the word written to the buffer for each pixel plotted
+		 */
+		unsigned int pixel() const {return _pixel;}
+		/**
+		 * Set the pixel value to plot from a colour.
+		 *
+		 * The alpha of the pixel is set to 255 (opaque).
+		 *
+		 * @param colour colour to plot
+		 */
+		void colour(const Colour &colour) {_pixel = (((unsigned)colour) >> 8) | 0xFF000000;}
+
+		void clear(unsigned int value = 0);
+
+		void fill(const DrawPath &path, DrawFillStyle fill_style = WINDING_NON_ZERO,
+				const DrawTransform *transform = 0, int flatness = 0);
+		void stroke(const DrawPath &path, const DrawTransform *transform = 0, int flatness = 0,
+				int thickness = 0, const DrawCapAndJoin *cap_and_join = 0, const DrawDashPattern *dashes = 0);
+
+	private:
+		//! @cond INTERNAL
+		struct Edge
+		{
+			double x0;   // x at y0
+			double y0;   // bottom of edge
+			double y1;   // top of edge
+			double dxdy; // change in x for each unit of y
+			int dir;     // change in winding number crossing edge from left to right
+
+			bool operator<(const Edge &other) const {return y0 < other.y0;}
+		};
+		//! @endcond
+
+		unsigned int *_pixels;
+		int _width;
+		int _height;
+		int _row_words;
+		int _x_eig;
+		int _y_eig;
+		Point _origin;
+		unsigned int _pixel;
+		std::vector<Edge> _edges;
+		std::vector<const Edge *> _active;
+
+		static double transform_scale(const DrawTransform *transform);
+		int draw_flatness(const DrawTransform *transform, int flatness) const;
+		void to_pixels(double ux, double uy, const DrawTransform *transform, double &x, double &y) const;
+		void add_edge(double x0, double y0, double x1, double y1);
+		void fill_edges(int winding);
+		void fill_span(unsigned int *row, int x0, int x1) const;
+	};
+}
+
+#endif /* TBX_DRAWRASTERISER_H_ */
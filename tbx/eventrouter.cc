@@ -29,6 +29,7 @@
 #include "component.h"
 #include "wimpmessagelistener.h"
 #include "redrawlistener.h"
+#include "deferredredraw.h"
 #include "openwindowlistener.h"
 #include "closewindowlistener.h"
 #include "pointerlistener.h"
@@ -44,6 +45,7 @@
 #include "monotonictime.h"
 #include "timer.h"
 #include "postpolllistener.h"
+#include "pollstats.h"
 
 #include <cstring>
 #include <kernel.h>
@@ -68,8 +70,9 @@ namespace tbx
 EventRouter::EventRouter()
 {
 	_instance = this;
-	_running_object_item = 0;
+	_dispatching_object_events = 0;
 	_remove_running = false;
+	_window_event_listeners = 0;
     _poll_mask = 1; // No Null events
 
     _autocreate_listeners = 0;
@@ -80,10 +83,9 @@ EventRouter::EventRouter()
 
     _drag_handler = 0;
 
-    _first_timer = 0;
-
     _catch_exceptions = true;
     _post_poll_listener = 0;
+    _poll_stats = 0;
 }
 
 EventRouter::~EventRouter()
@@ -94,18 +96,25 @@ void EventRouter::poll()
 {
     _kernel_swi_regs regs;
 	int poll = Wimp_Poll;
+
+	if (!_deferred_redraws.empty()) flush_deferred_redraws();
+
     regs.r[0] = _poll_mask;
     regs.r[1] = reinterpret_cast<int>(&_poll_block);
 
-    if ((_poll_mask & 1) && _first_timer)
+    if ((_poll_mask & 1) && !_jobs.empty())
+    {
+    	// Background jobs run on every null event
+    	regs.r[0] &= ~1;
+    } else if ((_poll_mask & 1) && !_timers.empty())
     {
     	// Use PollIdle if we have a timer in the future.
     	regs.r[0] &= ~1; // Ensure null events are processed
     	unsigned int now = monotonic_time();
-    	if (monotonic_lt(now, _first_timer->due))
+    	if (monotonic_lt(now, _timers.next_due()))
     	{
     		poll = Wimp_PollIdle;
-			regs.r[2] = _first_timer->due;
+			regs.r[2] = _timers.next_due();
     	}
     }
 
@@ -119,6 +128,15 @@ void EventRouter::poll()
            _post_poll_listener->post_poll(regs.r[0], _poll_block, _id_block, _reply_to);
         }
 
+        // Read before dispatch as handlers can reuse the poll block
+        unsigned int start_time = 0;
+        int stats_code = 0;
+        if (_poll_stats)
+        {
+        	start_time = _poll_stats->now();
+        	stats_code = PollStats::event_code(regs.r[0], _poll_block);
+        }
+
     	if (_catch_exceptions)
     	{
 			try
@@ -135,6 +153,8 @@ void EventRouter::poll()
     	{
     		route_event(regs.r[0]);
     	}
+
+    	if (_poll_stats) _poll_stats->processed(regs.r[0], stats_code, start_time);
 	}
 }
 
@@ -263,124 +283,122 @@ bool EventRouter::process_toolbox_event(ObjectId object_id, ComponentId comp_id)
 {
 	int action = _poll_block.word[2];
 	bool handled = false;
-	ObjectListenerItem *item = find_first_object_listener(object_id, action);
+	ObjectListenerList *list = _object_listeners.find(object_id, action);
+	if (list == 0) return false;
 
-	while (item && item->action == action)
+	// Listeners removed while dispatching are only marked as removed
+	// and the list is tidied up at the end
+	_dispatching_object_events++;
+	try
 	{
-		if (item->component_id == comp_id || item->component_id == NULL_ComponentId)
+		for (unsigned int i = 0; list != 0 && i < list->size(); i++)
 		{
-			_running_object_item = item;
-			handled = true;
-			(*item->handler)(_id_block, _poll_block, item->listener);
-			item = item->next;
-			if (_remove_running)
+			ObjectListenerItem &item = (*list)[i];
+			if (item.handler != 0
+				&& (item.component_id == comp_id || item.component_id == NULL_ComponentId))
 			{
-				ObjectListenerItem *remove_item = _running_object_item;
-				_remove_running = false;
-				_running_object_item = 0;
-				remove_object_listener(object_id, remove_item->component_id, remove_item->action, remove_item->listener);
-			} else
-				_running_object_item = 0;
-		} else
-			item = item->next;
+				handled = true;
+				(*item.handler)(_id_block, _poll_block, item.listener);
+				// Listeners may have been added or removed so find list again
+				list = _object_listeners.find(object_id, action);
+			}
+		}
+	} catch(...)
+	{
+		end_object_dispatch();
+		throw;
 	}
+	end_object_dispatch();
 
 	return handled;
 }
 
-EventRouter::ObjectListenerItem *EventRouter::find_first_object_listener(ObjectId handle, int action)
+/*
+ * Finish dispatching object events and tidy up any lists
+ * where listeners were removed during the dispatch.
+ */
+void EventRouter::end_object_dispatch()
 {
-	std::map<ObjectId, ObjectListenerItem *>::iterator found = _object_listeners.find(handle);
-	ObjectListenerItem *item = 0;
-
-	if (found != _object_listeners.end())
+	if (--_dispatching_object_events == 0 && !_object_lists_to_compact.empty())
 	{
-		item = found->second;
-		while (item && action != item->action)
+		std::vector<std::pair<ObjectId, int> > to_compact;
+		to_compact.swap(_object_lists_to_compact);
+		for (std::vector<std::pair<ObjectId, int> >::iterator i = to_compact.begin();
+				i != to_compact.end(); ++i)
 		{
-			item = item->next;
+			ObjectListenerList *list = _object_listeners.find(i->first, i->second);
+			if (list)
+			{
+				unsigned int keep = 0;
+				for (unsigned int j = 0; j < list->size(); j++)
+				{
+					if ((*list)[j].handler != 0) (*list)[keep++] = (*list)[j];
+				}
+				list->resize(keep);
+				if (keep == 0) remove_object_action(i->first, i->second);
+			}
 		}
 	}
-
-	return item;
 }
 
-void EventRouter::add_object_listener(ObjectId handle, ComponentId component_id, int action, Listener *listener, RawToolboxEventHandler handler)
+/*
+ * Remove a listener from a list of object listeners
+ */
+void EventRouter::remove_object_listener_item(ObjectId handle, int action, ObjectListenerList &list, unsigned int index)
 {
-	ObjectListenerItem *new_item = new ObjectListenerItem;
-	new_item->component_id = component_id;
-	new_item->action = action;
-	new_item->listener = listener;
-	new_item->handler = handler;
-	new_item->next = 0;
-
-	std::map<ObjectId, ObjectListenerItem *>::iterator found = _object_listeners.find(handle);
-	if (found == _object_listeners.end())
-	{
-		_object_listeners[handle] = new_item;
-	} else
+	if (_dispatching_object_events)
 	{
-		ObjectListenerItem *item = found->second;
-		ObjectListenerItem *prev = 0;
-		while (item && item->action <= action)
+		if (list[index].handler != 0)
 		{
-			prev = item;
-			item = item->next;
-		}
-		if (item == 0)
-		{
-			prev->next = new_item;
-		} else if (prev == 0)
-		{
-			new_item->next = item;
-			_object_listeners[handle] = new_item;
-		} else
-		{
-			new_item->next = item;
-			prev->next = new_item;
+			list[index].handler = 0;
+			_object_lists_to_compact.push_back(std::pair<ObjectId, int>(handle, action));
 		}
+	} else
+	{
+		list.erase(list.begin() + index);
+		if (list.empty()) remove_object_action(handle, action);
 	}
 }
 
-void EventRouter::remove_object_listener(ObjectId handle, ComponentId component_id, int action, Listener *listener)
+/*
+ * Remove the listener list for an object and action
+ */
+void EventRouter::remove_object_action(ObjectId handle, int action)
 {
-	std::map<ObjectId, ObjectListenerItem *>::iterator found = _object_listeners.find(handle);
-	if (found != _object_listeners.end())
+	_object_listeners.erase(handle, action);
+	std::vector<int> *actions = _object_actions.find(handle, 0);
+	if (actions)
 	{
-		ObjectListenerItem *item = found->second;
-		ObjectListenerItem *prev = 0;
+		std::vector<int>::iterator found = std::find(actions->begin(), actions->end(), action);
+		if (found != actions->end()) actions->erase(found);
+		if (actions->empty()) _object_actions.erase(handle, 0);
+	}
+}
 
-        while (item && item->action < action)
-		{
-			prev = item;
-			item = item->next;
-		}
-		while (item && item->action == action
-				&& (item->listener != listener || item->component_id != component_id))
-		{
-			prev = item;
-			item = item->next;
-		}
-		if (item && item->action == action && item->listener == listener && item->component_id == component_id)
+void EventRouter::add_object_listener(ObjectId handle, ComponentId component_id, int action, Listener *listener, RawToolboxEventHandler handler)
+{
+	ObjectListenerItem new_item;
+	new_item.component_id = component_id;
+	new_item.listener = listener;
+	new_item.handler = handler;
+
+	ObjectListenerList &list = _object_listeners.insert(handle, action);
+	if (list.empty()) _object_actions.insert(handle, 0).push_back(action);
+	list.push_back(new_item);
+}
+
+void EventRouter::remove_object_listener(ObjectId handle, ComponentId component_id, int action, Listener *listener)
+{
+	ObjectListenerList *list = _object_listeners.find(handle, action);
+	if (list)
+	{
+		for (unsigned int i = 0; i < list->size(); i++)
 		{
-			if (item == _running_object_item) _remove_running = true;
-			else
+			ObjectListenerItem &item = (*list)[i];
+			if (item.handler != 0 && item.listener == listener && item.component_id == component_id)
 			{
-				if (prev == 0)
-				{
-					if (item->next == 0)
-					{
-						_object_listeners.erase(handle);
-					} else
-					{
-						_object_listeners[handle] = item->next;
-					}
-				} else
-				{
-					prev->next = item->next;
-					item->next = 0;
-				}
-				delete item;
+				remove_object_listener_item(handle, action, *list, i);
+				break;
 			}
 		}
 	}
@@ -391,7 +409,16 @@ void EventRouter::remove_object_listener(ObjectId handle, ComponentId component_
  */
 void EventRouter::set_object_handler(ObjectId handle, int action, Listener *listener, RawToolboxEventHandler handler)
 {
-	ObjectListenerItem *item = find_first_object_listener(handle, action);
+	ObjectListenerList *list = _object_listeners.find(handle, action);
+	ObjectListenerItem *item = 0;
+	if (list)
+	{
+		for (ObjectListenerList::iterator i = list->begin(); i != list->end() && item == 0; ++i)
+		{
+			if (i->handler != 0) item = &(*i);
+		}
+	}
+
 	if (item == 0)
 	{
 		if (listener != 0)
@@ -410,40 +437,37 @@ void EventRouter::set_object_handler(ObjectId handle, int action, Listener *list
 
 void EventRouter::remove_all_listeners(ObjectId handle)
 {
-	std::map<ObjectId, ObjectListenerItem *>::iterator found = _object_listeners.find(handle);
-	if (found != _object_listeners.end())
+	std::vector<int> *found_actions = _object_actions.find(handle, 0);
+	if (found_actions)
 	{
-		ObjectListenerItem *item = found->second;
-		ObjectListenerItem *running = 0;
-		while (item)
+		std::vector<int> actions(*found_actions);
+		for (std::vector<int>::iterator a = actions.begin(); a != actions.end(); ++a)
 		{
-			ObjectListenerItem *next = item->next;
-			if (item == _running_object_item)
+			if (_dispatching_object_events)
 			{
-				item->next = 0;
-				running = item;
-				_remove_running = true;
+				ObjectListenerList *list = _object_listeners.find(handle, *a);
+				for (unsigned int i = 0; list != 0 && i < list->size(); i++)
+				{
+					remove_object_listener_item(handle, *a, *list, i);
+				}
 			} else
-				delete item;
-			item = next;
+			{
+				_object_listeners.erase(handle, *a);
+			}
 		}
-
-		if (running)
-		{
-			_object_listeners[handle] = running;
-		} else
-			_object_listeners.erase(handle);
+		if (!_dispatching_object_events) _object_actions.erase(handle, 0);
 	}
 
 	if (_window_event_listeners)
 	{
-		std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(handle);
-		if (found != _window_event_listeners->end())
+		WindowEventListenerItem ***found = _window_event_listeners->find(handle, 0);
+		if (found)
 		{
+			WindowEventListenerItem **items = *found;
 			bool delete_all = true;
 			for (int j = 0; j < MAX_WINDOW_EVENTS; j++)
 			{
-				WindowEventListenerItem *item = found->second[j];
+				WindowEventListenerItem *item = items[j];
 				WindowEventListenerItem *running = 0;
 				while (item)
 				{
@@ -458,12 +482,12 @@ void EventRouter::remove_all_listeners(ObjectId handle)
 						delete item;
 					item = next;
 				}
-				found->second[j] = running;
+				items[j] = running;
 			}
 			if (delete_all)
 			{
-				delete [] found->second;
-				_window_event_listeners->erase(found);
+				delete [] items;
+				_window_event_listeners->erase(handle, 0);
 			}
 		}
 	}
@@ -471,58 +495,42 @@ void EventRouter::remove_all_listeners(ObjectId handle)
 
 void EventRouter::remove_all_listeners(ObjectId handle, ComponentId component_id)
 {
-	std::map<ObjectId, ObjectListenerItem *>::iterator found = _object_listeners.find(handle);
-	if (found != _object_listeners.end())
+	std::vector<int> *found_actions = _object_actions.find(handle, 0);
+	if (found_actions)
 	{
-		ObjectListenerItem *old_first = found->second;
-		ObjectListenerItem *item = old_first;
-		ObjectListenerItem *prev = 0;
-		ObjectListenerItem *first = 0;
-
-		while (item)
+		std::vector<int> actions(*found_actions);
+		for (std::vector<int>::iterator a = actions.begin(); a != actions.end(); ++a)
 		{
-			ObjectListenerItem *next = item->next;
-			if (item->component_id == component_id)
+			ObjectListenerList *list = _object_listeners.find(handle, *a);
+			unsigned int i = 0;
+			while (list && i < list->size())
 			{
-				if (item == _running_object_item)
-				{
-					if (first == 0) first = item;
-					prev = item;
-					_remove_running = true;
-				} else
+				if ((*list)[i].handler != 0 && (*list)[i].component_id == component_id)
 				{
-					if (prev) prev->next = next;
-					delete item;
+					remove_object_listener_item(handle, *a, *list, i);
+					if (!_dispatching_object_events)
+					{
+						// Item has been erased so stay at the same index
+						list = _object_listeners.find(handle, *a);
+						continue;
+					}
 				}
-			} else
-			{
-				if (first == 0) first = item;
-				prev = item;
+				i++;
 			}
-
-			item = next;
 		}
-
-		if (first)
-		{
-			if (first != old_first)
-			{
-				_object_listeners[handle] = first;
-			}
-		} else
-			_object_listeners.erase(handle);
 	}
 
 	if (_window_event_listeners)
 	{
-		std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(handle);
-		if (found != _window_event_listeners->end())
+		WindowEventListenerItem ***found = _window_event_listeners->find(handle, 0);
+		if (found)
 		{
+			WindowEventListenerItem **items = *found;
 			bool delete_all = true;
 			// Just need to remove mouse_click 5 (6-1) and key press 8 (7-1)
 			for (int j = 5; j < 8; j+=2)
 			{
-				WindowEventListenerItem *item = found->second[j];
+				WindowEventListenerItem *item = items[j];
 				WindowEventListenerItem *prev = find_window_event_component(item, component_id);
 
 				while (item && item->component_id == component_id)
@@ -536,7 +544,7 @@ void EventRouter::remove_all_listeners(ObjectId handle, ComponentId component_id
 					} else
 					{
 						if (prev) prev->next = next;
-						else found->second[j] = next;
+						else items[j] = next;
 						delete item;
 					}
 					item = next;
@@ -544,18 +552,17 @@ void EventRouter::remove_all_listeners(ObjectId handle, ComponentId component_id
 			}
 			for (int j = 0; j < MAX_WINDOW_EVENTS && delete_all; j++)
 			{
-				if (found->second[j] != 0) delete_all = false;
+				if (items[j] != 0) delete_all = false;
 			}
 			if (delete_all)
 			{
-				delete [] found->second;
-				_window_event_listeners->erase(found);
+				delete [] items;
+				_window_event_listeners->erase(handle, 0);
 			}
 		}
 	}
 }
 
-
 void EventRouter::set_autocreate_listener(std::string template_name, AutoCreateListener *listener)
 {
 	if (_autocreate_listeners == 0) _autocreate_listeners = new std::map<std::string, AutoCreateListener*>();
@@ -573,7 +580,32 @@ void EventRouter::clear_autocreate_listener(std::string template_name)
 
 
 /**
- * Run all the null event commands
+ * Ask the WIMP to redraw all the areas collected by DeferredRedraw
+ * objects since the last poll.
+ *
+ * This is called before Wimp_Poll outside of any event handler, so
+ * a window that has been deleted since its areas were collected must
+ * not stop the poll. Its areas are discarded instead.
+ */
+void EventRouter::flush_deferred_redraws()
+{
+	// Flushing removes the object from the list
+	while (!_deferred_redraws.empty())
+	{
+		DeferredRedraw *redraw = _deferred_redraws.back();
+		try
+		{
+			redraw->flush();
+		} catch(OsError &)
+		{
+			redraw->discard();
+		}
+	}
+}
+
+/**
+ * Run all the null event commands, then the timers that are due
+ * and then the background jobs for the rest of their time budget.
  */
 void EventRouter::process_null_event()
 {
@@ -597,34 +629,10 @@ void EventRouter::process_null_event()
 	}
 
 	// Process timers
-	if (_first_timer)
-	{
-		unsigned int now = monotonic_time();
-		unsigned int actual = now; // take into account long timer routines
-		while (_first_timer && monotonic_ge(now, _first_timer->due))
-		{
-			TimerInfo *running = _first_timer;
-			unsigned int diff = monotonic_elapsed(_first_timer->due, actual);
-			_first_timer->timer->timer(diff);
-			if (running == _first_timer)
-			{
-				// Update due time for this timer
-				while (diff > _first_timer->elapsed)
-				{
-					diff -= _first_timer->elapsed;
-					_first_timer->due += _first_timer->elapsed;
-				}
-				_first_timer->due += _first_timer->elapsed;
-				if (_first_timer->next != 0)
-				{
-					_first_timer = _first_timer->next;
-					// Re-add in correct order
-					add_timer_info(running);
-					actual = monotonic_time();
-				}
-			}
-		}
-	}
+	_timers.process();
+
+	// Step background jobs
+	_jobs.process();
 }
 
 /*
@@ -918,10 +926,10 @@ EventRouter::WindowEventListenerItem *EventRouter::find_window_event_listener(Ob
     WindowEventListenerItem *item = 0;
     if (_window_event_listeners != 0)
     {
-       std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(object_id);
-       if (found != _window_event_listeners->end())
+       WindowEventListenerItem ***found = _window_event_listeners->find(object_id, 0);
+       if (found)
        {
-            item = found->second[event_code-1];
+            item = (*found)[event_code-1];
        }
     }
 
@@ -936,20 +944,20 @@ void EventRouter::add_window_event_listener(ObjectId object_id, int event_code,
     new_item->next = 0;
     new_item->component_id = NULL_ComponentId;
 
-    if (_window_event_listeners == 0) _window_event_listeners = new std::map<ObjectId, WindowEventListenerItem **>();
+    if (_window_event_listeners == 0) _window_event_listeners = new EventTable<WindowEventListenerItem **>();
 
-    std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(object_id);
-    if (found == _window_event_listeners->end())
+    WindowEventListenerItem ***found = _window_event_listeners->find(object_id, 0);
+    if (found == 0)
     {
     	WindowEventListenerItem **items = new WindowEventListenerItem*[MAX_WINDOW_EVENTS];
     	for (int j = 0; j < MAX_WINDOW_EVENTS; j++)
     		items[j] = 0;
 
     	items[event_code - 1] = new_item;
-    	(*_window_event_listeners)[object_id] = items;
+    	_window_event_listeners->insert(object_id, 0) = items;
     } else
     {
-    	WindowEventListenerItem *item = found->second[event_code - 1];
+    	WindowEventListenerItem *item = (*found)[event_code - 1];
     	WindowEventListenerItem *prev = 0;
     	while (item)
     	{
@@ -961,7 +969,7 @@ void EventRouter::add_window_event_listener(ObjectId object_id, int event_code,
     		prev->next = new_item;
     	} else
     	{
-    		found->second[event_code - 1] = new_item;
+    		(*found)[event_code - 1] = new_item;
     	}
     }
 }
@@ -975,10 +983,10 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, int event_cod
 {
     if (_window_event_listeners != 0)
     {
-       std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(object_id);
-       if (found != _window_event_listeners->end())
+       WindowEventListenerItem ***found = _window_event_listeners->find(object_id, 0);
+       if (found)
        {
-    	   WindowEventListenerItem *item = found->second[event_code-1];
+    	   WindowEventListenerItem *item = (*found)[event_code-1];
     	   WindowEventListenerItem *prev = 0;
     	   while (item && item->listener != listener && item->component_id != NULL_ComponentId)
     	   {
@@ -988,7 +996,7 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, int event_cod
     	   if (item == _running_window_event_item) _remove_running = true;
     	   else if (item != 0)
     	   {
-    		   if (prev == 0) found->second[event_code-1] = item->next;
+    		   if (prev == 0) (*found)[event_code-1] = item->next;
     		   else prev->next = item->next;
 
     		   if (prev == 0 && item->next == 0)
@@ -997,11 +1005,11 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, int event_cod
     			   // so check if there are any other events
     			   bool delete_all = true;
     			   for (int j = 0; j < MAX_WINDOW_EVENTS && delete_all; j++)
-    				   if (found->second[j]) delete_all = false;
+    				   if ((*found)[j]) delete_all = false;
     			   if (delete_all)
     			   {
-    				   delete [] found->second;
-    				   _window_event_listeners->erase(found);
+    				   delete [] *found;
+    				   _window_event_listeners->erase(object_id, 0);
     			   }
     		   }
 
@@ -1019,20 +1027,20 @@ void EventRouter::add_window_event_listener(ObjectId object_id, ComponentId comp
     new_item->next = 0;
     new_item->component_id = component_id;
 
-    if (_window_event_listeners == 0) _window_event_listeners = new std::map<ObjectId, WindowEventListenerItem **>();
+    if (_window_event_listeners == 0) _window_event_listeners = new EventTable<WindowEventListenerItem **>();
 
-    std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(object_id);
-    if (found == _window_event_listeners->end())
+    WindowEventListenerItem ***found = _window_event_listeners->find(object_id, 0);
+    if (found == 0)
     {
     	WindowEventListenerItem **items = new WindowEventListenerItem*[MAX_WINDOW_EVENTS];
     	for (int j = 0; j < MAX_WINDOW_EVENTS; j++)
     		items[j] = 0;
 
     	items[event_code - 1] = new_item;
-    	(*_window_event_listeners)[object_id] = items;
+    	_window_event_listeners->insert(object_id, 0) = items;
     } else
     {
-    	WindowEventListenerItem *item = found->second[event_code - 1];
+    	WindowEventListenerItem *item = (*found)[event_code - 1];
     	WindowEventListenerItem *prev = 0;
     	while (item && item->component_id != -1
     			&& item->component_id <= component_id)
@@ -1046,7 +1054,7 @@ void EventRouter::add_window_event_listener(ObjectId object_id, ComponentId comp
     		prev->next = new_item;
     	} else
     	{
-    		found->second[event_code - 1] = new_item;
+    		(*found)[event_code - 1] = new_item;
     	}
     }
 }
@@ -1092,10 +1100,10 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, ComponentId c
 {
     if (_window_event_listeners != 0)
     {
-       std::map<ObjectId, WindowEventListenerItem **>::iterator found = _window_event_listeners->find(object_id);
-       if (found != _window_event_listeners->end())
+       WindowEventListenerItem ***found = _window_event_listeners->find(object_id, 0);
+       if (found)
        {
-    	   WindowEventListenerItem *item = found->second[event_code-1];
+    	   WindowEventListenerItem *item = (*found)[event_code-1];
     	   WindowEventListenerItem *prev = find_window_event_component(item, component_id);
 
     	   while (item && item->component_id == component_id
@@ -1109,7 +1117,7 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, ComponentId c
     	   if (item == _running_window_event_item) _remove_running = true;
     	   else if (item != 0)
     	   {
-    		   if (prev == 0) found->second[event_code-1] = item->next;
+    		   if (prev == 0) (*found)[event_code-1] = item->next;
     		   else prev->next = item->next;
 
     		   if (prev == 0 && item->next == 0)
@@ -1118,11 +1126,11 @@ void EventRouter::remove_window_event_listener(ObjectId object_id, ComponentId c
     			   // so check if there are any other events
     			   bool delete_all = true;
     			   for (int j = 0; j < MAX_WINDOW_EVENTS && delete_all; j++)
-    				   if (found->second[j]) delete_all = false;
+    				   if ((*found)[j]) delete_all = false;
     			   if (delete_all)
     			   {
-    				   delete [] found->second;
-    				   _window_event_listeners->erase(found);
+    				   delete [] *found;
+    				   _window_event_listeners->erase(object_id, 0);
     			   }
     		   }
 
@@ -1389,14 +1397,26 @@ void EventRouter::cancel_drag()
  * time later than the elapsed time given.
  *
  * @param elapsed Minimum time between each call to the timer in centiseconds
+ * @param timer timer to call
+ * @returns handle that can be used to remove the timer
  */
-void EventRouter::add_timer(int elapsed, Timer *timer)
+TimerHandle EventRouter::add_timer(int elapsed, Timer *timer)
 {
-	TimerInfo *info = new TimerInfo;
-	info->due = monotonic_time() + elapsed;
-	info->elapsed = elapsed;
-	info->timer = timer;
-	add_timer_info(info);
+	return _timers.add(elapsed, timer, true);
+}
+
+/**
+ * Add a timer that is called once after a given time has elapsed.
+ *
+ * The timer is removed before it is called.
+ *
+ * @param elapsed Minimum time before the timer is called in centiseconds
+ * @param timer timer to call
+ * @returns handle that can be used to remove the timer
+ */
+TimerHandle EventRouter::add_one_shot_timer(int elapsed, Timer *timer)
+{
+	return _timers.add(elapsed, timer, false);
 }
 
 /**
@@ -1404,47 +1424,63 @@ void EventRouter::add_timer(int elapsed, Timer *timer)
  */
 void EventRouter::remove_timer(Timer *timer)
 {
-	TimerInfo *last = 0, *check = _first_timer;
-	while (check && check->timer != timer)
-	{
-		last = check;
-		check = check->next;
-	}
-	if (check)
-	{
-		if (last) last->next = check->next;
-		else _first_timer = check->next;
-		delete check;
-	}
+	_timers.remove(timer);
 }
 
 /**
- * Add internal timer info structure in correct location
+ * Remove timer using the handle returned when it was added
  */
-void EventRouter::add_timer_info(TimerInfo *info)
+void EventRouter::remove_timer(TimerHandle handle)
 {
-	if (_first_timer == 0)
-	{
-		_first_timer = info;
-		info->next = 0;
-	} else
-	{
-		TimerInfo *last = 0, *check = _first_timer;
-		while (check && monotonic_ge(info->due, check->due))
-		{
-			last = check;
-			check = check->next;
-		}
-		if (last == 0)
-		{
-			info->next = _first_timer;
-			_first_timer = info;
-		} else
-		{
-			info->next = last->next;
-			last->next = info;
-		}
-	}
+	_timers.remove(handle);
+}
+
+/**
+ * Add a deferred redraw to be flushed before the next Wimp_Poll
+ */
+void EventRouter::add_deferred_redraw(DeferredRedraw *redraw)
+{
+	_deferred_redraws.push_back(redraw);
+}
+
+/**
+ * Remove a deferred redraw from the list to flush
+ */
+void EventRouter::remove_deferred_redraw(DeferredRedraw *redraw)
+{
+	std::vector<DeferredRedraw *>::iterator found = std::find(_deferred_redraws.begin(), _deferred_redraws.end(), redraw);
+	if (found != _deferred_redraws.end()) _deferred_redraws.erase(found);
+}
+
+/**
+ * Add a job to be stepped on null events.
+ *
+ * Null events are only requested from the WIMP while there are
+ * background jobs waiting to run.
+ *
+ * @param job job to add
+ * @param priority priority of job, higher priority jobs are run first
+ * @param listener listener for job progress and completion or 0 for none.
+ */
+void EventRouter::add_background_job(BackgroundJob *job, int priority, BackgroundJobListener *listener)
+{
+	_jobs.add(job, priority, listener);
+}
+
+/**
+ * Remove a background job before it has finished
+ */
+void EventRouter::remove_background_job(BackgroundJob *job)
+{
+	_jobs.remove(job);
+}
+
+/**
+ * Check if a background job is still waiting to finish
+ */
+bool EventRouter::background_job_pending(BackgroundJob *job) const
+{
+	return _jobs.contains(job);
 }
 
 //! @endcond
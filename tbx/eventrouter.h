@@ -31,6 +31,9 @@
 #include "listener.h"
 #include "autocreatelistener.h"
 #include "pollinfo.h"
+#include "timerqueue.h"
+#include "jobqueue.h"
+#include "eventtable.h"
 
 namespace tbx
 {
@@ -46,8 +49,9 @@ class WimpMessageListener;
 class RedrawListener;
 class DragHandler;
 class Command;
-class Timer;
 class PostPollListener;
+class PollStats;
+class DeferredRedraw;
 
 class EventRouter
 {
@@ -68,6 +72,7 @@ private:
 	friend class Object;
 	friend class Component;
 	friend class Window;
+	friend class DeferredRedraw;
 
 	// Toolbox events
 	void add_autocreate_listener(const char *template_name, AutoCreateListener *listener);
@@ -97,8 +102,25 @@ private:
 	void set_drag_handler(DragHandler *handler, int drag_stop_swi = 0);
 	void cancel_drag();
 
-	void add_timer(int elapsed, Timer *timer);
+	TimerHandle add_timer(int elapsed, Timer *timer);
+	TimerHandle add_one_shot_timer(int elapsed, Timer *timer);
 	void remove_timer(Timer *timer);
+	void remove_timer(TimerHandle handle);
+
+	void add_deferred_redraw(DeferredRedraw *redraw);
+	void remove_deferred_redraw(DeferredRedraw *redraw);
+
+	void add_background_job(BackgroundJob *job, int priority, BackgroundJobListener *listener);
+	void remove_background_job(BackgroundJob *job);
+	bool background_job_pending(BackgroundJob *job) const;
+	/**
+	 * Get the maximum time spent running background jobs on a null event
+	 */
+	unsigned int background_job_budget() const {return _jobs.budget();}
+	/**
+	 * Set the maximum time spent running background jobs on a null event
+	 */
+	void background_job_budget(unsigned int budget) {_jobs.budget(budget);}
 
 private:
 	void route_event(int event_code);
@@ -106,6 +128,7 @@ private:
 	void process_toolbox_event();
 	bool process_toolbox_event(ObjectId object_id, ComponentId comp_id);
 
+	void flush_deferred_redraws();
 	void process_null_event();
 	void process_redraw_request();
 	void process_open_window_request();
@@ -129,16 +152,16 @@ private:
 	int _reply_to;
 	bool _catch_exceptions;
 	PostPollListener *_post_poll_listener;
+	PollStats *_poll_stats;
 
-	// List item for object/component toolbox events
+	// Listener for object/component toolbox events
     struct ObjectListenerItem
 	{
-		int action;
 		ComponentId component_id;
-		RawToolboxEventHandler handler;
+		RawToolboxEventHandler handler; // 0 if removed while dispatching
 		Listener *listener;
-		ObjectListenerItem *next;
 	};
+    typedef std::vector<ObjectListenerItem> ObjectListenerList;
 
     // List item for WIMP window events
     struct WindowEventListenerItem
@@ -159,37 +182,35 @@ private:
 
     // Running event delete helpers
     bool _remove_running;
-    ObjectListenerItem *_running_object_item;
+    int _dispatching_object_events;
+    std::vector<std::pair<ObjectId, int> > _object_lists_to_compact;
     WindowEventListenerItem *_running_window_event_item;
     WimpMessageListenerItem *_running_message_item;
 
-	std::map<ObjectId, ObjectListenerItem *> _object_listeners;
+	EventTable<ObjectListenerList> _object_listeners;
+	EventTable<std::vector<int> > _object_actions;
 	std::map<std::string, AutoCreateListener*> *_autocreate_listeners;
 	std::map<int, WimpMessageListenerItem *> **_message_listeners;
-	std::map<ObjectId, WindowEventListenerItem **> *_window_event_listeners;
+	EventTable<WindowEventListenerItem **> *_window_event_listeners;
 
 	std::vector<Command *> *_null_event_commands;
+	std::vector<DeferredRedraw *> _deferred_redraws;
 
 	DragHandler *_drag_handler;
 	int _drag_stop_swi;
 
-	struct TimerInfo
-	{
-		unsigned int due;
-		unsigned int elapsed;
-		Timer *timer;
-		TimerInfo *next;
-	} *_first_timer;
+	TimerQueue _timers;
+	JobQueue _jobs;
 
 private:
 	// Listener list helpers
-	ObjectListenerItem *find_first_object_listener(ObjectId handle, int action);
+	void end_object_dispatch();
+	void remove_object_listener_item(ObjectId handle, int action, ObjectListenerList &list, unsigned int index);
+	void remove_object_action(ObjectId handle, int action);
     WindowEventListenerItem *find_window_event_listener(ObjectId object_id, int event_code);
     WindowEventListenerItem *find_window_event_component(WindowEventListenerItem *&item, ComponentId component_id);
     void remove_running_window_event_listener(ObjectId object_id, int event_code);
 
-    void add_timer_info(TimerInfo *info);
-
 private:
 	static EventRouter *_instance;
 };
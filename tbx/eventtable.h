@@ -0,0 +1,184 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_EVENTTABLE_H_
+#define TBX_EVENTTABLE_H_
+
+#include <vector>
+#include <algorithm>
+#include "handles.h"
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Hash table used by the EventRouter to look up listeners
+ * for an object and event code.
+ *
+ * It uses open addressing with linear probing so the entries are
+ * held in one contiguous block and a lookup doesn't need to follow
+ * any pointers.
+ *
+ * Adding or erasing an entry can move other entries, so a pointer
+ * returned by find or insert is only valid until the table is
+ * next changed.
+ */
+template<class Value> class EventTable
+{
+public:
+	/**
+	 * Construct an empty table
+	 */
+	EventTable() : _size(0), _mask(0) {}
+
+	/**
+	 * Number of entries in the table
+	 */
+	unsigned int size() const {return _size;}
+
+	/**
+	 * Find the value for an object and code
+	 *
+	 * @param id object id
+	 * @param code event code
+	 * @returns pointer to the value or 0 if it is not in the table
+	 */
+	Value *find(ObjectId id, int code)
+	{
+		unsigned int pos = find_pos(id, code);
+		return (pos == NOT_FOUND) ? 0 : &_slots[pos].value;
+	}
+
+	/**
+	 * Find the value for an object and code adding it if necessary
+	 *
+	 * @param id object id
+	 * @param code event code
+	 * @returns reference to the value. If it has been added it is
+	 * default constructed.
+	 */
+	Value &insert(ObjectId id, int code)
+	{
+		if ((_size + 1) * 4 > _slots.size() * 3) grow();
+		unsigned int pos = hash(id, code);
+		while (_slots[pos].used)
+		{
+			if (_slots[pos].id == id && _slots[pos].code == code) return _slots[pos].value;
+			pos = (pos + 1) & _mask;
+		}
+		_slots[pos].used = true;
+		_slots[pos].id = id;
+		_slots[pos].code = code;
+		_size++;
+		return _slots[pos].value;
+	}
+
+	/**
+	 * Erase the value for an object and code
+	 *
+	 * @param id object id
+	 * @param code event code
+	 * @returns true if the value was in the table
+	 */
+	bool erase(ObjectId id, int code)
+	{
+		unsigned int pos = find_pos(id, code);
+		if (pos == NOT_FOUND) return false;
+
+		// Move following entries back so there are no gaps in their probe sequence
+		unsigned int next = (pos + 1) & _mask;
+		while (_slots[next].used)
+		{
+			unsigned int want = hash(_slots[next].id, _slots[next].code);
+			if (((next - want) & _mask) >= ((next - pos) & _mask))
+			{
+				_slots[pos].id = _slots[next].id;
+				_slots[pos].code = _slots[next].code;
+				std::swap(_slots[pos].value, _slots[next].value);
+				pos = next;
+			}
+			next = (next + 1) & _mask;
+		}
+		_slots[pos].used = false;
+		_slots[pos].value = Value();
+		_size--;
+		return true;
+	}
+
+private:
+	struct Slot
+	{
+		ObjectId id;
+		int code;
+		bool used;
+		Value value;
+		Slot() : id(0), code(0), used(false), value() {}
+	};
+
+	static const unsigned int NOT_FOUND = 0xFFFFFFFF;
+
+	unsigned int find_pos(ObjectId id, int code) const
+	{
+		if (_size == 0) return NOT_FOUND;
+		unsigned int pos = hash(id, code);
+		while (_slots[pos].used)
+		{
+			if (_slots[pos].id == id && _slots[pos].code == code) return pos;
+			pos = (pos + 1) & _mask;
+		}
+		return NOT_FOUND;
+	}
+
+	unsigned int hash(ObjectId id, int code) const
+	{
+		unsigned int h = id * 0x9E3779B1u ^ (unsigned int)code * 0x85EBCA77u;
+		return (h ^ (h >> 15)) & _mask;
+	}
+
+	void grow()
+	{
+		std::vector<Slot> old;
+		old.swap(_slots);
+		unsigned int new_size = old.empty() ? 16 : old.size() * 2;
+		_slots.resize(new_size);
+		_mask = new_size - 1;
+		_size = 0;
+		for (typename std::vector<Slot>::iterator i = old.begin(); i != old.end(); ++i)
+		{
+			if (i->used) std::swap(insert(i->id, i->code), i->value);
+		}
+	}
+
+	std::vector<Slot> _slots;
+	unsigned int _size;
+	unsigned int _mask;
+};
+
+//! @endcond
+
+}
+
+#endif
@@ -0,0 +1,1172 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "simulator.h"
+#include "swis.h"
+#include "../monotonictime.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace tbx
+{
+namespace host
+{
+
+//! @cond INTERNAL
+/**
+ * Read a box stored as four words in a Wimp block
+ */
+static BBox get_bbox(const int *block)
+{
+	return BBox(block[0], block[1], block[2], block[3]);
+}
+
+/**
+ * Store a box as four words in a Wimp block
+ */
+static void put_bbox(int *block, const BBox &box)
+{
+	block[0] = box.min.x;
+	block[1] = box.min.y;
+	block[2] = box.max.x;
+	block[3] = box.max.y;
+}
+//! @endcond
+
+/**
+ * Construct the simulator.
+ *
+ * The simulator is not used for SWI calls until it is installed.
+ */
+Simulator::Simulator() :
+	_time(0),
+	_task_handle(0x4C0001),
+	_id_block(0),
+	_polls(0),
+	_next_object_id(0x1000),
+	_next_ref(1),
+	_redraw_handle(0),
+	_unsupported(0),
+	_last_unsupported(0)
+{
+	std::memset(&_error, 0, sizeof(_error));
+}
+
+/**
+ * Destructor, uninstalls the simulator if it is the current backend
+ */
+Simulator::~Simulator()
+{
+	uninstall();
+}
+
+/**
+ * Make this simulator the backend for all SWI calls
+ */
+void Simulator::install()
+{
+	set_swi_backend(this);
+}
+
+/**
+ * Stop using this simulator for SWI calls if it is the current backend
+ */
+void Simulator::uninstall()
+{
+	if (swi_backend() == this) set_swi_backend(0);
+}
+
+/**
+ * Simulate a SWI
+ *
+ * @param number SWI number without the X bit
+ * @param regs registers on entry, updated to the registers on exit
+ * @returns 0 if successful or an error block.
+ */
+_kernel_oserror *Simulator::swi(int number, _kernel_swi_regs &regs)
+{
+	switch(number)
+	{
+	case OS_ReadMonotonicTime:
+		regs.r[0] = (int)_time;
+		break;
+
+	case OS_ReadModeVariable:
+		return read_mode_variable(regs);
+
+	case Wimp_Poll:
+		return wimp_poll(regs, false);
+
+	case Wimp_PollIdle:
+		return wimp_poll(regs, true);
+
+	case Wimp_OpenWindow:
+		return open_window(regs);
+
+	case Wimp_CloseWindow:
+		window(*reinterpret_cast<int *>(regs.r[1])).open = false;
+		break;
+
+	case Wimp_GetWindowState:
+		return window_state(regs, 9);
+
+	case Wimp_GetWindowInfo:
+		return window_state(regs, 22);
+
+	case Wimp_RedrawWindow:
+		return redraw_window(regs);
+
+	case Wimp_UpdateWindow:
+		return update_window(regs);
+
+	case Wimp_GetRectangle:
+		return get_rectangle(regs);
+
+	case Wimp_ForceRedraw:
+		if (regs.r[0] != -1)
+		{
+			return force_redraw(regs.r[0], BBox(regs.r[1], regs.r[2], regs.r[3], regs.r[4]));
+		}
+		break;
+
+	case Wimp_SetExtent:
+		{
+			if (regs.r[0] == _redraw_handle) return error(0x80CB01, "Extent set during redraw");
+			const BBox *extent = reinterpret_cast<const BBox *>(regs.r[1]);
+			window(regs.r[0]).extent = *extent;
+		}
+		break;
+
+	case Wimp_BlockCopy:
+		{
+			BlockCopyRecord record;
+			record.window_handle = regs.r[0];
+			record.source = BBox(regs.r[1], regs.r[2], regs.r[3], regs.r[4]);
+			record.destination = Point(regs.r[5], regs.r[6]);
+			_block_copies.push_back(record);
+		}
+		break;
+
+	case Wimp_SendMessage:
+		return send_message(regs);
+
+	case Wimp_TransferBlock:
+		// Both tasks share the host address space
+		std::memmove(reinterpret_cast<void *>(regs.r[3]), reinterpret_cast<const void *>(regs.r[1]), regs.r[4]);
+		break;
+
+	case OS_File:
+		// Files are not simulated, but deleting the scrap file
+		// at the end of a data transfer must succeed.
+		if (regs.r[0] != 6) return unsupported(number);
+		break;
+
+	case Wimp_ReportError:
+		{
+			const _kernel_oserror *err = reinterpret_cast<const _kernel_oserror *>(regs.r[0]);
+			std::fprintf(stderr, "Wimp_ReportError: %s\n", err->errmess);
+			regs.r[1] = 1; // OK
+		}
+		break;
+
+	case OS_Plot:
+	case ColourTrans_SetGCOL:
+	case Wimp_SetColour:
+	case Wimp_PlotIcon:
+		// Graphics output is not recorded
+		break;
+
+	case Wimp_SpriteOp:
+		// Every Wimp sprite is a 34x17 mode 28 sprite with no mask
+		// or palette and plotting is not recorded.
+		switch(regs.r[0] & 0xFF)
+		{
+		case 24: break;                // Select (sprite exists)
+		case 37: regs.r[4] = 0; break; // Palette
+		case 40:                       // Read information
+			regs.r[3] = 34;
+			regs.r[4] = 17;
+			regs.r[5] = 0;
+			regs.r[6] = 28;
+			break;
+		case 52: break;                // Plot scaled
+		default: return unsupported(number);
+		}
+		break;
+
+	case Wimp_ReadPixTrans:
+		// Sprites are plotted unscaled and the table is not used
+		if (regs.r[6])
+		{
+			int *factors = reinterpret_cast<int *>(regs.r[6]);
+			factors[0] = factors[1] = factors[2] = factors[3] = 1;
+		}
+		break;
+
+	case Wimp_TextOp:
+		// Desktop font is measured as the 16 OS unit wide system font
+		if ((regs.r[0] & 0xFF) == 1)
+		{
+			const char *text = reinterpret_cast<const char *>(regs.r[1]);
+			int len = std::strlen(text);
+			if (regs.r[2] > 0 && regs.r[2] < len) len = regs.r[2];
+			regs.r[0] = len * 16;
+		}
+		break;
+
+	case Hourglass_On:
+	case Hourglass_Off:
+	case Hourglass_Smash:
+	case Hourglass_Start:
+	case Hourglass_Percentage:
+		break;
+
+	case MessageTrans_FileInfo:
+		regs.r[0] = 0;
+		regs.r[2] = 0;
+		break;
+
+	case MessageTrans_OpenFile:
+	case MessageTrans_CloseFile:
+		break;
+
+	case MessageTrans_Lookup:
+		return message_lookup(regs);
+
+	case Toolbox_Initialise:
+		_id_block = reinterpret_cast<int *>(regs.r[6]);
+		regs.r[0] = 380;
+		regs.r[1] = _task_handle;
+		regs.r[2] = 0;
+		break;
+
+	case Toolbox_CreateObject:
+		if (regs.r[0] & 1) return unsupported(number); // Create from template block
+		else
+		{
+			std::map<std::string, int>::iterator found = _templates.find(reinterpret_cast<const char *>(regs.r[1]));
+			if (found == _templates.end()) return error(0x80CB00, "Template not found");
+			regs.r[0] = create_object(found->second);
+		}
+		break;
+
+	case Toolbox_DeleteObject:
+		_deleted.insert(regs.r[1]);
+		_classes.erase(regs.r[1]);
+		_showing.erase(regs.r[1]);
+		_windows.erase(regs.r[1]);
+		_client_handles.erase(regs.r[1]);
+		break;
+
+	case Toolbox_ShowObject:
+		_showing.insert(regs.r[1]);
+		window(regs.r[1]).open = true;
+		break;
+
+	case Toolbox_HideObject:
+		_showing.erase(regs.r[1]);
+		if (_windows.count(regs.r[1])) _windows[regs.r[1]].open = false;
+		break;
+
+	case Toolbox_GetObjectState:
+		regs.r[0] = _showing.count(regs.r[1]) ? 1 : 0;
+		break;
+
+	case Toolbox_SetClientHandle:
+		_client_handles[regs.r[1]] = regs.r[2];
+		break;
+
+	case Toolbox_GetClientHandle:
+		{
+			std::map<int, int>::iterator found = _client_handles.find(regs.r[1]);
+			regs.r[0] = (found == _client_handles.end()) ? 0 : found->second;
+		}
+		break;
+
+	case Toolbox_GetObjectClass:
+		{
+			std::map<int, int>::iterator found = _classes.find(regs.r[1]);
+			if (found == _classes.end()) return error(0x80CB00, "Object not found");
+			regs.r[0] = found->second;
+		}
+		break;
+
+	case Toolbox_GetParent:
+	case Toolbox_GetAncestor:
+		regs.r[0] = 0;
+		regs.r[1] = -1;
+		break;
+
+	case Toolbox_ObjectMiscOp:
+		return object_misc_op(regs);
+
+	case Window_GetPointerInfo:
+		// Pointer is not over any object
+		regs.r[0] = regs.r[1] = regs.r[2] = 0;
+		regs.r[3] = regs.r[4] = -1;
+		break;
+
+	case Window_WimpToToolbox:
+		regs.r[0] = (find_window(regs.r[1])) ? regs.r[1] : 0;
+		regs.r[1] = -1;
+		break;
+
+	default:
+		return unsupported(number);
+	}
+
+	return 0;
+}
+
+/**
+ * Add an event to the end of the queue returned by Wimp_Poll
+ *
+ * @param reason Wimp_Poll reason code
+ * @param block contents of the poll block for the event
+ * @param size size of the block in bytes (at most 256)
+ */
+void Simulator::post_event(int reason, const void *block /*= 0*/, int size /*= 0*/)
+{
+	Event event;
+	std::memset(&event, 0, sizeof(event));
+	event.reason = reason;
+	if (size > (int)sizeof(event.block)) size = sizeof(event.block);
+	if (block && size > 0) std::memcpy(event.block, block, size);
+	_events.push_back(event);
+}
+
+/**
+ * Add a toolbox event to the end of the event queue
+ *
+ * @param object_id id of the object to report as the self object
+ * @param component_id id of the component to report as the self component
+ * @param event_code toolbox event code
+ * @param data event specific data following the standard header
+ * @param size size of the data in bytes
+ */
+void Simulator::post_toolbox_event(int object_id, int component_id, int event_code, const void *data /*= 0*/, int size /*= 0*/)
+{
+	Event event;
+	std::memset(&event, 0, sizeof(event));
+	event.reason = 0x200;
+	if (size > 240) size = 240;
+	event.block[0] = 16 + ((size + 3) & ~3);
+	event.block[2] = event_code;
+	if (data && size > 0) std::memcpy(event.block + 4, data, size);
+	event.id_block[1] = -1; // No ancestor or parent
+	event.id_block[3] = -1;
+	event.id_block[4] = object_id;
+	event.id_block[5] = component_id;
+	_events.push_back(event);
+}
+
+/**
+ * Add a Wimp message from this task to the end of the event queue
+ *
+ * @param action message action code
+ * @param data message data following the message header
+ * @param size size of data in bytes
+ * @param reason Wimp_Poll reason code (17, 18 or 19)
+ */
+void Simulator::post_message(int action, const void *data /*= 0*/, int size /*= 0*/, int reason /*= 17*/)
+{
+	Event event;
+	std::memset(&event, 0, sizeof(event));
+	event.reason = reason;
+	if (size > 236) size = 236;
+	event.block[0] = 20 + ((size + 3) & ~3);
+	event.block[1] = _task_handle;
+	event.block[2] = _next_ref++;
+	event.block[4] = action;
+	if (data && size > 0) std::memcpy(event.block + 5, data, size);
+	_events.push_back(event);
+}
+
+/**
+ * Add a Wimp message from another task to the end of the event queue.
+ *
+ * This is used to play the part of the other task in a message
+ * protocol such as a data transfer.
+ *
+ * @param action message action code
+ * @param your_ref my_ref of the message this is a reply to or 0
+ * @param data message data following the message header
+ * @param size size of data in bytes
+ * @param reason Wimp_Poll reason code (17, 18 or 19). Default 18 (recorded).
+ * @returns my_ref of the message
+ */
+int Simulator::post_remote_message(int action, int your_ref, const void *data /*= 0*/, int size /*= 0*/, int reason /*= 18*/)
+{
+	Event event;
+	std::memset(&event, 0, sizeof(event));
+	event.reason = reason;
+	if (size > 236) size = 236;
+	event.block[0] = 20 + ((size + 3) & ~3);
+	event.block[1] = REMOTE_TASK;
+	event.block[2] = _next_ref++;
+	event.block[3] = your_ref;
+	event.block[4] = action;
+	if (data && size > 0) std::memcpy(event.block + 5, data, size);
+	_events.push_back(event);
+	return event.block[2];
+}
+
+/**
+ * Return a recorded message sent to another task to the sender as
+ * the Wimp does when it is not acknowledged.
+ *
+ * @param message message from sent_messages() to return
+ */
+void Simulator::bounce_message(const MessageRecord &message)
+{
+	post_event(19, &message.block[0], (int)message.block.size() * sizeof(int));
+}
+
+/**
+ * Clear the record of sent messages
+ */
+void Simulator::clear_messages()
+{
+	_sent.clear();
+}
+
+/**
+ * Add a redraw window request to the end of the event queue.
+ *
+ * The rectangles returned by Wimp_RedrawWindow are any invalid areas
+ * of the window when the event is processed, or the whole visible
+ * area of the window if there are none.
+ *
+ * @param window_handle handle of the window to redraw
+ */
+void Simulator::post_redraw(int window_handle)
+{
+	post_event(1, &window_handle, sizeof(int));
+}
+
+/**
+ * Add a redraw window request for each window with invalid areas
+ * from forced redraws.
+ */
+void Simulator::post_pending_redraws()
+{
+	for (std::map<int, WindowState>::iterator i = _windows.begin(); i != _windows.end(); ++i)
+	{
+		if (!i->second.invalid.empty()) post_redraw(i->first);
+	}
+}
+
+/**
+ * Add a template that can be created with Toolbox_CreateObject
+ *
+ * @param name template name
+ * @param object_class class of object created from the template
+ */
+void Simulator::add_template(const std::string &name, int object_class)
+{
+	_templates[name] = object_class;
+}
+
+/**
+ * Create a toolbox object
+ *
+ * @param object_class class of the object
+ * @returns id of the new object
+ */
+int Simulator::create_object(int object_class)
+{
+	int object_id = _next_object_id++;
+	_classes[object_id] = object_class;
+	return object_id;
+}
+
+/**
+ * Create a toolbox window object and open it.
+ *
+ * @param visible visible area in screen coordinates
+ * @param extent work area extent
+ * @returns id of the object, this is also its window handle
+ */
+int Simulator::create_window(const BBox &visible, const BBox &extent)
+{
+	int handle = create_object(0x82880); // Window class
+	WindowState &state = window(handle);
+	state.visible = visible;
+	state.extent = extent;
+	state.scroll_x = extent.min.x;
+	state.scroll_y = extent.max.y;
+	state.open = true;
+	_showing.insert(handle);
+	return handle;
+}
+
+/**
+ * Set the visible area of a window
+ *
+ * @param window_handle handle of the window
+ * @param visible visible area in screen coordinates
+ */
+void Simulator::visible_area(int window_handle, const BBox &visible)
+{
+	window(window_handle).visible = visible;
+}
+
+/**
+ * Get the visible area of a window
+ *
+ * @param window_handle handle of the window
+ * @returns visible area in screen coordinates
+ */
+BBox Simulator::visible_area(int window_handle) const
+{
+	const WindowState *state = find_window(window_handle);
+	return (state) ? state->visible : BBox(0,0,0,0);
+}
+
+/**
+ * Set the scroll offsets of a window
+ *
+ * @param window_handle handle of the window
+ * @param x horizontal scroll offset
+ * @param y vertical scroll offset
+ */
+void Simulator::scroll(int window_handle, int x, int y)
+{
+	WindowState &state = window(window_handle);
+	state.scroll_x = x;
+	state.scroll_y = y;
+}
+
+/**
+ * Get the horizontal scroll offset of a window
+ */
+int Simulator::scroll_x(int window_handle) const
+{
+	const WindowState *state = find_window(window_handle);
+	return (state) ? state->scroll_x : 0;
+}
+
+/**
+ * Get the vertical scroll offset of a window
+ */
+int Simulator::scroll_y(int window_handle) const
+{
+	const WindowState *state = find_window(window_handle);
+	return (state) ? state->scroll_y : 0;
+}
+
+/**
+ * Get the work area extent of a window
+ */
+BBox Simulator::extent(int window_handle) const
+{
+	const WindowState *state = find_window(window_handle);
+	return (state) ? state->extent : BBox(0,0,0,0);
+}
+
+/**
+ * Check if an object has been shown and not hidden
+ *
+ * @param object_id id of the object
+ * @returns true if the object is showing
+ */
+bool Simulator::showing(int object_id) const
+{
+	return (_showing.count(object_id) != 0);
+}
+
+/**
+ * Clear the recorded forced redraws, updates, redraw rectangles
+ * and block copies.
+ */
+void Simulator::clear_redraws()
+{
+	_forced.clear();
+	_updates.clear();
+	_rectangles.clear();
+	_block_copies.clear();
+}
+
+/**
+ * Simulate an integer property for Toolbox_ObjectMiscOp.
+ *
+ * The property is set from R4 and returned in R0.
+ *
+ * The same method numbers are used for all objects and gadgets.
+ *
+ * @param set_method method number to set the property
+ * @param get_method method number to get the property
+ */
+void Simulator::int_property(int set_method, int get_method)
+{
+	_int_setters.insert(set_method);
+	_int_getters[get_method] = set_method;
+}
+
+/**
+ * Simulate a string property for Toolbox_ObjectMiscOp.
+ *
+ * The property is set from the string pointed to by R4 and
+ * returned in the buffer at R4 of size R5.
+ *
+ * The same method numbers are used for all objects and gadgets.
+ *
+ * @param set_method method number to set the property
+ * @param get_method method number to get the property
+ */
+void Simulator::string_property(int set_method, int get_method)
+{
+	_string_setters.insert(set_method);
+	_string_getters[get_method] = set_method;
+}
+
+/**
+ * Set the value of a simulated integer property
+ *
+ * @param object_id object id
+ * @param set_method method number used to set the property
+ * @param component_id component id or 0 for an object property
+ * @param value new value
+ */
+void Simulator::set_int(int object_id, int set_method, int component_id, int value)
+{
+	_ints[PropertyKey(object_id, set_method, component_id)] = value;
+}
+
+/**
+ * Get the value of a simulated integer property
+ *
+ * @param object_id object id
+ * @param set_method method number used to set the property
+ * @param component_id component id or 0 for an object property
+ * @returns value of the property or 0 if it has not been set
+ */
+int Simulator::get_int(int object_id, int set_method, int component_id) const
+{
+	std::map<PropertyKey, int>::const_iterator found = _ints.find(PropertyKey(object_id, set_method, component_id));
+	return (found == _ints.end()) ? 0 : found->second;
+}
+
+/**
+ * Set the value of a simulated string property
+ *
+ * @param object_id object id
+ * @param set_method method number used to set the property
+ * @param component_id component id or 0 for an object property
+ * @param value new value
+ */
+void Simulator::set_string(int object_id, int set_method, int component_id, const std::string &value)
+{
+	_strings[PropertyKey(object_id, set_method, component_id)] = value;
+}
+
+/**
+ * Get the value of a simulated string property
+ *
+ * @param object_id object id
+ * @param set_method method number used to set the property
+ * @param component_id component id or 0 for an object property
+ * @returns value of the property or an empty string if it has not been set
+ */
+std::string Simulator::get_string(int object_id, int set_method, int component_id) const
+{
+	std::map<PropertyKey, std::string>::const_iterator found = _strings.find(PropertyKey(object_id, set_method, component_id));
+	return (found == _strings.end()) ? std::string() : found->second;
+}
+
+/**
+ * Set the text returned by MessageTrans_Lookup for a token
+ *
+ * @param token message token
+ * @param text message text. %0 to %3 are replaced by the lookup parameters
+ */
+void Simulator::set_message(const std::string &token, const std::string &text)
+{
+	_messages[token] = text;
+}
+
+//! @cond INTERNAL
+
+/**
+ * Return an error block with the given number and message
+ */
+_kernel_oserror *Simulator::error(int number, const char *message)
+{
+	_error.errnum = number;
+	std::strncpy(_error.errmess, message, sizeof(_error.errmess) - 1);
+	_error.errmess[sizeof(_error.errmess) - 1] = 0;
+	return &_error;
+}
+
+/**
+ * Record and return an error for a SWI that isn't simulated
+ */
+_kernel_oserror *Simulator::unsupported(int number)
+{
+	char message[64];
+	_unsupported++;
+	_last_unsupported = number;
+	std::sprintf(message, "SWI &%X not simulated", number);
+	return error(0x1E6, message);
+}
+
+/**
+ * Return the next queued event or a null event if the queue is empty.
+ *
+ * A null event is returned when there is nothing queued even if
+ * the mask disables null events so a program driven by the
+ * simulator never blocks.
+ */
+_kernel_oserror *Simulator::wimp_poll(_kernel_swi_regs &regs, bool idle)
+{
+	int *block = reinterpret_cast<int *>(regs.r[1]);
+	_polls++;
+
+	if (_events.empty())
+	{
+		if (idle && monotonic_lt(_time, (unsigned int)regs.r[2]))
+		{
+			_time = (unsigned int)regs.r[2];
+		}
+		regs.r[0] = 0;
+		regs.r[2] = 0;
+		return 0;
+	}
+
+	const Event &event = _events.front();
+	regs.r[0] = event.reason;
+	std::memcpy(block, event.block, sizeof(event.block));
+	if (_id_block)
+	{
+		if (event.reason == 0x200)
+		{
+			std::memcpy(_id_block, event.id_block, sizeof(event.id_block));
+		} else if (event.reason >= 1 && event.reason <= 8 && event.reason != 7)
+		{
+			// The Toolbox reports the window the event is for as the self object
+			int handle = (event.reason == 6) ? event.block[3] : event.block[0];
+			if (find_window(handle))
+			{
+				std::memset(_id_block, 0, sizeof(event.id_block));
+				_id_block[1] = -1;
+				_id_block[3] = -1;
+				_id_block[4] = handle;
+				_id_block[5] = -1;
+			}
+		}
+	}
+	regs.r[2] = (event.reason >= 17 && event.reason <= 19) ? event.block[1] : 0;
+	_events.pop_front();
+
+	return 0;
+}
+
+/**
+ * Send a message.
+ *
+ * The message is recorded and the sender and my_ref are filled in.
+ * Messages to this task, its windows or broadcast are queued to be
+ * returned by Wimp_Poll. Messages to other windows or tasks are
+ * treated as if they were sent to another task which is reported as
+ * REMOTE_TASK.
+ */
+_kernel_oserror *Simulator::send_message(_kernel_swi_regs &regs)
+{
+	int reason = regs.r[0];
+	int *block = reinterpret_cast<int *>(regs.r[1]);
+	int destination = regs.r[2];
+	int size = block[0];
+	if (size < 20 || size > 256) return error(0x288, "Bad message size");
+
+	if (reason != 19)
+	{
+		block[1] = _task_handle;
+		block[2] = _next_ref++;
+	}
+
+	MessageRecord record;
+	record.reason = reason;
+	record.destination = destination;
+	record.icon_handle = regs.r[3];
+	record.block.assign(block, block + (size + 3) / 4);
+	_sent.push_back(record);
+
+	bool local = (destination == _task_handle || (destination != 0 && find_window(destination) != 0));
+	if ((local || destination == 0) && reason != 19)
+	{
+		// Broadcasts are also delivered to the sender
+		post_event(reason, block, size);
+	}
+	regs.r[2] = (local) ? _task_handle : REMOTE_TASK;
+
+	return 0;
+}
+
+/**
+ * Fill in the block for Wimp_GetWindowState or Wimp_GetWindowInfo
+ *
+ * @param words number of words to fill in
+ */
+_kernel_oserror *Simulator::window_state(_kernel_swi_regs &regs, int words)
+{
+	int *block = reinterpret_cast<int *>(regs.r[1] & ~1);
+	const WindowState &state = window(block[0]);
+
+	std::memset(block + 1, 0, (words - 1) * sizeof(int));
+	put_bbox(block + 1, state.visible);
+	block[5] = state.scroll_x;
+	block[6] = state.scroll_y;
+	block[7] = state.behind;
+	block[8] = (state.open) ? (1 << 16) : 0;
+	if (words > 14) put_bbox(block + 11, state.extent);
+
+	return 0;
+}
+
+/**
+ * Open a window, the scroll offsets are limited to the extent
+ * as the Wimp does.
+ */
+_kernel_oserror *Simulator::open_window(_kernel_swi_regs &regs)
+{
+	const int *block = reinterpret_cast<const int *>(regs.r[1]);
+	WindowState &state = window(block[0]);
+
+	state.visible = get_bbox(block + 1);
+	state.scroll_x = block[5];
+	state.scroll_y = block[6];
+	state.behind = block[7];
+	state.open = true;
+
+	if (state.visible.width() > state.extent.width())
+	{
+		state.visible.max.x = state.visible.min.x + state.extent.width();
+	}
+	if (state.visible.height() > state.extent.height())
+	{
+		state.visible.min.y = state.visible.max.y - state.extent.height();
+	}
+	if (state.scroll_x > state.extent.max.x - state.visible.width())
+	{
+		state.scroll_x = state.extent.max.x - state.visible.width();
+	}
+	if (state.scroll_x < state.extent.min.x) state.scroll_x = state.extent.min.x;
+	if (state.scroll_y < state.extent.min.y + state.visible.height())
+	{
+		state.scroll_y = state.extent.min.y + state.visible.height();
+	}
+	if (state.scroll_y > state.extent.max.y) state.scroll_y = state.extent.max.y;
+
+	return 0;
+}
+
+/**
+ * Start a redraw of the invalid areas of a window
+ */
+_kernel_oserror *Simulator::redraw_window(_kernel_swi_regs &regs)
+{
+	int *block = reinterpret_cast<int *>(regs.r[1]);
+	WindowState &state = window(block[0]);
+
+	_redraw_handle = block[0];
+	_redraw_rects.clear();
+	if (state.invalid.empty())
+	{
+		_redraw_rects.push_back(state.visible);
+	} else
+	{
+		for (std::vector<BBox>::iterator i = state.invalid.begin(); i != state.invalid.end(); ++i)
+		{
+			BBox screen = work_to_screen(state, *i);
+			if (screen.min.x < screen.max.x && screen.min.y < screen.max.y)
+			{
+				_redraw_rects.push_back(screen);
+			}
+		}
+		state.invalid.clear();
+	}
+
+	return get_rectangle(regs);
+}
+
+/**
+ * Start an update of an area of a window
+ */
+_kernel_oserror *Simulator::update_window(_kernel_swi_regs &regs)
+{
+	int *block = reinterpret_cast<int *>(regs.r[1]);
+	const WindowState &state = window(block[0]);
+	RedrawRecord record;
+	record.window_handle = block[0];
+	record.work_area = get_bbox(block + 1);
+	_updates.push_back(record);
+
+	_redraw_handle = block[0];
+	_redraw_rects.clear();
+	BBox screen = work_to_screen(state, record.work_area);
+	if (screen.min.x < screen.max.x && screen.min.y < screen.max.y)
+	{
+		_redraw_rects.push_back(screen);
+	}
+
+	return get_rectangle(regs);
+}
+
+/**
+ * Return the next rectangle to redraw for a redraw or update
+ */
+_kernel_oserror *Simulator::get_rectangle(_kernel_swi_regs &regs)
+{
+	int *block = reinterpret_cast<int *>(regs.r[1]);
+
+	if (_redraw_rects.empty())
+	{
+		_redraw_handle = 0;
+		regs.r[0] = 0;
+	} else
+	{
+		BBox screen = _redraw_rects.front();
+		_redraw_rects.erase(_redraw_rects.begin());
+		block[0] = _redraw_handle;
+		fill_redraw_block(block, window(_redraw_handle), screen);
+		_rectangles.push_back(screen);
+		regs.r[0] = 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Record a forced redraw and mark the area as invalid
+ */
+_kernel_oserror *Simulator::force_redraw(int handle, const BBox &work_area)
+{
+	RedrawRecord record;
+	record.window_handle = handle;
+	record.work_area = work_area;
+	_forced.push_back(record);
+	window(handle).invalid.push_back(work_area);
+	return 0;
+}
+
+/**
+ * Simulate the window methods for the extent and the registered properties
+ */
+_kernel_oserror *Simulator::object_misc_op(_kernel_swi_regs &regs)
+{
+	int object_id = regs.r[1];
+	int method = regs.r[2];
+
+	if (_deleted.count(object_id)) return error(0x80CB00, "Object not found");
+
+	switch(method)
+	{
+	case 0: // Window_GetWimpHandle
+		regs.r[0] = object_id;
+		return 0;
+
+	case 15: // Window_SetExtent
+		window(object_id).extent = *reinterpret_cast<const BBox *>(regs.r[3]);
+		return 0;
+
+	case 16: // Window_GetExtent
+		*reinterpret_cast<BBox *>(regs.r[3]) = window(object_id).extent;
+		return 0;
+
+	case 17: // Window_ForceRedraw
+		return force_redraw(object_id, *reinterpret_cast<const BBox *>(regs.r[3]));
+	}
+
+	if (_int_setters.count(method))
+	{
+		set_int(object_id, method, regs.r[3], regs.r[4]);
+		return 0;
+	}
+	if (_string_setters.count(method))
+	{
+		const char *value = reinterpret_cast<const char *>(regs.r[4]);
+		set_string(object_id, method, regs.r[3], (value) ? value : "");
+		return 0;
+	}
+
+	std::map<int, int>::iterator getter = _int_getters.find(method);
+	if (getter != _int_getters.end())
+	{
+		regs.r[0] = get_int(object_id, getter->second, regs.r[3]);
+		return 0;
+	}
+	getter = _string_getters.find(method);
+	if (getter != _string_getters.end())
+	{
+		std::string value = get_string(object_id, getter->second, regs.r[3]);
+		char *buffer = reinterpret_cast<char *>(regs.r[4]);
+		int size = regs.r[5];
+		if (buffer && size > 0)
+		{
+			int copy = ((int)value.size() < size) ? (int)value.size() : size - 1;
+			std::memcpy(buffer, value.data(), copy);
+			buffer[copy] = 0;
+			regs.r[5] = copy + 1;
+		} else
+		{
+			regs.r[5] = (int)value.size() + 1;
+		}
+		return 0;
+	}
+
+	return unsupported(Toolbox_ObjectMiscOp);
+}
+
+/**
+ * Look up a message token.
+ *
+ * The default after a ':' in the token is used if the token
+ * has not been set.
+ */
+_kernel_oserror *Simulator::message_lookup(_kernel_swi_regs &regs)
+{
+	std::string token(reinterpret_cast<const char *>(regs.r[1]));
+	std::string::size_type colon = token.find(':');
+	std::string text;
+
+	std::map<std::string, std::string>::iterator found = _messages.find(token.substr(0, colon));
+	if (found != _messages.end()) text = found->second;
+	else if (colon != std::string::npos) text = token.substr(colon + 1);
+	else return error(0xAC2, ("Message token " + token + " not found").c_str());
+
+	_lookup_result.clear();
+	for (std::string::size_type pos = 0; pos < text.size(); pos++)
+	{
+		if (text[pos] == '%' && pos + 1 < text.size() && text[pos+1] >= '0' && text[pos+1] <= '3')
+		{
+			const char *arg = reinterpret_cast<const char *>(regs.r[4 + text[pos+1] - '0']);
+			if (arg) _lookup_result += arg;
+			pos++;
+		} else
+		{
+			_lookup_result += text[pos];
+		}
+	}
+
+	char *buffer = reinterpret_cast<char *>(regs.r[2]);
+	if (buffer)
+	{
+		int copy = (int)_lookup_result.size();
+		if (copy >= regs.r[3]) copy = regs.r[3] - 1;
+		std::memcpy(buffer, _lookup_result.data(), copy);
+		buffer[copy] = 0;
+		regs.r[3] = copy;
+	} else
+	{
+		regs.r[2] = reinterpret_cast<int>(_lookup_result.c_str());
+		regs.r[3] = (int)_lookup_result.size();
+	}
+
+	return 0;
+}
+
+/**
+ * Return mode variables for a 1920x1080 32 bit colour mode
+ * with square pixels.
+ */
+_kernel_oserror *Simulator::read_mode_variable(_kernel_swi_regs &regs)
+{
+	switch(regs.r[1])
+	{
+	case 3: regs.r[2] = -1; break;   // NColour
+	case 4: regs.r[2] = 1; break;    // XEigFactor
+	case 5: regs.r[2] = 1; break;    // YEigFactor
+	case 9: regs.r[2] = 5; break;    // Log2BPP
+	case 10: regs.r[2] = 5; break;   // Log2BPC
+	case 11: regs.r[2] = 1919; break; // XWindLimit
+	case 12: regs.r[2] = 1079; break; // YWindLimit
+	default: regs.r[2] = 0; break;
+	}
+	return 0;
+}
+
+/**
+ * Get the state of a window, creating a default state
+ * if it is not already known.
+ */
+Simulator::WindowState &Simulator::window(int handle)
+{
+	std::map<int, WindowState>::iterator found = _windows.find(handle);
+	if (found == _windows.end())
+	{
+		WindowState state;
+		state.visible = BBox(100, 100, 740, 612);
+		state.extent = BBox(0, -1024, 1280, 0);
+		found = _windows.insert(std::make_pair(handle, state)).first;
+	}
+	return found->second;
+}
+
+/**
+ * Find the state of a window
+ *
+ * @returns window state or 0 if the window is not known
+ */
+const Simulator::WindowState *Simulator::find_window(int handle) const
+{
+	std::map<int, WindowState>::const_iterator found = _windows.find(handle);
+	return (found == _windows.end()) ? 0 : &found->second;
+}
+
+/**
+ * Fill in the visible area, scroll offsets and clip rectangle
+ * of a redraw block
+ */
+void Simulator::fill_redraw_block(int *block, const WindowState &state, const BBox &screen)
+{
+	put_bbox(block + 1, state.visible);
+	block[5] = state.scroll_x;
+	block[6] = state.scroll_y;
+	put_bbox(block + 7, screen);
+}
+
+/**
+ * Convert a work area rectangle to screen coordinates clipped to
+ * the visible area of the window.
+ */
+BBox Simulator::work_to_screen(const WindowState &state, const BBox &work) const
+{
+	int origin_x = state.visible.min.x - state.scroll_x;
+	int origin_y = state.visible.max.y - state.scroll_y;
+	BBox screen(work.min.x + origin_x, work.min.y + origin_y,
+			work.max.x + origin_x, work.max.y + origin_y);
+
+	if (screen.min.x < state.visible.min.x) screen.min.x = state.visible.min.x;
+	if (screen.min.y < state.visible.min.y) screen.min.y = state.visible.min.y;
+	if (screen.max.x > state.visible.max.x) screen.max.x = state.visible.max.x;
+	if (screen.max.y > state.visible.max.y) screen.max.y = state.visible.max.y;
+
+	return screen;
+}
+
+//! @endcond
+
+}
+}
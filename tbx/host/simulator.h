@@ -0,0 +1,344 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_HOST_SIMULATOR_H_
+#define TBX_HOST_SIMULATOR_H_
+
+#include "swibackend.h"
+#include "../bbox.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tbx
+{
+namespace host
+{
+	/**
+	 * SWI backend that simulates enough of the Wimp and Toolbox for
+	 * TBX applications and views to be run without RISC OS.
+	 *
+	 * The simulator provides
+	 * - a monotonic clock that only moves when advance is called or
+	 *   Wimp_PollIdle is called with no events queued.
+	 * - a queue of events returned by Wimp_Poll and Wimp_PollIdle.
+	 * - Toolbox object creation and classes for templates added with
+	 *   add_template and the self object/component in the id block
+	 *   for toolbox events.
+	 * - Window visible area, scroll offsets and extents. Setting the
+	 *   extent of a window while it is being redrawn gives an error.
+	 * - A record of all forced redraws and the rectangles returned by
+	 *   Wimp_RedrawWindow and Wimp_UpdateWindow.
+	 * - Storage for object and gadget properties registered with
+	 *   int_property or string_property.
+	 * - Message lookup from tokens added with set_message.
+	 * - Wimp_TextOp with every character 16 OS units wide.
+	 * - Wimp sprites that are all 34 by 17 pixels in mode 28.
+	 * - Wimp messages. Messages sent to this task are returned by
+	 *   Wimp_Poll, messages to other tasks are recorded and
+	 *   post_remote_message and bounce_message can be used to play the
+	 *   other side of a message protocol such as a data transfer.
+	 *
+	 * Any other SWI fails with an error that includes its number.
+	 *
+	 * Toolbox object ids are also used as the Wimp window handle
+	 * for the object.
+	 *
+	 * As TBX passes pointers in registers the simulator can only be
+	 * used on a host with 32 bit pointers.
+	 */
+	class Simulator : public SwiBackend
+	{
+	public:
+		/**
+		 * Task handle returned for messages sent to other tasks
+		 * and used as the sender of post_remote_message.
+		 */
+		static const int REMOTE_TASK = 0x4D0001;
+
+		Simulator();
+		virtual ~Simulator();
+
+		virtual _kernel_oserror *swi(int number, _kernel_swi_regs &regs);
+
+		void install();
+		void uninstall();
+
+		/**
+		 * Current value of the simulated monotonic time
+		 *
+		 * @returns time in centiseconds
+		 */
+		unsigned int time() const {return _time;}
+		/**
+		 * Set the simulated monotonic time
+		 *
+		 * @param t new time in centiseconds
+		 */
+		void time(unsigned int t) {_time = t;}
+		/**
+		 * Advance the simulated monotonic time
+		 *
+		 * @param cs number of centiseconds to move the time on by
+		 */
+		void advance(unsigned int cs) {_time += cs;}
+
+		void post_event(int reason, const void *block = 0, int size = 0);
+		void post_toolbox_event(int object_id, int component_id, int event_code, const void *data = 0, int size = 0);
+		void post_message(int action, const void *data = 0, int size = 0, int reason = 17);
+		int post_remote_message(int action, int your_ref, const void *data = 0, int size = 0, int reason = 18);
+		void post_redraw(int window_handle);
+		void post_pending_redraws();
+		/**
+		 * Number of events waiting to be returned from Wimp_Poll
+		 */
+		int events_queued() const {return (int)_events.size();}
+		/**
+		 * Number of times Wimp_Poll or Wimp_PollIdle has been called
+		 */
+		int polls() const {return _polls;}
+
+		void add_template(const std::string &name, int object_class);
+		int create_object(int object_class);
+		int create_window(const BBox &visible, const BBox &extent);
+
+		void visible_area(int window_handle, const BBox &visible);
+		BBox visible_area(int window_handle) const;
+		void scroll(int window_handle, int x, int y);
+		int scroll_x(int window_handle) const;
+		int scroll_y(int window_handle) const;
+		BBox extent(int window_handle) const;
+		bool showing(int object_id) const;
+
+		/**
+		 * Redraw request recorded from a force redraw or update window
+		 */
+		struct RedrawRecord
+		{
+			/** Window handle */
+			int window_handle;
+			/** Area of the work area to redraw */
+			BBox work_area;
+		};
+
+		/**
+		 * Work area rectangles passed to Wimp_ForceRedraw or
+		 * Window::force_redraw since the last clear_redraws.
+		 */
+		const std::vector<RedrawRecord> &forced_redraws() const {return _forced;}
+		/**
+		 * Work area rectangles passed to Wimp_UpdateWindow
+		 * since the last clear_redraws.
+		 */
+		const std::vector<RedrawRecord> &updates() const {return _updates;}
+		/**
+		 * Screen rectangles returned by Wimp_RedrawWindow,
+		 * Wimp_UpdateWindow and Wimp_GetRectangle since the last
+		 * clear_redraws.
+		 */
+		const std::vector<BBox> &rectangles() const {return _rectangles;}
+
+		/**
+		 * Block copy recorded from Wimp_BlockCopy
+		 */
+		struct BlockCopyRecord
+		{
+			/** Window handle */
+			int window_handle;
+			/** Source work area */
+			BBox source;
+			/** Destination of the bottom left of the source */
+			Point destination;
+		};
+		/**
+		 * Calls to Wimp_BlockCopy since the last clear_redraws
+		 */
+		const std::vector<BlockCopyRecord> &block_copies() const {return _block_copies;}
+		void clear_redraws();
+
+		void int_property(int set_method, int get_method);
+		void string_property(int set_method, int get_method);
+		void set_int(int object_id, int set_method, int component_id, int value);
+		int get_int(int object_id, int set_method, int component_id) const;
+		void set_string(int object_id, int set_method, int component_id, const std::string &value);
+		std::string get_string(int object_id, int set_method, int component_id) const;
+
+		void set_message(const std::string &token, const std::string &text);
+
+		/**
+		 * Task handle of the simulated task
+		 */
+		int task_handle() const {return _task_handle;}
+
+		/**
+		 * Message recorded from Wimp_SendMessage
+		 */
+		struct MessageRecord
+		{
+			/** Wimp_SendMessage reason code (17, 18 or 19) */
+			int reason;
+			/** Destination task or window handle */
+			int destination;
+			/** Destination icon handle */
+			int icon_handle;
+			/** Contents of the message block after sending */
+			std::vector<int> block;
+
+			/**
+			 * Message action code
+			 */
+			int action() const {return block[4];}
+			/**
+			 * my_ref filled in when the message was sent
+			 */
+			int my_ref() const {return block[2];}
+			/**
+			 * your_ref of the message
+			 */
+			int your_ref() const {return block[3];}
+			/**
+			 * Get a word from the message
+			 *
+			 * @param index index of the word from the start of the message
+			 */
+			int word(int index) const {return block[index];}
+			/**
+			 * Get a string from the message
+			 *
+			 * @param index index of the word the string starts at
+			 */
+			const char *str(int index) const {return reinterpret_cast<const char *>(&block[index]);}
+		};
+		/**
+		 * Messages sent with Wimp_SendMessage since the last clear_messages
+		 */
+		const std::vector<MessageRecord> &sent_messages() const {return _sent;}
+		void clear_messages();
+		void bounce_message(const MessageRecord &message);
+
+		/**
+		 * Number of SWIs called that the simulator does not support
+		 */
+		int unsupported_calls() const {return _unsupported;}
+		/**
+		 * Number of the last unsupported SWI called
+		 */
+		int last_unsupported() const {return _last_unsupported;}
+
+	private:
+		//! @cond INTERNAL
+		struct Event
+		{
+			int reason;
+			int block[64];
+			int id_block[6];
+		};
+
+		struct WindowState
+		{
+			BBox visible;
+			BBox extent;
+			int scroll_x;
+			int scroll_y;
+			int behind;
+			bool open;
+			std::vector<BBox> invalid;
+			WindowState() : scroll_x(0), scroll_y(0), behind(-1), open(false) {}
+		};
+
+		struct PropertyKey
+		{
+			int object_id;
+			int method;
+			int component_id;
+			PropertyKey(int o, int m, int c) : object_id(o), method(m), component_id(c) {}
+			bool operator<(const PropertyKey &other) const
+			{
+				if (object_id != other.object_id) return object_id < other.object_id;
+				if (method != other.method) return method < other.method;
+				return component_id < other.component_id;
+			}
+		};
+
+		_kernel_oserror *error(int number, const char *message);
+		_kernel_oserror *unsupported(int number);
+
+		_kernel_oserror *wimp_poll(_kernel_swi_regs &regs, bool idle);
+		_kernel_oserror *window_state(_kernel_swi_regs &regs, int words);
+		_kernel_oserror *open_window(_kernel_swi_regs &regs);
+		_kernel_oserror *redraw_window(_kernel_swi_regs &regs);
+		_kernel_oserror *update_window(_kernel_swi_regs &regs);
+		_kernel_oserror *get_rectangle(_kernel_swi_regs &regs);
+		_kernel_oserror *force_redraw(int handle, const BBox &work_area);
+		_kernel_oserror *send_message(_kernel_swi_regs &regs);
+		_kernel_oserror *object_misc_op(_kernel_swi_regs &regs);
+		_kernel_oserror *message_lookup(_kernel_swi_regs &regs);
+		_kernel_oserror *read_mode_variable(_kernel_swi_regs &regs);
+
+		WindowState &window(int handle);
+		const WindowState *find_window(int handle) const;
+		void fill_redraw_block(int *block, const WindowState &state, const BBox &screen);
+		BBox work_to_screen(const WindowState &state, const BBox &work) const;
+		//! @endcond
+
+	private:
+		unsigned int _time;
+		int _task_handle;
+		int *_id_block;
+		std::deque<Event> _events;
+		int _polls;
+		int _next_object_id;
+		int _next_ref;
+		std::map<std::string, int> _templates;
+		std::map<int, int> _classes;
+		std::set<int> _showing;
+		std::set<int> _deleted;
+		std::map<int, int> _client_handles;
+		std::map<int, WindowState> _windows;
+		int _redraw_handle;
+		std::vector<BBox> _redraw_rects;
+		std::vector<RedrawRecord> _forced;
+		std::vector<RedrawRecord> _updates;
+		std::vector<BBox> _rectangles;
+		std::vector<BlockCopyRecord> _block_copies;
+		std::vector<MessageRecord> _sent;
+		std::map<PropertyKey, int> _ints;
+		std::map<PropertyKey, std::string> _strings;
+		std::map<int, int> _int_getters;
+		std::map<int, int> _string_getters;
+		std::set<int> _int_setters;
+		std::set<int> _string_setters;
+		std::map<std::string, std::string> _messages;
+		std::string _lookup_result;
+		_kernel_oserror _error;
+		int _unsupported;
+		int _last_unsupported;
+	};
+}
+}
+
+#endif
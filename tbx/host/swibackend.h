@@ -0,0 +1,82 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_HOST_SWIBACKEND_H_
+#define TBX_HOST_SWIBACKEND_H_
+
+#include "kernel.h"
+
+namespace tbx
+{
+namespace host
+{
+	/**
+	 * Interface to the code that carries out SWI calls when TBX
+	 * is built for a host machine instead of RISC OS.
+	 *
+	 * The host versions of _swix, _swi and _kernel_swi decode their
+	 * arguments into a register block and pass it to the backend set
+	 * with set_swi_backend.
+	 */
+	class SwiBackend
+	{
+	public:
+		virtual ~SwiBackend() {}
+
+		/**
+		 * Carry out a SWI
+		 *
+		 * @param number SWI number with the X bit cleared
+		 * @param regs registers on entry, updated with the registers
+		 * on exit.
+		 * @returns 0 if successful, otherwise a pointer to an error block.
+		 */
+		virtual _kernel_oserror *swi(int number, _kernel_swi_regs &regs) = 0;
+
+		/**
+		 * Write a character to the VDU stream.
+		 *
+		 * The default implementation ignores the character.
+		 *
+		 * @param ch character to write
+		 */
+		virtual void oswrch(int ch) {}
+
+		/**
+		 * Run a command line.
+		 *
+		 * The default implementation ignores the command.
+		 *
+		 * @param command command to run
+		 * @returns 0 if successful
+		 */
+		virtual int oscli(const char *command) {return 0;}
+	};
+
+	void set_swi_backend(SwiBackend *backend);
+	SwiBackend *swi_backend();
+}
+}
+
+#endif
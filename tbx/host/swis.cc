@@ -0,0 +1,176 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host implementation of the SharedCLibrary SWI veneers.
+ *
+ * The register masks are decoded here and the SWI passed on to the
+ * current SwiBackend.
+ */
+
+#include "swis.h"
+#include "swibackend.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace tbx
+{
+namespace host
+{
+
+static SwiBackend *current_backend = 0;
+
+/**
+ * Set the backend used to carry out the SWI calls.
+ *
+ * @param backend new backend or 0 to make all SWIs fail.
+ */
+void set_swi_backend(SwiBackend *backend)
+{
+	current_backend = backend;
+}
+
+/**
+ * Get the backend used to carry out the SWI calls.
+ *
+ * @returns current backend or 0 if none has been set.
+ */
+SwiBackend *swi_backend()
+{
+	return current_backend;
+}
+
+//! @cond INTERNAL
+/**
+ * Set an error block for a SWI that could not be called
+ */
+static _kernel_oserror *swi_error(const char *message, int swi_no)
+{
+	static _kernel_oserror err;
+	err.errnum = 0x1E6; // SWI not known
+	std::sprintf(err.errmess, "%s (SWI &%X)", message, swi_no);
+	return &err;
+}
+
+/**
+ * Decode the register mask and call the backend.
+ *
+ * @param swi_no SWI number
+ * @param mask register mask
+ * @param ap arguments following the mask
+ * @param ret set to the register selected by _RETURN
+ * @returns 0 or error from the backend
+ */
+static _kernel_oserror *call_swi(int swi_no, unsigned int mask, va_list ap, int *ret)
+{
+	_kernel_swi_regs regs;
+	std::memset(&regs, 0, sizeof(regs));
+	swi_no &= ~XOS_Bit;
+
+	if (mask & _BLOCK(0)) return swi_error("_BLOCK not supported on host", swi_no);
+
+	int reg;
+	for (reg = 0; reg < 10; reg++)
+	{
+		if (mask & _IN(reg)) regs.r[reg] = va_arg(ap, int);
+	}
+
+	if (current_backend == 0) return swi_error("No SWI backend", swi_no);
+
+	_kernel_oserror *err = current_backend->swi(swi_no, regs);
+	if (err) return err;
+
+	for (reg = 0; reg < 10; reg++)
+	{
+		if (mask & _OUT(reg))
+		{
+			int *out = va_arg(ap, int *);
+			if (out) *out = regs.r[reg];
+		}
+	}
+	if (mask & _OUT(_FLAGS))
+	{
+		// Processor flags are not simulated
+		int *flags = va_arg(ap, int *);
+		if (flags) *flags = 0;
+	}
+
+	if (ret) *ret = regs.r[(mask >> 16) & 15];
+
+	return 0;
+}
+//! @endcond
+
+}
+}
+
+using namespace tbx::host;
+
+extern "C" _kernel_oserror *_swix(int swi_no, unsigned int mask, ...)
+{
+	va_list ap;
+	va_start(ap, mask);
+	_kernel_oserror *err = call_swi(swi_no, mask, ap, 0);
+	va_end(ap);
+	return err;
+}
+
+extern "C" int _swi(int swi_no, unsigned int mask, ...)
+{
+	va_list ap;
+	int ret = 0;
+	va_start(ap, mask);
+	_kernel_oserror *err = call_swi(swi_no, mask, ap, &ret);
+	va_end(ap);
+	if (err)
+	{
+		std::fprintf(stderr, "%s\n", err->errmess);
+		std::abort();
+	}
+	return ret;
+}
+
+extern "C" _kernel_oserror *_kernel_swi(int no, _kernel_swi_regs *in, _kernel_swi_regs *out)
+{
+	no &= ~XOS_Bit;
+	if (current_backend == 0) return swi_error("No SWI backend", no);
+	_kernel_swi_regs regs = *in;
+	_kernel_oserror *err = current_backend->swi(no, regs);
+	if (err == 0) *out = regs;
+	return err;
+}
+
+extern "C" int _kernel_oswrch(int ch)
+{
+	if (current_backend) current_backend->oswrch(ch);
+	return ch;
+}
+
+extern "C" int _kernel_oscli(const char *s)
+{
+	return (current_backend) ? current_backend->oscli(s) : -2;
+}
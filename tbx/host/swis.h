@@ -0,0 +1,184 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Host replacement for the RISC OS SharedCLibrary swis.h.
+ *
+ * The register masks use the same encoding as the RISC OS header so the
+ * TBX sources can be compiled unchanged. Only the SWI names used by TBX
+ * are defined. Calls are passed to the SwiBackend set in swibackend.h.
+ */
+
+#ifndef TBX_HOST_SWIS_H
+#define TBX_HOST_SWIS_H
+
+#include "kernel.h"
+
+#define _FLAGS     0x10
+#define _IN(i)     (1U << (i))
+#define _INR(i,j)  (~0U << (i) ^ ~0U << (j) << 1)
+#define _OUT(i)    ((i) == _FLAGS ? 1U << 21 : 1U << (31 - (i)))
+#define _OUTR(i,j) (~0U << (31 - (j)) ^ ~0U << (31 - (i)) << 1)
+#define _BLOCK(i)  (1U << 11 | (unsigned int)(i) << 12)
+#define _RETURN(i) ((unsigned int)(i) << 16)
+
+#define _C         (1U << 29)
+#define _Z         (1U << 30)
+#define _N         (1U << 31)
+#define _V         (1U << 28)
+
+#define XOS_Bit    0x20000
+
+/* OS */
+#define OS_CLI                        0x05
+#define OS_Word                       0x07
+#define OS_File                       0x08
+#define OS_FSControl                  0x29
+#define OS_SpriteOp                   0x2E
+#define OS_ReadModeVariable           0x35
+#define OS_ReadMonotonicTime          0x42
+#define OS_Plot                       0x45
+#define OS_ConvertStandardDateAndTime 0xC0
+#define OS_ConvertDateAndTime         0xC1
+
+/* Wimp */
+#define Wimp_Initialise               0x400C0
+#define Wimp_CreateWindow             0x400C1
+#define Wimp_CreateIcon               0x400C2
+#define Wimp_DeleteWindow             0x400C3
+#define Wimp_DeleteIcon               0x400C4
+#define Wimp_OpenWindow               0x400C5
+#define Wimp_CloseWindow              0x400C6
+#define Wimp_Poll                     0x400C7
+#define Wimp_RedrawWindow             0x400C8
+#define Wimp_UpdateWindow             0x400C9
+#define Wimp_GetRectangle             0x400CA
+#define Wimp_GetWindowState           0x400CB
+#define Wimp_GetWindowInfo            0x400CC
+#define Wimp_SetIconState             0x400CD
+#define Wimp_GetIconState             0x400CE
+#define Wimp_GetPointerInfo           0x400CF
+#define Wimp_DragBox                  0x400D0
+#define Wimp_ForceRedraw              0x400D1
+#define Wimp_SetCaretPosition         0x400D2
+#define Wimp_GetCaretPosition         0x400D3
+#define Wimp_CreateMenu               0x400D4
+#define Wimp_SetExtent                0x400D7
+#define Wimp_ProcessKey               0x400DC
+#define Wimp_StartTask                0x400DE
+#define Wimp_ReportError              0x400DF
+#define Wimp_PollIdle                 0x400E1
+#define Wimp_PlotIcon                 0x400E2
+#define Wimp_ReadPalette              0x400E5
+#define Wimp_SetColour                0x400E6
+#define Wimp_SendMessage              0x400E7
+#define Wimp_SpriteOp                 0x400E9
+#define Wimp_BaseOfSprites            0x400EA
+#define Wimp_BlockCopy                0x400EB
+#define Wimp_ReadPixTrans             0x400ED
+#define Wimp_TransferBlock            0x400F1
+#define Wimp_ReadSysInfo              0x400F2
+#define Wimp_TextOp                   0x400F9
+
+/* Font */
+#define Font_Paint                    0x40086
+#define Font_ScanString               0x400A1
+
+/* Draw */
+#define Draw_ProcessPath              0x40700
+#define Draw_Fill                     0x40702
+#define Draw_Stroke                   0x40704
+
+/* ColourTrans */
+#define ColourTrans_SelectColour      0x40740
+#define ColourTrans_SelectTable       0x40741
+#define ColourTrans_SetGCOL           0x40743
+#define ColourTrans_SetFontColours    0x4074F
+
+/* FilerAction */
+#define FilerAction_SendSelectedDirectory 0x40F80
+#define FilerAction_SendSelectedFile  0x40F81
+#define FilerAction_SendStartOperation 0x40F82
+
+/* Hourglass */
+#define Hourglass_On                  0x406C0
+#define Hourglass_Off                 0x406C1
+#define Hourglass_Smash               0x406C2
+#define Hourglass_Start               0x406C3
+#define Hourglass_Percentage          0x406C4
+
+/* MessageTrans */
+#define MessageTrans_FileInfo         0x41500
+#define MessageTrans_OpenFile         0x41501
+#define MessageTrans_Lookup           0x41502
+#define MessageTrans_CloseFile        0x41504
+#define MessageTrans_GSLookup         0x41507
+
+/* DragASprite and DragAnObject */
+#define DragASprite_Start             0x42400
+#define DragASprite_Stop              0x42401
+#define DragAnObject_Start            0x49C40
+#define DragAnObject_Stop             0x49C41
+
+/* JPEG */
+#define JPEG_Info                     0x49980
+#define JPEG_FileInfo                 0x49981
+#define JPEG_PlotScaled               0x49982
+#define JPEG_PlotFileScaled           0x49983
+#define JPEG_PlotTransformed          0x49984
+#define JPEG_PlotFileTransformed      0x49985
+
+/* Toolbox */
+#define Toolbox_CreateObject          0x44EC0
+#define Toolbox_DeleteObject          0x44EC1
+#define Toolbox_ShowObject            0x44EC3
+#define Toolbox_HideObject            0x44EC4
+#define Toolbox_GetObjectState        0x44EC5
+#define Toolbox_ObjectMiscOp          0x44EC6
+#define Toolbox_SetClientHandle       0x44EC7
+#define Toolbox_GetClientHandle       0x44EC8
+#define Toolbox_GetObjectClass        0x44EC9
+#define Toolbox_GetParent             0x44ECA
+#define Toolbox_GetAncestor           0x44ECB
+#define Toolbox_GetTemplateName       0x44ECC
+#define Toolbox_RaiseToolboxEvent     0x44ECD
+#define Toolbox_GetSysInfo            0x44ECE
+#define Toolbox_Initialise            0x44ECF
+
+/* Window */
+#define Window_GetPointerInfo         0x82883
+#define Window_WimpToToolbox          0x82884
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+_kernel_oserror *_swix(int swi_no, unsigned int mask, ...);
+int _swi(int swi_no, unsigned int mask, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "jobqueue.h"
+
+#include <algorithm>
+
+namespace tbx
+{
+
+/**
+ * Construct an empty job queue
+ *
+ * @param clock function to read the current time, defaults to monotonic_time
+ */
+JobQueue::JobQueue(Clock clock /*= monotonic_time*/) :
+	_clock(clock),
+	_budget(2)
+{
+}
+
+/**
+ * Add a job to the queue.
+ *
+ * If the job is already in the queue its priority and listener
+ * are updated.
+ *
+ * @param job job to add
+ * @param priority priority of the job, higher priority jobs run first
+ * @param listener listener for progress and completion or 0 for none
+ */
+void JobQueue::add(BackgroundJob *job, int priority, BackgroundJobListener *listener)
+{
+	int index = find(job);
+	if (index >= 0) _jobs.erase(_jobs.begin() + index);
+
+	Item item;
+	item.job = job;
+	item.priority = priority;
+	item.listener = listener;
+	item.last_progress = -1;
+
+	// Keep the queue in priority order with new jobs at the end of their priority
+	std::vector<Item>::iterator pos = _jobs.begin();
+	while (pos != _jobs.end() && pos->priority >= priority) ++pos;
+	_jobs.insert(pos, item);
+}
+
+/**
+ * Remove a job from the queue.
+ *
+ * The listener is not told about jobs that are removed.
+ *
+ * @param job job to remove
+ * @returns true if the job was found and removed
+ */
+bool JobQueue::remove(BackgroundJob *job)
+{
+	int index = find(job);
+	if (index < 0) return false;
+	_jobs.erase(_jobs.begin() + index);
+	return true;
+}
+
+/**
+ * Check if a job is in the queue
+ *
+ * @param job job to check
+ * @returns true if the job is waiting to run
+ */
+bool JobQueue::contains(BackgroundJob *job) const
+{
+	return (find(job) >= 0);
+}
+
+/**
+ * Run job steps until the time budget is used or there are no
+ * more jobs.
+ */
+void JobQueue::process()
+{
+	if (_jobs.empty()) return;
+
+	unsigned int start = _clock();
+	do
+	{
+		run_step();
+	} while (!_jobs.empty() && monotonic_elapsed(start, _clock()) < _budget);
+}
+
+/**
+ * Find the position of a job in the queue
+ *
+ * @returns index of job or -1 if not in the queue
+ */
+int JobQueue::find(BackgroundJob *job) const
+{
+	for (unsigned int i = 0; i < _jobs.size(); i++)
+	{
+		if (_jobs[i].job == job) return (int)i;
+	}
+	return -1;
+}
+
+/**
+ * Run one step of the job at the front of the queue.
+ *
+ * The job or listener may change the queue, so the job is
+ * looked up again after each call out.
+ *
+ * @returns true if the job has more to do
+ */
+bool JobQueue::run_step()
+{
+	BackgroundJob *job = _jobs.front().job;
+	bool more;
+	try
+	{
+		more = job->step();
+	} catch(...)
+	{
+		// Let other jobs of the same priority run before this one is tried again
+		int index = find(job);
+		if (index >= 0) next_turn(index);
+		throw;
+	}
+
+	int index = find(job);
+	if (index < 0) return false; // Removed by the step
+
+	int percent = job->progress();
+	if (percent >= 0 && percent != _jobs[index].last_progress)
+	{
+		_jobs[index].last_progress = percent;
+		if (_jobs[index].listener)
+		{
+			_jobs[index].listener->job_progress(job, percent);
+			index = find(job);
+			if (index < 0) return false;
+		}
+	}
+
+	if (more)
+	{
+		next_turn(index);
+	} else
+	{
+		BackgroundJobListener *listener = _jobs[index].listener;
+		_jobs.erase(_jobs.begin() + index);
+		if (listener) listener->job_finished(job);
+	}
+
+	return more;
+}
+
+/**
+ * Move a job behind the other jobs with the same priority so
+ * they get the next turn.
+ *
+ * @param index position of the job in the queue
+ */
+void JobQueue::next_turn(unsigned int index)
+{
+	unsigned int end = index + 1;
+	while (end < _jobs.size() && _jobs[end].priority == _jobs[index].priority) end++;
+	std::rotate(_jobs.begin() + index, _jobs.begin() + index + 1, _jobs.begin() + end);
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_JOBQUEUE_H_
+#define TBX_JOBQUEUE_H_
+
+#include <vector>
+#include "backgroundjob.h"
+#include "monotonictime.h"
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Queue of background jobs run on null events by the EventRouter.
+ *
+ * Jobs with a higher priority are always stepped first, jobs of the
+ * same priority take turns a step at a time. Steps are run until the
+ * time budget for the null event has been used, at least one step is
+ * always run.
+ */
+class JobQueue
+{
+public:
+	/**
+	 * Function to return the current time in centiseconds
+	 */
+	typedef unsigned int (*Clock)();
+
+	JobQueue(Clock clock = monotonic_time);
+
+	/**
+	 * Get the function used to read the time
+	 */
+	Clock clock() const {return _clock;}
+	/**
+	 * Set the function used to read the time
+	 */
+	void clock(Clock clock) {_clock = clock;}
+
+	/**
+	 * Get the time budget for each call to process
+	 *
+	 * @returns time budget in centiseconds
+	 */
+	unsigned int budget() const {return _budget;}
+	/**
+	 * Set the time budget for each call to process
+	 *
+	 * @param budget time budget in centiseconds
+	 */
+	void budget(unsigned int budget) {_budget = budget;}
+
+	void add(BackgroundJob *job, int priority, BackgroundJobListener *listener);
+	bool remove(BackgroundJob *job);
+	bool contains(BackgroundJob *job) const;
+
+	/**
+	 * Check if there are any jobs waiting to run
+	 */
+	bool empty() const {return _jobs.empty();}
+	/**
+	 * Number of jobs waiting to run
+	 */
+	unsigned int size() const {return _jobs.size();}
+
+	void process();
+
+private:
+	int find(BackgroundJob *job) const;
+	bool run_step();
+	void next_turn(unsigned int index);
+
+	struct Item
+	{
+		BackgroundJob *job;
+		int priority;
+		BackgroundJobListener *listener;
+		int last_progress;
+	};
+
+	Clock _clock;
+	unsigned int _budget;
+	std::vector<Item> _jobs;
+};
+
+//! @endcond
+
+}
+
+#endif
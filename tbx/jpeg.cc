@@ -30,6 +30,7 @@
  */
 
 #include "jpeg.h"
+#include "jpeginfo.h"
 #include "kernel.h"
 #include <fstream>
 #include <cstring>
@@ -50,6 +51,7 @@ JPEG::JPEG(void)
 	_y_density = 0;
 	_extra_workspace = 0;
 	_plot_flags = 3;
+	_progressive = false;
 }
 
 /**
@@ -79,6 +81,8 @@ JPEG::JPEG(const JPEG &other)
 	_y_density = other._y_density;
 	_extra_workspace = other._extra_workspace;
 	_plot_flags = other._plot_flags;
+	_progressive = other._progressive;
+	_deferred_file = other._deferred_file;
 }
 
 /**
@@ -102,6 +106,8 @@ JPEG &JPEG::operator=(const JPEG &other)
 	_y_density = other._y_density;
 	_extra_workspace = other._extra_workspace;
 	_plot_flags = other._plot_flags;
+	_progressive = other._progressive;
+	_deferred_file = other._deferred_file;
 
 	return *this;
 }
@@ -109,12 +115,45 @@ JPEG &JPEG::operator=(const JPEG &other)
 /**
  * Load JPEG from file
  *
+ * If the body is deferred only the header of the file is read
+ * when it is loaded and the rest of the file is read the first
+ * time it is plotted. The size and density are available
+ * straight away, but extra_workspace() is not known until the
+ * image has been plotted.
+ *
  * @param file_name name of file to load from
+ * @param defer_body true to delay reading the image data until it is plotted.
+ * Default false to read it all immediately.
  * @returns true if load succeeded
  */
-bool JPEG::load(const std::string &file_name)
+bool JPEG::load(const std::string &file_name, bool defer_body /*= false*/)
 {
-	std::ifstream file(file_name.c_str());
+	if (defer_body)
+	{
+		JPEGInfo info;
+		if (!info.read(file_name)) return false;
+
+		delete [] _image;
+		_image = 0;
+		_size = 0;
+		_deferred_file = file_name;
+		_flags = (info.greyscale() ? 1 : 0) | (info.density_simple_ratio() ? 4 : 0);
+		_width = info.width();
+		_height = info.height();
+		_x_density = info.x_density();
+		_y_density = info.y_density();
+		if (info.density_units() == JPEGInfo::DOTS_PER_CM)
+		{
+			// JPEG module always gives the density in dots per inch
+			_x_density = (_x_density * 254 + 50) / 100;
+			_y_density = (_y_density * 254 + 50) / 100;
+		}
+		_extra_workspace = 0;
+		_progressive = info.progressive();
+		return true;
+	}
+
+	std::ifstream file(file_name.c_str(), std::ios_base::in | std::ios_base::binary);
 	bool loaded = false;
 
 	if (file.is_open())
@@ -126,6 +165,7 @@ bool JPEG::load(const std::string &file_name)
 			if (_image) delete[] _image;
 			_image = 0;
 			_size = 0;
+			_deferred_file.clear();
 			file.seekg(0, std::ios_base::beg);
 			_image = new unsigned char[size];
 			_size = size;
@@ -145,6 +185,8 @@ bool JPEG::load(const std::string &file_name)
 				_x_density = regs.r[4];
 				_y_density = regs.r[5];
 				_extra_workspace = regs.r[6];
+				JPEGInfo info;
+				_progressive = info.read(_image, _size) && info.progressive();
 				loaded = true;
 			} else
 			{
@@ -157,6 +199,53 @@ bool JPEG::load(const std::string &file_name)
 	return loaded;
 }
 
+/**
+ * Read the image data for a JPEG loaded with its body deferred.
+ *
+ * If the data can not be read the JPEG is marked as invalid
+ * so it isn't tried again.
+ *
+ * @returns true if the image data is now in memory
+ */
+bool JPEG::load_body() const
+{
+	if (_deferred_file.empty()) return false;
+
+	std::ifstream file(_deferred_file.c_str(), std::ios_base::in | std::ios_base::binary);
+	_deferred_file.clear();
+	if (!file.is_open()) return false;
+
+	file.seekg(0, std::ios_base::end);
+	int size = file.tellg();
+	if (size <= 0) return false;
+
+	file.seekg(0, std::ios_base::beg);
+	_image = new unsigned char[size];
+	_size = size;
+	file.read((char *)_image, _size);
+
+	_kernel_swi_regs regs;
+
+	regs.r[0] = 1; /* return dimensions */
+	regs.r[1] = reinterpret_cast<int>(_image);
+	regs.r[2] = _size;
+	// JPEG_Info switch call
+	if (_kernel_swi(0x49980, &regs, &regs) == 0)
+	{
+		// Use the values from the JPEG module from now on
+		_flags = regs.r[0];
+		_x_density = regs.r[4];
+		_y_density = regs.r[5];
+		_extra_workspace = regs.r[6];
+		return true;
+	}
+
+	delete [] _image;
+	_image = 0;
+	_size = 0;
+	return false;
+}
+
 /**
  * Plot jpeg to screen
  *
@@ -165,7 +254,7 @@ bool JPEG::load(const std::string &file_name)
  */
 void JPEG::plot(int x, int y) const
 {
-	if (_image == 0) return;
+	if (_image == 0 && !load_body()) return;
 
 	_kernel_swi_regs regs;
 
@@ -187,7 +276,7 @@ void JPEG::plot(int x, int y) const
  */
 void JPEG::plot(const Point &pos) const
 {
-	if (_image == 0) return;
+	if (_image == 0 && !load_body()) return;
 
 	_kernel_swi_regs regs;
 
@@ -212,7 +301,7 @@ void JPEG::plot(const Point &pos) const
  */
 void JPEG::plot(int x, int y, const ScaleFactors &sf)
 {
-	if (_image == 0) return;
+	if (_image == 0 && !load_body()) return;
 
 	_kernel_swi_regs regs;
 
@@ -234,7 +323,7 @@ void JPEG::plot(int x, int y, const ScaleFactors &sf)
  */
 void JPEG::plot(const BBox &bbox)
 {
-	if (_image == 0) return;
+	if (_image == 0 && !load_body()) return;
 
 	_kernel_swi_regs regs;
 
@@ -254,7 +343,7 @@ void JPEG::plot(const BBox &bbox)
  */
 void JPEG::plot(const DrawTransform &dt)
 {
-	if (_image == 0) return;
+	if (_image == 0 && !load_body()) return;
 
 	_kernel_swi_regs regs;
 
@@ -292,6 +381,9 @@ void JPEG::error_defused(bool error_defused)
 /**
  * Check if a file is a JPEG file
  *
+ * This uses the JPEG module. Use JPEGInfo to check the header
+ * of the file without calling the module.
+ *
  * @param file_name name of file to check
  * @returns true if it is a JPEG file
  */
@@ -311,6 +403,9 @@ bool JPEG::IsJPEGFile(const std::string &file_name)
  *
  * Pass 0 for any parameters not required
  *
+ * This uses the JPEG module. JPEGInfo reads the size and density
+ * from the header of the file without calling the module.
+ *
  * @param file_name name of file to get the information for
  * @param width set to width in pixels
  * @param height set to height in pixels
@@ -333,8 +428,8 @@ bool JPEG::GetFileInfo(const std::string &file_name, int *width, int *height, in
 	// JPEG_FileInfo
 	if (_kernel_swi(0x49981, &regs, &regs) == 0)
 	{
-		if (*width) *width = regs.r[2];
-		if (*height) *height = regs.r[3];
+		if (width) *width = regs.r[2];
+		if (height) *height = regs.r[3];
 		if (x_density) *x_density = regs.r[4];
 		if (y_density) *y_density = regs.r[5];
 		if (workspace) *workspace = regs.r[6];
@@ -48,15 +48,20 @@ namespace tbx {
 class JPEG : public Image
 {
 private:
-	unsigned char *_image;
-	int _size;
-	int _flags;
+	mutable unsigned char *_image;
+	mutable int _size;
+	mutable int _flags;
 	int _width;
 	int _height;
-	int _x_density;
-	int _y_density;
-	int _extra_workspace;
+	mutable int _x_density;
+	mutable int _y_density;
+	mutable int _extra_workspace;
 	int _plot_flags;
+	bool _progressive;
+	mutable std::string _deferred_file;
+
+	bool load_body() const;
+
 public:
 	JPEG();
 	JPEG(const JPEG &other);
@@ -68,7 +73,7 @@ public:
 	virtual void plot(int x, int y) const;
 	virtual void plot(const Point &pos) const;
 
-	bool load(const std::string &file_name);
+	bool load(const std::string &file_name, bool defer_body = false);
 
 	void plot(int x, int y, const ScaleFactors &sf);
 	void plot(const BBox &bbox);
@@ -95,7 +100,17 @@ public:
 	 *
 	 * @returns true if image is valid
 	 */
-	bool is_valid() const		{return (_image != 0);}
+	bool is_valid() const		{return (_image != 0 || !_deferred_file.empty());}
+
+	/**
+	 * Check if the image data has been loaded
+	 *
+	 * When a JPEG is loaded with the body deferred this returns false
+	 * until the image is first plotted.
+	 *
+	 * @returns true if the image data is in memory
+	 */
+	bool is_loaded() const		{return (_image != 0);}
 
 	/**
 	 * Get the width of image
@@ -114,18 +129,22 @@ public:
 	/**
 	 * Get the horizontal pixel density
 	 *
-	 * @returns horizontal pixel density
+	 * @returns horizontal pixel density in dots per inch or
+	 * only the aspect ratio if density_simple_ratio() is true.
 	 */
 	int x_density() const		{return _x_density;}
 	/**
 	 * Get the vertical pixel density
 	 *
-	 * @returns vertical pixel density
+	 * @returns vertical pixel density in dots per inch or
+	 * only the aspect ratio if density_simple_ratio() is true.
 	 */
 	int y_density() const		{return _y_density;}
 	/**
 	 * Return the extra memory required to plot this image
 	 *
+	 * This is not known until the image data has been loaded.
+	 *
 	 * @returns number of extra workspace bytes required
 	 */
 	int extra_workspace() const	{return _extra_workspace;}
@@ -148,6 +167,12 @@ public:
 	 * @returns true if the image has a simple density ratio
 	 */
 	bool density_simple_ratio() const		{return ((_flags & 4) != 0);}
+	/**
+	 * Check if this image uses progressive encoding
+	 *
+	 * @returns true if the image is progressive
+	 */
+	bool progressive() const				{return _progressive;}
 
 	static bool IsJPEGFile(const std::string &file_name);
 	static bool GetFileInfo(const std::string &file_name, int *width, int *height, int *x_density, int *y_density, int *workspace, bool *greyscale_image, bool *no_transform_plots, bool *pixel_density_is_simple_ratio);
@@ -0,0 +1,363 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "jpeginfo.h"
+#include <fstream>
+#include <cstring>
+
+namespace tbx {
+
+//! @cond INTERNAL
+/**
+ * Maximum amount of an APP segment read to look for the density
+ */
+const int MAX_APP_READ = 4096;
+
+/**
+ * Base class for the source of the JPEG header bytes
+ */
+class JPEGInfoSource
+{
+public:
+	virtual ~JPEGInfoSource() {}
+	virtual int read(unsigned char *buffer, int size) = 0;
+	virtual bool skip(int size) = 0;
+
+	/**
+	 * Read a single byte
+	 *
+	 * @returns byte read or -1 at the end of the data
+	 */
+	int byte()
+	{
+		unsigned char b;
+		return (read(&b, 1) == 1) ? b : -1;
+	}
+};
+
+/**
+ * Source to read the header from a file
+ */
+class JPEGInfoFileSource : public JPEGInfoSource
+{
+	std::ifstream &_file;
+public:
+	JPEGInfoFileSource(std::ifstream &file) : _file(file) {}
+
+	virtual int read(unsigned char *buffer, int size)
+	{
+		_file.read(reinterpret_cast<char *>(buffer), size);
+		return (int)_file.gcount();
+	}
+
+	virtual bool skip(int size)
+	{
+		// Seek so segments that aren't needed are not read
+		_file.seekg(size, std::ios_base::cur);
+		return _file.good();
+	}
+};
+
+/**
+ * Source to read the header from memory
+ */
+class JPEGInfoMemorySource : public JPEGInfoSource
+{
+	const unsigned char *_data;
+	int _size;
+	int _pos;
+public:
+	JPEGInfoMemorySource(const void *data, int size) :
+		_data(static_cast<const unsigned char *>(data)), _size(size), _pos(0) {}
+
+	virtual int read(unsigned char *buffer, int size)
+	{
+		if (size > _size - _pos) size = _size - _pos;
+		std::memcpy(buffer, _data + _pos, size);
+		_pos += size;
+		return size;
+	}
+
+	virtual bool skip(int size)
+	{
+		if (size > _size - _pos) return false;
+		_pos += size;
+		return true;
+	}
+};
+
+/**
+ * Class to scan the JPEG markers for the details
+ */
+class JPEGInfoScanner
+{
+	JPEGInfoSource &_source;
+	bool _jfif;
+	bool _exif_resolution;
+	int _exif_x, _exif_y, _exif_unit;
+
+	bool exif(const unsigned char *data, int size, int &orientation);
+	int exif_value(const unsigned char *tiff, int size, const unsigned char *entry, bool big_endian);
+
+public:
+	JPEGInfoScanner(JPEGInfoSource &source) : _source(source),
+		_jfif(false), _exif_resolution(false),
+		_exif_x(0), _exif_y(0), _exif_unit(0) {}
+
+	bool scan(int &width, int &height, int &x_density, int &y_density, JPEGInfo::DensityUnits &units,
+			int &components, bool &progressive, int &orientation);
+};
+
+/**
+ * Read a 16 bit value
+ */
+static inline unsigned int get16(const unsigned char *data, bool big_endian)
+{
+	return big_endian ? ((data[0] << 8) | data[1]) : (data[0] | (data[1] << 8));
+}
+
+/**
+ * Read a 32 bit value
+ */
+static inline unsigned int get32(const unsigned char *data, bool big_endian)
+{
+	return big_endian ? ((get16(data, true) << 16) | get16(data + 2, true))
+			: (get16(data, false) | (get16(data + 2, false) << 16));
+}
+
+/**
+ * Scan the markers up to the start of frame
+ *
+ * @returns true if a start of frame marker was found
+ */
+bool JPEGInfoScanner::scan(int &width, int &height, int &x_density, int &y_density, JPEGInfo::DensityUnits &units,
+		int &components, bool &progressive, int &orientation)
+{
+	unsigned char buffer[MAX_APP_READ];
+
+	// Start of image
+	if (_source.byte() != 0xFF || _source.byte() != 0xD8) return false;
+
+	while (true)
+	{
+		int marker = _source.byte();
+		if (marker != 0xFF) return false;
+		// Any number of fill bytes may precede a marker
+		while ((marker = _source.byte()) == 0xFF);
+		if (marker < 0) return false;
+
+		// Stand alone markers
+		if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) continue;
+		// End of image or start of scan before the frame header
+		if (marker == 0xD9 || marker == 0xDA) return false;
+
+		if (_source.read(buffer, 2) != 2) return false;
+		int length = get16(buffer, true) - 2;
+		if (length < 0) return false;
+
+		if (marker >= 0xC0 && marker <= 0xCF
+			&& marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+		{
+			// Start of frame
+			if (length < 6 || _source.read(buffer, 6) != 6) return false;
+			height = get16(buffer + 1, true);
+			width = get16(buffer + 3, true);
+			components = buffer[5];
+			progressive = ((marker & 3) == 2);
+			if (_jfif || !_exif_resolution) return (components != 0);
+
+			x_density = _exif_x;
+			y_density = _exif_y;
+			units = (_exif_unit == 3) ? JPEGInfo::DOTS_PER_CM : JPEGInfo::DOTS_PER_INCH;
+			return (components != 0);
+		}
+
+		int used = 0;
+		if (marker == 0xE0 && !_jfif)
+		{
+			used = (length < 14) ? length : 14;
+			if (_source.read(buffer, used) != used) return false;
+			if (used == 14 && std::memcmp(buffer, "JFIF", 5) == 0)
+			{
+				_jfif = true;
+				switch(buffer[7])
+				{
+				case 1: units = JPEGInfo::DOTS_PER_INCH; break;
+				case 2: units = JPEGInfo::DOTS_PER_CM; break;
+				default: units = JPEGInfo::NO_UNITS; break;
+				}
+				x_density = get16(buffer + 8, true);
+				y_density = get16(buffer + 10, true);
+			}
+		} else if (marker == 0xE1)
+		{
+			used = (length < MAX_APP_READ) ? length : MAX_APP_READ;
+			if (_source.read(buffer, used) != used) return false;
+			if (used > 6 && std::memcmp(buffer, "Exif\0", 6) == 0)
+			{
+				exif(buffer + 6, used - 6, orientation);
+			}
+		}
+
+		if (length > used && !_source.skip(length - used)) return false;
+	}
+
+	return false;
+}
+
+/**
+ * Read the resolution and orientation from the first EXIF IFD
+ *
+ * @param tiff TIFF header following the EXIF identifier
+ * @param size size of data available
+ * @param orientation updated with the orientation if found
+ * @returns true if the data was valid
+ */
+bool JPEGInfoScanner::exif(const unsigned char *tiff, int size, int &orientation)
+{
+	if (size < 8) return false;
+	bool big_endian;
+	if (tiff[0] == 'M' && tiff[1] == 'M') big_endian = true;
+	else if (tiff[0] == 'I' && tiff[1] == 'I') big_endian = false;
+	else return false;
+	if (get16(tiff + 2, big_endian) != 42) return false;
+
+	unsigned int ifd = get32(tiff + 4, big_endian);
+	if (ifd > (unsigned int)size - 2) return false;
+	int entries = get16(tiff + ifd, big_endian);
+	const unsigned char *entry = tiff + ifd + 2;
+	const unsigned char *end = tiff + size;
+
+	for (int j = 0; j < entries && entry + 12 <= end; j++, entry += 12)
+	{
+		switch(get16(entry, big_endian))
+		{
+		case 0x0112: // Orientation
+			{
+				int value = get16(entry + 8, big_endian);
+				if (value >= 1 && value <= 8) orientation = value;
+			}
+			break;
+		case 0x011A: // XResolution
+			_exif_x = exif_value(tiff, size, entry, big_endian);
+			break;
+		case 0x011B: // YResolution
+			_exif_y = exif_value(tiff, size, entry, big_endian);
+			break;
+		case 0x0128: // ResolutionUnit
+			_exif_unit = get16(entry + 8, big_endian);
+			break;
+		}
+	}
+
+	_exif_resolution = (_exif_x > 0 && _exif_y > 0 && _exif_unit != 1);
+	return true;
+}
+
+/**
+ * Get a rational EXIF value rounded to the nearest integer
+ *
+ * @returns value or 0 if it could not be read
+ */
+int JPEGInfoScanner::exif_value(const unsigned char *tiff, int size, const unsigned char *entry, bool big_endian)
+{
+	if (get16(entry + 2, big_endian) != 5) return 0; // Not RATIONAL
+	unsigned int offset = get32(entry + 8, big_endian);
+	if (size < 8 || offset > (unsigned int)size - 8) return 0;
+	unsigned int num = get32(tiff + offset, big_endian);
+	unsigned int den = get32(tiff + offset + 4, big_endian);
+	if (den == 0) return 0;
+	return (int)((num + den / 2) / den);
+}
+//! @endcond
+
+/**
+ * Construct with no details
+ */
+JPEGInfo::JPEGInfo() :
+	_width(0),
+	_height(0),
+	_x_density(0),
+	_y_density(0),
+	_density_units(NO_UNITS),
+	_components(0),
+	_progressive(false),
+	_orientation(1)
+{
+}
+
+/**
+ * Read the details from the header of a JPEG file
+ *
+ * Only the start of the file up to the frame header is read.
+ *
+ * @param file_name name of the file to read
+ * @returns true if the file is a JPEG with a valid header
+ */
+bool JPEGInfo::read(const std::string &file_name)
+{
+	std::ifstream file(file_name.c_str(), std::ios_base::in | std::ios_base::binary);
+	if (!file.is_open())
+	{
+		*this = JPEGInfo();
+		return false;
+	}
+
+	JPEGInfoFileSource source(file);
+	JPEGInfoScanner scanner(source);
+	*this = JPEGInfo();
+	_x_density = _y_density = 1;
+	if (!scanner.scan(_width, _height, _x_density, _y_density, _density_units,
+			_components, _progressive, _orientation))
+	{
+		*this = JPEGInfo();
+	}
+
+	return is_valid();
+}
+
+/**
+ * Read the details from a JPEG in memory
+ *
+ * @param data pointer to the start of the JPEG data
+ * @param size size of the data. This only needs to include the
+ * data up to the frame header.
+ * @returns true if the data is a JPEG with a valid header
+ */
+bool JPEGInfo::read(const void *data, int size)
+{
+	JPEGInfoMemorySource source(data, size);
+	JPEGInfoScanner scanner(source);
+	*this = JPEGInfo();
+	_x_density = _y_density = 1;
+	if (!scanner.scan(_width, _height, _x_density, _y_density, _density_units,
+			_components, _progressive, _orientation))
+	{
+		*this = JPEGInfo();
+	}
+
+	return is_valid();
+}
+
+}
@@ -0,0 +1,154 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_JPEGINFO_H_
+#define TBX_JPEGINFO_H_
+
+#include <string>
+
+namespace tbx {
+
+/**
+ * Class to read the details of a JPEG image from its header.
+ *
+ * The markers at the start of the JPEG are scanned natively up
+ * to the start of frame marker so only the first few kilobytes of
+ * the file are read and no SWIs are called. This makes it suitable
+ * for quickly probing a large number of files.
+ *
+ * The density is taken from the JFIF header or, if there isn't
+ * one, from the EXIF resolution.
+ */
+class JPEGInfo
+{
+public:
+	/**
+	 * Units for the density of the image
+	 */
+	enum DensityUnits
+	{
+		NO_UNITS,       //!< density gives the pixel aspect ratio only
+		DOTS_PER_INCH,  //!< density is in dots per inch
+		DOTS_PER_CM     //!< density is in dots per centimetre
+	};
+
+private:
+	int _width;
+	int _height;
+	int _x_density;
+	int _y_density;
+	DensityUnits _density_units;
+	int _components;
+	bool _progressive;
+	int _orientation;
+
+public:
+	JPEGInfo();
+
+	bool read(const std::string &file_name);
+	bool read(const void *data, int size);
+
+	/**
+	 * Check if the header has been read successfully
+	 *
+	 * @returns true if the details are valid
+	 */
+	bool is_valid() const {return (_components != 0);}
+
+	/**
+	 * Get the width of the image
+	 *
+	 * @returns width of image in pixels
+	 */
+	int width() const {return _width;}
+
+	/**
+	 * Get the height of the image
+	 *
+	 * @returns height of image in pixels. This can be 0 if the height
+	 * is defined later in the file.
+	 */
+	int height() const {return _height;}
+
+	/**
+	 * Get the horizontal pixel density
+	 *
+	 * @returns horizontal pixel density in density_units()
+	 */
+	int x_density() const {return _x_density;}
+
+	/**
+	 * Get the vertical pixel density
+	 *
+	 * @returns vertical pixel density in density_units()
+	 */
+	int y_density() const {return _y_density;}
+
+	/**
+	 * Get the units of the pixel density
+	 *
+	 * @returns units for x_density() and y_density()
+	 */
+	DensityUnits density_units() const {return _density_units;}
+
+	/**
+	 * Check if the density is only a simple ratio
+	 *
+	 * @returns true if the density has no units
+	 */
+	bool density_simple_ratio() const {return (_density_units == NO_UNITS);}
+
+	/**
+	 * Get the number of colour components in the image
+	 *
+	 * @returns number of components (1 for greyscale, 3 for YCbCr, 4 for CMYK)
+	 */
+	int components() const {return _components;}
+
+	/**
+	 * Check if the image is grey scale
+	 *
+	 * @returns true if the image has a single colour component
+	 */
+	bool greyscale() const {return (_components == 1);}
+
+	/**
+	 * Check if the image is progressive
+	 *
+	 * @returns true if the image uses progressive encoding
+	 */
+	bool progressive() const {return _progressive;}
+
+	/**
+	 * Get the EXIF orientation of the image
+	 *
+	 * @returns orientation from 1 to 8 or 1 (normal) if the
+	 * image does not specify it
+	 */
+	int orientation() const {return _orientation;}
+};
+
+}
+
+#endif /* TBX_JPEGINFO_H_ */
@@ -321,7 +321,7 @@ void LoaderManager::start_loader(WimpMessageEvent &msg_event, int reply_to)
 	find_loading(msg_event, reply_to);
 	if (_loading)
 	{
-		_loading->_data_save_reply = new WimpMessage(msg, 14);
+		_loading->_data_save_reply = new WimpMessage(msg, 15);
 		_loading->_data_save_reply->message_id(2); // DataSaveAck
 		_loading->_data_save_reply->your_ref(msg.my_ref());
 		_loading->_data_save_reply->word(9) = -1; // Save is unsafe i.e. not to a filer
@@ -66,13 +66,15 @@ namespace tbx
 	 * Compare if one time is less than another taking into account
 	 * wrap around.
 	 *
+	 * The times are assumed to be less than half the range of an unsigned
+	 * int (about 248 days) apart, so 0xFFFFFFFF is less than 0.
+	 *
 	 * @param compare value to check to see if it is less than
 	 * @param to value to compare to
 	 * @returns true if compare < to.
 	 */
 	inline bool monotonic_lt(unsigned int compare, unsigned int to)
 	{
-		if (to >= compare) return false;
 		return (compare - to) > 0x7FFFFFFF;
 	}
 
@@ -86,9 +88,7 @@ namespace tbx
 	 */
 	inline bool monotonic_le(unsigned int compare, unsigned int to)
 	{
-		if (to > compare) return false;
-		if (to == compare) return true;
-		return (compare - to) > 0x7FFFFFFF;
+		return (compare == to) || (compare - to) > 0x7FFFFFFF;
 	}
 
 	/**
@@ -101,8 +101,7 @@ namespace tbx
 	 */
 	inline bool monotonic_gt(unsigned int compare, unsigned int to)
 	{
-		if (compare > to) return true;
-		return (compare - to) < 0x7FFFFFFF;
+		return (compare != to) && (compare - to) <= 0x7FFFFFFF;
 	}
 
 	/**
@@ -115,9 +114,7 @@ namespace tbx
 	 */
 	inline bool monotonic_ge(unsigned int compare, unsigned int to)
 	{
-		if (compare > to) return true;
-		if (compare == to) return true;
-		return (compare - to) < 0x7FFFFFFF;
+		return (compare - to) <= 0x7FFFFFFF;
 	}
 }
 
@@ -0,0 +1,211 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "pollstats.h"
+#include <ostream>
+#include <iomanip>
+
+namespace tbx
+{
+
+/**
+ * Construct an empty statistics item
+ */
+PollStatsItem::PollStatsItem() :
+	count(0), total_time(0), max_time(0), over_budget(0)
+{
+	for (int j = 0; j < HISTOGRAM_SIZE; j++) histogram[j] = 0;
+}
+
+/**
+ * Add a time to the statistics
+ *
+ * @param time time taken to process the event
+ * @param over true if the time was over the budget
+ */
+void PollStatsItem::add(unsigned int time, bool over)
+{
+	count++;
+	total_time += time;
+	if (time > max_time) max_time = time;
+	if (over) over_budget++;
+
+	int bucket = 0;
+	while (time && bucket < HISTOGRAM_SIZE - 1)
+	{
+		bucket++;
+		time >>= 1;
+	}
+	histogram[bucket]++;
+}
+
+/**
+ * Construct poll statistics with no budget or automatic dump.
+ *
+ * @param clock function used to read the time
+ */
+PollStats::PollStats(Clock clock /*= monotonic_time*/) :
+	_clock(clock),
+	_budget(0),
+	_polls(0),
+	_dump_interval(0),
+	_dump_stream(0),
+	_last_dump(0)
+{
+}
+
+PollStats::~PollStats()
+{
+}
+
+/**
+ * Set the statistics to be dumped to a stream at a regular interval.
+ *
+ * The dump is written after an event has been processed when the
+ * interval has elapsed since the last dump.
+ *
+ * @param interval time in clock units between dumps or 0 to stop the dumps
+ * @param os stream to dump the statistics to. It must exist
+ * until the dump is stopped.
+ */
+void PollStats::dump_interval(unsigned int interval, std::ostream *os)
+{
+	_dump_interval = interval;
+	_dump_stream = (interval) ? os : 0;
+	_last_dump = _clock();
+}
+
+/**
+ * Get the statistics for a code
+ *
+ * @param category category of the code
+ * @param code poll reason code, toolbox event number or message number
+ * @returns pointer to the statistics or 0 if there are none recorded
+ */
+const PollStatsItem *PollStats::item(Category category, int code) const
+{
+	ItemMap::const_iterator found = _items[category].find(code);
+	return (found == _items[category].end()) ? 0 : &found->second;
+}
+
+/**
+ * Clear all the statistics
+ */
+void PollStats::reset()
+{
+	_polls = 0;
+	for (int c = 0; c < NUM_CATEGORIES; c++) _items[c].clear();
+}
+
+/**
+ * Write the statistics to a stream as text.
+ *
+ * There is one line for each code with the count, total, maximum
+ * and number of times over budget followed by the histogram.
+ *
+ * @param os stream to write to
+ */
+void PollStats::dump(std::ostream &os) const
+{
+	static const char *names[NUM_CATEGORIES] = {"Reason", "Toolbox", "Message"};
+
+	os << "Poll statistics: " << _polls << " events, budget " << _budget << std::endl;
+	for (int c = 0; c < NUM_CATEGORIES; c++)
+	{
+		for (ItemMap::const_iterator i = _items[c].begin(); i != _items[c].end(); ++i)
+		{
+			const PollStatsItem &item = i->second;
+			os << names[c] << " &" << std::hex << i->first << std::dec
+				<< " count " << item.count
+				<< " total " << item.total_time
+				<< " max " << item.max_time
+				<< " over " << item.over_budget
+				<< " histogram";
+			int last = PollStatsItem::HISTOGRAM_SIZE - 1;
+			while (last > 0 && item.histogram[last] == 0) last--;
+			for (int j = 0; j <= last; j++) os << " " << item.histogram[j];
+			os << std::endl;
+		}
+	}
+}
+
+/**
+ * Get the detailed code for an event returned from Wimp_Poll.
+ *
+ * This must be read before the event is processed as the
+ * poll block may be reused while it is processed.
+ *
+ * @param reason_code reason code returned from Wimp_Poll
+ * @param poll_block poll block returned from Wimp_Poll
+ * @returns toolbox event code, message number or 0 for other events
+ */
+int PollStats::event_code(int reason_code, const PollBlock &poll_block)
+{
+	if (reason_code == 0x200) return poll_block.word[2];
+	if (reason_code >= 17 && reason_code <= 19) return poll_block.word[4];
+	return 0;
+}
+
+/**
+ * Record the time taken to process an event.
+ *
+ * This is called by the event loop after each event has been processed.
+ *
+ * @param reason_code reason code returned from Wimp_Poll
+ * @param event_code toolbox event code or message number from event_code()
+ * @param start_time time from the clock when the event was received
+ */
+void PollStats::processed(int reason_code, int event_code, unsigned int start_time)
+{
+	unsigned int end_time = _clock();
+	unsigned int time = monotonic_elapsed(start_time, end_time);
+	bool over = (_budget != 0 && time > _budget);
+
+	_polls++;
+	_items[REASON_CODE][reason_code].add(time, over);
+
+	// Report over budget with the most detailed code available
+	Category category = REASON_CODE;
+	int code = reason_code;
+	if (reason_code == 0x200)
+	{
+		category = TOOLBOX_EVENT;
+		code = event_code;
+		_items[category][code].add(time, over);
+	} else if (reason_code >= 17 && reason_code <= 19)
+	{
+		category = WIMP_MESSAGE;
+		code = event_code;
+		_items[category][code].add(time, over);
+	}
+	if (over) over_budget(category, code, time);
+
+	if (_dump_stream && monotonic_elapsed(_last_dump, end_time) >= _dump_interval)
+	{
+		dump(*_dump_stream);
+		_last_dump = end_time;
+	}
+}
+
+}
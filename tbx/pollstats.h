@@ -0,0 +1,181 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_POLLSTATS_H_
+#define TBX_POLLSTATS_H_
+
+#include <map>
+#include <iosfwd>
+#include "pollinfo.h"
+#include "monotonictime.h"
+
+namespace tbx
+{
+
+/**
+ * Statistics for one type of event processed after Wimp_Poll
+ */
+struct PollStatsItem
+{
+	/**
+	 * Number of buckets in the time histogram
+	 */
+	static const int HISTOGRAM_SIZE = 16;
+
+	unsigned int count;       ///< Number of times the event was processed
+	unsigned int total_time;  ///< Total time processing the event
+	unsigned int max_time;    ///< Longest time processing the event
+	unsigned int over_budget; ///< Number of times processing took longer than the budget
+	/**
+	 * Histogram of processing times.
+	 *
+	 * Bucket 0 counts times of 0, bucket n counts times from
+	 * 2^(n-1) to 2^n - 1. The last bucket also counts all longer times.
+	 */
+	unsigned int histogram[HISTOGRAM_SIZE];
+
+	PollStatsItem();
+	void add(unsigned int time, bool over);
+};
+
+/**
+ * Class to record how long the application takes to process
+ * each event returned from Wimp_Poll.
+ *
+ * Set it on the application with Application::set_poll_stats to
+ * start recording. When no PollStats is set the event loop only has
+ * the cost of checking for it.
+ *
+ * Times are recorded for each poll reason code, toolbox event
+ * action and WIMP message number. The times are in the units of
+ * the clock function which defaults to the monotonic time in
+ * centiseconds. Set the clock to a higher resolution timer to get
+ * more accurate results.
+ *
+ * Override over_budget to be told when processing an event takes
+ * longer than the budget.
+ */
+class PollStats
+{
+public:
+	/**
+	 * Function to return the current time
+	 */
+	typedef unsigned int (*Clock)();
+
+	/**
+	 * Type of code the statistics are recorded for
+	 */
+	enum Category
+	{
+		REASON_CODE,   ///< Wimp_Poll reason code
+		TOOLBOX_EVENT, ///< Toolbox event action for reason code 0x200
+		WIMP_MESSAGE,  ///< Message number for reason codes 17, 18 and 19
+		NUM_CATEGORIES ///< Number of categories
+	};
+
+	/**
+	 * Map from a code to its statistics
+	 */
+	typedef std::map<int, PollStatsItem> ItemMap;
+
+	PollStats(Clock clock = monotonic_time);
+	virtual ~PollStats();
+
+	/**
+	 * Get the function used to read the time
+	 */
+	Clock clock() const {return _clock;}
+	/**
+	 * Set the function used to read the time
+	 */
+	void clock(Clock clock) {_clock = clock;}
+	/**
+	 * Get the current time from the clock
+	 */
+	unsigned int now() const {return _clock();}
+
+	/**
+	 * Get the time budget for processing an event
+	 *
+	 * @returns budget in clock units or 0 if there is no budget
+	 */
+	unsigned int budget() const {return _budget;}
+	/**
+	 * Set the time budget for processing an event.
+	 *
+	 * @param budget maximum time in clock units that an event should
+	 * take to process or 0 for no budget.
+	 */
+	void budget(unsigned int budget) {_budget = budget;}
+
+	void dump_interval(unsigned int interval, std::ostream *os);
+	/**
+	 * Get the interval between automatic dumps of the statistics
+	 */
+	unsigned int dump_interval() const {return _dump_interval;}
+
+	/**
+	 * Get the statistics for all the codes in a category
+	 *
+	 * @param category category to return the statistics for
+	 */
+	const ItemMap &items(Category category) const {return _items[category];}
+	const PollStatsItem *item(Category category, int code) const;
+	/**
+	 * Number of events processed since the statistics were last reset
+	 */
+	unsigned int polls() const {return _polls;}
+
+	void reset();
+	void dump(std::ostream &os) const;
+
+	static int event_code(int reason_code, const PollBlock &poll_block);
+	void processed(int reason_code, int event_code, unsigned int start_time);
+
+	/**
+	 * Called when processing an event has taken longer than the budget.
+	 *
+	 * Override to report slow events. It is called after the event has
+	 * been processed. The default implementation does nothing.
+	 *
+	 * @param category category of code
+	 * @param code reason code, toolbox event or message number that was over budget
+	 * @param time time taken to process the event
+	 */
+	virtual void over_budget(Category category, int code, unsigned int time) {}
+
+private:
+	Clock _clock;
+	unsigned int _budget;
+	unsigned int _polls;
+	ItemMap _items[NUM_CATEGORIES];
+	unsigned int _dump_interval;
+	std::ostream *_dump_stream;
+	unsigned int _last_dump;
+};
+
+}
+
+#endif
@@ -341,6 +341,7 @@ void ResRelocationTable::pointers_to_offsets(char *body, char *strings, char *ms
  */
 ResData::ResData(ResDataHeader header, char *all_strings, int num_reloc, ResRelocation *relocs)
 {
+	_pending = 0;
 	_strings = 0;
 	_messages = 0;
 	_strings_size = 0;
@@ -377,6 +378,7 @@ ResData::ResData(ResDataHeader header, char *all_strings, int num_reloc, ResRelo
  */
 ResData::ResData(const ResData &other)
 {
+	_pending = 0;
 	if (other._reloc_table._size == 0)
 	{
 		_messages_size = _strings_size = 0;
@@ -407,6 +409,7 @@ ResData::ResData(const ResData &other)
  */
 ResData::ResData()
 {
+	_pending = 0;
 	_strings = 0;
 	_strings_size = 0;
 	_messages = 0;
@@ -417,6 +420,155 @@ ResData::~ResData()
 {
 	free_string_table(_strings);
 	free_string_table(_messages);
+	if (_pending)
+	{
+		for (std::vector<char *>::iterator i = _pending->begin(); i != _pending->end(); ++i)
+		{
+			delete [] *i;
+		}
+		delete _pending;
+	}
+}
+
+/**
+ * Make a copy of this data for a copy of the body it belongs to
+ *
+ * @param new_body body of the copy
+ * @param old_body body this data belongs to
+ * @returns new copy of the data with the pointers in new_body updated
+ */
+ResData *ResData::copy(char *new_body, const char *old_body) const
+{
+	ResData *data;
+	if (_pending == 0)
+	{
+		data = new ResData(*this);
+		data->_reloc_table.fix_all_pointers(new_body, old_body,
+				data->_strings, _strings,
+				data->_messages, _messages);
+	} else
+	{
+		// The tables are out of date during a batch edit so build new ones
+		data = new ResData();
+		data->_reloc_table = _reloc_table;
+		data->_reloc_table.fix_all_pointers(new_body, old_body, 0, 0, 0, 0);
+		data->build_tables(new_body);
+	}
+
+	return data;
+}
+
+/**
+ * Start a batch edit.
+ *
+ * Until end_batch is called text that is changed is stored
+ * separately instead of updating the string and message tables.
+ */
+void ResData::begin_batch()
+{
+	if (_pending == 0) _pending = new std::vector<char *>();
+}
+
+/**
+ * End a batch edit rebuilding the string and message tables
+ * in one pass.
+ *
+ * @param body body the data belongs to
+ */
+void ResData::end_batch(char *body)
+{
+	if (_pending == 0) return;
+
+	char *old_strings = _strings;
+	char *old_messages = _messages;
+	build_tables(body);
+	free_string_table(old_strings);
+	free_string_table(old_messages);
+
+	for (std::vector<char *>::iterator i = _pending->begin(); i != _pending->end(); ++i)
+	{
+		delete [] *i;
+	}
+	delete _pending;
+	_pending = 0;
+}
+
+/**
+ * Store a copy of text changed during a batch edit
+ *
+ * @param text text to store
+ * @param len length of text or -1 to calculate it
+ * @returns pointer to the copy
+ */
+char *ResData::add_pending(const char *text, int len)
+{
+	if (len == -1) len = std::strlen(text);
+	char *copy = new char[len + 1];
+	std::memcpy(copy, text, len);
+	copy[len] = 0;
+	_pending->push_back(copy);
+
+	return copy;
+}
+
+/**
+ * Build new string and message tables from the text pointed
+ * to by the body.
+ *
+ * The existing tables are not deleted as the text may be in them.
+ *
+ * @param body body the data belongs to
+ */
+void ResData::build_tables(char *body)
+{
+	int strings_size = 0;
+	int messages_size = 0;
+	int idx;
+
+	for (idx = 0; idx < _reloc_table._size; idx++)
+	{
+		switch (_reloc_table._relocs[idx].type)
+		{
+		case ResRelocation::STRING_REF:
+			strings_size += text_len(body, _reloc_table._relocs[idx].offset);
+			break;
+		case ResRelocation::MESSAGE_REF:
+			messages_size += text_len(body, _reloc_table._relocs[idx].offset);
+			break;
+		default:
+			// Other types are not strings so do nothing
+			break;
+		}
+	}
+
+	_strings = (strings_size) ? alloc_string_table(strings_size) : 0;
+	_strings_size = strings_size;
+	_messages = (messages_size) ? alloc_string_table(messages_size) : 0;
+	_messages_size = messages_size;
+
+	char *pstr = _strings;
+	char *pmsg = _messages;
+
+	for (idx = 0; idx < _reloc_table._size; idx++)
+	{
+		const ResRelocation &reloc = _reloc_table._relocs[idx];
+		char **pto;
+		switch (reloc.type)
+		{
+		case ResRelocation::STRING_REF: pto = &pstr; break;
+		case ResRelocation::MESSAGE_REF: pto = &pmsg; break;
+		default: continue; // Other types are not strings
+		}
+
+		const char *from = text(body, reloc.offset);
+		if (from)
+		{
+			int len = std::strlen(from) + 1;
+			std::memcpy(*pto, from, len);
+			number(body, reloc.offset, (int)*pto);
+			*pto += len;
+		}
+	}
 }
 
 /**
@@ -450,17 +602,18 @@ void ResData::calculate_string_sizes(const char *body)
  */
 void ResData::write(std::ostream &file) const
 {
+	// Tables are padded to a word boundary with zeros so the
+	// file does not depend on what was left in the padding
+	static const char padding[4] = {0, 0, 0, 0};
 	if (_strings_size)
 	{
-		// tables are created padded to word boundary
-		int table_size= (_strings_size +3) &~3;
-		file.write(_strings, table_size);
+		file.write(_strings, _strings_size);
+		file.write(padding, ((_strings_size + 3) & ~3) - _strings_size);
 	}
 	if (_messages_size)
 	{
-		// tables are created padded to word boundary
-		int table_size= (_messages_size +3) &~3;
-		file.write(_messages, table_size);
+		file.write(_messages, _messages_size);
+		file.write(padding, ((_messages_size + 3) & ~3) - _messages_size);
 	}
 	if (_reloc_table._size)
 	{
@@ -491,6 +644,13 @@ int ResData::text_len(const char *body, int offset) const
  */
 void ResData::text(char *body, int offset, const char *new_text, int new_len, bool is_string)
 {
+	if (_pending)
+	{
+		// Tables are rebuilt when the batch edit ends
+		number(body, offset, (new_text == 0) ? 0 : (int)add_pending(new_text, new_len));
+		return;
+	}
+
 	const char *old_text = text(body, offset);
 	int old_len = 0;
 	if (old_text != 0) old_len = std::strlen(old_text) + 1;
@@ -541,6 +701,9 @@ void ResData::init_text(char *body, int offset, const char *value, bool is_strin
 	if (value == 0)
 	{
 		*ptext = 0;
+	} else if (_pending)
+	{
+		*ptext = (int)add_pending(value, -1);
 	} else
 	{
 		char *pstr = insert_chars(body, is_string,
@@ -943,45 +1106,28 @@ void ResData::copy_strings_and_messages(char *new_body, const char *copy_body)
 	if (_messages_size) _messages = alloc_string_table(_messages_size);
 	char *pstr = _strings;
 	char *pmsg = _messages;
-	char **pcopy;
 	char **pto;
 
 	for (relocIdx = 0; relocIdx < _reloc_table._size; relocIdx++)
 	{
-		ResRelocation &reloc = _reloc_table._relocs[relocIdx];
+		const ResRelocation &reloc = _reloc_table._relocs[relocIdx];
 		switch(reloc.type)
 		{
-		case ResRelocation::STRING_REF:
-			pcopy = (char **)(copy_body + reloc.offset);
-			pto = (char **)(new_body + reloc.offset);
-			if (*pcopy)
-			{
-				*pto = pstr;
-				strcpy(pstr, *pcopy);
-				pstr += strlen(pstr)+1;
-			} else
-			{
-				*pto = 0;
-			}		
-			break;
-
-		case ResRelocation::MESSAGE_REF:
-			pcopy = (char **)(copy_body + reloc.offset);
-			pto = (char **)(new_body + reloc.offset);
-			if (*pcopy)
-			{
-				*pto = pmsg;
-				strcpy(pmsg, *pcopy);
-				pmsg += strlen(pmsg)+1;
-			} else
-			{
-				*pto = 0;
-			}		
-			break;
+		case ResRelocation::STRING_REF: pto = &pstr; break;
+		case ResRelocation::MESSAGE_REF: pto = &pmsg; break;
+		default: continue; // Other types are not strings
+		}
 
-		default:
-			// Other types are not strings so do nothing
-			break;
+		// Text pointers are 32 bit values in the body
+		const char *from = text(copy_body, reloc.offset);
+		if (from)
+		{
+			number(new_body, reloc.offset, (int)*pto);
+			std::strcpy(*pto, from);
+			*pto += std::strlen(*pto) + 1;
+		} else
+		{
+			number(new_body, reloc.offset, 0);
 		}
 	}
 }
@@ -1030,19 +1176,28 @@ void ResData::add_data_from(char *body, int offset, const char *from_body, const
 /**
  * Fix offset pointers and object refs when bytes
  * have been added or removed from the body.
+ *
+ * Relocations in the changed area should have been removed before
+ * this is called.
+ *
+ * @param new_body new location of the body
+ * @param old_body old location of the body
+ * @param offset offset of the area changed
+ * @param old_size size of the area before the change
+ * @param diff change in size of the area
  */
-void ResData::fix_offsets(char *new_body, const char *old_body, int offset, int diff)
+void ResData::fix_offsets(char *new_body, const char *old_body, int offset, int old_size, int diff)
 {
 	for (int relocIdx = 0; relocIdx < _reloc_table._size; relocIdx++)
 	{
 		ResRelocation &reloc = _reloc_table._relocs[relocIdx];
 		if (reloc.type == ResRelocation::OBJECT_REF)
 		{
-			if (reloc.offset >= offset) reloc.offset += diff;
 			int ref = number(old_body, reloc.offset);
+			if (reloc.offset >= offset) reloc.offset += diff;
 			if (ref)
 			{
-				if ((char *)ref - old_body >= offset) ref += diff;
+				if ((char *)ref - old_body >= offset + old_size) ref += diff;
 				ref += new_body-old_body;
 			}
 			number(new_body, reloc.offset, ref);
@@ -1057,46 +1212,38 @@ void ResData::fix_offsets(char *new_body, const char *old_body, int offset, int
 void ResData::remove_data(char *body, int offset, int size)
 {
 	int end_offset = offset + size;
-	int deleted_count = 0;
-	int num_relocs = _reloc_table._size;
-	ResRelocation *reloc = _reloc_table._relocs;
-	ResRelocation *copy_from = reloc;
-	while (num_relocs--)
+	int idx;
+
+	// Remove the text first while the relocation table is complete so
+	// all the other text pointers are updated. During a batch edit the
+	// text is left in the tables until they are rebuilt.
+	if (_pending == 0)
 	{
-		if (copy_from > reloc) *reloc = *copy_from;
-		if (reloc->offset >= offset && reloc->offset < end_offset)
+		for (idx = 0; idx < _reloc_table._size; idx++)
 		{
-			switch(reloc->type)
+			const ResRelocation &reloc = _reloc_table._relocs[idx];
+			if (reloc.offset >= offset && reloc.offset < end_offset
+				&& (reloc.type == ResRelocation::STRING_REF
+					|| reloc.type == ResRelocation::MESSAGE_REF))
 			{
-			case ResRelocation::STRING_REF:
+				const char *old_text = text(body, reloc.offset);
+				if (old_text != 0)
 				{
-					const char *old_text = text(body, offset);
-					if (old_text != 0)
-					{
-						remove_chars(body, true, old_text, std::strlen(old_text) + 1);
-					}
+					number(body, reloc.offset, 0);
+					remove_chars(body, reloc.type == ResRelocation::STRING_REF,
+							old_text, std::strlen(old_text) + 1);
 				}
-				break;
-
-			case ResRelocation::MESSAGE_REF:
-				{
-					const char *old_text = text(body, offset);
-					if (old_text != 0)
-					{
-						remove_chars(body, false, old_text, std::strlen(old_text) + 1);
-					}
-				}
-				break;
-			default:
-				// Other types are not strings so do nothing
-				break;
 			}
-			deleted_count++;
-		} else
-		{
-			reloc++;
 		}
-		copy_from++;
+	}
+
+	int deleted_count = 0;
+	ResRelocation *reloc = _reloc_table._relocs;
+	for (idx = 0; idx < _reloc_table._size; idx++)
+	{
+		const ResRelocation &from = _reloc_table._relocs[idx];
+		if (from.offset >= offset && from.offset < end_offset) deleted_count++;
+		else *reloc++ = from;
 	}
 
 	if (deleted_count)
@@ -1120,6 +1267,30 @@ void ResData::remove_data(char *body, int offset, int size)
 	}
 }
 
+/**
+ * Get a new generation number for an implementation.
+ *
+ * Numbers are not reused until the counter wraps, so a component index
+ * can tell a new implementation from a deleted one that had the same
+ * address. Zero is never returned.
+ */
+unsigned int ResImpl::next_generation()
+{
+	static unsigned int last_generation = 0;
+	unsigned int generation;
+	do
+	{
+#if defined(__GNUC__) && !defined(__riscos__)
+		// Host tools such as resvalidate use resources on several threads
+		generation = __sync_add_and_fetch(&last_generation, 1);
+#else
+		generation = ++last_generation;
+#endif
+	} while (generation == 0);
+
+	return generation;
+}
+
 /**
  * Construct an implementation as a pointer to the given object
  *
@@ -1132,7 +1303,8 @@ ResImpl::ResImpl(void *object_header, int body_offset, int size) :
 		_body(_header + body_offset),
 		_size(size),
 		_data(0),
-		_type_reloc_table(0)
+		_type_reloc_table(0),
+		_generation(next_generation())
 {
 }
 
@@ -1147,7 +1319,8 @@ ResImpl::ResImpl(void *object_header, int body_offset, int size, ResData *data)
 		_body(_header + body_offset),
 		_size(size),
 		_data(data),
-		_type_reloc_table(0)
+		_type_reloc_table(0),
+		_generation(next_generation())
 {
 
 }
@@ -1171,16 +1344,11 @@ ResImpl::ResImpl(const ResImpl &other)
 		_size = other._size;
 		std::memcpy(_header, other._header, other._size);
 		_body = _header + (other._body - other._header);
-		if (other._data)
-		{
-			_data = new ResData(*(other._data));
-			_data->_reloc_table.fix_all_pointers(_body, other._body,
-						_data->_strings, other._data->_strings,
-						_data->_messages, other._data->_messages);
-		}
+		if (other._data) _data = other._data->copy(_body, other._body);
 		else _data = 0;
 	}
 	_type_reloc_table = other._type_reloc_table;
+	_generation = next_generation();
 }
 
 /**
@@ -1210,11 +1378,7 @@ ResImpl::ResImpl(const ResImpl &other, bool copy_read_only)
 		_body = _header + (other._body - other._header);
 		if (other._data)
 		{
-			_data = new ResData(*(other._data));
-			_data->_reloc_table.fix_all_pointers(_body, other._body,
-					_data->_strings, other._data->_strings,
-					_data->_messages, other._data->_messages);
-
+			_data = other._data->copy(_body, other._body);
 		} else if (other._ref_count == -1)
 		{
 			// If the header and body match this is a gadget or menuitem
@@ -1239,6 +1403,7 @@ ResImpl::ResImpl(const ResImpl &other, bool copy_read_only)
 		} else _data = 0;
 	}
 	_type_reloc_table = other._type_reloc_table;
+	_generation = next_generation();
 }
 
 /**
@@ -1413,6 +1578,23 @@ ResData *ResImpl::component_data(char *new_body, int offset, int size) const
 	return comp_data;
 }
 
+/**
+ * Start a batch edit of the text in this implementation
+ */
+void ResImpl::begin_batch()
+{
+	if (_data == 0) _data = new ResData();
+	_data->begin_batch();
+}
+
+/**
+ * End a batch edit rebuilding the string and message tables
+ */
+void ResImpl::end_batch()
+{
+	if (_data) _data->end_batch(_body);
+}
+
 /**
  * Insert a copy of the given implementation into this one.
  *
@@ -1425,6 +1607,7 @@ void ResImpl::insert(int offset, const ResImpl *insert_impl)
 	int body_offset = _body - _header;
 	int body_size = _size - body_offset;
 	if (offset < 0 || offset > body_size) throw std::range_error("Offset outside of body in ResImpl");
+	_generation = next_generation(); // Components will move
 
 	int inserted_count = insert_impl->_size;
 	char *new_data = new char[_size + inserted_count];
@@ -1455,12 +1638,13 @@ void ResImpl::replace(int offset, int old_size, const ResImpl *rep_impl)
 	int body_offset = _body - _header;
 	int body_size = _size - body_offset;
 	if (offset < 0 || offset + old_size > body_size) throw std::range_error("Offset or offset + old size outside of body in ResImpl");
+	_generation = next_generation(); // Components will move
 
 	// TODO: We could probably make it more efficient if relocation tables are
 	// same and possibly reduce string allocation/reallocation
 	_data->remove_data(_body, offset, old_size);
 
-	int size_diff = rep_impl->size() != old_size;
+	int size_diff = rep_impl->size() - old_size;
 	if (size_diff != 0)
 	{
 		char *new_data = new char[_size + size_diff];
@@ -1468,7 +1652,7 @@ void ResImpl::replace(int offset, int old_size, const ResImpl *rep_impl)
 		std::memmove(new_data + body_offset + offset + rep_impl->size(),
 			        _header + body_offset + offset + old_size,
 					_size - body_offset - offset - old_size);
-		_data->fix_offsets(new_data + body_offset, _body, offset, size_diff);
+		_data->fix_offsets(new_data + body_offset, _body, offset, old_size, size_diff);
 		delete [] _header;
 		_header = new_data;
 		_body = new_data + body_offset;
@@ -1488,15 +1672,18 @@ void ResImpl::erase(int offset, int size)
 	int body_offset = _body - _header;
 	int body_size = _size - body_offset;
 	if (offset < 0 || offset + size > body_size) throw std::range_error("Offset or offset + size outside of body in ResImpl");
+	_generation = next_generation(); // Components will move
 
 	_data->remove_data(_body, offset, size);
 
 	char *new_data = new char[_size - size];
 	memcpy(new_data, _header, body_offset + offset);
-	memcpy(new_data + offset, _body + offset + size, _size - body_offset - offset - size);
+	memcpy(new_data + body_offset + offset, _body + offset + size, _size - body_offset - offset - size);
+	_data->fix_offsets(new_data + body_offset, _body, offset, size, -size);
 	delete [] _header;
 	_header = new_data;
 	_body = new_data + body_offset;
+	_size -= size;
 }
 
 //! @endcond
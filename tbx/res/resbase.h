@@ -27,6 +27,7 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "resstruct.h"
 
@@ -78,6 +79,7 @@ class ResData
 	char *_messages;
 	int _messages_size;
 	ResRelocationTable _reloc_table;
+	std::vector<char *> *_pending; // Text set during a batch edit or 0 if not batching
 
 	friend class ResImpl;
 
@@ -134,10 +136,15 @@ public:
 	ResData *component_data(char *new_body, char *copy_body, int offset, int size) const;
 	void add_data_from(char *body, int offset, const char *from_body, const ResData *from_data);
 	void remove_data(char *body, int offset, int size);
-	void fix_offsets(char *new_body, const char *old_body, int offset, int diff);
+	void fix_offsets(char *new_body, const char *old_body, int offset, int old_size, int diff);
 
 	static ResData *copy_from_read_only(char *new_header, char *readonly_header);
 	static ResData *copy_component_from_read_only(char *new_body, char *readonly_header, int offset, int size);
+	ResData *copy(char *new_body, const char *old_body) const;
+
+	void begin_batch();
+	void end_batch(char *body);
+	bool batch() const {return (_pending != 0);}
 
 	void write(std::ostream &file) const;
 
@@ -145,6 +152,8 @@ private:
 	char *remove_chars(char *body, bool string_table, const char *where, int num);
 	char *insert_chars(char *body, bool string_table, const char *where, int num);
 	void copy_strings_and_messages(char *new_body, const char *copy_body);
+	char *add_pending(const char *text, int len);
+	void build_tables(char *body);
 
 };
 
@@ -165,9 +174,11 @@ class ResImpl
 	int _size;
 	ResData *_data;
 	ResRelocationTable *_type_reloc_table;
+	unsigned int _generation; // Changes when the components move
 
 private:
 	~ResImpl();
+	static unsigned int next_generation();
 
 public:
 	ResImpl(void *object_header, int body_offset, int size);
@@ -185,6 +196,15 @@ public:
 	const ResData *data() const {return _data;}
 	int size() const {return _size;}
 
+	/**
+	 * Number that identifies this implementation and the layout of
+	 * its components.
+	 *
+	 * Each implementation gets a new number when it is created and
+	 * whenever components are inserted, replaced or erased.
+	 */
+	unsigned int generation() const {return _generation;}
+
 	const char *text(int offset) const {return (char *)(*(int *)(_body + offset));}
 	int text_len(int offset) const;
 	void text(int offset, const char *new_text, int len, bool is_string)
@@ -228,6 +248,13 @@ public:
 
 	ResData *component_data(char *new_body, int offset, int size) const;
 
+	void begin_batch();
+	void end_batch();
+	/**
+	 * Check if a batch edit is in progress
+	 */
+	bool batch() const {return (_data != 0 && _data->batch());}
+
 	/**
 	 * Check if implentation is in a read only state
 	 */
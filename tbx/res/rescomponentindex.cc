@@ -0,0 +1,163 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "rescomponentindex.h"
+#include "resobject.h"
+
+namespace tbx {
+
+namespace res {
+
+//! @cond INTERNAL
+
+/**
+ * Clear the index ready to add the components for an implementation
+ *
+ * @param impl implementation of the object the index is for
+ * @param count number of components that will be added
+ */
+void ResComponentIndex::start(const ResImpl *impl, int count)
+{
+	int capacity = 16;
+	while (capacity < count * 2) capacity *= 2;
+	Slot empty;
+	empty.key = 0;
+	empty.offset = -1;
+	_slots.assign(capacity, empty);
+	_count = 0;
+	_generation = impl->generation();
+}
+
+/**
+ * Check if the index is up to date for the given implementation
+ *
+ * @param impl implementation of the object the index is for
+ * @returns true if the index can be used
+ */
+bool ResComponentIndex::valid(const ResImpl *impl) const
+{
+	return _generation != 0 && _generation == impl->generation();
+}
+
+/**
+ * Mark the index as up to date for the given implementation.
+ *
+ * Used when an owner has kept the index in step with a change.
+ *
+ * @param impl implementation of the object the index is for
+ */
+void ResComponentIndex::validate(const ResImpl *impl)
+{
+	_generation = impl->generation();
+}
+
+/**
+ * Add a component to the index.
+ *
+ * If the key is already in the index the original offset is kept,
+ * so the index finds the first of any duplicates.
+ *
+ * @param key component ID or other key
+ * @param offset offset of the component in the body
+ */
+void ResComponentIndex::add(int key, int offset)
+{
+	if ((_count + 1) * 2 > (int)_slots.size())
+	{
+		grow(_slots.empty() ? 16 : _slots.size() * 2);
+	}
+
+	int slot = find_slot(key);
+	if (_slots[slot].offset == -1)
+	{
+		_slots[slot].key = key;
+		_slots[slot].offset = offset;
+		_count++;
+	}
+}
+
+/**
+ * Find the offset of the component with the given key
+ *
+ * @param key component ID or other key
+ * @returns offset of the component or -1 if it is not in the index
+ */
+int ResComponentIndex::find(int key) const
+{
+	if (_count == 0) return -1;
+	return _slots[find_slot(key)].offset;
+}
+
+/**
+ * Mix the bits of the key so sequential IDs are spread out
+ */
+unsigned int ResComponentIndex::hash(int key)
+{
+	unsigned int h = (unsigned int)key;
+	h ^= h >> 16;
+	h *= 0x45d9f3bu;
+	h ^= h >> 16;
+	return h;
+}
+
+/**
+ * Find the slot containing the key or the empty slot
+ * it should be placed in.
+ */
+int ResComponentIndex::find_slot(int key) const
+{
+	unsigned int mask = _slots.size() - 1;
+	unsigned int pos = hash(key) & mask;
+	while (_slots[pos].offset != -1 && _slots[pos].key != key)
+	{
+		pos = (pos + 1) & mask;
+	}
+	return pos;
+}
+
+/**
+ * Increase the size of the table and rehash the current entries
+ *
+ * @param capacity new size of the table, must be a power of 2
+ */
+void ResComponentIndex::grow(int capacity)
+{
+	std::vector<Slot> old_slots;
+	old_slots.swap(_slots);
+	Slot empty;
+	empty.key = 0;
+	empty.offset = -1;
+	_slots.assign(capacity, empty);
+	_count = 0;
+	for (std::vector<Slot>::iterator i = old_slots.begin(); i != old_slots.end(); ++i)
+	{
+		if (i->offset != -1) add(i->key, i->offset);
+	}
+}
+
+//! @endcond
+
+}
+
+}
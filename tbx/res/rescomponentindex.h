@@ -0,0 +1,93 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_RES_RESCOMPONENTINDEX_H_
+#define TBX_RES_RESCOMPONENTINDEX_H_
+
+#include <vector>
+
+namespace tbx {
+
+namespace res {
+
+//! @cond INTERNAL
+
+class ResImpl;
+
+/**
+ * Hash table from a component ID (or other integer key) to the offset
+ * of the component in the body of a resource object.
+ *
+ * Used by ResWindow and ResMenu so finding a component does not need to
+ * walk every component. The index is built lazily by its owner and is
+ * tied to the generation of the resource implementation it was built
+ * from, so it is automatically treated as out of date if the object
+ * switches to a different implementation (even one allocated at the
+ * same address) or the implementation has components inserted, replaced
+ * or erased. Owners that keep the index in step with a change call
+ * validate() after it.
+ */
+class ResComponentIndex
+{
+	/**
+	 * One entry in the table
+	 */
+	struct Slot
+	{
+		int key;
+		int offset; // -1 if slot is empty
+	};
+	std::vector<Slot> _slots;
+	int _count;
+	unsigned int _generation; // Generation of implementation built for or 0
+
+public:
+	ResComponentIndex() : _count(0), _generation(0) {}
+
+	bool valid(const ResImpl *impl) const;
+
+	/**
+	 * Mark the index as out of date so it will be rebuilt
+	 */
+	void invalidate() {_generation = 0;}
+
+	void validate(const ResImpl *impl);
+
+	void start(const ResImpl *impl, int count);
+	void add(int key, int offset);
+	int find(int key) const;
+
+private:
+	static unsigned int hash(int key);
+	int find_slot(int key) const;
+	void grow(int capacity);
+};
+
+//! @endcond
+
+}
+
+}
+
+#endif /* TBX_RES_RESCOMPONENTINDEX_H_ */
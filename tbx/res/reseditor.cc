@@ -41,7 +41,7 @@ namespace res {
 /**
  * Construct an empty resource file
  */
-ResEditor::ResEditor()
+ResEditor::ResEditor() : _use_index(false)
 {
 	_header = new char[sizeof(ResFileHeader)];
 	header()->file_id = RESF_MARKER;
@@ -60,6 +60,40 @@ ResEditor::~ResEditor()
 void ResEditor::clear()
 {
 	_objects.clear();
+	_name_index.clear();
+}
+
+/**
+ * Turn on or off the use of an index to find objects by name.
+ *
+ * When it is on the index is kept up to date by the editor methods
+ * that add, remove or replace objects so find, contains and object
+ * do not need to search through all the objects.
+ *
+ * If an object is renamed directly through an iterator the index
+ * must be rebuilt by calling this method with true again.
+ *
+ * @param use true to build and use the index, false to remove it
+ */
+void ResEditor::name_index(bool use)
+{
+	_use_index = use;
+	if (use) rebuild_name_index();
+	else _name_index.clear();
+}
+
+/**
+ * Rebuild the name index from the current objects
+ */
+void ResEditor::rebuild_name_index()
+{
+	_name_index.clear();
+	if (!_use_index) return;
+	_name_index.reserve(_objects.size());
+	for (unsigned int j = 0; j < _objects.size(); j++)
+	{
+		_name_index.add(_objects[j].name(), j);
+	}
 }
 
 /**
@@ -71,6 +105,7 @@ void ResEditor::clear()
 bool ResEditor::load(std::string file_name)
 {
 	_objects.clear();
+	_name_index.clear();
 
 	std::ifstream file(file_name.c_str(), std::ios_base::in | std::ios_base::binary);
 	if (!file) return false;
@@ -101,6 +136,8 @@ bool ResEditor::load(std::string file_name)
 		}
 	}
 
+	rebuild_name_index();
+
 	return true;
 }
 
@@ -171,6 +208,7 @@ void ResEditor::add(ResObject obj)
 {
 	if (find(obj.name()) != end()) throw ResObjectExists(obj.name());
 	_objects.push_back(obj);
+	if (_use_index) _name_index.add(obj.name(), _objects.size() - 1);
 }
 
 /**
@@ -195,7 +233,7 @@ void ResEditor::erase(std::string name)
 {
 	std::vector<ResObject>::iterator i = find(name);
 	if (i == _objects.end()) throw ResObjectNotFound(name);
-	_objects.erase(i);
+	erase(i);
 }
 
 /**
@@ -206,6 +244,12 @@ void ResEditor::erase(std::string name)
  */
 ResEditor::const_iterator ResEditor::find(std::string name) const
 {
+	if (_use_index)
+	{
+		int index = _name_index.find(name.c_str());
+		return (index == -1) ? _objects.end() : _objects.begin() + index;
+	}
+
 	const_iterator i;
 	for (i = _objects.begin(); i != _objects.end(); ++i)
 	{
@@ -223,6 +267,12 @@ ResEditor::const_iterator ResEditor::find(std::string name) const
  */
 ResEditor::iterator ResEditor::find(std::string name)
 {
+	if (_use_index)
+	{
+		int index = _name_index.find(name.c_str());
+		return (index == -1) ? _objects.end() : _objects.begin() + index;
+	}
+
 	ResEditor::iterator i;
 	for (i = _objects.begin(); i != _objects.end(); ++i)
 	{
@@ -239,7 +289,17 @@ ResEditor::iterator ResEditor::find(std::string name)
 ResEditor::iterator ResEditor::insert(iterator before, ResObject obj)
 {
 	if (find(obj.name()) != end())  throw ResObjectExists(obj.name());
-	return _objects.insert(before, obj);
+	if (before == _objects.end())
+	{
+		_objects.push_back(obj);
+		if (_use_index) _name_index.add(obj.name(), _objects.size() - 1);
+		return _objects.end() - 1;
+	}
+	int index = before - _objects.begin();
+	_objects.insert(before, obj);
+	// Objects after the insert have moved so the index must be rebuilt
+	rebuild_name_index();
+	return _objects.begin() + index;
 }
 
 /**
@@ -247,7 +307,12 @@ ResEditor::iterator ResEditor::insert(iterator before, ResObject obj)
  */
 ResEditor::iterator ResEditor::erase(iterator where)
 {
-	return _objects.erase(where);
+	bool last = (where + 1 == _objects.end());
+	if (_use_index && last) _name_index.erase((*where).name());
+	iterator next = _objects.erase(where);
+	// Objects after the erase have moved so the index must be rebuilt
+	if (_use_index && !last) rebuild_name_index();
+	return next;
 }
 
 /**
@@ -264,6 +329,11 @@ void ResEditor::replace(iterator where, ResObject obj)
 	if (std::strcmp((*where).name(), obj.name()) != 0)
 	{
 		if (find(obj.name()) != end())  throw ResObjectExists(obj.name());
+		if (_use_index)
+		{
+			_name_index.erase((*where).name());
+			_name_index.add(obj.name(), where - _objects.begin());
+		}
 	}
 	*where = obj;
 }
@@ -32,6 +32,7 @@
 #define TBX_RESEDITOR_H_
 
 #include "resobject.h"
+#include "resnameindex.h"
 #include <vector>
 
 namespace tbx {
@@ -41,11 +42,17 @@ namespace res {
 /**
  * Class to allow creation, loading, editing and saving of a
  * toolbox resource file.
+ *
+ * Objects are found by name by searching through all the objects.
+ * For editors with a large number of objects an index of the names
+ * can be turned on with name_index(true) to speed this up.
  */
 class ResEditor
 {
 	char *_header;
 	std::vector<ResObject> _objects;
+	bool _use_index;
+	ResNameIndex _name_index;
 
 public:
 	ResEditor();
@@ -112,7 +119,17 @@ public:
 	bool load(std::string file_name);
 	bool save(std::string file_name);
 
+	void name_index(bool use);
+	/**
+	 * Check if an index is used to find objects by name
+	 *
+	 * @returns true if the name index is used
+	 */
+	bool name_index() const {return _use_index;}
+
 private:
+	void rebuild_name_index();
+
 	// Only editor can change header
 	ResFileHeader *header() {return reinterpret_cast<ResFileHeader *>(_header);}
 
@@ -24,6 +24,7 @@
 
 #include "resfile.h"
 #include <fstream>
+#include <cstring>
 #include "resexcept.h"
 
 using namespace std;
@@ -37,18 +38,94 @@ ResFile::ResFile(void)
 {
 	_res = 0;
 	_length = 0;
+	_lazy = false;
 }
 
 ResFile::~ResFile(void)
 {
+	clear();
+}
+
+/**
+ * Delete the loaded file and any relocated copies of its objects
+ */
+void ResFile::clear()
+{
+	for (std::map<int, char *>::iterator i = _relocated.begin(); i != _relocated.end(); ++i)
+	{
+		delete [] i->second;
+	}
+	_relocated.clear();
+	_name_index.clear();
 	delete [] _res;
+	_res = 0;
+	_length = 0;
+}
+
+/**
+ * Convert the offsets in an object to pointers
+ *
+ * @param p pointer to the data header before the object
+ */
+static void relocate_object(char *p)
+{
+	ResDataHeader *rdh = (ResDataHeader *)p;
+	ResObjectHeader *obj = (ResObjectHeader *)(p + 12);
+	obj->body += (int)obj;
+
+	if (rdh->relocations_table_offset == -1) return;
+
+	p += rdh->relocations_table_offset;
+	int num_relocs = *((int *)p);
+	p += 4;
+	ResRelocation *reloc = (ResRelocation *)p;
+	for (int j = 0; j < num_relocs; j++)
+	{
+		int *op = (int *)(obj->body + reloc->offset);
+		switch(reloc->type)
+		{
+		case ResRelocation::STRING_REF:
+			{
+				char *sp = ((char *)rdh) + rdh->string_table_offset;
+				if (*op == -1) *op = 0;
+				else *op += (int)sp;
+			}
+			break;
+		case ResRelocation::MESSAGE_REF:
+			{
+				char *sp = ((char *)rdh) + rdh->messages_table_offset;
+				if (*op == -1) *op = 0;
+				else *op += (int)sp;
+			}
+			break;
+
+		case ResRelocation::OBJECT_REF:
+			*op += (int)(char *)obj->body;
+			break;
+
+		case ResRelocation::SPRITE_AREA_REF:
+			if (*op == -1) *op = 0;
+			else *op = (int)ResObject::client_sprite_pointer();
+			break;
+		}
+		reloc++;
+	}
 }
 
 /**
  * Load a resource file
+ *
+ * @param fname name of the resource file to load
+ * @param lazy false (the default) to relocate every object as the
+ * file is loaded. true to leave the loaded data unchanged and only
+ * relocate an object when it is first accessed.
+ * @returns true if the file was loaded
  */
-bool ResFile::load(const std::string &fname)
+bool ResFile::load(const std::string &fname, bool lazy /*= false*/)
 {
+	clear();
+	_lazy = lazy;
+
 	ifstream res_file(fname.c_str(), ios::binary);
 	if (!res_file) return false;
 
@@ -60,79 +137,49 @@ bool ResFile::load(const std::string &fname)
 	_res = new char[_length];
 	res_file.read(_res, _length);
 
-	char *p = _res;
-	char *end = _res + _length;
-	ResFileHeader *rh = (ResFileHeader *)p;
+	ResFileHeader *rh = (ResFileHeader *)_res;
 
 	if (_length < 12 || rh->file_id != RESF_MARKER) return false;
 
-	p += rh->object_offset;
-	while (p < end)
+	if (!_lazy)
 	{
-		ResDataHeader *rdh = (ResDataHeader *)p;
-		ResObjectHeader *obj = (ResObjectHeader *)(p + 12);
-		obj->body += (int)obj;
-
-		if (rdh->relocations_table_offset != -1)
+		int offset = first_offset();
+		while (offset < _length)
 		{
-			p += rdh->relocations_table_offset;
-			int num_relocs = *((int *)p);
-			p += 4;
-			ResRelocation *reloc = (ResRelocation *)p;
-			for (int j = 0; j < num_relocs; j++)
-			{
-				int *op = (int *)(obj->body + reloc->offset);
-				switch(reloc->type)
-				{
-				case ResRelocation::STRING_REF:
-					{
-						char *sp = ((char *)rdh) + rdh->string_table_offset;
-						if (*op == -1) *op = 0;
-						else *op += (int)sp;
-					}
-					break;
-				case ResRelocation::MESSAGE_REF:
-					{
-						char *sp = ((char *)rdh) + rdh->messages_table_offset;
-						if (*op == -1) *op = 0;
-						else *op += (int)sp;
-					}
-					break;
-
-				case ResRelocation::OBJECT_REF:
-					*op += (int)obj->body;
-					break;
-
-				case ResRelocation::SPRITE_AREA_REF:
-					if (*op == -1) *op = 0;
-					else *op = (int)ResObject::client_sprite_pointer();
-					break;
-				}
-				reloc++;
-			}
-
-			p +=  num_relocs * 8;
-		} else
-		{
-			p += 12 + obj->total_size;
+			int this_offset = offset;
+			next_object(offset);
+			relocate_object(_res + this_offset);
 		}
 	}
 
 	return res_file.good();
 }
 
-
 /**
  * Find name in resource
+ *
+ * @param name name of object to find
+ * @returns const_iterator for the object or end() if not found
  */
 ResFile::const_iterator ResFile::find(std::string name) const
 {
-	const_iterator i(begin());
-	for (; i != end(); ++i)
+	if (_res == 0) return end();
+	if (_name_index.count() == 0) build_name_index();
+	int offset = _name_index.find(name.c_str());
+	return const_iterator(this, (offset == -1) ? end_offset() : offset);
+}
+
+/**
+ * Build the index from the object names to their offsets
+ */
+void ResFile::build_name_index() const
+{
+	int offset = first_offset();
+	while (offset < _length)
 	{
-		if (name == (_res + i._offset + 24)) break;
+		_name_index.add(_res + offset + 24, offset);
+		next_object(offset);
 	}
-	return i;
 }
 
 /**
@@ -202,7 +249,33 @@ void ResFile::next_object(int &offset) const
  */
 ResObject ResFile::at_offset(int offset) const
 {
-	return ResObject((ResObjectHeader *)(_res + offset + 12));
+	char *p = (_lazy) ? relocated_object(offset) : (_res + offset);
+	return ResObject((ResObjectHeader *)(p + 12));
+}
+
+/**
+ * Get the relocated copy of the object at the given offset for
+ * a file loaded lazily, creating it if this is the first access.
+ *
+ * The copy includes the data header, tables and relocations so
+ * it can be used in the same way as an object relocated on load.
+ *
+ * @param offset offset of the object in the file
+ * @returns pointer to the data header of the relocated copy
+ */
+char *ResFile::relocated_object(int offset) const
+{
+	std::map<int, char *>::iterator found = _relocated.find(offset);
+	if (found != _relocated.end()) return found->second;
+
+	int next = offset;
+	next_object(next);
+	char *copy = new char[next - offset];
+	std::memcpy(copy, _res + offset, next - offset);
+	relocate_object(copy);
+	_relocated[offset] = copy;
+
+	return copy;
 }
 
 }
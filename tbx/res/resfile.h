@@ -27,6 +27,8 @@
 
 #include "resobject.h"
 #include "resiteratorbase.h"
+#include "resnameindex.h"
+#include <map>
 
 namespace tbx {
 
@@ -38,17 +40,37 @@ namespace res {
  *
  * ResObjects returned from this object are only valid
  * as long as the ResFile object is in memory.
+ *
+ * By default all the objects are relocated when the file is loaded.
+ * For large files where only a few of the objects are used the
+ * file can be loaded lazily instead. In this case the bytes read
+ * from the file are never modified and each object is relocated
+ * into its own copy the first time it is accessed.
+ *
+ * An index of the object names is built the first time an object
+ * is looked up by name so subsequent lookups do not need to scan
+ * the whole file.
  */
 class ResFile
 {
 	char *_res;
 	int _length;
+	bool _lazy;
+	mutable std::map<int, char *> _relocated;
+	mutable ResNameIndex _name_index;
 
 public:
 	ResFile(void);
 	~ResFile(void);
 
-	bool load(const std::string &fname);
+	bool load(const std::string &fname, bool lazy = false);
+
+	/**
+	 * Check if the file was loaded with lazy relocation
+	 *
+	 * @returns true if objects are relocated on first access
+	 */
+	bool lazy() const {return _lazy;}
 
 	bool contains(std::string name) const;
 	ResObject object(std::string name) const;
@@ -113,6 +135,11 @@ protected:
 	int end_offset() const;
 	void next_object(int &offset) const;
 	ResObject at_offset(int offset) const;
+
+private:
+	void clear();
+	char *relocated_object(int offset) const;
+	void build_name_index() const;
 };
 
 }
@@ -145,13 +145,31 @@ ResMenu::const_iterator ResMenu::cend() const
  */
 ResMenu::const_iterator ResMenu::find(ComponentId component_id) const
 {
-	const_iterator i = begin();
-	for (; i != end(); ++i)
+	int offset = find_offset(component_id);
+	return (offset == -1) ? end() : const_iterator(this, offset);
+}
+
+/**
+ * Find the offset of the item with the given component id
+ * building the index to the items if necessary.
+ *
+ * @param component_id id of component to find
+ * @returns offset of component or -1 if not found
+ */
+int ResMenu::find_offset(ComponentId component_id) const
+{
+	if (!_item_index.valid(_impl))
 	{
-		if (int_value(i._offset + 4) == component_id) break;
+		int count = item_count();
+		_item_index.start(_impl, count);
+		for (int index = 0; index < count; index++)
+		{
+			int offset = MENU_DATA_SIZE + index * MENU_ITEM_SIZE;
+			_item_index.add(int_value(offset + 4), offset);
+		}
 	}
 
-	return i; 
+	return _item_index.find(component_id);
 }
 
 /**
@@ -182,13 +200,8 @@ ResMenu::iterator ResMenu::end()
  */
 ResMenu::iterator ResMenu::find(ComponentId component_id)
 {
-	iterator i = begin();
-	for (; i != end(); ++i)
-	{
-		if (int_value(i._offset + 4) == component_id) break;
-	}
-
-	return i; 
+	int offset = find_offset(component_id);
+	return (offset == -1) ? end() : iterator(this, offset);
 }
 
 /**
@@ -240,6 +253,8 @@ void ResMenu::replace(const ResMenuItem &item)
 
 	make_writeable();
 	replace_component(pos._offset, MENU_ITEM_SIZE, item._impl);
+	// Items are a fixed size and the ID is the same so nothing moves
+	_item_index.validate(_impl);
 }
 
 
@@ -269,6 +284,8 @@ ResMenu::iterator ResMenu::insert(iterator pos, const ResMenuItem &item)
 	iterator i = find(item.component_id());
 	if (i != end()) throw ResMenuItemExists(name(), item.component_id());
 
+	bool append = (pos._offset == end()._offset);
+
 	make_writeable();
 
 	int insert_location = pos._offset;
@@ -276,6 +293,16 @@ ResMenu::iterator ResMenu::insert(iterator pos, const ResMenuItem &item)
 
 	int_value(28, item_count()+1); // Update menu item count
 
+	// Items added to the end do not move the existing items
+	if (append)
+	{
+		_item_index.add(item.component_id(), insert_location);
+		_item_index.validate(_impl);
+	} else
+	{
+		_item_index.invalidate();
+	}
+
 	return pos;
 }
 
@@ -295,10 +322,16 @@ ResMenu::iterator ResMenu::replace(iterator pos, const ResMenuItem &item)
 		throw ResMenuItemExists(name(), item.component_id());
 	}
 
+	bool keep_index = _item_index.valid(_impl)
+		&& item.component_id() == int_value(pos._offset + 4);
+
 	make_writeable();
 
 	replace_component(pos._offset, MENU_ITEM_SIZE, item._impl);
 
+	if (keep_index) _item_index.validate(_impl);
+	else _item_index.invalidate();
+
 	return pos;
 }
 
@@ -313,6 +346,7 @@ ResMenu::iterator ResMenu::erase(iterator pos)
 	make_writeable();
 	erase_component(pos._offset, MENU_ITEM_SIZE);
 	int_value(28, item_count()-1); // Update menu item count
+	_item_index.invalidate();
 
 	return pos;
 }
@@ -27,6 +27,7 @@
 
 #include "resobject.h"
 #include "resiteratorbase.h"
+#include "rescomponentindex.h"
 #include "../handles.h"
 
 namespace tbx
@@ -387,6 +388,7 @@ class ResMenu : public ResObject
       ResMenu&operator=(const ResMenu&other)
       {
          ResObject::operator=(other);
+         _item_index.invalidate();
          return *this;
       }
 
@@ -399,6 +401,7 @@ class ResMenu : public ResObject
       {
          other.check_class_id(CLASS_ID);
 		 ResObject::operator =(other);
+         _item_index.invalidate();
          return *this;
       }
 
@@ -623,6 +626,11 @@ class ResMenu : public ResObject
 	   iterator insert(iterator pos, const ResMenuItem &item);
 	   iterator replace(iterator pos, const ResMenuItem &item);
 	   iterator erase(iterator pos);
+
+	private:
+	   // Index from component ID to offset built on first use
+	   mutable ResComponentIndex _item_index;
+	   int find_offset(ComponentId component_id) const;
 };
 
 }
@@ -0,0 +1,193 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "resnameindex.h"
+#include <cstring>
+
+namespace tbx {
+
+namespace res {
+
+//! @cond INTERNAL
+
+/**
+ * Check if a name is too long to be in the index.
+ *
+ * Only the first 12 characters of a name are stored, so without
+ * this check a longer name would match the stored prefix.
+ */
+static bool name_too_long(const char *name)
+{
+	for (int j = 0; j <= 12; j++)
+	{
+		if (name[j] == 0) return false;
+	}
+	return true;
+}
+
+/**
+ * Remove all names from the index
+ */
+void ResNameIndex::clear()
+{
+	_slots.clear();
+	_count = 0;
+}
+
+/**
+ * Make sure the index can hold the given number of names
+ * without needing to grow the table.
+ */
+void ResNameIndex::reserve(int count)
+{
+	int capacity = 16;
+	while (capacity < count * 2) capacity *= 2;
+	if (capacity > (int)_slots.size()) grow(capacity);
+}
+
+/**
+ * Add a name to the index.
+ *
+ * If the name is already in the index the original value is kept,
+ * so the index finds the first of any duplicate names.
+ *
+ * @param name name to add
+ * @param value value to return for the name (must not be negative)
+ */
+void ResNameIndex::add(const char *name, int value)
+{
+	if ((_count + 1) * 2 > (int)_slots.size())
+	{
+		grow(_slots.empty() ? 16 : _slots.size() * 2);
+	}
+
+	int slot = find_slot(name);
+	if (_slots[slot].value == -1)
+	{
+		unsigned int len = 0;
+		while (len < 12 && name[len]) len++;
+		std::memcpy(_slots[slot].name, name, len);
+		if (len < 12) std::memset(_slots[slot].name + len, 0, 12 - len);
+		_slots[slot].value = value;
+		_count++;
+	}
+}
+
+/**
+ * Find the value for a name
+ *
+ * @param name name to look up
+ * @returns value added with the name or -1 if it is not in the index
+ */
+int ResNameIndex::find(const char *name) const
+{
+	if (_count == 0 || name_too_long(name)) return -1;
+	return _slots[find_slot(name)].value;
+}
+
+/**
+ * Remove a name from the index
+ *
+ * @param name name to remove. Nothing is done if it is not in the index.
+ */
+void ResNameIndex::erase(const char *name)
+{
+	if (_count == 0 || name_too_long(name)) return;
+	unsigned int mask = _slots.size() - 1;
+	unsigned int hole = find_slot(name);
+	if (_slots[hole].value == -1) return;
+	_slots[hole].value = -1;
+	_count--;
+
+	// Move following entries back so probing never stops early
+	unsigned int pos = (hole + 1) & mask;
+	while (_slots[pos].value != -1)
+	{
+		unsigned int home = hash(_slots[pos].name) & mask;
+		// Move if the home slot is not between the hole and this position
+		if (((pos - home) & mask) >= ((pos - hole) & mask))
+		{
+			_slots[hole] = _slots[pos];
+			_slots[pos].value = -1;
+			hole = pos;
+		}
+		pos = (pos + 1) & mask;
+	}
+}
+
+/**
+ * FNV-1a hash of an object name
+ */
+unsigned int ResNameIndex::hash(const char *name)
+{
+	unsigned int h = 2166136261u;
+	for (int j = 0; j < 12 && name[j]; j++)
+	{
+		h ^= (unsigned char)name[j];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/**
+ * Find the slot containing the name or the empty slot
+ * it should be placed in.
+ */
+int ResNameIndex::find_slot(const char *name) const
+{
+	unsigned int mask = _slots.size() - 1;
+	unsigned int pos = hash(name) & mask;
+	while (_slots[pos].value != -1
+		&& std::strncmp(_slots[pos].name, name, 12) != 0)
+	{
+		pos = (pos + 1) & mask;
+	}
+	return pos;
+}
+
+/**
+ * Increase the size of the table and rehash the current entries
+ *
+ * @param capacity new size of the table, must be a power of 2
+ */
+void ResNameIndex::grow(int capacity)
+{
+	std::vector<Slot> old_slots;
+	old_slots.swap(_slots);
+	Slot empty;
+	std::memset(&empty, 0, sizeof(Slot));
+	empty.value = -1;
+	_slots.assign(capacity, empty);
+	_count = 0;
+	for (std::vector<Slot>::iterator i = old_slots.begin(); i != old_slots.end(); ++i)
+	{
+		if (i->value != -1) add(i->name, i->value);
+	}
+}
+
+//! @endcond
+
+}
+
+}
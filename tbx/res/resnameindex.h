@@ -0,0 +1,84 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_RES_RESNAMEINDEX_H_
+#define TBX_RES_RESNAMEINDEX_H_
+
+#include <vector>
+
+namespace tbx {
+
+namespace res {
+
+//! @cond INTERNAL
+
+/**
+ * Hash table to quickly look up an integer value from a resource object name.
+ *
+ * Used by the ResFile and ResEditor to speed up finding objects by name.
+ * The table uses open addressing with linear probing and is grown
+ * so it is never more than half full.
+ *
+ * Names are compared up to the 12 characters used for an object name.
+ */
+class ResNameIndex
+{
+	/**
+	 * One entry in the table
+	 */
+	struct Slot
+	{
+		char name[12];
+		int value; // -1 if slot is empty
+	};
+	std::vector<Slot> _slots;
+	int _count;
+
+public:
+	ResNameIndex() : _count(0) {}
+
+	/**
+	 * Return number of names in the index
+	 */
+	int count() const {return _count;}
+
+	void clear();
+	void reserve(int count);
+	void add(const char *name, int value);
+	int find(const char *name) const;
+	void erase(const char *name);
+
+private:
+	static unsigned int hash(const char *name);
+	int find_slot(const char *name) const;
+	void grow(int capacity);
+};
+
+//! @endcond
+
+}
+
+}
+
+#endif /* TBX_RES_RESNAMEINDEX_H_ */
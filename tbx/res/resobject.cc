@@ -154,9 +154,9 @@ ResObject *ResObject::load(std::istream &file)
 	if (file.fail()) return 0;
 
 	// Read object body
-	char *data = new char[(int)object_header.body + object_header.body_size];
+	char *data = new char[(int)(char *)object_header.body + object_header.body_size];
 	std::memcpy(data, &object_header, sizeof(ResObjectHeader));
-	file.read(data + sizeof(ResObjectHeader), (int)object_header.body + object_header.body_size - sizeof(ResObjectHeader));
+	file.read(data + sizeof(ResObjectHeader), (int)(char *)object_header.body + object_header.body_size - sizeof(ResObjectHeader));
 
 	// Make body offset to real pointer
 	reinterpret_cast<ResObjectHeader *>(data)->body += (int)data;
@@ -165,7 +165,7 @@ ResObject *ResObject::load(std::istream &file)
 
 	if (data_header.relocations_table_offset != -1)
 	{
-		int strings_size = object_header.total_size - (int)object_header.body - object_header.body_size;
+		int strings_size = object_header.total_size - (int)(char *)object_header.body - object_header.body_size;
 
 		// Read in strings
 		char *strings = 0;
@@ -215,6 +215,9 @@ ResObject *ResObject::load(std::istream &file)
  */
 bool ResObject::save(std::ostream &file)
 {
+	// Tables must be up to date to save
+	if (_impl->batch()) _impl->end_batch();
+
 	ResDataHeader data_header;
 	const ResData *data = _impl->data();
 	int body_offset = object_header()->body - _impl->header();
@@ -388,6 +391,32 @@ void ResObject::check_class_id(int class_id) const
 	}
 }
 
+/**
+ * Start a batch edit of this object.
+ *
+ * Normally every change to a string or message in an object updates
+ * the objects string or message table straight away, which becomes
+ * slow when a large number of changes are made. During a batch edit
+ * changed text is kept separately and the tables are rebuilt once
+ * when end_batch_edit is called.
+ *
+ * The object can be used as normal during a batch edit.
+ * Saving the object ends the batch edit.
+ */
+void ResObject::begin_batch_edit()
+{
+	make_writeable();
+	_impl->begin_batch();
+}
+
+/**
+ * End a batch edit rebuilding the string and message tables
+ */
+void ResObject::end_batch_edit()
+{
+	_impl->end_batch();
+}
+
 /**
  * Insert a component in an object
  *
@@ -132,6 +132,15 @@ public:
 
 	void check_class_id(int class_id) const;
 
+	void begin_batch_edit();
+	void end_batch_edit();
+	/**
+	 * Check if a batch edit is in progress
+	 *
+	 * @returns true if begin_batch_edit has been called without end_batch_edit
+	 */
+	bool batch_edit() const {return _impl->batch();}
+
 
 protected:
 	ResObject(std::string name, int class_id, int version, int object_size);
@@ -159,6 +168,28 @@ protected:
 	void erase_component(int offset, int size);
 };
 
+/**
+ * Class to batch edit a ResObject for the lifetime of this object.
+ *
+ * It calls begin_batch_edit on the object when it is constructed
+ * and end_batch_edit when it is destroyed.
+ */
+class ResBatchEdit
+{
+	ResObject &_object;
+public:
+	/**
+	 * Start batch edit of an object
+	 *
+	 * @param object object to batch edit
+	 */
+	ResBatchEdit(ResObject &object) : _object(object) {_object.begin_batch_edit();}
+	/**
+	 * End the batch edit
+	 */
+	~ResBatchEdit() {_object.end_batch_edit();}
+};
+
 
 }
 
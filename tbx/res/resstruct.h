@@ -70,6 +70,25 @@ struct ResRelocation
 	Type type;  //!< Type of relocation
 };
 
+//! @cond INTERNAL
+#if defined(__LP64__)
+/**
+ * Body pointer held in 32 bits so the object header keeps the
+ * layout of the resource file when built as a 64 bit host program.
+ *
+ * The host tests keep all allocations below 4GB.
+ */
+struct ResBodyPointer
+{
+	unsigned int _address;
+
+	operator char *() const {return (char *)(unsigned long)_address;}
+	ResBodyPointer &operator=(char *body) {_address = (unsigned int)(unsigned long)body; return *this;}
+	ResBodyPointer &operator+=(int offset) {_address += (unsigned int)offset; return *this;}
+};
+#endif
+//! @endcond
+
 /**
  * Common header for all resource objects
  */
@@ -80,7 +99,11 @@ struct ResObjectHeader
     int version;		//!< version * 100
 	char name[12];		//!< Null terminated name
 	int total_size;     //!< Total size of object including tables
+#if defined(__LP64__)
+	ResBodyPointer body; //!< Pointer to body
+#else
 	char *body;			//!< Pointer to body
+#endif
 	int body_size;	    //!< Size of header and body only
 };
 
@@ -0,0 +1,496 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "resvalidator.h"
+#include "resfile.h"
+#include "reswindow.h"
+#include "resmenu.h"
+#include "resshortcut.h"
+#include "../stringutils.h"
+#include <fstream>
+#include <cstring>
+
+namespace tbx {
+
+namespace res {
+
+// Size of the data header and object header in a file
+const int DATA_HEADER_SIZE = 12;
+const int OBJECT_HEADER_SIZE = 36;
+
+/**
+ * Construct a validator
+ */
+ResValidator::ResValidator() :
+	_loaded(false),
+	_object_count(0),
+	_data(0),
+	_length(0)
+{
+}
+
+/**
+ * Check a resource file
+ *
+ * @param file_name name of the file to check
+ * @returns true if the file is valid. Use issues() to get the details
+ * of any problems found.
+ */
+bool ResValidator::validate(const std::string &file_name)
+{
+	reset();
+	_file_name = file_name;
+
+	std::ifstream file(file_name.c_str(), std::ios::binary);
+	if (!file)
+	{
+		issue(0, "Unable to open file");
+		return false;
+	}
+
+	file.seekg(0, std::ios::end);
+	int length = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	std::vector<char> data(length + 1);
+	if (length > 0) file.read(&data[0], length);
+	if (!file)
+	{
+		issue(0, "Unable to read file");
+		return false;
+	}
+	_loaded = true;
+
+	check_data(&data[0], length);
+
+	// Only try the library load if it won't fall over
+	if (_issues.empty()) check_library_load();
+
+	return valid();
+}
+
+/**
+ * Check resource file data that is already in memory
+ *
+ * The data is not modified.
+ *
+ * @param data resource file data
+ * @param length length of data
+ * @returns true if the data is valid. Use issues() to get the details
+ * of any problems found.
+ */
+bool ResValidator::validate(const char *data, int length)
+{
+	reset();
+	_loaded = true;
+	check_data(data, length);
+
+	return valid();
+}
+
+/**
+ * Clear results of last validation
+ */
+void ResValidator::reset()
+{
+	_file_name.clear();
+	_loaded = false;
+	_object_count = 0;
+	_issues.clear();
+	_object_name.clear();
+}
+
+/**
+ * Record a problem
+ *
+ * @param offset offset in the file of the problem
+ * @param message description of the problem
+ */
+void ResValidator::issue(int offset, const std::string &message)
+{
+	ResValidationIssue new_issue;
+	new_issue.offset = offset;
+	new_issue.object = _object_name;
+	new_issue.message = message;
+	_issues.push_back(new_issue);
+}
+
+/**
+ * Get a word from the data.
+ *
+ * The caller must ensure the offset is in the data.
+ */
+int ResValidator::int_at(int offset) const
+{
+	int value;
+	std::memcpy(&value, _data + offset, 4);
+	return value;
+}
+
+/**
+ * Check the file header and all the objects
+ */
+void ResValidator::check_data(const char *data, int length)
+{
+	_data = data;
+	_length = length;
+
+	if (length < 12)
+	{
+		issue(0, "File is too short to contain the resource file header");
+	} else if (int_at(0) != RESF_MARKER)
+	{
+		issue(0, "File does not start with the resource file marker");
+	} else
+	{
+		int offset = int_at(8);
+		if (offset != -1)
+		{
+			if (offset < 12 || offset > length)
+			{
+				issue(8, "Offset to the first object is outside of the file");
+			} else
+			{
+				while (offset < length)
+				{
+					int next = check_object(offset);
+					if (next == -1) break; // Can't find the next object
+					_object_count++;
+					offset = next;
+				}
+			}
+		}
+	}
+
+	_object_name.clear();
+	_data = 0;
+	_length = 0;
+}
+
+/**
+ * Check the object at the given offset
+ *
+ * @param offset offset of the data header of the object
+ * @returns offset to the next object or -1 if it can't be found
+ */
+int ResValidator::check_object(int offset)
+{
+	_object_name.clear();
+	if (offset + DATA_HEADER_SIZE + OBJECT_HEADER_SIZE > _length)
+	{
+		issue(offset, "Object header extends past the end of the file");
+		return -1;
+	}
+
+	const char *name = _data + offset + 24;
+	int name_len = 0;
+	while (name_len < 12 && name[name_len]) name_len++;
+	_object_name.assign(name, name_len);
+	if (name_len == 12) issue(offset + 24, "Object name is not terminated");
+
+	int string_table = int_at(offset);
+	int message_table = int_at(offset + 4);
+	int reloc_table = int_at(offset + 8);
+	int class_id = int_at(offset + 12);
+	int total_size = int_at(offset + 36);
+	int body = int_at(offset + 40); // Offset from object header
+	int body_size = int_at(offset + 44);
+	int num_relocs = 0;
+	int next;
+
+	if (reloc_table == -1)
+	{
+		next = offset + DATA_HEADER_SIZE + total_size;
+	} else
+	{
+		if (reloc_table < DATA_HEADER_SIZE + OBJECT_HEADER_SIZE
+			|| reloc_table > _length - offset - 4)
+		{
+			issue(offset + 8, "Relocation table offset is outside of the file");
+			return -1;
+		}
+		num_relocs = int_at(offset + reloc_table);
+		if (num_relocs < 0 || num_relocs > (_length - offset - reloc_table - 4) / 8)
+		{
+			issue(offset + reloc_table, "Number of relocations is invalid");
+			return -1;
+		}
+		next = offset + reloc_table + 4 + num_relocs * 8;
+		if (DATA_HEADER_SIZE + total_size != reloc_table)
+		{
+			issue(offset + 36, "Object total size does not match the relocation table offset");
+		}
+	}
+
+	if (total_size < OBJECT_HEADER_SIZE || next > _length || next <= offset)
+	{
+		issue(offset + 36, "Object total size is invalid");
+		return -1;
+	}
+
+	if (body < OBJECT_HEADER_SIZE || body_size < 0 || body + body_size > total_size)
+	{
+		issue(offset + 40, "Object body is outside of the object");
+		return next;
+	}
+
+	int body_pos = offset + DATA_HEADER_SIZE + body;
+	int tables_start = DATA_HEADER_SIZE + body + body_size;
+	_string_start = _string_end = _message_start = _message_end = -1;
+
+	if (reloc_table == -1)
+	{
+		if (string_table != -1 || message_table != -1)
+		{
+			issue(offset, "Object has a string or message table but no relocation table");
+		}
+	} else
+	{
+		if (string_table != -1)
+		{
+			if (string_table < tables_start || string_table > reloc_table
+				|| (message_table != -1 && string_table > message_table))
+			{
+				issue(offset, "String table offset is invalid");
+			} else
+			{
+				_string_start = offset + string_table;
+				_string_end = offset + ((message_table == -1) ? reloc_table : message_table);
+			}
+		}
+		if (message_table != -1)
+		{
+			if (message_table < tables_start || message_table > reloc_table)
+			{
+				issue(offset + 4, "Message table offset is invalid");
+			} else
+			{
+				_message_start = offset + message_table;
+				_message_end = offset + reloc_table;
+			}
+		}
+
+		check_relocations(offset + reloc_table + 4, num_relocs, body_pos, body_size);
+	}
+
+	switch(class_id)
+	{
+	case ResWindow::CLASS_ID: check_window(body_pos, body_size); break;
+	case ResMenu::CLASS_ID: check_menu(body_pos, body_size); break;
+	}
+
+	return next;
+}
+
+/**
+ * Check the entries in a relocation table
+ *
+ * @param reloc_table offset of first relocation in the file
+ * @param num_relocs number of relocations
+ * @param body offset of the object body in the file
+ * @param body_size size of the body
+ */
+void ResValidator::check_relocations(int reloc_table, int num_relocs, int body, int body_size)
+{
+	for (int j = 0; j < num_relocs; j++)
+	{
+		int reloc_pos = reloc_table + j * 8;
+		int reloc_offset = int_at(reloc_pos);
+		int type = int_at(reloc_pos + 4);
+		if (reloc_offset < 0 || reloc_offset > body_size - 4)
+		{
+			issue(reloc_pos, "Relocation offset is outside of the object body");
+			continue;
+		}
+		int value = int_at(body + reloc_offset);
+
+		switch(type)
+		{
+		case ResRelocation::STRING_REF:
+			if (value == -1) break;
+			if (_string_start == -1) issue(reloc_pos, "String reference without a string table");
+			else check_text(reloc_pos, _string_start, _string_end, value, "String");
+			break;
+
+		case ResRelocation::MESSAGE_REF:
+			if (value == -1) break;
+			if (_message_start == -1) issue(reloc_pos, "Message reference without a message table");
+			else check_text(reloc_pos, _message_start, _message_end, value, "Message");
+			break;
+
+		case ResRelocation::SPRITE_AREA_REF:
+			// Value is only used to see if there is a sprite area
+			break;
+
+		case ResRelocation::OBJECT_REF:
+			if (value != -1 && (value < 0 || value > body_size))
+			{
+				issue(reloc_pos, "Object reference is outside of the object body");
+			}
+			break;
+
+		default:
+			issue(reloc_pos + 4, "Unknown relocation type " + tbx::to_string(type));
+			break;
+		}
+	}
+}
+
+/**
+ * Check an offset into a string or message table refers to a
+ * terminated string in the table
+ */
+void ResValidator::check_text(int offset, int table_start, int table_end, int text_offset, const char *desc)
+{
+	if (text_offset < 0 || text_offset >= table_end - table_start)
+	{
+		issue(offset, std::string(desc) + " offset is outside of the table");
+	} else if (std::memchr(_data + table_start + text_offset, 0, table_end - table_start - text_offset) == 0)
+	{
+		issue(offset, std::string(desc) + " is not terminated in the table");
+	}
+}
+
+/**
+ * Check the shortcuts and gadgets of a window object
+ *
+ * @param body offset of the body in the file
+ * @param body_size size of the body
+ */
+void ResValidator::check_window(int body, int body_size)
+{
+	if (body_size < 48)
+	{
+		issue(body, "Window body is too small");
+		return;
+	}
+
+	int num_shortcuts = int_at(body + 32);
+	int shortcut_offset = int_at(body + 36);
+	int num_gadgets = int_at(body + 40);
+	int gadget_offset = int_at(body + 44);
+
+	if (num_shortcuts < 0
+		|| (num_shortcuts > 0 && (shortcut_offset < 0
+			|| shortcut_offset > body_size - num_shortcuts * SHORTCUT_SIZE)))
+	{
+		issue(body + 32, "Window shortcuts are outside of the window body");
+	}
+
+	if (num_gadgets < 0
+		|| (num_gadgets > 0 && (gadget_offset < 0 || gadget_offset > body_size)))
+	{
+		issue(body + 40, "Window gadgets are outside of the window body");
+		return;
+	}
+
+	int pos = gadget_offset;
+	for (int j = 0; j < num_gadgets; j++)
+	{
+		if (pos > body_size - 8)
+		{
+			issue(body + pos, "Gadget " + tbx::to_string(j) + " header is outside of the window body");
+			return;
+		}
+		int size;
+		try
+		{
+			size = ResGadget::gadget_size(int_at(body + pos + 4));
+		} catch(std::invalid_argument &)
+		{
+			issue(body + pos + 4, "Gadget " + tbx::to_string(j) + " is an unknown type without a size");
+			return;
+		}
+		if (size < 36 || pos + size > body_size)
+		{
+			issue(body + pos + 4, "Gadget " + tbx::to_string(j) + " size is invalid");
+			return;
+		}
+		pos += size;
+	}
+
+	if (num_gadgets > 0 && pos != body_size)
+	{
+		issue(body + pos, "Gadgets do not finish at the end of the window body");
+	}
+}
+
+/**
+ * Check the menu items of a menu object
+ *
+ * @param body offset of the body in the file
+ * @param body_size size of the body
+ */
+void ResValidator::check_menu(int body, int body_size)
+{
+	if (body_size < MENU_DATA_SIZE)
+	{
+		issue(body, "Menu body is too small");
+		return;
+	}
+	int num_items = int_at(body + 28);
+	if (num_items < 0 || MENU_DATA_SIZE + num_items * MENU_ITEM_SIZE != body_size)
+	{
+		issue(body + 28, "Number of menu items does not match the size of the menu body");
+	}
+}
+
+/**
+ * Check the file loads using a ResFile
+ */
+void ResValidator::check_library_load()
+{
+	ResFile res_file;
+	if (!res_file.load(_file_name, true))
+	{
+		issue(0, "ResFile failed to load the file");
+		return;
+	}
+
+	int count = 0;
+	try
+	{
+		for (ResFile::const_iterator i = res_file.begin(); i != res_file.end(); ++i)
+		{
+			ResObject obj = *i;
+			_object_name = obj.name();
+			count++;
+		}
+		_object_name.clear();
+	} catch(std::exception &e)
+	{
+		issue(0, std::string("ResFile failed to read the objects: ") + e.what());
+		_object_name.clear();
+		return;
+	}
+
+	if (count != _object_count)
+	{
+		issue(0, "ResFile found " + tbx::to_string(count) + " objects");
+	}
+}
+
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_RES_RESVALIDATOR_H_
+#define TBX_RES_RESVALIDATOR_H_
+
+#include <string>
+#include <vector>
+
+namespace tbx {
+
+namespace res {
+
+/**
+ * Details of a problem found by the ResValidator
+ */
+struct ResValidationIssue
+{
+	int offset;          //!< Offset in the file of the problem
+	std::string object;  //!< Name of object with the problem or "" if not in an object
+	std::string message; //!< Description of the problem
+};
+
+/**
+ * Class to check the structure of a toolbox resource file.
+ *
+ * The file is checked without relocating or creating any objects so
+ * it can be used to check files that may be damaged. It checks:
+ * - the file header
+ * - the data header, body and total sizes of each object
+ * - the relocation table entries and the string and message offsets
+ *   they refer to
+ * - the size and position of the gadgets and shortcuts in windows
+ * - the number of items in menus
+ *
+ * If the structure is valid the file is then loaded with a ResFile
+ * to check the library can read every object.
+ *
+ * A ResValidator does not use any shared data, so separate
+ * ResValidators can be used at the same time on different threads.
+ */
+class ResValidator
+{
+	std::string _file_name;
+	bool _loaded;
+	int _object_count;
+	std::vector<ResValidationIssue> _issues;
+
+	// Details of the data and object being checked
+	const char *_data;
+	int _length;
+	std::string _object_name;
+	int _string_start, _string_end;
+	int _message_start, _message_end;
+
+public:
+	ResValidator();
+
+	bool validate(const std::string &file_name);
+	bool validate(const char *data, int length);
+
+	/**
+	 * Name of the last file validated
+	 *
+	 * @returns file name or "" if the last validation was of data in memory
+	 */
+	const std::string &file_name() const {return _file_name;}
+
+	/**
+	 * Check if the data to validate was loaded
+	 *
+	 * @returns false if the file could not be read
+	 */
+	bool loaded() const {return _loaded;}
+
+	/**
+	 * Check if no problems were found by the last validation
+	 *
+	 * @returns true if the resources are valid
+	 */
+	bool valid() const {return _loaded && _issues.empty();}
+
+	/**
+	 * Number of objects found in the last validation
+	 */
+	int object_count() const {return _object_count;}
+
+	/**
+	 * Problems found by the last validation
+	 */
+	const std::vector<ResValidationIssue> &issues() const {return _issues;}
+
+private:
+	void reset();
+	void issue(int offset, const std::string &message);
+	int int_at(int offset) const;
+	void check_data(const char *data, int length);
+	void check_library_load();
+	int check_object(int offset);
+	void check_relocations(int reloc_table, int num_relocs, int body, int body_size);
+	void check_text(int offset, int table_start, int table_end, int text_offset, const char *desc);
+	void check_window(int body, int body_size);
+	void check_menu(int body, int body_size);
+};
+
+}
+
+}
+
+#endif /* TBX_RES_RESVALIDATOR_H_ */
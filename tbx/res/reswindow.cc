@@ -165,13 +165,10 @@ void ResWindow::next_gadget(int &item_offset) const
  */
 ResWindow::gadget_iterator ResWindow::find_gadget(ComponentId component_id)
 {
-	gadget_iterator i = gadget_begin();
-	for (; i != gadget_end(); ++i)
-	{
-		if (int_value(i._offset + 24) == component_id) break;
-	}
+	if (!_gadget_index.valid(_impl)) build_gadget_index();
+	int offset = _gadget_index.find(component_id);
 
-	return i; 
+	return (offset == -1) ? gadget_end() : gadget_iterator(this, offset);
 }
 
 /**
@@ -181,13 +178,25 @@ ResWindow::gadget_iterator ResWindow::find_gadget(ComponentId component_id)
  */
 ResWindow::const_gadget_iterator ResWindow::find_gadget(ComponentId component_id) const
 {
-	const_gadget_iterator i = gadget_begin();
-	for (; i != gadget_end(); ++i)
+	if (!_gadget_index.valid(_impl)) build_gadget_index();
+	int offset = _gadget_index.find(component_id);
+
+	return (offset == -1) ? gadget_end() : const_gadget_iterator(this, offset);
+}
+
+/**
+ * Build the index from the component ID to the offset of each gadget
+ */
+void ResWindow::build_gadget_index() const
+{
+	_gadget_index.start(_impl, num_gadgets());
+	int offset = first_gadget_offset();
+	int end_offset = end_gadget_offset();
+	while (offset < end_offset)
 	{
-		if (int_value(i._offset + 24) == component_id) break;
+		_gadget_index.add(int_value(offset + 24), offset);
+		next_gadget(offset);
 	}
-
-	return i; 
 }
 
 /**
@@ -239,6 +248,10 @@ void ResWindow::replace_gadget(const ResGadget &gadget)
 
 	int old_size = ResGadget::gadget_size(*((int *)(object_header()->body + pos._offset + 4)));
 	replace_component(pos._offset, old_size, gadget._impl);
+
+	// Other gadgets only move if the size has changed
+	if (old_size == gadget._impl->size()) _gadget_index.validate(_impl);
+	else _gadget_index.invalidate();
 }
 
 
@@ -268,6 +281,8 @@ ResWindow::gadget_iterator ResWindow::insert_gadget(gadget_iterator pos, const R
 	gadget_iterator i = find_gadget(gadget.component_id());
 	if (i != gadget_end()) throw ResGadgetExists(name(), gadget.component_id());
 
+	bool append = (pos._offset == end_gadget_offset());
+
 	make_writeable();
 
 	int insert_location = pos._offset;
@@ -285,6 +300,16 @@ ResWindow::gadget_iterator ResWindow::insert_gadget(gadget_iterator pos, const R
 
 	int_value(40, num_gadgets()+1); // Update gadget count
 
+	// Gadgets added to the end do not move the existing gadgets
+	if (append)
+	{
+		_gadget_index.add(gadget.component_id(), insert_location);
+		_gadget_index.validate(_impl);
+	} else
+	{
+		_gadget_index.invalidate();
+	}
+
 	return pos;
 }
 
@@ -305,11 +330,18 @@ ResWindow::gadget_iterator ResWindow::replace_gadget(gadget_iterator pos, const
 		throw ResGadgetExists(name(), gadget.component_id());
 	}
 
+	bool keep_index = _gadget_index.valid(_impl)
+		&& gadget.component_id() == int_value(pos._offset + 24);
+
 	make_writeable();
 
 	int old_size = ResGadget::gadget_size(*((int *)(object_header()->body + pos._offset + 4)));
 	replace_component(pos._offset, old_size, gadget._impl);
 
+	// Index is still correct if the ID is the same and nothing has moved
+	if (keep_index && old_size == gadget._impl->size()) _gadget_index.validate(_impl);
+	else _gadget_index.invalidate();
+
 	return pos;
 }
 
@@ -327,6 +359,7 @@ ResWindow::gadget_iterator ResWindow::erase_gadget(gadget_iterator pos)
 	int count = num_gadgets()-1;
 	int_value(40, count); // Update gadget count
 	if (count == 0) int_value(44, 0); // Update gadget pointer
+	_gadget_index.invalidate();
 
 	return pos;
 }
@@ -395,13 +428,10 @@ int ResWindow::end_shortcut_offset() const
  */
 ResWindow::shortcut_iterator ResWindow::find_shortcut(int key_code)
 {
-	shortcut_iterator i = shortcut_begin();
-	for (; i != shortcut_end(); ++i)
-	{
-		if (int_value(i._offset + 4) == key_code) break;
-	}
+	if (!_shortcut_index.valid(_impl)) build_shortcut_index();
+	int offset = _shortcut_index.find(key_code);
 
-	return i; 
+	return (offset == -1) ? shortcut_end() : shortcut_iterator(this, offset);
 }
 
 /**
@@ -412,13 +442,23 @@ ResWindow::shortcut_iterator ResWindow::find_shortcut(int key_code)
  */
 ResWindow::const_shortcut_iterator ResWindow::find_shortcut(int key_code) const
 {
-	const_shortcut_iterator i = shortcut_begin();
-	for (; i != shortcut_end(); ++i)
+	if (!_shortcut_index.valid(_impl)) build_shortcut_index();
+	int offset = _shortcut_index.find(key_code);
+
+	return (offset == -1) ? shortcut_end() : const_shortcut_iterator(this, offset);
+}
+
+/**
+ * Build the index from the key code to the offset of each shortcut
+ */
+void ResWindow::build_shortcut_index() const
+{
+	_shortcut_index.start(_impl, num_shortcuts());
+	int end_offset = end_shortcut_offset();
+	for (int offset = first_shortcut_offset(); offset < end_offset; offset += SHORTCUT_SIZE)
 	{
-		if (int_value(i._offset + 4) == key_code) break;
+		_shortcut_index.add(int_value(offset + 4), offset);
 	}
-
-	return i; 
 }
 
 /**
@@ -467,6 +507,8 @@ void ResWindow::replace_shortcut(const ResShortcut &shortcut)
 	make_writeable();
 
 	replace_component(pos._offset, SHORTCUT_SIZE, shortcut._impl);
+	// Shortcuts are a fixed size and the key code is the same so nothing moves
+	_shortcut_index.validate(_impl);
 }
 
 
@@ -496,6 +538,8 @@ ResWindow::shortcut_iterator ResWindow::insert_shortcut(shortcut_iterator pos, c
 	shortcut_iterator i = find_shortcut(shortcut.key_code());
 	if (i != shortcut_end()) throw ResShortcutExists(name(), shortcut.key_code());
 
+	bool append = (pos._offset == end_shortcut_offset());
+
 	make_writeable();
 
 	int insert_location = pos._offset;
@@ -514,6 +558,17 @@ ResWindow::shortcut_iterator ResWindow::insert_shortcut(shortcut_iterator pos, c
 
 	int_value(32, num_shortcuts()+1); // Update shortcut count
 
+	// Gadgets follow the shortcuts so will always have moved
+	_gadget_index.invalidate();
+	if (append)
+	{
+		_shortcut_index.add(shortcut.key_code(), insert_location);
+		_shortcut_index.validate(_impl);
+	} else
+	{
+		_shortcut_index.invalidate();
+	}
+
 	return pos;
 }
 
@@ -534,10 +589,16 @@ ResWindow::shortcut_iterator ResWindow::replace_shortcut(shortcut_iterator pos,
 		throw ResShortcutExists(name(), shortcut.key_code());
 	}
 
+	bool keep_index = _shortcut_index.valid(_impl)
+		&& shortcut.key_code() == int_value(pos._offset + 4);
+
 	make_writeable();
 
 	replace_component(pos._offset, SHORTCUT_SIZE, shortcut._impl);
 
+	if (keep_index) _shortcut_index.validate(_impl);
+	else _shortcut_index.invalidate();
+
 	return pos;
 }
 
@@ -554,6 +615,8 @@ ResWindow::shortcut_iterator ResWindow::erase_shortcut(shortcut_iterator pos)
 	int count = num_shortcuts()-1;
 	int_value(32, count); // Update shortcut count
 	if (count == 0) int_value(36, 0); // Update shortcut pointer
+	_shortcut_index.invalidate();
+	_gadget_index.invalidate();
 
 	return pos;
 }
@@ -28,6 +28,7 @@
 #include "resgadget.h"
 #include "resshortcut.h"
 #include "resiteratorbase.h"
+#include "rescomponentindex.h"
 #include "../handles.h"
 #include "../colour.h"
 
@@ -136,6 +137,8 @@ class ResWindow : public ResObject
       ResWindow&operator=(const ResWindow&other)
       {
          ResObject::operator=(other);
+         _gadget_index.invalidate();
+         _shortcut_index.invalidate();
          return *this;
       }
 
@@ -148,6 +151,8 @@ class ResWindow : public ResObject
       {
          other.check_class_id(CLASS_ID);
 		 ResObject::operator =(other);
+         _gadget_index.invalidate();
+         _shortcut_index.invalidate();
          return *this;
       }
 
@@ -1321,6 +1326,12 @@ class ResWindow : public ResObject
 		int end_shortcut_offset() const;
 	    ResShortcut shortcut_at_offset(int item_offset) const;
 
+	private:
+		// Indices from component ID/key code to offset built on first use
+		mutable ResComponentIndex _gadget_index;
+		mutable ResComponentIndex _shortcut_index;
+		void build_gadget_index() const;
+		void build_shortcut_index() const;
 };
 
 }
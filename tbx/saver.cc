@@ -234,7 +234,8 @@ void Saver::SaverImpl::recorded_message(WimpMessageEvent &event, int reply_to)
  */
 void Saver::SaverImpl::acknowledge_message(WimpMessageEvent &event)
 {
-	if (event.message().your_ref() != _my_ref) return;
+	// Returned messages are unchanged so check our reference
+	if (event.message().my_ref() != _my_ref) return;
 
     switch(event.message().message_id())
     {
@@ -510,6 +510,9 @@ bool UserSprite::remove_mask()
  * information use pixel(x,y,&tint) to return the tint information as
  * well.
  *
+ * Each call uses OS_SpriteOp so use SpritePixels to process
+ * many pixels.
+ *
  * @param x x coordinate to get the pixel for in pixels
  * @param y y coordinate to  get the pixel for in pixels
  * @returns gcol pixel value in sprite
@@ -560,6 +563,9 @@ int UserSprite::pixel(int x, int y, int *tint) const
  * tint is set to 0, use pixel(x,y,gcol, tint) to set the tint
  * information as well.
  *
+ * Each call uses OS_SpriteOp so use SpritePixels to process
+ * many pixels.
+ *
  * @param x x coordinate to set the pixel for in pixels
  * @param y y coordinate to  set the pixel for in pixels
  * @param gcol pixel value to set from 0 to number colours in sprite-1
@@ -877,7 +883,8 @@ int SpriteArea::get_bits_per_pixel(int mode)
 {
 	int bitsPerPixel = 32;
 
-	if (mode & 1)
+	// Mode numbers below 256 are never sprite mode words
+	if ((mode & 1) && (unsigned int)mode >= 256)
 	{
 		switch(SpriteColours(mode >> 27))
 		{
@@ -1376,7 +1383,7 @@ ColourPalette::~ColourPalette()
  */
 ColourPalette::ColourPalette(int size /* = 0 */)
 {
-   if (_size)
+   if (size)
    {
       _palette = new Colour[size];
       _size = size;
@@ -0,0 +1,701 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "spritepixels.h"
+#include "modeinfo.h"
+#include <cstring>
+#include <algorithm>
+
+namespace tbx {
+
+//! @cond INTERNAL
+/**
+ * Get the bits per pixel for a sprite mode
+ */
+static int sprite_bits_per_pixel(int mode)
+{
+	if ((unsigned int)mode < 256)
+	{
+		switch(SpriteFormat(mode))
+		{
+		case SF_Colour2dpi90x45: case SF_Colour2dpi45: case SF_Colour2dpi90:
+		case SF_Colour4dpi45: case SF_Colour4dpi90x45: case SF_Colour4dpi90:
+		case SF_Colour16dpi45: case SF_Colour16dpi90x45: case SF_Colour16dpi90:
+		case SF_Colour256dpi45: case SF_Colour256dpi90x45: case SF_Colour256dpi90:
+			return SpriteArea::get_bits_per_pixel(mode);
+		}
+
+		// Other mode numbers need to be looked up
+		switch(ModeInfo(mode).colours())
+		{
+		case 2: return 1;
+		case 4: return 2;
+		case 16: return 4;
+		case 256: return 8;
+		case 65536: return 16;
+		default: return 32;
+		}
+	}
+
+	return SpriteArea::get_bits_per_pixel(mode);
+}
+
+/**
+ * Get the mask for the bits of a pixel value
+ *
+ * @param bpp bits per pixel (1 to 32)
+ */
+static inline unsigned int value_mask(int bpp)
+{
+	return (bpp >= 32) ? 0xFFFFFFFFu : ((1u << bpp) - 1);
+}
+
+/**
+ * Get the value of a pixel of any depth from a row
+ */
+static inline unsigned int get_bits(const unsigned char *row, int bit, int bpp)
+{
+	switch(bpp)
+	{
+	case 8: return row[bit >> 3];
+	case 16: return reinterpret_cast<const unsigned short *>(row)[bit >> 4];
+	case 32: return reinterpret_cast<const unsigned int *>(row)[bit >> 5];
+	}
+	return (row[bit >> 3] >> (bit & 7)) & value_mask(bpp);
+}
+
+/**
+ * Set the value of a pixel of any depth in a row
+ */
+static inline void set_bits(unsigned char *row, int bit, int bpp, unsigned int value)
+{
+	switch(bpp)
+	{
+	case 8: row[bit >> 3] = (unsigned char)value; break;
+	case 16: reinterpret_cast<unsigned short *>(row)[bit >> 4] = (unsigned short)value; break;
+	case 32: reinterpret_cast<unsigned int *>(row)[bit >> 5] = value; break;
+	default:
+		{
+			int shift = bit & 7;
+			unsigned char mask = (unsigned char)(value_mask(bpp) << shift);
+			unsigned char &byte = row[bit >> 3];
+			byte = (unsigned char)((byte & ~mask) | ((value << shift) & mask));
+		}
+		break;
+	}
+}
+
+/**
+ * Fill a range of pixels in a row
+ *
+ * @param row start of the row
+ * @param bit first bit to fill
+ * @param count number of pixels to fill
+ * @param bpp bits per pixel
+ * @param value pixel value to fill with
+ */
+static void fill_row(unsigned char *row, int bit, int count, int bpp, unsigned int value)
+{
+	if (bpp == 32)
+	{
+		std::fill_n(reinterpret_cast<unsigned int *>(row) + (bit >> 5), count, value);
+		return;
+	}
+	if (bpp == 16)
+	{
+		std::fill_n(reinterpret_cast<unsigned short *>(row) + (bit >> 4), count, (unsigned short)value);
+		return;
+	}
+
+	// Replicate the value across a byte so the whole bytes can be set at once
+	unsigned int pattern = value & value_mask(bpp);
+	for (int b = bpp; b < 8; b <<= 1) pattern |= pattern << b;
+
+	unsigned char *data = row + (bit >> 3);
+	int start = bit & 7;
+	int end = start + count * bpp;
+
+	if (end <= 8)
+	{
+		unsigned char mask = (unsigned char)(((1 << (end - start)) - 1) << start);
+		*data = (unsigned char)((*data & ~mask) | (pattern & mask));
+		return;
+	}
+	if (start)
+	{
+		unsigned char mask = (unsigned char)(0xFF << start);
+		*data = (unsigned char)((*data & ~mask) | (pattern & mask));
+		data++;
+		end -= 8;
+	}
+	std::memset(data, (int)pattern, end >> 3);
+	if (end & 7)
+	{
+		data += end >> 3;
+		unsigned char mask = (unsigned char)((1 << (end & 7)) - 1);
+		*data = (unsigned char)((*data & ~mask) | (pattern & mask));
+	}
+}
+
+/**
+ * Copy a range of pixels from one row to another
+ *
+ * The rows may overlap.
+ *
+ * @param dest destination row
+ * @param dest_bit first bit in the destination
+ * @param source source row
+ * @param source_bit first bit in the source
+ * @param count number of pixels to copy
+ * @param bpp bits per pixel
+ */
+static void copy_row(unsigned char *dest, int dest_bit, const unsigned char *source, int source_bit, int count, int bpp)
+{
+	int bits = count * bpp;
+	int start = dest_bit & 7;
+
+	if (start != (source_bit & 7))
+	{
+		// Not aligned the same so copy a pixel at a time in a safe direction
+		if (dest == source && dest_bit > source_bit)
+		{
+			for (int j = count - 1; j >= 0; j--)
+				set_bits(dest, dest_bit + j * bpp, bpp, get_bits(source, source_bit + j * bpp, bpp));
+		} else
+		{
+			for (int j = 0; j < count; j++)
+				set_bits(dest, dest_bit + j * bpp, bpp, get_bits(source, source_bit + j * bpp, bpp));
+		}
+		return;
+	}
+
+	unsigned char *d = dest + (dest_bit >> 3);
+	const unsigned char *s = source + (source_bit >> 3);
+	int end = start + bits;
+
+	if (end <= 8)
+	{
+		unsigned char mask = (unsigned char)(((1 << bits) - 1) << start);
+		*d = (unsigned char)((*d & ~mask) | (*s & mask));
+		return;
+	}
+
+	// Read partial bytes before the move in case the rows overlap
+	unsigned char first = s[0];
+	unsigned char last = (end & 7) ? s[end >> 3] : 0;
+	int whole = start ? 1 : 0;
+	std::memmove(d + whole, s + whole, (end >> 3) - whole);
+	if (start)
+	{
+		unsigned char mask = (unsigned char)(0xFF << start);
+		d[0] = (unsigned char)((d[0] & ~mask) | (first & mask));
+	}
+	if (end & 7)
+	{
+		unsigned char mask = (unsigned char)((1 << (end & 7)) - 1);
+		d[end >> 3] = (unsigned char)((d[end >> 3] & ~mask) | (last & mask));
+	}
+}
+
+/**
+ * Map the pixels of one sprite to another with a function
+ */
+template<int S, int D, class F> static void map_rows(const SpritePixels &source, SpritePixels &dest, int width, int height, const F &f)
+{
+	for (int y = 0; y < height; y++)
+	{
+		SpriteRow<S> s = source.row<S>(y);
+		SpriteRow<D> d = dest.row<D>(y);
+		for (int x = 0; x < width; x++) d.set(x, f(s[x]));
+	}
+}
+
+/**
+ * Map the pixels to the destination depth
+ */
+template<int S, class F> static void map_to(const SpritePixels &source, SpritePixels &dest, int width, int height, const F &f)
+{
+	switch(dest.bits_per_pixel())
+	{
+	case 1: map_rows<S,1>(source, dest, width, height, f); break;
+	case 2: map_rows<S,2>(source, dest, width, height, f); break;
+	case 4: map_rows<S,4>(source, dest, width, height, f); break;
+	case 8: map_rows<S,8>(source, dest, width, height, f); break;
+	case 16: map_rows<S,16>(source, dest, width, height, f); break;
+	case 32: map_rows<S,32>(source, dest, width, height, f); break;
+	}
+}
+
+/**
+ * Map the pixels of the area common to two sprites with a function
+ */
+template<class F> static void map_pixels(const SpritePixels &source, SpritePixels &dest, const F &f)
+{
+	int width = std::min(source.width(), dest.width());
+	int height = std::min(source.height(), dest.height());
+
+	switch(source.bits_per_pixel())
+	{
+	case 1: map_to<1>(source, dest, width, height, f); break;
+	case 2: map_to<2>(source, dest, width, height, f); break;
+	case 4: map_to<4>(source, dest, width, height, f); break;
+	case 8: map_to<8>(source, dest, width, height, f); break;
+	case 16: map_to<16>(source, dest, width, height, f); break;
+	case 32: map_to<32>(source, dest, width, height, f); break;
+	}
+}
+
+/**
+ * Function to look up a pixel in a table
+ */
+struct SpriteTableLookup
+{
+	const unsigned int *table;
+	SpriteTableLookup(const unsigned int *t) : table(t) {}
+	unsigned int operator()(unsigned int pixel) const {return table[pixel];}
+};
+
+/**
+ * Function to convert a 16 bit pixel to 32 bits
+ */
+struct SpritePixel16To32
+{
+	unsigned int operator()(unsigned int pixel) const
+	{
+		unsigned int r = pixel & 0x1F, g = (pixel >> 5) & 0x1F, b = (pixel >> 10) & 0x1F;
+		return ((r << 3) | (r >> 2)) | (((g << 3) | (g >> 2)) << 8) | (((b << 3) | (b >> 2)) << 16);
+	}
+};
+
+/**
+ * Function to convert a 32 bit pixel to 16 bits
+ */
+struct SpritePixel32To16
+{
+	unsigned int operator()(unsigned int pixel) const
+	{
+		return ((pixel >> 3) & 0x1F) | ((pixel >> 6) & 0x3E0) | ((pixel >> 9) & 0x7C00);
+	}
+};
+
+/**
+ * Function to copy the pixel value unchanged
+ */
+struct SpritePixelCopy
+{
+	unsigned int operator()(unsigned int pixel) const {return pixel;}
+};
+
+/**
+ * Set the mask from the sprite pixels
+ */
+template<int S> static void mask_rows(SpritePixels &pixels, unsigned int key)
+{
+	int width = pixels.width();
+	for (int y = 0; y < pixels.height(); y++)
+	{
+		SpriteRow<S> s = pixels.row<S>(y);
+		if (pixels.mask_bits_per_pixel() == 1)
+		{
+			// Build new format mask a byte at a time
+			unsigned char *mask = pixels.mask_row<1>(y).data();
+			int x = 0;
+			for (; x + 8 <= width; x += 8)
+			{
+				unsigned int bits = 0;
+				for (int b = 0; b < 8; b++)
+				{
+					if (s[x + b] != key) bits |= (1 << b);
+				}
+				*mask++ = (unsigned char)bits;
+			}
+			if (x < width)
+			{
+				unsigned int bits = *mask & ~((1 << (width - x)) - 1);
+				for (int b = 0; x + b < width; b++)
+				{
+					if (s[x + b] != key) bits |= (1 << b);
+				}
+				*mask = (unsigned char)bits;
+			}
+		} else
+		{
+			// Old format mask uses the same layout as the image
+			SpriteRow<S> m = pixels.mask_row<S>(y);
+			for (int x = 0; x < width; x++)
+			{
+				m.set(x, (s[x] == key) ? 0 : ~0u);
+			}
+		}
+	}
+}
+//! @endcond
+
+/**
+ * Construct an invalid view
+ */
+SpritePixels::SpritePixels() :
+	_image(0), _row_bytes(0), _width(0), _height(0), _bpp(0), _first_bit(0),
+	_mask(0), _mask_row_bytes(0), _mask_bpp(0), _mask_first_bit(0)
+{
+}
+
+/**
+ * Construct a view of the pixels of a user sprite
+ *
+ * @param sprite sprite to view
+ */
+SpritePixels::SpritePixels(const UserSprite &sprite)
+{
+	if (sprite.is_valid()) init(sprite.pointer());
+	else *this = SpritePixels();
+}
+
+/**
+ * Construct a view of the pixels of a sprite in memory
+ *
+ * @param sprite pointer to the start of the sprite header
+ */
+SpritePixels::SpritePixels(OsSpritePtr sprite)
+{
+	init(sprite);
+}
+
+/**
+ * Set up the view from the sprite header
+ */
+void SpritePixels::init(OsSpritePtr sprite)
+{
+	unsigned int mode = (unsigned int)sprite[10];
+	int words = sprite[4] + 1;
+	int last_bit = sprite[7];
+
+	_bpp = sprite_bits_per_pixel((int)mode);
+	_row_bytes = words * 4;
+	_height = sprite[5] + 1;
+	_first_bit = sprite[6];
+	_width = (words * 32 - _first_bit - (31 - last_bit)) / _bpp;
+	_image = reinterpret_cast<unsigned char *>(sprite) + sprite[8];
+
+	if (sprite[9] != sprite[8])
+	{
+		_mask = reinterpret_cast<unsigned char *>(sprite) + sprite[9];
+		if (mode >= 256 && (mode >> 27) != 0)
+		{
+			// New format sprites have 1bpp masks
+			_mask_bpp = 1;
+			_mask_row_bytes = ((_width + 31) >> 5) * 4;
+			_mask_first_bit = 0;
+		} else
+		{
+			_mask_bpp = _bpp;
+			_mask_row_bytes = _row_bytes;
+			_mask_first_bit = _first_bit;
+		}
+	} else
+	{
+		_mask = 0;
+		_mask_row_bytes = 0;
+		_mask_bpp = 0;
+		_mask_first_bit = 0;
+	}
+}
+
+/**
+ * Clip an area to the sprite
+ *
+ * @returns false if there is nothing left after clipping
+ */
+bool SpritePixels::clip(int &x, int &y, int &width, int &height) const
+{
+	if (x < 0) {width += x; x = 0;}
+	if (y < 0) {height += y; y = 0;}
+	if (x + width > _width) width = _width - x;
+	if (y + height > _height) height = _height - y;
+	return (width > 0 && height > 0);
+}
+
+/**
+ * Get a pixel
+ *
+ * @param x x coordinate of pixel
+ * @param y y coordinate of pixel (0 is the bottom row)
+ * @returns pixel value. This is the colour number for sprites up to 256
+ * colours, 0BGR with 5 bits per component for 32K colours and 0xBBGGRR for 16M colours
+ */
+unsigned int SpritePixels::pixel(int x, int y) const
+{
+	return get_bits(row_data(y), _first_bit + x * _bpp, _bpp);
+}
+
+/**
+ * Set a pixel
+ *
+ * @param x x coordinate of pixel
+ * @param y y coordinate of pixel (0 is the bottom row)
+ * @param value new pixel value
+ */
+void SpritePixels::pixel(int x, int y, unsigned int value)
+{
+	set_bits(row_data(y), _first_bit + x * _bpp, _bpp, value);
+}
+
+/**
+ * Check if a pixel is solid in the mask
+ *
+ * @param x x coordinate of pixel
+ * @param y y coordinate of pixel (0 is the bottom row)
+ * @returns true if the pixel is solid or there is no mask
+ */
+bool SpritePixels::mask_pixel(int x, int y) const
+{
+	if (_mask == 0) return true;
+	return get_bits(mask_row_data(y), _mask_first_bit + x * _mask_bpp, _mask_bpp) != 0;
+}
+
+/**
+ * Set a pixel in the mask
+ *
+ * Does nothing if the sprite doesn't have a mask
+ *
+ * @param x x coordinate of pixel
+ * @param y y coordinate of pixel (0 is the bottom row)
+ * @param on true to make the pixel solid, false to make it transparent
+ */
+void SpritePixels::mask_pixel(int x, int y, bool on)
+{
+	if (_mask == 0) return;
+	set_bits(mask_row_data(y), _mask_first_bit + x * _mask_bpp, _mask_bpp, on ? ~0u : 0);
+}
+
+/**
+ * Fill a rectangle of the sprite with a pixel value
+ *
+ * The rectangle is clipped to the sprite.
+ *
+ * @param x left of the rectangle
+ * @param y bottom of the rectangle
+ * @param width width of the rectangle in pixels
+ * @param height height of the rectangle in pixels
+ * @param value pixel value to fill with
+ */
+void SpritePixels::fill(int x, int y, int width, int height, unsigned int value)
+{
+	if (!clip(x, y, width, height)) return;
+
+	int bit = _first_bit + x * _bpp;
+	for (int row = y; row < y + height; row++)
+	{
+		fill_row(row_data(row), bit, width, _bpp, value);
+	}
+}
+
+/**
+ * Fill a rectangle of the mask
+ *
+ * The rectangle is clipped to the sprite. Does nothing if the sprite
+ * doesn't have a mask.
+ *
+ * @param x left of the rectangle
+ * @param y bottom of the rectangle
+ * @param width width of the rectangle in pixels
+ * @param height height of the rectangle in pixels
+ * @param on true to make the pixels solid, false to make them transparent
+ */
+void SpritePixels::fill_mask(int x, int y, int width, int height, bool on)
+{
+	if (_mask == 0 || !clip(x, y, width, height)) return;
+
+	int bit = _mask_first_bit + x * _mask_bpp;
+	for (int row = y; row < y + height; row++)
+	{
+		fill_row(mask_row_data(row), bit, width, _mask_bpp, on ? ~0u : 0);
+	}
+}
+
+/**
+ * Copy a rectangle of pixels from a sprite to this sprite.
+ *
+ * The source may be this sprite and the areas may overlap.
+ * The rectangle is clipped to both sprites. Only the image is
+ * copied, not the mask.
+ *
+ * @param x left of the destination in this sprite
+ * @param y bottom of the destination in this sprite
+ * @param source sprite to copy from
+ * @param source_x left of the rectangle in the source
+ * @param source_y bottom of the rectangle in the source
+ * @param width width of the rectangle in pixels
+ * @param height height of the rectangle in pixels
+ * @throws SpriteException if the sprites have different numbers of bits per pixel
+ */
+void SpritePixels::copy(int x, int y, const SpritePixels &source, int source_x, int source_y, int width, int height)
+{
+	if (source._bpp != _bpp) throw SpriteException("Can not copy between sprites with different bits per pixel");
+
+	int sx = source_x, sy = source_y;
+	if (!source.clip(sx, sy, width, height)) return;
+	x += sx - source_x;
+	y += sy - source_y;
+	int dx = x, dy = y;
+	if (!clip(dx, dy, width, height)) return;
+	sx += dx - x;
+	sy += dy - y;
+
+	int dest_bit = _first_bit + dx * _bpp;
+	int source_bit = source._first_bit + sx * _bpp;
+
+	if (row_data(dy) > source.row_data(sy))
+	{
+		// Destination is later in memory so copy from the end in case of overlap
+		for (int row = 0; row < height; row++)
+		{
+			copy_row(row_data(dy + row), dest_bit, source.row_data(sy + row), source_bit, width, _bpp);
+		}
+	} else
+	{
+		for (int row = height - 1; row >= 0; row--)
+		{
+			copy_row(row_data(dy + row), dest_bit, source.row_data(sy + row), source_bit, width, _bpp);
+		}
+	}
+}
+
+/**
+ * Set pixels of another sprite by looking up the pixels of this sprite
+ * in a table.
+ *
+ * The table can be used to remap colours between palettes or give
+ * the colour values for a 32K or 16M colour sprite.
+ *
+ * The area common to both sprites is processed.
+ *
+ * @param dest sprite to receive the looked up pixels. This can be
+ * this sprite to remap it in place.
+ * @param table table with 1 << bits_per_pixel() entries of pixel
+ * values for the destination sprite
+ * @throws SpriteException if this sprite has more than 8 bits per pixel
+ */
+void SpritePixels::lookup(SpritePixels &dest, const unsigned int *table) const
+{
+	if (_bpp > 8) throw SpriteException("Sprite lookup needs 8 bits per pixel or less");
+	map_pixels(*this, dest, SpriteTableLookup(table));
+}
+
+/**
+ * Set the mask from a colour key.
+ *
+ * Pixels of the key colour are made transparent and all others
+ * are made solid. Does nothing if the sprite doesn't have a mask.
+ *
+ * @param key pixel value of the transparent colour
+ */
+void SpritePixels::mask_from_colour(unsigned int key)
+{
+	if (_mask == 0) return;
+
+	switch(_bpp)
+	{
+	case 1: mask_rows<1>(*this, key); break;
+	case 2: mask_rows<2>(*this, key); break;
+	case 4: mask_rows<4>(*this, key); break;
+	case 8: mask_rows<8>(*this, key); break;
+	case 16: mask_rows<16>(*this, key); break;
+	case 32: mask_rows<32>(*this, key); break;
+	}
+}
+
+/**
+ * Convert the pixels of this sprite to the format of another sprite.
+ *
+ * Conversion is supported between sprites with the same number of
+ * bits per pixel, from up to 256 colours to another sprite of up to 256
+ * colours (the colour numbers are kept), from up to 256 colours
+ * to 32K or 16M colours using the palette and between 32K and
+ * 16M colours.
+ *
+ * The area common to both sprites is converted.
+ *
+ * @param dest sprite to receive the converted pixels.
+ * @param palette palette for this sprite. Required when converting
+ * from 256 colours or less to 32K or 16M colours.
+ * @throws SpriteException if the conversion is not supported or
+ * the palette is needed but not given.
+ */
+void SpritePixels::convert(SpritePixels &dest, const ColourPalette *palette /*= 0*/) const
+{
+	int dest_bpp = dest.bits_per_pixel();
+
+	if (_bpp <= 8 && dest_bpp > 8)
+	{
+		if (palette == 0) throw SpriteException("Palette required to convert sprite");
+		unsigned int table[256];
+		int entries = 1 << _bpp;
+		for (int j = 0; j < entries; j++)
+		{
+			table[j] = (j < palette->size()) ? colour_to_pixel((*palette)[j], dest_bpp) : 0;
+		}
+		map_pixels(*this, dest, SpriteTableLookup(table));
+	} else if (_bpp == dest_bpp || (_bpp <= 8 && dest_bpp <= 8))
+	{
+		map_pixels(*this, dest, SpritePixelCopy());
+	} else if (_bpp == 16 && dest_bpp == 32)
+	{
+		map_pixels(*this, dest, SpritePixel16To32());
+	} else if (_bpp == 32 && dest_bpp == 16)
+	{
+		map_pixels(*this, dest, SpritePixel32To16());
+	} else
+	{
+		throw SpriteException("Unsupported sprite conversion");
+	}
+}
+
+/**
+ * Convert a colour to a pixel value for a 32K or 16M colour sprite
+ *
+ * @param colour colour to convert
+ * @param bpp bits per pixel of the sprite (16 or 32)
+ * @returns pixel value
+ */
+unsigned int SpritePixels::colour_to_pixel(const Colour &colour, int bpp)
+{
+	unsigned int pixel = ((unsigned int)colour) >> 8;
+	return (bpp == 16) ? SpritePixel32To16()(pixel) : pixel;
+}
+
+/**
+ * Convert a pixel value from a 32K or 16M colour sprite to a colour
+ *
+ * @param pixel pixel value to convert
+ * @param bpp bits per pixel of the sprite (16 or 32)
+ * @returns colour
+ */
+Colour SpritePixels::pixel_to_colour(unsigned int pixel, int bpp)
+{
+	if (bpp == 16) pixel = SpritePixel16To32()(pixel);
+	return Colour((pixel & 0xFFFFFF) << 8);
+}
+
+}
@@ -0,0 +1,257 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_SPRITEPIXELS_H_
+#define TBX_SPRITEPIXELS_H_
+
+#include "sprite.h"
+
+namespace tbx {
+
+/**
+ * Typed view of one row of pixels in a sprite or sprite mask.
+ *
+ * The template parameter gives the number of bits per pixel
+ * which must be 1, 2, 4, 8, 16 or 32.
+ *
+ * Pixels are packed into the row from the least significant
+ * bits of each byte as they are in a RISC OS sprite.
+ */
+template<int BPP> class SpriteRow
+{
+	unsigned char *_data;
+	int _first_bit;
+	int _width;
+
+public:
+	/**
+	 * Construct a view of a row
+	 *
+	 * @param data pointer to the first word of the row
+	 * @param first_bit bit in the row of the first pixel
+	 * @param width width of the row in pixels
+	 */
+	SpriteRow(unsigned char *data, int first_bit, int width) :
+		_data(data + (first_bit >> 3)), _first_bit(first_bit & 7), _width(width) {}
+
+	/**
+	 * Get the width of the row
+	 *
+	 * @returns width in pixels
+	 */
+	int width() const {return _width;}
+
+	/**
+	 * Get pointer to the data for the row
+	 *
+	 * @returns pointer to the byte containing the first pixel
+	 */
+	unsigned char *data() const {return _data;}
+
+	/**
+	 * Get the mask for the bits of a pixel value
+	 *
+	 * @returns pixel value with all the bits set
+	 */
+	static unsigned int value_mask()
+	{
+		// BPP & 31 keeps the shift in range when BPP is 32
+		return (BPP >= 32) ? 0xFFFFFFFFu : ((1u << (BPP & 31)) - 1);
+	}
+
+	/**
+	 * Get a pixel from the row
+	 *
+	 * @param x pixel position in the row (0 to width()-1)
+	 * @returns pixel value
+	 */
+	unsigned int operator[](int x) const
+	{
+		if (BPP == 8) return _data[x];
+		if (BPP == 16) return reinterpret_cast<const unsigned short *>(_data)[x];
+		if (BPP == 32) return reinterpret_cast<const unsigned int *>(_data)[x];
+		int bit = _first_bit + x * BPP;
+		return (_data[bit >> 3] >> (bit & 7)) & value_mask();
+	}
+
+	/**
+	 * Set a pixel in the row
+	 *
+	 * @param x pixel position in the row (0 to width()-1)
+	 * @param value new pixel value
+	 */
+	void set(int x, unsigned int value)
+	{
+		if (BPP == 8) _data[x] = (unsigned char)value;
+		else if (BPP == 16) reinterpret_cast<unsigned short *>(_data)[x] = (unsigned short)value;
+		else if (BPP == 32) reinterpret_cast<unsigned int *>(_data)[x] = value;
+		else
+		{
+			int bit = _first_bit + x * BPP;
+			int shift = bit & 7;
+			unsigned char mask = (unsigned char)(value_mask() << shift);
+			unsigned char &byte = _data[bit >> 3];
+			byte = (unsigned char)((byte & ~mask) | ((value << shift) & mask));
+		}
+	}
+};
+
+/**
+ * Direct view of the pixels and mask of a sprite.
+ *
+ * This reads and writes the sprite data in memory without calling
+ * OS_SpriteOp so it is much faster than UserSprite::pixel for
+ * processing a whole image. Sprites of 1, 2, 4, 8, 16 and 32 bits per
+ * pixel are supported along with old format masks (the same depth as
+ * the image) and new format 1 bit per pixel masks.
+ *
+ * Pixel coordinates are the same as UserSprite::pixel with (0,0)
+ * at the bottom left of the sprite.
+ *
+ * The view refers directly to the memory of the sprite so it must not
+ * be used after the sprite is deleted or its sprite area is changed
+ * in a way that can move the sprite, including creating or removing
+ * its mask or palette.
+ */
+class SpritePixels
+{
+	unsigned char *_image;
+	int _row_bytes;
+	int _width;
+	int _height;
+	int _bpp;
+	int _first_bit;
+	unsigned char *_mask;
+	int _mask_row_bytes;
+	int _mask_bpp;
+	int _mask_first_bit;
+
+	void init(OsSpritePtr sprite);
+	unsigned char *row_data(int y) const {return _image + (_height - 1 - y) * _row_bytes;}
+	unsigned char *mask_row_data(int y) const {return _mask + (_height - 1 - y) * _mask_row_bytes;}
+	bool clip(int &x, int &y, int &width, int &height) const;
+
+public:
+	SpritePixels();
+	SpritePixels(const UserSprite &sprite);
+	SpritePixels(OsSpritePtr sprite);
+
+	/**
+	 * Check if the view refers to a sprite
+	 *
+	 * @returns true if the view is valid
+	 */
+	bool is_valid() const {return (_image != 0);}
+
+	/**
+	 * Get the width of the sprite
+	 *
+	 * @returns width in pixels
+	 */
+	int width() const {return _width;}
+
+	/**
+	 * Get the height of the sprite
+	 *
+	 * @returns height in pixels
+	 */
+	int height() const {return _height;}
+
+	/**
+	 * Get the number of bits used for each pixel
+	 *
+	 * @returns 1, 2, 4, 8, 16 or 32
+	 */
+	int bits_per_pixel() const {return _bpp;}
+
+	/**
+	 * Get the number of bytes between rows of the sprite
+	 *
+	 * @returns bytes per row (always a multiple of 4)
+	 */
+	int row_bytes() const {return _row_bytes;}
+
+	/**
+	 * Check if the sprite has a mask
+	 *
+	 * @returns true if there is a mask
+	 */
+	bool has_mask() const {return (_mask != 0);}
+
+	/**
+	 * Get the number of bits used for each pixel in the mask
+	 *
+	 * @returns 1 for a new format mask otherwise the same as bits_per_pixel()
+	 */
+	int mask_bits_per_pixel() const {return _mask_bpp;}
+
+	/**
+	 * Get a typed view of a row of the sprite
+	 *
+	 * BPP must match bits_per_pixel().
+	 *
+	 * @param y row to return (0 is the bottom row)
+	 * @returns view of the row
+	 * @throws SpriteException if BPP does not match the sprite
+	 */
+	template<int BPP> SpriteRow<BPP> row(int y) const
+	{
+		if (BPP != _bpp) throw SpriteException("Sprite row bits per pixel mismatch");
+		return SpriteRow<BPP>(row_data(y), _first_bit, _width);
+	}
+
+	/**
+	 * Get a typed view of a row of the sprite mask
+	 *
+	 * BPP must match mask_bits_per_pixel().
+	 *
+	 * @param y row to return (0 is the bottom row)
+	 * @returns view of the row
+	 * @throws SpriteException if there is no mask or BPP does not match it
+	 */
+	template<int BPP> SpriteRow<BPP> mask_row(int y) const
+	{
+		if (_mask == 0 || BPP != _mask_bpp) throw SpriteException("Sprite mask row bits per pixel mismatch");
+		return SpriteRow<BPP>(mask_row_data(y), _mask_first_bit, _width);
+	}
+
+	unsigned int pixel(int x, int y) const;
+	void pixel(int x, int y, unsigned int value);
+	bool mask_pixel(int x, int y) const;
+	void mask_pixel(int x, int y, bool on);
+
+	void fill(int x, int y, int width, int height, unsigned int value);
+	void fill_mask(int x, int y, int width, int height, bool on);
+	void copy(int x, int y, const SpritePixels &source, int source_x, int source_y, int width, int height);
+	void lookup(SpritePixels &dest, const unsigned int *table) const;
+	void mask_from_colour(unsigned int key);
+	void convert(SpritePixels &dest, const ColourPalette *palette = 0) const;
+
+	static unsigned int colour_to_pixel(const Colour &colour, int bpp);
+	static Colour pixel_to_colour(unsigned int pixel, int bpp);
+};
+
+}
+
+#endif /* TBX_SPRITEPIXELS_H_ */
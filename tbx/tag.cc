@@ -46,14 +46,44 @@
 //	</
 //	  tag
 //	>
+//
+//	The binary file format is:
+//	  "\0TAG" followed by a version byte
+//	  tag name table
+//	  attribute name table
+//	  number of top level tags
+//	  top level tags
+//
+//	A name table is a count followed by that many strings. Each
+//	tag is:
+//	  tag name index
+//	  number of attributes
+//	  attributes as (attribute name index * 2 + 1 if it has a value)
+//	    followed by the value string if it has one
+//	  text string
+//	  number of child tags
+//	  child tags
+//
+//	Numbers are written as variable length unsigned integers with
+//	7 bits per byte, least significant first, and the top bit set
+//	if more bytes follow. Strings are a length followed by the
+//	characters.
 /////////////////////////////////////////////////////////////
 
 #include "tag.h"
+#include "tagarena.h"
+#include "tagreader.h"
 #include <cstdlib>
+#include <cstring>
+#include <new>
 
 using namespace std;
 using namespace tbx;
 
+// Header for binary format
+static const char BINARY_ID[4] = {0, 'T', 'A', 'G'};
+static const char BINARY_VERSION = 1;
+
 /**
  * Construct an attribute without a value
  *
@@ -101,14 +131,22 @@ Tag::Tag(Tag *parent, int id)
 
 	_id  = id;
 	_data = NULL;
+	_child_index = NULL;
+	_attribute_index = NULL;
+	_next_same = NULL;
+	_use_index = parent ? parent->_use_index : false;
 }
 
 /**
  * Destructor for tag deletes assosiated tag data
+ *
+ * The child tags and attributes are deleted by the TagDoc.
  */
 Tag::~Tag()
 {
 	delete _data;
+	delete _child_index;
+	delete _attribute_index;
 }
 
 
@@ -138,7 +176,7 @@ TagDoc *Tag::doc() const
  */
 Tag *Tag::add_child(int id)
 {
-	Tag *tag = new Tag(this, id);
+	Tag *tag = doc()->new_tag(this, id);
 	if (_first_child == NULL)
 	{
 		_first_child = _last_child = tag;
@@ -148,6 +186,14 @@ Tag *Tag::add_child(int id)
 		_last_child = tag;
 	}
 
+	if (_child_index)
+	{
+		std::pair<Tag *, Tag *> &same = (*_child_index)[id];
+		if (same.first) same.second->_next_same = tag;
+		else same.first = tag;
+		same.second = tag;
+	}
+
 	return tag;
 }
 
@@ -166,10 +212,29 @@ Tag *Tag::add_child(const std::string &name)
 /**
  * Deletes at child tag
  *
+ * The child tags and attributes of the tag are also deleted.
+ *
  * @param tag tag to delete.
  */
 void Tag::delete_child(Tag *tag)
 {
+	if (_child_index)
+	{
+		ChildIndex::iterator found = _child_index->find(tag->_id);
+		std::pair<Tag *, Tag *> &same = found->second;
+		if (same.first == tag)
+		{
+			if (tag->_next_same) same.first = tag->_next_same;
+			else _child_index->erase(found);
+		} else
+		{
+			Tag *prev = same.first;
+			while (prev->_next_same != tag) prev = prev->_next_same;
+			prev->_next_same = tag->_next_same;
+			if (same.second == tag) same.second = prev;
+		}
+	}
+
 	if (_first_child == tag)
 	{
 		_first_child = tag->_next;
@@ -182,7 +247,7 @@ void Tag::delete_child(Tag *tag)
 		if (_last_child == tag) _last_child = prev;
 	}
 
-	delete tag;
+	doc()->free_tag(tag);
 }
 
 /**
@@ -194,6 +259,13 @@ void Tag::delete_child(Tag *tag)
  */
 Tag *Tag::find_child(int id, Tag *after /*= 0*/) const
 {
+	if (after && after->_id == id && _child_index) return after->_next_same;
+	if (!after && (_child_index || use_child_index()))
+	{
+		ChildIndex::const_iterator found = _child_index->find(id);
+		return (found == _child_index->end()) ? NULL : found->second.first;
+	}
+
 	Tag *found;
 	if (after) found = after->_next;
 	else found = _first_child;
@@ -203,6 +275,37 @@ Tag *Tag::find_child(int id, Tag *after /*= 0*/) const
 	return found;
 }
 
+/**
+ * Check if the child index should be used and build it if it should
+ *
+ * @returns true if the child index has been built
+ */
+bool Tag::use_child_index() const
+{
+	if (!_use_index) return false;
+
+	int count = 0;
+	Tag *child = _first_child;
+	while (child && count < TagDoc::CHILD_INDEX_SIZE)
+	{
+		count++;
+		child = child->_next;
+	}
+	if (!child) return false;
+
+	_child_index = new ChildIndex();
+	for (child = _first_child; child; child = child->_next)
+	{
+		std::pair<Tag *, Tag *> &same = (*_child_index)[child->_id];
+		if (same.first) same.second->_next_same = child;
+		else same.first = child;
+		same.second = child;
+		child->_next_same = NULL;
+	}
+
+	return true;
+}
+
 /**
  * Find the a child tag with the given name
  *
@@ -323,9 +426,10 @@ void Tag::attribute(int att_id)
 	if (found) found->has_value(false);
 	else
 	{
-		found = new TagAttribute(att_id);
+		found = doc()->new_attribute(att_id);
 		found->_next = _first_attribute;
 		_first_attribute = found;
+		if (_attribute_index) index_attribute(found);
 	}
 }
 
@@ -343,9 +447,10 @@ void Tag::attribute(int att_id, const std::string &value)
 	if (found) found->value(value);
 	else
 	{
-		found = new TagAttribute(att_id, value);
+		found = doc()->new_attribute(att_id, value);
 		found->_next = _first_attribute;
 		_first_attribute = found;
+		if (_attribute_index) index_attribute(found);
 	}
 }
 
@@ -368,8 +473,9 @@ void Tag::delete_attribute(int att_id)
 	{
 		if (prev) prev->_next = found->_next;
 		else _first_attribute = found->_next;
+		if (_attribute_index) (*_attribute_index)[att_id] = NULL;
 
-		delete found;
+		doc()->free_attribute(found);
 	}
 }
 
@@ -415,16 +521,64 @@ void Tag::delete_attribute(const std::string &name)
 /**
  * Find the attribute with the given id
  *
+ * When the document uses the CHILD_INDEX storage option, tags with
+ * many attributes find them from an index of the attribute ids.
+ *
  * @param att_id attribute id, must have been allocated with TagDoc::attribute_id
  * @return TagAttribute pointer or 0 if not found
  */
 TagAttribute *Tag::find_attribute(int att_id) const
 {
+	if (_attribute_index || use_attribute_index())
+	{
+		if ((unsigned int)att_id >= _attribute_index->size()) return NULL;
+		return (*_attribute_index)[att_id];
+	}
+
 	TagAttribute *found = _first_attribute;
 	while (found && found->_id != att_id) found = found->_next;
 	return found;
 }
 
+/**
+ * Check if the attribute index should be used and build it if it should
+ *
+ * @returns true if the attribute index has been built
+ */
+bool Tag::use_attribute_index() const
+{
+	if (!_use_index) return false;
+
+	int count = 0;
+	TagAttribute *att = _first_attribute;
+	while (att && count < TagDoc::CHILD_INDEX_SIZE)
+	{
+		count++;
+		att = att->_next;
+	}
+	if (!att) return false;
+
+	_attribute_index = new AttributeIndex();
+	for (att = _first_attribute; att; att = att->_next)
+	{
+		index_attribute(att);
+	}
+
+	return true;
+}
+
+/**
+ * Add an attribute to the attribute index
+ */
+void Tag::index_attribute(TagAttribute *att) const
+{
+	if ((unsigned int)att->_id >= _attribute_index->size())
+	{
+		_attribute_index->resize(att->_id + 1, NULL);
+	}
+	(*_attribute_index)[att->_id] = att;
+}
+
 /**
  * Find the attribute with the given id
  *
@@ -463,39 +617,146 @@ std::string Tag::attribute_value(const std::string &name) const
 
 /**
  * Constructor for a new empty tag document.
+ *
+ * @param storage combination of values from the Storage enumeration
+ * to set how the tags are stored. Defaults to HEAP.
  */
-TagDoc::TagDoc() : Tag(NULL, -2)
+TagDoc::TagDoc(int storage /*= HEAP*/) : Tag(NULL, -2),
+	_binary(false),
+	_storage(storage),
+	_tag_arena(NULL),
+	_attribute_arena(NULL)
 {
+	_use_index = (storage & CHILD_INDEX) != 0;
+	if (storage & ARENA)
+	{
+		_tag_arena = new TagArena(sizeof(Tag));
+		_attribute_arena = new TagArena(sizeof(TagAttribute));
+	}
 }
 
 /**
- * Destructor
+ * Destructor deletes all the tags in the document
  */
 TagDoc::~TagDoc()
 {
+	free_contents(this);
+	delete _tag_arena;
+	delete _attribute_arena;
 }
 
 /**
- * Returns the tag id for a name or allocates a new one if the name
- * has not already been used.
+ * Create a new tag
  *
- * @param name name for the tag
+ * @param parent parent for the tag
+ * @param id tag id
  */
-int TagDoc::tag_id(const std::string &name)
+Tag *TagDoc::new_tag(Tag *parent, int id)
+{
+	if (_tag_arena) return new (_tag_arena->allocate()) Tag(parent, id);
+	return new Tag(parent, id);
+}
+
+/**
+ * Delete a tag and all its children and attributes
+ *
+ * @param tag tag that has been unlinked from its parent
+ */
+void TagDoc::free_tag(Tag *tag)
+{
+	free_contents(tag);
+	if (_tag_arena)
+	{
+		tag->~Tag();
+		_tag_arena->release(tag);
+	} else
+	{
+		delete tag;
+	}
+}
+
+/**
+ * Delete all the children and attributes of a tag
+ */
+void TagDoc::free_contents(Tag *tag)
 {
-	int id = -1;
-	int j, size = _tag_names.size();
+	Tag *child = tag->_first_child;
+	while (child)
+	{
+		Tag *next = child->_next;
+		free_tag(child);
+		child = next;
+	}
+	tag->_first_child = tag->_last_child = NULL;
+	delete tag->_child_index;
+	tag->_child_index = NULL;
+	delete tag->_attribute_index;
+	tag->_attribute_index = NULL;
 
-	for (j = 0; j < size && id < 0; j++)
+	TagAttribute *att = tag->_first_attribute;
+	while (att)
 	{
-		if (_tag_names[j] == name) id = j;
+		TagAttribute *next = att->_next;
+		free_attribute(att);
+		att = next;
 	}
+	tag->_first_attribute = NULL;
+}
 
-	if (id < 0)
+/**
+ * Create an attribute without a value
+ *
+ * @param id attribute id
+ */
+TagAttribute *TagDoc::new_attribute(int id)
+{
+	if (_attribute_arena) return new (_attribute_arena->allocate()) TagAttribute(id);
+	return new TagAttribute(id);
+}
+
+/**
+ * Create an attribute with a value
+ *
+ * @param id attribute id
+ * @param value attribute value
+ */
+TagAttribute *TagDoc::new_attribute(int id, const std::string &value)
+{
+	if (_attribute_arena) return new (_attribute_arena->allocate()) TagAttribute(id, value);
+	return new TagAttribute(id, value);
+}
+
+/**
+ * Delete an attribute
+ *
+ * @param att attribute that has been unlinked from its tag
+ */
+void TagDoc::free_attribute(TagAttribute *att)
+{
+	if (_attribute_arena)
+	{
+		att->~TagAttribute();
+		_attribute_arena->release(att);
+	} else
 	{
-		id = _tag_names.size();
-		_tag_names.push_back(name);
+		delete att;
 	}
+}
+
+/**
+ * Returns the tag id for a name or allocates a new one if the name
+ * has not already been used.
+ *
+ * @param name name for the tag
+ */
+int TagDoc::tag_id(const std::string &name)
+{
+	std::map<std::string, int>::iterator found = _tag_ids.find(name);
+	if (found != _tag_ids.end()) return found->second;
+
+	int id = _tag_names.size();
+	_tag_names.push_back(name);
+	_tag_ids[name] = id;
 
 	return id;
 }
@@ -508,15 +769,8 @@ int TagDoc::tag_id(const std::string &name)
  */
 int TagDoc::tag_id_if_exists(const std::string &name) const
 {
-	int id = -1;
-	int j, size = _tag_names.size();
-
-	for (j = 0; j < size && id < 0; j++)
-	{
-		if (_tag_names[j] == name) id = j;
-	}
-
-	return id;
+	std::map<std::string, int>::const_iterator found = _tag_ids.find(name);
+	return (found == _tag_ids.end()) ? -1 : found->second;
 }
 
 /**
@@ -537,19 +791,12 @@ const std::string &TagDoc::tag_name(int id) const
  */
 int TagDoc::attribute_id(const std::string &name)
 {
-	int id = -1;
-	int j, size = _attribute_names.size();
-
-	for (j = 0; j < size && id < 0; j++)
-	{
-		if (_attribute_names[j] == name) id = j;
-	}
+	std::map<std::string, int>::iterator found = _attribute_ids.find(name);
+	if (found != _attribute_ids.end()) return found->second;
 
-	if (id < 0)
-	{
-		id = _attribute_names.size();
-		_attribute_names.push_back(name);
-	}
+	int id = _attribute_names.size();
+	_attribute_names.push_back(name);
+	_attribute_ids[name] = id;
 
 	return id;
 }
@@ -562,15 +809,8 @@ int TagDoc::attribute_id(const std::string &name)
  */
 int TagDoc::attribute_id_if_exists(const std::string &name) const
 {
-	int id = -1;
-	int j, size = _attribute_names.size();
-
-	for (j = 0; j < size && id < 0; j++)
-	{
-		if (_attribute_names[j] == name) id = j;
-	}
-
-	return id;
+	std::map<std::string, int>::const_iterator found = _attribute_ids.find(name);
+	return (found == _attribute_ids.end()) ? -1 : found->second;
 }
 
 /**
@@ -587,7 +827,8 @@ const std::string &TagDoc::attribute_name(int id) const
 //@{
 //	Read a tagged document from an input stream.
 //
-//	This will read only between the next start tag and its
+//	If the stream is in the binary format the whole document is
+//	read, otherwise this will read only between the next start tag and its
 //  associated end tag. If multiple top level tags this will
 //	have to be repeated called for each tag.
 //
@@ -598,10 +839,49 @@ const std::string &TagDoc::attribute_name(int id) const
 
 std::istream &operator>>(std::istream &is, TagDoc &doc)
 {
-	doc.read_tag(is);
+	// Text can not start with a 0, so read_binary is used to
+	// report a bad header or version rather than the text reader
+	if (is.peek() == BINARY_ID[0]) doc.read_binary(is);
+	else doc.read_tag(is);
 	return is;
 }
 
+//! @cond INTERNAL
+/**
+ * Handler to add the tags read by a TagReader to a document
+ */
+class TagDocBuilder : public TagReadHandler
+{
+	Tag *_tag;
+public:
+	TagDocBuilder(Tag *root) : _tag(root) {}
+
+	virtual bool start_tag(const std::string &name)
+	{
+		_tag = _tag->add_child(name);
+		return true;
+	}
+	virtual bool attribute(const std::string &name, const std::string &value, bool has_value)
+	{
+		if (has_value) _tag->attribute(name, value);
+		else _tag->attribute(name);
+		return true;
+	}
+	virtual bool text(const std::string &text)
+	{
+		// Text can come before and after child tags
+		if (_tag->text().empty()) _tag->text(text);
+		else _tag->text(_tag->text() + text);
+		return true;
+	}
+	virtual bool end_tag(const std::string &name)
+	{
+		_tag = _tag->parent();
+		return true;
+	}
+};
+//! @endcond
+
 /**
  * Reads a tag and all its children from a stream
  *
@@ -610,97 +890,27 @@ std::istream &operator>>(std::istream &is, TagDoc &doc)
  */
 void TagDoc::read_tag(std::istream &is)
 {
-	Tag *tag = this;
-	string tag_name;
-	string att_name, next_att_name;
-	string att_value;
-	string text;
-	bool start_tag = false;
-	char c;
-
-	is.setf(ios::skipws);
-
-	do
-	{
-		if (start_tag)
-		{
-			c = read_string(is, text);
-			tag->text(text);
-			start_tag = false;
-		} else
-		{
-			is >> c;
-		}
-		if (!is)
-		{
-			if (tag == this) throw TagException(TagException::EmptyFile,"");
-			else throw TagException(TagException::ErrorReading, "");
-		}
-
-		if (c != '<') throw TagException(TagException::InvalidTagStartChar, c);
-		c = read_name(is, tag_name);
-
-		if (c == '/')
-		{
-			// End tag
-			c = read_name(is, tag_name);
-			if (tag->name() != tag_name) throw TagException(TagException::EndTagNotMatch, tag_name);
-			if (c == ' ') is >> c;
-			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
-			tag = tag->parent();
-		} else if (c != '>' && c != ' ') throw TagException(TagException::InvalidNameEnd, c);
-		else
-		{
-			if (tag_name.empty()) throw TagException(TagException::MissingTagName,"");
-			// Add new tag and move focus to it.
-			tag = tag->add_child(tag_name);
-			start_tag = true;
-
-			// Parse attributes
-			next_att_name.erase();
-
-			while (c != '>' && c != '/' && is)
-			{
-				if (!next_att_name.empty())
-				{
-					att_name = next_att_name;
-					next_att_name.erase();
-				} else c = read_name(is, att_name);
-
-				if (c == ' ') c = read_name(is, next_att_name);
-
-				if (c == '=')
-				{
-					is >> c;
-					if (c != '\"') throw TagException(TagException::InvalidStringStart,c);
-					c = read_string(is, att_value);
-					if (c != '\"') throw TagException(TagException::InvalidStringEnd,c);
-					tag->attribute(att_name, att_value);
-				} else if (!att_name.empty())
-					tag->attribute(att_name);
-			}
-
-			if (c == '/')
-			{
-				// Tag with no text or children
-				is >> c;
-				tag = tag->parent();
-			}
-			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
-		}
-
-	} while (tag != this); // Exit when we get back up to this level
-
+	TagDocBuilder builder(this);
+	TagReader reader(is);
+	reader.read_tag(builder);
 }
 
 /**
  * Write Tag document to an output stream
  *
+ * The binary format is used if TagDoc::binary() is true.
+ *
  * @param os stream to write to
  * @param doc Tag document to write
  */
 std::ostream &operator<<(std::ostream &os, TagDoc &doc)
 {
+	if (doc.binary())
+	{
+		doc.write_binary(os);
+		return os;
+	}
+
 	Tag *child = doc.first_child();
 	while (child)
 	{
@@ -735,6 +945,7 @@ void TagDoc::write_tag(std::ostream &os, Tag *tag, int indent /* = 0*/)
 			write_string(os, att->value());
 			os << "\"";
 		}
+		att = att->next();
 	}
 
 	Tag *child = tag->first_child();
@@ -754,9 +965,10 @@ void TagDoc::write_tag(std::ostream &os, Tag *tag, int indent /* = 0*/)
 				write_tag(os, child, indent+3);
 				child = child->next();
 			}
+			// Only indent after children so the text reads back the same
+			for (j = 0; j < indent; j++) os << ' ';
 		}
 
-		for (j = 0; j < indent; j++) os << ' ';
 		os << "</" << tag->name() << '>';
 	}
 
@@ -772,9 +984,9 @@ void TagDoc::write_tag(std::ostream &os, Tag *tag, int indent /* = 0*/)
  */
 void TagDoc::write_string(std::ostream &os, const std::string &text)
 {
-	unsigned int pos = 0;
+	std::string::size_type pos = 0;
 	const char *entities = "&<>\"\'";
-	unsigned int epos = text.find_first_of(entities);
+	std::string::size_type epos = text.find_first_of(entities);
 
 	while (epos != string::npos)
 	{
@@ -805,70 +1017,315 @@ void TagDoc::write_string(std::ostream &os, const std::string &text)
  */
 char TagDoc::read_string(std::istream &is, std::string &text)
 {
-	char c;
-	
-	text.erase();
+	return TagReader::read_string(is, text);
+}
 
-	is >> c;
-	is.unsetf(ios::skipws);
+/**
+ * Read a name from and input stream.
+ *
+ * @param is input string to read from
+ * @param name name to read
+ * @returns char that finished string read
+ * @throws TagException if an invalid entity is found in the string
+ */
+char TagDoc::read_name(std::istream &is, std::string &name)
+{
+	return TagReader::read_name(is, name);
+}
 
-	while (is && c != '\"' && c != '<')
+/**
+ * Write a number in the binary format
+ */
+static void write_binary_number(std::ostream &os, unsigned int value)
+{
+	char bytes[5];
+	int len = 0;
+	while (value >= 0x80)
+	{
+		bytes[len++] = (char)((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	bytes[len++] = (char)value;
+	os.write(bytes, len);
+}
+
+/**
+ * Write a string in the binary format
+ */
+static void write_binary_string(std::ostream &os, const std::string &text)
+{
+	write_binary_number(os, text.size());
+	if (!text.empty()) os.write(text.data(), text.size());
+}
+
+/**
+ * Read a number in the binary format
+ *
+ * @throws TagException if the end of the data is reached
+ */
+static unsigned int read_binary_number(std::streambuf *buf)
+{
+	unsigned int value = 0;
+	int shift = 0;
+	int c;
+	do
+	{
+		c = buf->sbumpc();
+		if (c == std::char_traits<char>::eof()) throw TagException(TagException::ErrorReading, "");
+		if (shift > 28) throw TagException(TagException::InvalidBinary, "");
+		value |= (unsigned int)(c & 0x7F) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	return value;
+}
+
+/**
+ * Read a string in the binary format
+ *
+ * The string is read in chunks so a corrupt length fails when the
+ * data runs out instead of allocating all the memory it asks for.
+ *
+ * @throws TagException if the end of the data is reached
+ */
+static void read_binary_string(std::streambuf *buf, std::string &text)
+{
+	unsigned int len = read_binary_number(buf);
+	text.clear();
+	char chunk[256];
+	while (len)
 	{
-		if (c == '&')
+		unsigned int size = (len < sizeof(chunk)) ? len : sizeof(chunk);
+		if (buf->sgetn(chunk, size) != (std::streamsize)size)
 		{
-			std::string entity;
-			is >> c;
-			while (entity.length() < 5 && c != ';' && is)
+			throw TagException(TagException::ErrorReading, "");
+		}
+		text.append(chunk, size);
+		len -= size;
+	}
+}
+
+/**
+ * Check if a stream contains a document in the binary format.
+ *
+ * The stream is not moved on.
+ *
+ * @param is input stream to check
+ * @returns true if the stream starts with the binary header for
+ * the version of the format read by this class
+ */
+bool TagDoc::is_binary(std::istream &is)
+{
+	if (is.peek() != BINARY_ID[0]) return false;
+
+	std::streambuf *buf = is.rdbuf();
+	char header[sizeof(BINARY_ID) + 1];
+	std::streamsize got;
+	std::streampos start = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+
+	if (start != std::streampos(-1))
+	{
+		got = buf->sgetn(header, sizeof(header));
+		buf->pubseekpos(start, std::ios::in);
+	} else
+	{
+		// Stream can not seek, so put the characters back
+		int c;
+		got = 0;
+		while (got < (std::streamsize)sizeof(header)
+			&& (c = buf->sbumpc()) != std::char_traits<char>::eof())
+		{
+			header[got++] = (char)c;
+		}
+		for (std::streamsize j = got; j > 0; j--)
+		{
+			if (buf->sputbackc(header[j-1]) == std::char_traits<char>::eof())
 			{
-				entity += c;
-				is >> c;
+				is.setstate(ios::badbit);
+				break;
 			}
+		}
+	}
 
-			if (c != ';') throw TagException(TagException::InvalidEntityEnd, entity);
+	return got == (std::streamsize)sizeof(header)
+		&& std::memcmp(header, BINARY_ID, sizeof(BINARY_ID)) == 0
+		&& header[sizeof(BINARY_ID)] == BINARY_VERSION;
+}
 
-			if (entity == "amp")	   text += '&';
-			else if (entity == "lt")   text += '<';
-			else if (entity == "gt")   text += '>';
-			else if (entity == "apos") text += '\'';
-			else if (entity == "quot") text += '\"';
-			else throw TagException(TagException::InvalidEntity, entity);
-		} else
-			text += c;
+/**
+ * Write the whole document to a stream in the binary format
+ *
+ * The binary format is faster to read and write and smaller than
+ * the text format.
+ *
+ * @param os stream to write to
+ */
+void TagDoc::write_binary(std::ostream &os)
+{
+	os.write(BINARY_ID, sizeof(BINARY_ID));
+	os.put(BINARY_VERSION);
+
+	std::vector<std::string>::const_iterator i;
+	write_binary_number(os, _tag_names.size());
+	for (i = _tag_names.begin(); i != _tag_names.end(); ++i)
+	{
+		write_binary_string(os, *i);
+	}
+	write_binary_number(os, _attribute_names.size());
+	for (i = _attribute_names.begin(); i != _attribute_names.end(); ++i)
+	{
+		write_binary_string(os, *i);
+	}
+
+	unsigned int count = 0;
+	Tag *child;
+	for (child = first_child(); child; child = child->next()) count++;
+	write_binary_number(os, count);
+	for (child = first_child(); child; child = child->next())
+	{
+		write_binary_tag(os, child);
+	}
+}
 
-		is >> c;
+/**
+ * Write a tag and all its children in the binary format
+ *
+ * @param os stream to write to
+ * @param tag to write
+ */
+void TagDoc::write_binary_tag(std::ostream &os, Tag *tag)
+{
+	write_binary_number(os, tag->id());
+
+	// Attributes are added to the front of the list when they are
+	// read, so write them in reverse to keep the same order
+	std::vector<TagAttribute *> atts;
+	TagAttribute *att;
+	for (att = tag->first_attribute(); att; att = att->next()) atts.push_back(att);
+	write_binary_number(os, atts.size());
+	for (std::vector<TagAttribute *>::reverse_iterator ai = atts.rbegin(); ai != atts.rend(); ++ai)
+	{
+		att = *ai;
+		write_binary_number(os, att->id() * 2 + (att->has_value() ? 1 : 0));
+		if (att->has_value()) write_binary_string(os, att->value());
 	}
 
-	is.setf(ios::skipws);
+	write_binary_string(os, tag->text());
 
-	return c;
+	unsigned int count = 0;
+	Tag *child;
+	for (child = tag->first_child(); child; child = child->next()) count++;
+	write_binary_number(os, count);
+	for (child = tag->first_child(); child; child = child->next())
+	{
+		write_binary_tag(os, child);
+	}
 }
 
 /**
- * Read a name from and input stream.
+ * Read a whole document in the binary format from a stream
  *
- * @param is input string to read from
- * @param name name to read
- * @returns char that finished string read
- * @throws TagException if an invalid entity is found in the string
+ * The tags read are added to the end of the document and it is set to
+ * write in the binary format.
+ *
+ * @param is input stream to read data from
+ * @throws TagException if read fails or the data is not valid
  */
-char TagDoc::read_name(std::istream &is, std::string &name)
+void TagDoc::read_binary(std::istream &is)
 {
-	char c;
-	std::string delims(" >/=");
-	
-	name.erase();
+	std::streambuf *buf = is.rdbuf();
+	char header[sizeof(BINARY_ID) + 1];
+
+	if (buf->sgetn(header, sizeof(header)) != (std::streamsize)sizeof(header))
+	{
+		is.setstate(ios::failbit | ios::eofbit);
+		throw TagException(TagException::EmptyFile, "");
+	}
+	if (std::string(header, sizeof(BINARY_ID)) != std::string(BINARY_ID, sizeof(BINARY_ID))
+		|| header[sizeof(BINARY_ID)] != BINARY_VERSION)
+	{
+		is.setstate(ios::failbit);
+		throw TagException(TagException::InvalidBinary, "");
+	}
+
+	try
+	{
+		// Map names from the file to the ids in this document
+		std::vector<int> tag_ids, att_ids;
+		std::string name;
+		unsigned int count, j;
+
+		count = read_binary_number(buf);
+		for (j = 0; j < count; j++)
+		{
+			read_binary_string(buf, name);
+			tag_ids.push_back(tag_id(name));
+		}
+		count = read_binary_number(buf);
+		for (j = 0; j < count; j++)
+		{
+			read_binary_string(buf, name);
+			att_ids.push_back(attribute_id(name));
+		}
+
+		count = read_binary_number(buf);
+		for (j = 0; j < count; j++)
+		{
+			read_binary_tag(buf, this, tag_ids, att_ids, 1);
+		}
+	} catch(TagException &)
+	{
+		is.setstate(ios::failbit);
+		throw;
+	}
+
+	_binary = true;
+}
+
+/**
+ * Read a tag and all its children in the binary format
+ *
+ * @param buf stream buffer to read from
+ * @param parent tag to add the new tag to
+ * @param tag_ids map from tag name index in the data to tag id
+ * @param att_ids map from attribute name index in the data to attribute id
+ * @param depth nesting depth of the tag, 1 for a top level tag
+ * @throws TagException if read fails or the data is not valid or
+ * nested deeper than MAX_BINARY_DEPTH
+ */
+void TagDoc::read_binary_tag(std::streambuf *buf, Tag *parent, const std::vector<int> &tag_ids, const std::vector<int> &att_ids, int depth)
+{
+	if (depth > MAX_BINARY_DEPTH) throw TagException(TagException::InvalidBinary, "");
 
-	is >> c;
-	is.unsetf(ios::skipws);
+	unsigned int index = read_binary_number(buf);
+	if (index >= tag_ids.size()) throw TagException(TagException::InvalidBinary, "");
+	Tag *tag = parent->add_child(tag_ids[index]);
 
-	while (is && delims.find(c) == std::string::npos)
+	std::string value;
+	unsigned int count = read_binary_number(buf);
+	unsigned int j;
+	for (j = 0; j < count; j++)
 	{
-		name += c;
-		is >> c;
+		index = read_binary_number(buf);
+		if ((index >> 1) >= att_ids.size()) throw TagException(TagException::InvalidBinary, "");
+		if (index & 1)
+		{
+			read_binary_string(buf, value);
+			tag->attribute(att_ids[index >> 1], value);
+		} else
+		{
+			tag->attribute(att_ids[index >> 1]);
+		}
 	}
-	is.setf(ios::skipws);
 
-	return c;
+	read_binary_string(buf, value);
+	if (!value.empty()) tag->text(value);
+
+	count = read_binary_number(buf);
+	for (j = 0; j < count; j++)
+	{
+		read_binary_tag(buf, tag, tag_ids, att_ids, depth + 1);
+	}
 }
 
 /**
@@ -911,6 +1368,7 @@ std::string TagException::error_text(Cause cause, std::string item)
 	case InvalidStringEnd: text.assign("Missing quote (\") at end of string, char found = ").append(item); break;
 	case InvalidEntityEnd: text.assign("Missing end to entity, starts ").append(item); break;
 	case InvalidEntity: text.assign("Invalid character entity ").append(item); break;
+	case InvalidBinary: text.assign("Invalid binary tag data"); break;
 	}
 
 	return text;
@@ -26,6 +26,7 @@
 #define TBX_TAG_H_
 
 #include <vector>
+#include <map>
 #include <string>
 #include <iostream>
 #include <stdexcept>
@@ -36,6 +37,7 @@ namespace tbx
 
 class TagDoc;
 class Tag;
+class TagArena;
 
 /**
  * Class to represent a single attribute
@@ -98,6 +100,8 @@ protected:
 
 	// Tag class maintains the attributes
 	friend class Tag;
+	// TagDoc allocates the attributes
+	friend class TagDoc;
 };
 
 /**
@@ -230,6 +234,25 @@ protected:
 	int _id;			//!< ID for this type of tag
 	std::string _text;	//!< text for this type of tag or "" if not set
 	TagData *_data;		//!< user data or 0 if none
+
+private:
+	//! @cond INTERNAL
+	// Map of tag id to first and last child with that id
+	typedef std::map<int, std::pair<Tag *, Tag *> > ChildIndex;
+	// Attributes by attribute id, 0 where the tag does not have the attribute
+	typedef std::vector<TagAttribute *> AttributeIndex;
+	//! @endcond
+	mutable ChildIndex *_child_index; // Index of children if built
+	mutable AttributeIndex *_attribute_index; // Index of attributes if built
+	Tag *_next_same; // Next sibling with the same id if parent has an index
+	bool _use_index; // Document uses the CHILD_INDEX storage option
+
+	bool use_child_index() const;
+	bool use_attribute_index() const;
+	void index_attribute(TagAttribute *att) const;
+
+	// TagDoc allocates the tags
+	friend class TagDoc;
 };
 
 /**
@@ -239,14 +262,46 @@ protected:
  * for the tag and attribute names.
  *
  * It also allows loading and saving of the tags using a simple XML
- * like text file format.
+ * like text file format or a compact binary format.
+ *
+ * Storage options can be given when the document is created for
+ * documents with a large number of tags.
  */
 class TagDoc : public Tag
 {
 public:
-	TagDoc();
+	/**
+	 * Options for how the tags are stored.
+	 *
+	 * These can be combined.
+	 */
+	enum Storage
+	{
+		HEAP = 0,       //!< Allocate each tag and attribute separately
+		ARENA = 1,      //!< Allocate tags and attributes in blocks owned by the document
+		CHILD_INDEX = 2 //!< Index the children by id of tags with many children and the attributes of tags with many attributes
+	};
+	/**
+	 * Number of children or attributes a tag must have before
+	 * they are indexed when the CHILD_INDEX storage option is used
+	 */
+	static const int CHILD_INDEX_SIZE = 16;
+	/**
+	 * Deepest nesting of tags read_binary will read before
+	 * it decides the data is not valid
+	 */
+	static const int MAX_BINARY_DEPTH = 1024;
+
+	explicit TagDoc(int storage = HEAP);
 	~TagDoc();
 
+	/**
+	 * Get the storage options used for this document
+	 *
+	 * @returns combination of values from the Storage enumeration
+	 */
+	int storage() const	{return _storage;}
+
 	int tag_id(const std::string &name);
 	const std::string &tag_name(int id) const;
 	int tag_id_if_exists(const std::string &name) const;
@@ -258,11 +313,42 @@ public:
 	void write_tag(std::ostream &os, Tag *tag, int indent = 0);
 	void read_tag(std::istream &is);
 
+	void write_binary(std::ostream &os);
+	void read_binary(std::istream &is);
+	static bool is_binary(std::istream &is);
+
+	/**
+	 * Set if the document is written in the binary format by
+	 * the stream operator.
+	 *
+	 * @param binary true to write in the binary format, false for the text format
+	 */
+	void binary(bool binary)	{_binary = binary;}
+	/**
+	 * Check if the document is written in the binary format by
+	 * the stream operator.
+	 *
+	 * This is set automatically when a binary document is read.
+	 *
+	 * @returns true if the binary format is used
+	 */
+	bool binary() const			{return _binary;}
+
 protected:
 	// Helper functions
 	void write_string(std::ostream &os, const std::string &text);
 	char read_string(std::istream &is, std::string &text);
 	char read_name(std::istream &is, std::string &name);
+	void write_binary_tag(std::ostream &os, Tag *tag);
+	void read_binary_tag(std::streambuf *buf, Tag *parent, const std::vector<int> &tag_ids, const std::vector<int> &att_ids, int depth);
+
+	// Allocation of tags and attributes
+	Tag *new_tag(Tag *parent, int id);
+	void free_tag(Tag *tag);
+	TagAttribute *new_attribute(int id);
+	TagAttribute *new_attribute(int id, const std::string &value);
+	void free_attribute(TagAttribute *att);
+	void free_contents(Tag *tag);
 
 protected:
 	/**
@@ -273,6 +359,33 @@ protected:
 	 * List of all attribute names known to this document
 	 */
 	std::vector<std::string> _attribute_names;
+	/**
+	 * Map of tag name to tag id
+	 */
+	std::map<std::string, int> _tag_ids;
+	/**
+	 * Map of attribute name to attribute id
+	 */
+	std::map<std::string, int> _attribute_ids;
+	/**
+	 * true if the stream operator uses the binary format
+	 */
+	bool _binary;
+	/**
+	 * Storage options
+	 */
+	int _storage;
+	/**
+	 * Arena for tags or 0 if not using an arena
+	 */
+	TagArena *_tag_arena;
+	/**
+	 * Arena for attributes or 0 if not using an arena
+	 */
+	TagArena *_attribute_arena;
+
+	// Tag uses the storage options
+	friend class Tag;
 };
 
 
@@ -288,7 +401,8 @@ public:
 	enum Cause {None, EmptyFile, ErrorReading, EndTagNotMatch,
 		InvalidTagStartChar, InvalidTagEndChar,
 		InvalidNameEnd, MissingTagName,
-		InvalidStringStart, InvalidStringEnd, InvalidEntityEnd, InvalidEntity
+		InvalidStringStart, InvalidStringEnd, InvalidEntityEnd, InvalidEntity,
+		InvalidBinary
 	};
 	TagException(Cause cause, const std::string &item);
 	TagException(Cause cause, char c);
@@ -0,0 +1,93 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "tagarena.h"
+
+namespace tbx
+{
+
+/**
+ * Construct an arena
+ *
+ * @param item_size size of each item
+ * @param block_items number of items to allocate at a time
+ */
+TagArena::TagArena(unsigned int item_size, unsigned int block_items /*= 256*/) :
+	_block_items(block_items),
+	_next_item(block_items),
+	_free(0)
+{
+	// Keep items aligned and big enough for the free list
+	if (item_size < sizeof(void *)) item_size = sizeof(void *);
+	_item_size = (item_size + 7) & ~7;
+}
+
+/**
+ * Destructor releases all the memory used by the arena
+ */
+TagArena::~TagArena()
+{
+	for (std::vector<char *>::iterator i = _blocks.begin(); i != _blocks.end(); ++i)
+	{
+		delete [] *i;
+	}
+}
+
+/**
+ * Allocate memory for an item
+ *
+ * @returns pointer to uninitialised memory for the item
+ */
+void *TagArena::allocate()
+{
+	void *item;
+	if (_free)
+	{
+		item = _free;
+		_free = *reinterpret_cast<void **>(_free);
+	} else
+	{
+		if (_next_item == _block_items)
+		{
+			_blocks.push_back(new char[_item_size * _block_items]);
+			_next_item = 0;
+		}
+		item = _blocks.back() + _item_size * _next_item++;
+	}
+
+	return item;
+}
+
+/**
+ * Return an item so it can be reused
+ *
+ * @param item item returned from allocate that has been destroyed
+ */
+void TagArena::release(void *item)
+{
+	*reinterpret_cast<void **>(item) = _free;
+	_free = item;
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_TAGARENA_H_
+#define TBX_TAGARENA_H_
+
+#include <vector>
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Class to allocate fixed size items from large blocks.
+ *
+ * Used by the TagDoc to allocate its tags and attributes
+ * so they are stored close together and all the memory is
+ * released in one go when the document is deleted.
+ *
+ * Released items are kept on a free list to be reused.
+ * The arena does not construct or destroy the items.
+ */
+class TagArena
+{
+public:
+	TagArena(unsigned int item_size, unsigned int block_items = 256);
+	~TagArena();
+
+	void *allocate();
+	void release(void *item);
+
+private:
+	unsigned int _item_size;
+	unsigned int _block_items;
+	std::vector<char *> _blocks;
+	unsigned int _next_item;
+	void *_free;
+};
+
+//! @endcond
+
+}
+
+#endif
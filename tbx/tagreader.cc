@@ -0,0 +1,246 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "tagreader.h"
+#include "tag.h"
+
+using namespace std;
+
+namespace tbx
+{
+
+/**
+ * Construct a reader for the given stream
+ *
+ * @param is stream to read from
+ */
+TagReader::TagReader(std::istream &is) : _is(is), _stopped(false)
+{
+}
+
+/**
+ * Read the next tag and all its children from the stream
+ *
+ * @param handler handler to call with the parts of the tag
+ * @returns true if the whole tag was read, false if the handler stopped
+ * the read. Once stopped the reader can not be used again.
+ * @throws TagException if read fails or there is a syntax error
+ */
+bool TagReader::read_tag(TagReadHandler &handler)
+{
+	string tag_name;
+	string att_name, next_att_name;
+	string att_value;
+	string text;
+	bool read_text = false;
+	char c;
+
+	if (_stopped) return false;
+	_open.clear();
+	_stopped = true; // Reset when the whole tag has been read
+
+	_is.setf(ios::skipws);
+
+	do
+	{
+		if (read_text)
+		{
+			c = read_string(_is, text);
+			if (!text.empty() && !handler.text(text)) return false;
+			read_text = false;
+		} else
+		{
+			_is >> c;
+		}
+		if (!_is)
+		{
+			if (_open.empty()) throw TagException(TagException::EmptyFile,"");
+			else throw TagException(TagException::ErrorReading, "");
+		}
+
+		if (c != '<') throw TagException(TagException::InvalidTagStartChar, c);
+		c = read_name(_is, tag_name);
+
+		if (c == '/' && tag_name.empty())
+		{
+			// End tag
+			c = read_name(_is, tag_name);
+			if (_open.empty() || _open.back() != tag_name) throw TagException(TagException::EndTagNotMatch, tag_name);
+			if (c == ' ') _is >> c;
+			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
+			_open.pop_back();
+			if (!handler.end_tag(tag_name)) return false;
+			// Text can follow a child tag
+			read_text = !_open.empty();
+		} else if (c != '>' && c != ' ' && c != '/') throw TagException(TagException::InvalidNameEnd, c);
+		else
+		{
+			if (tag_name.empty()) throw TagException(TagException::MissingTagName,"");
+			_open.push_back(tag_name);
+			if (!handler.start_tag(tag_name)) return false;
+			read_text = true;
+
+			// Parse attributes
+			next_att_name.erase();
+
+			// A name read ahead is still an attribute if the tag ends after it
+			while (((c != '>' && c != '/') || !next_att_name.empty()) && _is)
+			{
+				if (!next_att_name.empty())
+				{
+					att_name = next_att_name;
+					next_att_name.erase();
+				} else c = read_name(_is, att_name);
+
+				if (c == ' ') c = read_name(_is, next_att_name);
+
+				// If the name after the space is another attribute, c is the
+				// character after that name so this attribute has no value.
+				if (c == '=' && next_att_name.empty())
+				{
+					_is >> c;
+					if (c != '\"') throw TagException(TagException::InvalidStringStart,c);
+					c = read_string(_is, att_value);
+					if (c != '\"') throw TagException(TagException::InvalidStringEnd,c);
+					if (!handler.attribute(att_name, att_value, true)) return false;
+				} else if (!att_name.empty())
+				{
+					if (!handler.attribute(att_name, string(), false)) return false;
+				}
+			}
+
+			if (c == '/')
+			{
+				// Tag with no text or children
+				_is >> c;
+				if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
+				_open.pop_back();
+				if (!handler.end_tag(tag_name)) return false;
+			}
+			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
+		}
+
+	} while (!_open.empty()); // Exit when we get back to the top level
+
+	_stopped = false;
+	return true;
+}
+
+/**
+ * Read all the tags to the end of the stream
+ *
+ * @param handler handler to call with the parts of the tags
+ * @returns true if the end of the stream was reached, false if the
+ * handler stopped the read.
+ * @throws TagException if read fails or there is a syntax error
+ */
+bool TagReader::read(TagReadHandler &handler)
+{
+	while (!_stopped)
+	{
+		_is >> ws;
+		if (_is.peek() == char_traits<char>::eof()) return true;
+		read_tag(handler);
+	}
+
+	return false;
+}
+
+/**
+ * Read a string from an input stream converting entities used
+ * back to characters.
+ *
+ * @param is input string to read from
+ * @param text text to read
+ * @returns char that finished string read
+ * @throws TagException if an invalid entity is found in the string
+ */
+char TagReader::read_string(std::istream &is, std::string &text)
+{
+	char c;
+
+	text.erase();
+
+	is >> c;
+	is.unsetf(ios::skipws);
+
+	while (is && c != '\"' && c != '<')
+	{
+		if (c == '&')
+		{
+			std::string entity;
+			is >> c;
+			while (entity.length() < 5 && c != ';' && is)
+			{
+				entity += c;
+				is >> c;
+			}
+
+			if (c != ';') throw TagException(TagException::InvalidEntityEnd, entity);
+
+			if (entity == "amp")	   text += '&';
+			else if (entity == "lt")   text += '<';
+			else if (entity == "gt")   text += '>';
+			else if (entity == "apos") text += '\'';
+			else if (entity == "quot") text += '\"';
+			else throw TagException(TagException::InvalidEntity, entity);
+		} else
+			text += c;
+
+		is >> c;
+	}
+
+	is.setf(ios::skipws);
+
+	return c;
+}
+
+/**
+ * Read a name from and input stream.
+ *
+ * @param is input string to read from
+ * @param name name to read
+ * @returns char that finished string read
+ */
+char TagReader::read_name(std::istream &is, std::string &name)
+{
+	char c;
+	std::string delims(" >/=");
+
+	name.erase();
+
+	is >> c;
+	is.unsetf(ios::skipws);
+
+	while (is && delims.find(c) == std::string::npos)
+	{
+		name += c;
+		is >> c;
+	}
+	is.setf(ios::skipws);
+
+	return c;
+}
+
+}
@@ -0,0 +1,119 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_TAGREADER_H_
+#define TBX_TAGREADER_H_
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace tbx
+{
+
+/**
+ * Class to receive the parts of a tag file as they are read
+ * by a TagReader.
+ *
+ * Each function returns true to continue reading or false to
+ * stop the reader. The default implementations just continue.
+ */
+class TagReadHandler
+{
+public:
+	virtual ~TagReadHandler() {}
+
+	/**
+	 * Called when the name of a new tag has been read
+	 *
+	 * @param name name of the tag
+	 * @returns true to continue reading
+	 */
+	virtual bool start_tag(const std::string &name) {return true;}
+	/**
+	 * Called for each attribute of the last started tag
+	 *
+	 * @param name name of the attribute
+	 * @param value value of the attribute or "" if it has no value
+	 * @param has_value true if the attribute had a value
+	 * @returns true to continue reading
+	 */
+	virtual bool attribute(const std::string &name, const std::string &value, bool has_value) {return true;}
+	/**
+	 * Called for text in the current tag.
+	 *
+	 * A tag with children can have text before and after each
+	 * child, so this can be called more than once for a tag.
+	 *
+	 * @param text text with the character entities converted
+	 * @returns true to continue reading
+	 */
+	virtual bool text(const std::string &text) {return true;}
+	/**
+	 * Called at the end of a tag
+	 *
+	 * @param name name of the tag
+	 * @returns true to continue reading
+	 */
+	virtual bool end_tag(const std::string &name) {return true;}
+};
+
+/**
+ * Class to read a tag file in the text format written by a TagDoc
+ * without building a document in memory.
+ *
+ * The parts of the file are passed to a TagReadHandler as they are read.
+ * The memory used depends only on the depth of the tags and the size
+ * of the largest name or text, so it can be used to pick a few tags
+ * out of a very large file.
+ */
+class TagReader
+{
+public:
+	TagReader(std::istream &is);
+
+	bool read_tag(TagReadHandler &handler);
+	bool read(TagReadHandler &handler);
+
+	/**
+	 * Get the number of tags that have been started but not ended
+	 */
+	int depth() const {return _open.size();}
+	/**
+	 * Check if the reader was stopped by the handler
+	 */
+	bool stopped() const {return _stopped;}
+
+	static char read_string(std::istream &is, std::string &text);
+	static char read_name(std::istream &is, std::string &name);
+
+private:
+	std::istream &_is;
+	std::vector<std::string> _open;
+	bool _stopped;
+};
+
+}
+
+#endif
@@ -52,6 +52,46 @@ namespace tbx
 		 */
 		virtual void timer(unsigned int elapsed) = 0;
 	};
+
+	/**
+	 * Handle returned when a timer is added that can be used
+	 * to remove it.
+	 *
+	 * The handle stays safe to use after the timer has been
+	 * removed or a one shot timer has run, removing it again
+	 * just does nothing.
+	 */
+	class TimerHandle
+	{
+		unsigned int _slot;
+		unsigned int _generation;
+		friend class TimerQueue;
+		TimerHandle(unsigned int slot, unsigned int generation) :
+			_slot(slot), _generation(generation) {}
+
+	public:
+		/**
+		 * Construct a null timer handle
+		 */
+		TimerHandle() : _slot(0), _generation(0) {}
+
+		/**
+		 * Check if this is a null handle
+		 *
+		 * @returns true if the handle does not refer to a timer
+		 */
+		bool null() const {return (_generation == 0);}
+
+		/**
+		 * Check if two handles are the same
+		 */
+		bool operator==(const TimerHandle &other) const {return (_slot == other._slot && _generation == other._generation);}
+
+		/**
+		 * Check if two handles are different
+		 */
+		bool operator!=(const TimerHandle &other) const {return (_slot != other._slot || _generation != other._generation);}
+	};
 }
 
 #endif /* TBX_TIMER_H_ */
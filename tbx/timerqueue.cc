@@ -0,0 +1,289 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "timerqueue.h"
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Construct an empty timer queue
+ *
+ * @param clock function used to read the current time
+ */
+TimerQueue::TimerQueue(Clock clock) : _clock(clock),
+	_processing(false), _process_time(0)
+{
+}
+
+/**
+ * Add a timer to the queue
+ *
+ * @param elapsed centiseconds until the timer is due
+ * @param timer timer to call
+ * @param repeat true to call the timer every elapsed centiseconds,
+ * false to remove the timer after it has been called once.
+ * @returns handle to remove the timer
+ */
+TimerHandle TimerQueue::add(unsigned int elapsed, Timer *timer, bool repeat /*= true*/)
+{
+	unsigned int slot;
+	if (_free_slots.empty())
+	{
+		slot = _slots.size();
+		Slot new_slot;
+		new_slot.generation = 1;
+		_slots.push_back(new_slot);
+	} else
+	{
+		slot = _free_slots.back();
+		_free_slots.pop_back();
+	}
+
+	Slot &info = _slots[slot];
+	info.due = _clock() + elapsed;
+	// Don't run timers added from a timer callback until the next process call
+	if (_processing && monotonic_le(info.due, _process_time)) info.due = _process_time + 1;
+	info.elapsed = elapsed;
+	info.timer = timer;
+	info.repeat = repeat;
+
+	_heap.push_back(slot);
+	info.heap_pos = _heap.size() - 1;
+	move_up(info.heap_pos);
+
+	return TimerHandle(slot, info.generation);
+}
+
+/**
+ * Remove a timer using the handle returned when it was added
+ *
+ * @param handle handle of timer to remove
+ * @returns true if the timer was removed, false if it had already
+ * been removed or was a one shot timer that has run.
+ */
+bool TimerQueue::remove(TimerHandle handle)
+{
+	if (!active(handle)) return false;
+	remove_slot(handle._slot);
+	return true;
+}
+
+/**
+ * Remove the first timer found in the queue that calls the given timer.
+ *
+ * This needs to search the queue, so removing with a handle is
+ * quicker.
+ *
+ * @param timer timer to remove
+ * @returns true if a timer was removed
+ */
+bool TimerQueue::remove(Timer *timer)
+{
+	for (std::vector<unsigned int>::iterator i = _heap.begin(); i != _heap.end(); ++i)
+	{
+		if (_slots[*i].timer == timer)
+		{
+			remove_slot(*i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Check if the timer for a handle is still in the queue
+ *
+ * @param handle handle returned when the timer was added
+ * @returns true if the timer is in the queue
+ */
+bool TimerQueue::active(TimerHandle handle) const
+{
+	return (handle._slot < _slots.size()
+		&& _slots[handle._slot].generation == handle._generation
+		&& _slots[handle._slot].heap_pos != NOT_QUEUED);
+}
+
+/**
+ * Call all the timers that are due.
+ *
+ * Repeating timers are rescheduled for the first time after the
+ * current time they would be due, one shot timers are removed
+ * before they are called.
+ *
+ * Timers added by a timer callback are not run until the next
+ * call, even if they are already due.
+ */
+void TimerQueue::process()
+{
+	if (_heap.empty()) return;
+
+	unsigned int now = _clock();
+	unsigned int actual = now; // take into account long timer routines
+	_processing = true;
+	_process_time = now;
+
+	try
+	{
+		while (!_heap.empty() && monotonic_ge(now, _slots[_heap.front()].due))
+		{
+			unsigned int slot = _heap.front();
+			Slot &info = _slots[slot];
+			Timer *timer = info.timer;
+			unsigned int diff = monotonic_elapsed(info.due, actual);
+
+			if (!info.repeat)
+			{
+				remove_slot(slot);
+				timer->timer(diff);
+			} else
+			{
+				unsigned int generation = info.generation;
+				try
+				{
+					timer->timer(diff);
+				} catch(...)
+				{
+					reschedule(slot, generation, now, diff);
+					throw;
+				}
+				reschedule(slot, generation, now, diff);
+			}
+			actual = _clock();
+		}
+	} catch(...)
+	{
+		// Leave the queue usable if a timer throws
+		_processing = false;
+		throw;
+	}
+
+	_processing = false;
+}
+
+/**
+ * Move a repeating timer on to the next time it is due after it has
+ * been called.
+ *
+ * @param slot slot of the timer
+ * @param generation generation of the slot before the timer was called
+ * @param now time the timers are being processed for
+ * @param diff how late the timer was called
+ */
+void TimerQueue::reschedule(unsigned int slot, unsigned int generation, unsigned int now, unsigned int diff)
+{
+	// Timer callback may have removed the timer or added new
+	// ones so the reference to the slot may no longer be valid
+	Slot &after = _slots[slot];
+	if (after.generation == generation && after.heap_pos != NOT_QUEUED)
+	{
+		if (after.elapsed == 0)
+		{
+			after.due = now + 1;
+		} else
+		{
+			// Skip missed calls
+			while (diff > after.elapsed)
+			{
+				diff -= after.elapsed;
+				after.due += after.elapsed;
+			}
+			after.due += after.elapsed;
+		}
+		move_down(after.heap_pos);
+	}
+}
+
+/**
+ * Remove a timer from the heap and free its slot
+ */
+void TimerQueue::remove_slot(unsigned int slot)
+{
+	unsigned int pos = _slots[slot].heap_pos;
+	unsigned int last = _heap.back();
+	_heap.pop_back();
+
+	if (last != slot)
+	{
+		place(pos, last);
+		if (pos > 0 && due_before(last, _heap[(pos - 1) / 2])) move_up(pos);
+		else move_down(pos);
+	}
+
+	Slot &info = _slots[slot];
+	info.heap_pos = NOT_QUEUED;
+	info.timer = 0;
+	if (++info.generation == 0) info.generation = 1;
+	_free_slots.push_back(slot);
+}
+
+/**
+ * Move the slot at the given heap position up until it is in order
+ */
+void TimerQueue::move_up(unsigned int pos)
+{
+	unsigned int slot = _heap[pos];
+	while (pos > 0)
+	{
+		unsigned int parent = (pos - 1) / 2;
+		if (!due_before(slot, _heap[parent])) break;
+		place(pos, _heap[parent]);
+		pos = parent;
+	}
+	place(pos, slot);
+}
+
+/**
+ * Move the slot at the given heap position down until it is in order
+ */
+void TimerQueue::move_down(unsigned int pos)
+{
+	unsigned int slot = _heap[pos];
+	unsigned int size = _heap.size();
+	while (true)
+	{
+		unsigned int child = pos * 2 + 1;
+		if (child >= size) break;
+		if (child + 1 < size && due_before(_heap[child + 1], _heap[child])) child++;
+		if (!due_before(_heap[child], slot)) break;
+		place(pos, _heap[child]);
+		pos = child;
+	}
+	place(pos, slot);
+}
+
+/**
+ * Put a slot at a heap position and record the position in the slot
+ */
+void TimerQueue::place(unsigned int pos, unsigned int slot)
+{
+	_heap[pos] = slot;
+	_slots[slot].heap_pos = pos;
+}
+
+//! @endcond
+
+}
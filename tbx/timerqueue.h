@@ -0,0 +1,121 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_TIMERQUEUE_H_
+#define TBX_TIMERQUEUE_H_
+
+#include <vector>
+#include "timer.h"
+#include "monotonictime.h"
+
+namespace tbx
+{
+
+//! @cond INTERNAL
+
+/**
+ * Queue of timers waiting to be run used by the EventRouter.
+ *
+ * The timers are held in a binary heap ordered by the time they
+ * are next due, so adding, removing with a handle and rescheduling
+ * a timer are all O(log n).
+ *
+ * The function used to read the time can be changed so the
+ * queue can be run with a simulated clock.
+ */
+class TimerQueue
+{
+public:
+	/**
+	 * Function to return the current time in centiseconds
+	 */
+	typedef unsigned int (*Clock)();
+
+	TimerQueue(Clock clock = monotonic_time);
+
+	/**
+	 * Get the function used to read the time
+	 */
+	Clock clock() const {return _clock;}
+	/**
+	 * Set the function used to read the time
+	 */
+	void clock(Clock clock) {_clock = clock;}
+
+	TimerHandle add(unsigned int elapsed, Timer *timer, bool repeat = true);
+	bool remove(TimerHandle handle);
+	bool remove(Timer *timer);
+	bool active(TimerHandle handle) const;
+
+	/**
+	 * Check if there are any timers in the queue
+	 */
+	bool empty() const {return _heap.empty();}
+	/**
+	 * Number of timers in the queue
+	 */
+	unsigned int size() const {return _heap.size();}
+	/**
+	 * Time the next timer is due. Only valid if the queue is not empty
+	 */
+	unsigned int next_due() const {return _slots[_heap.front()].due;}
+
+	void process();
+
+private:
+	void remove_slot(unsigned int slot);
+	void reschedule(unsigned int slot, unsigned int generation, unsigned int now, unsigned int diff);
+	void move_up(unsigned int pos);
+	void move_down(unsigned int pos);
+	void place(unsigned int pos, unsigned int slot);
+	bool due_before(unsigned int slot1, unsigned int slot2) const
+	{
+		return monotonic_lt(_slots[slot1].due, _slots[slot2].due);
+	}
+
+	static const unsigned int NOT_QUEUED = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		unsigned int due;
+		unsigned int elapsed;
+		Timer *timer;
+		unsigned int generation;
+		unsigned int heap_pos;
+		bool repeat;
+	};
+
+	Clock _clock;
+	bool _processing;
+	unsigned int _process_time;
+	std::vector<Slot> _slots;
+	std::vector<unsigned int> _free_slots;
+	std::vector<unsigned int> _heap;
+};
+
+//! @endcond
+
+}
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_CELLLAYOUTS_H_
+#define TBX_CELLLAYOUTS_H_
+
+#include "itemrenderer.h"
+#include "selection.h"
+#include "../visiblearea.h"
+#include <vector>
+
+namespace tbx {
+
+namespace view {
+
+//! @cond INTERNAL
+
+/**
+ * Layout of the cells of rows with variable heights used by
+ * the ListView and ReportView.
+ *
+ * The rows are added from the top down and the horizontal
+ * position set separately so it can be used for each column
+ * of a report.
+ */
+class RowCellLayout : public ItemRenderer::CellLayout
+{
+	const VisibleArea &_visible_area;
+	unsigned int _first;
+	std::vector<int> _tops;
+	std::vector<bool> _selected;
+	int _min_x;
+	int _max_x;
+
+public:
+	/**
+	 * Construct the layout
+	 *
+	 * @param visible_area visible area of the window being redrawn
+	 * @param first index of the first row
+	 * @param top work area y coordinate of the top of the first row
+	 */
+	RowCellLayout(const VisibleArea &visible_area, unsigned int first, int top) :
+		_visible_area(visible_area), _first(first), _min_x(0), _max_x(0)
+	{
+		_tops.push_back(top);
+	}
+
+	/**
+	 * Add the next row
+	 *
+	 * @param height height of the row
+	 * @param selected true if the row is selected
+	 */
+	void add_row(unsigned int height, bool selected)
+	{
+		_tops.push_back(_tops.back() - (int)height);
+		_selected.push_back(selected);
+	}
+
+	/**
+	 * Set the horizontal position of the cells
+	 *
+	 * @param min_x work area x coordinate of the left of the cells
+	 * @param max_x work area x coordinate of the right of the cells
+	 */
+	void columns(int min_x, int max_x)
+	{
+		_min_x = min_x;
+		_max_x = max_x;
+	}
+
+	virtual void position(ItemRenderer::Info &info) const
+	{
+		unsigned int row = info.index - _first;
+		info.bounds.min.x = _min_x;
+		info.bounds.max.x = _max_x;
+		info.bounds.max.y = _tops[row];
+		info.bounds.min.y = _tops[row+1];
+		info.screen.x = _visible_area.screen_x(_min_x);
+		info.screen.y = _visible_area.screen_y(info.bounds.min.y);
+		info.selected = _selected[row];
+	}
+};
+
+/**
+ * Layout of cells of the same size in a grid used by the TileView
+ */
+class GridCellLayout : public ItemRenderer::CellLayout
+{
+	const VisibleArea &_visible_area;
+	Size _cell_size;
+	int _cols_per_row;
+	int _left;
+	int _top;
+	mutable Selection::Cursor _selection_cursor;
+
+public:
+	/**
+	 * Construct the layout
+	 *
+	 * @param visible_area visible area of the window being redrawn
+	 * @param cell_size size of each cell
+	 * @param cols_per_row number of cells in each row
+	 * @param left work area x coordinate of the left of the grid
+	 * @param top work area y coordinate of the top of the grid
+	 * @param selection selection for the items or 0 if none
+	 */
+	GridCellLayout(const VisibleArea &visible_area, const Size &cell_size, int cols_per_row,
+			int left, int top, const Selection *selection) :
+		_visible_area(visible_area), _cell_size(cell_size), _cols_per_row(cols_per_row),
+		_left(left), _top(top), _selection_cursor(selection)
+	{
+	}
+
+	virtual void position(ItemRenderer::Info &info) const
+	{
+		int row = info.index / _cols_per_row;
+		int col = info.index % _cols_per_row;
+		info.bounds.min.x = _left + col * _cell_size.width;
+		info.bounds.max.x = info.bounds.min.x + _cell_size.width;
+		info.bounds.max.y = _top - row * _cell_size.height;
+		info.bounds.min.y = info.bounds.max.y - _cell_size.height;
+		info.screen.x = _visible_area.screen_x(info.bounds.min.x);
+		info.screen.y = _visible_area.screen_y(info.bounds.min.y);
+		info.selected = _selection_cursor.selected(info.index);
+	}
+};
+
+//! @endcond
+
+}
+
+}
+
+#endif /* TBX_CELLLAYOUTS_H_ */
@@ -47,6 +47,26 @@ namespace view {
 const int IV_MARGIN = 8; // Margin on each side of cell
 const int IV_GAP = 8;    // Gap between sprite and text
 
+//! @cond INTERNAL
+/**
+ * Icon painters with the settings that are the same for every item
+ */
+struct IconItemRenderer::Painters
+{
+	IconPainter text_ip;   // Text when using the client sprite area
+	IconPainter sprite_ip; // Sprite from the client sprite area
+	IconPainter wimp_ip;   // Text and sprite from the wimp sprite area
+
+	Painters()
+	{
+		text_ip.hcentred(true);
+		sprite_ip.hcentred(true);
+		sprite_ip.use_client_sprite_area();
+		wimp_ip.text_and_sprite_centred();
+	}
+};
+//! @endcond
+
 /**
  * Protected constructor for derived renderer which must provide
  * the text() and sprite_name() overrides.
@@ -57,7 +77,8 @@ const int IV_GAP = 8;    // Gap between sprite and text
 IconItemRenderer::IconItemRenderer(bool use_client /*= true*/) :
 		TypedItemRenderer<std::string>(0),
 		_sprite_name_provider(0),
-		_use_client_area(use_client)
+		_use_client_area(use_client),
+		_range_painters(0)
 {
 }
 
@@ -72,7 +93,8 @@ IconItemRenderer::IconItemRenderer(bool use_client /*= true*/) :
 IconItemRenderer::IconItemRenderer(ItemViewValue<std::string> *np, bool use_client /*= true*/) :
 		TypedItemRenderer<std::string>(np),
 		_sprite_name_provider(np),
-		_use_client_area(use_client)
+		_use_client_area(use_client),
+		_range_painters(0)
 {
 }
 /**
@@ -87,7 +109,8 @@ IconItemRenderer::IconItemRenderer(ItemViewValue<std::string> *np, bool use_clie
 IconItemRenderer::IconItemRenderer(ItemViewValue<std::string> *np, ItemViewValue<std::string> *sp, bool use_client /*= true*/) :
 		TypedItemRenderer<std::string>(np),
 		_sprite_name_provider(sp),
-		_use_client_area(use_client)
+		_use_client_area(use_client),
+		_range_painters(0)
 {
 }
 
@@ -103,7 +126,7 @@ IconItemRenderer::~IconItemRenderer()
  */
 std::string IconItemRenderer::text(unsigned int index) const
 {
-	if (_value_provider) return _value_provider->value(index);
+	if (_value_provider) return value(index);
 	return std::string();
 }
 
@@ -115,8 +138,9 @@ std::string IconItemRenderer::text(unsigned int index) const
  */
 std::string IconItemRenderer::sprite_name(unsigned int index) const
 {
-	if (_sprite_name_provider) return _sprite_name_provider->value(index);
-	else return text(index);
+	if (_sprite_name_provider == 0) return text(index);
+	else if (_sprite_name_provider == _value_provider) return value(index);
+	else return _sprite_name_provider->value(index);
 }
 
 /**
@@ -148,44 +172,20 @@ tbx::Size IconItemRenderer::standard_size(unsigned int text_width /*= 160*/, uns
  */
 void IconItemRenderer::render(const ItemRenderer::Info &info)
 {
-	BBox content(info.bounds);
-	content.inflate(-IV_MARGIN); // Reduce size for border
-
-	if (use_client_sprite_area(info.index))
+	if (_range_painters)
 	{
-		// Can't do sprite and text icon for user client area so
-		// do two paints.
-		IconPainter ip;
-		ip.inverted(info.selected);
-		ip.bounds() = content;
-		ip.bounds().max.y = content.min.y + 32;
-		ip.hcentred(true);
-
-		// Paint text at bottom
-		ip.text(text(info.index));
-		ip.redraw(info.redraw);
-
-		// Paint sprite at top
-		ip.text_icon(false);
-		ip.sprite(sprite_name(info.index));
-		ip.use_client_sprite_area();
-		ip.bounds().max.y = content.max.y;
-		ip.bounds().min.y = content.max.y - 68;
-		ip.redraw(info.redraw);
+		paint(info, *_range_painters);
 	} else
 	{
-		// WIMP sprite can be done with one Icon
-		IconPainter ip;
-		ip.text(text(info.index)).sprite(sprite_name(info.index));
-		ip.text_and_sprite_centred();
-		ip.inverted(info.selected);
-		ip.bounds() = content;
-		ip.redraw(info.redraw);
+		Painters painters;
+		paint(info, painters);
 	}
 
 #ifdef CHECK_SIZES
 	Graphics g;
 
+	BBox content(info.bounds);
+	content.inflate(-IV_MARGIN);
 	BBox sbounds;
 	info.redraw.visible_area().screen(content, sbounds);
 
@@ -209,6 +209,66 @@ void IconItemRenderer::render(const ItemRenderer::Info &info)
 
 }
 
+/**
+ * Render a range of icons.
+ *
+ * The painters are created once and kept for the range, render
+ * only changes the text, sprite, position and selection.
+ */
+void IconItemRenderer::render_range(const ItemRenderer::RangeInfo &range)
+{
+	Painters painters;
+	_range_painters = &painters;
+	try
+	{
+		TypedItemRenderer<std::string>::render_range(range);
+	} catch(...)
+	{
+		_range_painters = 0;
+		throw;
+	}
+	_range_painters = 0;
+}
+
+/**
+ * Paint an item using the given painters
+ */
+void IconItemRenderer::paint(const ItemRenderer::Info &info, Painters &painters)
+{
+	BBox content(info.bounds);
+	content.inflate(-IV_MARGIN); // Reduce size for border
+
+	if (use_client_sprite_area(info.index))
+	{
+		// Can't do sprite and text icon for user client area so
+		// do two paints.
+
+		// Paint text at bottom
+		IconPainter &text_ip = painters.text_ip;
+		text_ip.text(text(info.index));
+		text_ip.inverted(info.selected);
+		text_ip.bounds() = content;
+		text_ip.bounds().max.y = content.min.y + 32;
+		text_ip.redraw(info.redraw);
+
+		// Paint sprite at top
+		IconPainter &sprite_ip = painters.sprite_ip;
+		sprite_ip.sprite(sprite_name(info.index));
+		sprite_ip.inverted(info.selected);
+		sprite_ip.bounds() = content;
+		sprite_ip.bounds().min.y = content.max.y - 68;
+		sprite_ip.redraw(info.redraw);
+	} else
+	{
+		// WIMP sprite can be done with one Icon
+		IconPainter &ip = painters.wimp_ip;
+		ip.text(text(info.index)).sprite(sprite_name(info.index));
+		ip.inverted(info.selected);
+		ip.bounds() = content;
+		ip.redraw(info.redraw);
+	}
+}
+
 /**
  * Return the width of the given item
  */
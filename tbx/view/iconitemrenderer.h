@@ -52,6 +52,12 @@ class IconItemRenderer: public tbx::view::TypedItemRenderer<std::string>
 {
 	ItemViewValue<std::string> *_sprite_name_provider;
 	bool _use_client_area;
+	//! @cond INTERNAL
+	struct Painters;
+	//! @endcond
+	Painters *_range_painters;
+
+	void paint(const ItemRenderer::Info &info, Painters &painters);
 
 protected:
 	IconItemRenderer(bool use_client = true);
@@ -86,6 +92,16 @@ public:
 	 */
 	virtual void render(const ItemRenderer::Info &info);
 
+	/**
+	 * Render a range of icons.
+	 *
+	 * The icon painters are set up once for the range and then
+	 * render is called for each item.
+	 *
+	 * @param range Information on redraw event and items to be redrawn
+	 */
+	virtual void render_range(const ItemRenderer::RangeInfo &range);
+
 	static tbx::Size standard_size(unsigned int width = 160, unsigned int sprite_height = 68);
 
 	virtual unsigned int width(unsigned int index) const;
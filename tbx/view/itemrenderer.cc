@@ -32,32 +32,76 @@
 #include "itemrenderer.h"
 #include "../font.h"
 #include "../sprite.h"
+#include "../scalefactors.h"
 
 
 namespace tbx {
 
 namespace view {
+
+/**
+ * Called to render a range of items that need drawing.
+ *
+ * The default positions each item in turn and calls render.
+ *
+ * @param range Information on the redraw event and the items to be redrawn
+ */
+void ItemRenderer::render_range(const ItemRenderer::RangeInfo &range)
+{
+	Info info(range.redraw);
+	for (unsigned int index = range.first; index <= range.last; index++)
+	{
+		info.index = index;
+		range.layout.position(info);
+		render(info);
+	}
+}
+
 /**
  * Render as cell retrieved as text.
  */
 void WimpFontItemRenderer::render(const ItemRenderer::Info &info)
 {
-	std::string t = _value_provider->value(info.index);
+	std::string t = value(info.index);
 	if (!t.empty())
 	{
 		WimpFont font;
 
-		if (info.selected)
-		{
-			font.set_colours(Colour::white, Colour::black);
-		} else
+		if (_range_colours != (int)info.selected)
 		{
-			font.set_colours(Colour::black, Colour::white);
+			if (info.selected)
+			{
+				font.set_colours(Colour::white, Colour::black);
+			} else
+			{
+				font.set_colours(Colour::black, Colour::white);
+			}
+			if (_range_colours != -2) _range_colours = (int)info.selected;
 		}
 		font.paint(info.screen.x, info.screen.y+8, t);
 	}
 }
 
+/**
+ * Render a range of cells retrieved as text.
+ *
+ * The colours set are remembered while the range is rendered
+ * so they are only set again when the selection state changes.
+ */
+void WimpFontItemRenderer::render_range(const ItemRenderer::RangeInfo &range)
+{
+	_range_colours = -1;
+	try
+	{
+		TypedItemRenderer<std::string>::render_range(range);
+	} catch(...)
+	{
+		_range_colours = -2;
+		throw;
+	}
+	_range_colours = -2;
+}
+
 /**
  * Used to measure the width of a column
  */
@@ -83,8 +127,59 @@ Size WimpFontItemRenderer::size(unsigned int index) const
  */
 void SpriteItemRenderer::render(const ItemRenderer::Info &info)
 {
-	tbx::Sprite *s = _value_provider->value(info.index);
-	if (s) s->plot_screen(info.screen);
+	tbx::Sprite *s = value(info.index);
+	if (s == 0) return;
+	if (_range_table == 0)
+	{
+		s->plot_screen(info.screen);
+		return;
+	}
+
+	if (s != _range_sprite)
+	{
+		const UserSprite *us = dynamic_cast<const UserSprite *>(s);
+		const WimpSprite *ws = (us == 0) ? dynamic_cast<const WimpSprite *>(s) : 0;
+		if (us) _range_table->create(us);
+		else if (ws) _range_table->create(ws);
+		else
+		{
+			// Unknown type of sprite so let it set itself up
+			_range_sprite = 0;
+			s->plot_screen(info.screen);
+			return;
+		}
+		s->get_wimp_scale(*_range_scale);
+		_range_sprite = s;
+	}
+	s->plot_scaled(info.screen, _range_scale, _range_table);
+}
+
+/**
+ * Render sprites for a range of cells
+ *
+ * The scale factors and translation table are kept for the range
+ * and only read again when a different sprite is plotted.
+ */
+void SpriteItemRenderer::render_range(const ItemRenderer::RangeInfo &range)
+{
+	ScaleFactors scale;
+	TranslationTable table;
+	_range_sprite = 0;
+	_range_scale = &scale;
+	_range_table = &table;
+	try
+	{
+		TypedItemRenderer<tbx::Sprite *>::render_range(range);
+	} catch(...)
+	{
+		_range_sprite = 0;
+		_range_scale = 0;
+		_range_table = 0;
+		throw;
+	}
+	_range_sprite = 0;
+	_range_scale = 0;
+	_range_table = 0;
 }
 
 /**
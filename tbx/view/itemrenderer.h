@@ -33,6 +33,7 @@
 #define ITEMRENDERER_H_
 
 #include <string>
+#include <vector>
 #include "../bbox.h"
 #include "../redrawlistener.h"
 #include "viewvalue.h"
@@ -40,6 +41,8 @@
 namespace tbx
 {
    class Sprite;
+   class ScaleFactors;
+   class TranslationTable;
 };
 
 namespace tbx {
@@ -95,6 +98,57 @@ public:
 		Info(const tbx::RedrawEvent &r) : redraw(r) {};
 	};
 
+	/**
+	 * Interface to give the position of each item in a range
+	 * of items to render.
+	 */
+	class CellLayout
+	{
+	public:
+		virtual ~CellLayout() {}
+
+		/**
+		 * Set the bounds, screen position and selected state
+		 * for the item.
+		 *
+		 * @param info information to update. The index must be set
+		 * to the item to position before this is called.
+		 */
+		virtual void position(ItemRenderer::Info &info) const = 0;
+	};
+
+	/**
+	 * Information on a range of items that need drawing
+	 */
+	struct RangeInfo
+	{
+		/**
+		 * Redraw event object from the view
+		 */
+		const tbx::RedrawEvent &redraw;
+
+		/**
+		 * zero based index of the first item to redraw
+		 */
+		unsigned int first;
+
+		/**
+		 * zero based index of the last item to redraw
+		 */
+		unsigned int last;
+
+		/**
+		 * Object to get the position of each item in the range
+		 */
+		const CellLayout &layout;
+
+		/**
+		 * Construct the range information
+		 */
+		RangeInfo(const tbx::RedrawEvent &r, unsigned int f, unsigned int l, const CellLayout &cl) :
+			redraw(r), first(f), last(l), layout(cl) {};
+	};
+
 	/**
 	 * Called to render each item that needs drawing
 	 *
@@ -107,6 +161,18 @@ public:
 	 */
 	virtual void render(const ItemRenderer::Info &info) = 0;
 
+	/**
+	 * Called to render a range of items that need drawing.
+	 *
+	 * The views call this rather than render. An override may set
+	 * up state or retrieve values once for the range, but must then
+	 * call render for each item so subclasses that override render
+	 * still draw their items.
+	 *
+	 * @param range Information on the redraw event and items to be redrawn
+	 */
+	virtual void render_range(const ItemRenderer::RangeInfo &range);
+
 	/**
 	 * Used to measure the width of a column
 	 */
@@ -160,13 +226,59 @@ template<class T> class TypedItemRenderer : public ItemRenderer
 {
 protected:
 	ItemViewValue<T> *_value_provider; //!< Object to retrieve the value for a rendered
+	std::vector<T> _range_values; //!< Values retrieved for the range being rendered
+	unsigned int _range_first; //!< Index of the first value in _range_values
+
+	/**
+	 * Get the value for an item.
+	 *
+	 * While a range is rendered the value retrieved for the
+	 * range is returned, otherwise it is asked for from the
+	 * value provider.
+	 *
+	 * @param index zero based index of the item
+	 */
+	T value(unsigned int index) const
+	{
+		if (index - _range_first < _range_values.size()) return _range_values[index - _range_first];
+		return _value_provider->value(index);
+	}
+
 public:
 	/**
 	 * Construct the item view renderer
 	 *
 	 * @param vp object used to retrieve values to render
 	 */
-	TypedItemRenderer(ItemViewValue<T> *vp) : _value_provider(vp) {}
+	TypedItemRenderer(ItemViewValue<T> *vp) : _value_provider(vp), _range_first(0) {}
+
+	/**
+	 * Render a range of items.
+	 *
+	 * The values for the range are retrieved together using
+	 * ItemViewValue::values then render is called for each item.
+	 *
+	 * @param range Information on the redraw event and items to be redrawn
+	 */
+	virtual void render_range(const ItemRenderer::RangeInfo &range)
+	{
+		if (_value_provider == 0)
+		{
+			ItemRenderer::render_range(range);
+			return;
+		}
+		_value_provider->values(range.first, range.last, _range_values);
+		_range_first = range.first;
+		try
+		{
+			ItemRenderer::render_range(range);
+		} catch(...)
+		{
+			_range_values.clear();
+			throw;
+		}
+		_range_values.clear();
+	}
 };
 
 /**
@@ -177,6 +289,19 @@ public:
  */
 class WimpFontItemRenderer : public TypedItemRenderer<std::string>
 {
+protected:
+	/**
+	 * Font colours set while a range is rendered.
+	 *
+	 * -2 when a range is not being rendered, -1 if the colours
+	 * have not been set yet, otherwise 1 for the selected colours
+	 * and 0 for the normal colours.
+	 *
+	 * An override of render that sets the wimp font colours itself
+	 * should set this to -1 if it is not -2.
+	 */
+	int _range_colours;
+
 public:
 	/**
 	 * Construct with object to give value to render
@@ -184,7 +309,7 @@ public:
 	 * @param vv object that returns a string to render
 	 */
 	WimpFontItemRenderer(ItemViewValue<std::string> *vv)
-	: TypedItemRenderer<std::string>(vv)
+	: TypedItemRenderer<std::string>(vv), _range_colours(-2)
 	  {
 	  }
 
@@ -197,6 +322,15 @@ public:
 	 */
 	virtual void render(const ItemRenderer::Info &info);
 
+	/**
+	 * Render a range of text cells.
+	 *
+	 * render is called for each item, but the font colours are
+	 * only set when they change from the previous item.
+	 *
+	 * @param range Information on the redraw event and items to be redrawn
+	 */
+	virtual void render_range(const ItemRenderer::RangeInfo &range);
 
 	/**
 	 * Used to measure the width of a column
@@ -229,6 +363,10 @@ public:
 
 class SpriteItemRenderer : public TypedItemRenderer<tbx::Sprite *>
 {
+	const tbx::Sprite *_range_sprite;
+	tbx::ScaleFactors *_range_scale;
+	tbx::TranslationTable *_range_table;
+
 public:
 	/**
 	 * Construct with object to give value to render
@@ -236,7 +374,8 @@ public:
 	 * @param vv object that returns a sprite to render
 	 */
 	SpriteItemRenderer(ItemViewValue<tbx::Sprite *> *vv) :
-		 TypedItemRenderer<tbx::Sprite *>(vv) {};
+		 TypedItemRenderer<tbx::Sprite *>(vv),
+		 _range_sprite(0), _range_scale(0), _range_table(0) {};
 
 	virtual ~SpriteItemRenderer() {};
 
@@ -245,6 +384,18 @@ public:
 	 */
 	virtual void render(const ItemRenderer::Info &info);
 
+	/**
+	 * Render the sprites for a range of cells.
+	 *
+	 * render is called for each item, but the scale factors and
+	 * colour translation table are only read again when the sprite
+	 * differs from the one plotted for the previous item. The
+	 * sprites must not be changed while they are rendered.
+	 *
+	 * @param range Information on the redraw event and items to be redrawn
+	 */
+	virtual void render_range(const ItemRenderer::RangeInfo &range);
+
 	/**
 	 * Used to measure the width of a column
 	 */
@@ -42,6 +42,7 @@ namespace view {
  */
 ItemView::ItemView(Window window) :
 		_window(window),
+		_redraw(window),
 		_selection(0),
 		_click_listeners(0),
 		_count(0),
@@ -60,7 +61,7 @@ ItemView::~ItemView()
 	_window.remove_scroll_request_listener(this);
 	if (_selection || _click_listeners)
 	{
-		if (_selection) _selection->remove_listener(this);
+		if (_selection) _selection->remove_changes_listener(this);
 		_window.remove_mouse_click_listener(this);
 		delete _click_listeners;
 	}
@@ -80,7 +81,7 @@ void ItemView::selection(Selection *selection)
 	if (_selection)
 	{
 		if (_count) _selection->clear();
-		_selection->remove_listener(this);
+		_selection->remove_changes_listener(this);
 		delete _selection;
 		if (selection == 0 && _click_listeners == 0) _window.remove_mouse_click_listener(this);
 	} else if (selection != 0)
@@ -89,7 +90,7 @@ void ItemView::selection(Selection *selection)
 	}
 
 	_selection = selection;
-	if (_selection) _selection->add_listener(this);
+	if (_selection) _selection->add_changes_listener(this);
 }
 
 /**
@@ -372,19 +373,38 @@ void ItemView::process_mouse_click(int index, MouseClickEvent &event)
 /**
  * Selection has changed event handling.
  *
- * The ItemView implementation forces a redraw of the items that have
- * had there selection changed.
+ * The ItemView implementation redraws the items that have
+ * had their selection changed.
+ *
+ * This is called for each change from selection_changes so
+ * subclasses can still override it.
  */
 void ItemView::selection_changed(const SelectionChangedEvent &event)
 {
 	BBox bounds;
 	get_bounds(bounds, event.first(), event.last());
-	_window.force_redraw(bounds);
+	_redraw.invalidate(bounds);
 
 	// Any other selection turns last select menu off
 	_flags &= ~LAST_SELECT_MENU;
 }
 
+/**
+ * All the changes from one selection action.
+ *
+ * The view listens for these rather than each change so
+ * calls selection_changed for each of the merged changes. The
+ * areas to redraw are combined before the next poll.
+ */
+void ItemView::selection_changes(const SelectionChangesEvent &event)
+{
+	SelectionChangesEvent::const_iterator c;
+	for (c = event.begin(); c != event.end(); ++c)
+	{
+		selection_changed(*c);
+	}
+}
+
 
 }
 }
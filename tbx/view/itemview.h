@@ -33,6 +33,7 @@
 #define TBX_ITEMVIEW_H_
 
 #include "../window.h"
+#include "../deferredredraw.h"
 #include "../mouseclicklistener.h"
 #include "../margin.h"
 #include "../draghandler.h"
@@ -59,15 +60,20 @@ class ItemViewClickListener;
  * removed and changed methods.
  *
  * The items are rendered using the ItemRenderer passed to the constructor.
+ *
+ * Areas that need redrawing after changes are collected and the WIMP
+ * is asked to redraw them just before the next Wimp_Poll.
  */
 class ItemView :
 	public RedrawListener,
 	public ScrollRequestListener,
 	public MouseClickListener,
-	public SelectionListener
+	public SelectionListener,
+	public SelectionChangesListener
 {
 protected:
 	Window _window; ///< Window displaying this view
+	DeferredRedraw _redraw; ///< Areas of the window to redraw before the next poll
 	Margin _margin; ///< Margin around areas displaying items
 	Selection *_selection; ///< Selection model
 	/// Listeners for a mouse click on the view
@@ -171,6 +177,9 @@ public:
 	// Selection listener override
 	virtual void selection_changed(const SelectionChangedEvent &event);
 
+	// Selection changes listener override
+	virtual void selection_changes(const SelectionChangesEvent &event);
+
 	/**
 	 * Called to update the window extent needed to contain
 	 * this view.
@@ -30,6 +30,7 @@
  */
 
 #include "listview.h"
+#include "celllayouts.h"
 #include "../osgraphics.h"
 #include <algorithm>
 
@@ -45,7 +46,8 @@ ListView::ListView(tbx::Window window, ItemRenderer *item_renderer)
     : ItemView(window),
       _item_renderer(item_renderer),
       _height(0),
-      _width(0)
+      _width(0),
+      _row_heights(0)
 {
 }
 
@@ -54,6 +56,7 @@ ListView::ListView(tbx::Window window, ItemRenderer *item_renderer)
  */
 ListView::~ListView()
 {
+	delete _row_heights;
 }
 
 /**
@@ -86,6 +89,9 @@ void ListView::item_renderer(ItemRenderer *ir)
  * If the row height is 0. It will take the height from
  * the first item in the list. This is how the view
  * starts up.
+ *
+ * When variable_row_height is on this is the height used
+ * for rows that have not been measured.
  */
 void ListView::row_height(unsigned int height)
 {
@@ -95,6 +101,11 @@ void ListView::row_height(unsigned int height)
 	}
 	if (height != _height)
 	{
+		if (_row_heights)
+		{
+			if (_count) refresh();
+			_row_heights->default_height(height);
+		}
 		_height = height;
 		if (_count)
 		{
@@ -104,6 +115,34 @@ void ListView::row_height(unsigned int height)
 	}
 }
 
+/**
+ * Turn on or off variable height rows.
+ *
+ * When on the height of each row is taken from the item renderer
+ * the first time the row is shown. Rows that have not been shown
+ * use the row_height() until they are measured.
+ *
+ * @param on true to allow rows to have different heights
+ */
+void ListView::variable_row_height(bool on)
+{
+	if (on == (_row_heights != 0)) return;
+	if (_count) refresh();
+	if (on)
+	{
+		_row_heights = new RowHeights(_height, _count);
+	} else
+	{
+		delete _row_heights;
+		_row_heights = 0;
+	}
+	if (_count)
+	{
+		update_window_extent();
+		refresh();
+	}
+}
+
 /**
  * Turn on or off auto sizing.
  *
@@ -212,56 +251,72 @@ void ListView::size_to_width(unsigned int min/* = 0*/, unsigned int max /*= 0xFF
 void ListView::redraw(const tbx::RedrawEvent & event)
 {
 	BBox work_clip = event.visible_area().work(event.clip());
+	int top = -work_clip.max.y - _margin.top;
+	int bottom = -work_clip.min.y - _margin.top;
 
-	unsigned int first_row = (-work_clip.max.y - _margin.top) / _height;
-	unsigned int last_row =  (-work_clip.min.y - _margin.top) / _height;
+	if (_row_heights && _item_renderer != 0)
+	{
+		unsigned int old_total = _row_heights->total();
+		unsigned int changed_row = measure_rows(top, bottom);
+		if (changed_row != NO_INDEX) rows_moved(changed_row, old_total);
+	}
 
-	if (first_row < 0) first_row = 0;
-	if (last_row < 0) return; // Nothing to draw
+	unsigned int first_row = row_from_offset(top);
+	unsigned int last_row =  row_from_offset(bottom);
 
 	if (first_row >= _count) return; // Nothing to draw
 	if (last_row >= _count) last_row = _count - 1;
 
-    ItemRenderer::Info cell_info(event);
+    Selection::Cursor selection_cursor(_selection);
+    const VisibleArea &visible_area = event.visible_area();
+    int top_y = -row_top(first_row) - _margin.top;
+    RowCellLayout layout(visible_area, first_row, top_y);
+    layout.columns(_margin.left, _margin.left + _width);
 
-	cell_info.bounds.max.y = -first_row * _height - _margin.top;
-	cell_info.screen.y = event.visible_area().screen_y(cell_info.bounds.max.y);
-
-	cell_info.screen.x = event.visible_area().screen_x(_margin.left);
-	cell_info.bounds.min.x = _margin.left;
-    cell_info.bounds.max.x = _margin.left + _width;
+    int screen_x = visible_area.screen_x(_margin.left);
+    int screen_y = visible_area.screen_y(top_y);
 
+    // Fill selected backgrounds first so the items can be rendered together
     for (unsigned int row = first_row; row <= last_row; row++)
     {
-        cell_info.bounds.min.y = cell_info.bounds.max.y - _height;
-        cell_info.screen.y -= _height;
-        cell_info.index = row;
-
-        cell_info.selected = (_selection != 0 && _selection->selected(row));
+        unsigned int height = height_of_row(row);
+        bool selected = selection_cursor.selected(row);
+        screen_y -= height;
 
-        if (cell_info.selected)
+        if (selected)
         {
         	// Fill background with selected colour
     		OSGraphics g;
     		g.foreground(Colour::black);
-    		g.fill_rectangle(cell_info.screen.x, cell_info.screen.y,
-    				cell_info.screen.x + _width -1,
-    				cell_info.screen.y + _height - 1);
+    		g.fill_rectangle(screen_x, screen_y,
+    				screen_x + _width -1,
+    				screen_y + height - 1);
         }
 
-        _item_renderer->render(cell_info);
-
-        cell_info.bounds.max.y = cell_info.bounds.min.y;
+        layout.add_row(height, selected);
     }
+
+    _item_renderer->render_range(ItemRenderer::RangeInfo(event, first_row, last_row, layout));
 }
 
 /**
  * Update the Window extent after a change in size.
  */
 void ListView::update_window_extent()
+{
+	BBox extent = window_extent();
+	// Keep an extent waiting to be set by the redraw up to date
+	if (_redraw.extent_pending()) _redraw.extent(extent);
+	else _window.extent(extent);
+}
+
+/**
+ * Calculate the window extent needed for the view
+ */
+BBox ListView::window_extent()
 {
 	int width = _width + _margin.left + _margin.right;
-	int height = _count * _height + _margin.top + _margin.bottom;
+	int height = row_top(_count) + _margin.top + _margin.bottom;
 
 	WindowState state;
 	_window.get_state(state);
@@ -271,8 +326,7 @@ void ListView::update_window_extent()
 	if (height < state.visible_area().bounds().height())
 	   height = state.visible_area().bounds().height();
 
-	BBox extent(0,-height, width, 0);
-	_window.extent(extent);
+	return BBox(0,-height, width, 0);
 }
 
 /**
@@ -283,9 +337,9 @@ void ListView::update_window_extent()
 
 void ListView::refresh()
 {
-	BBox all(_margin.left, -_margin.top - _count * _height,
+	BBox all(_margin.left, -_margin.top - row_top(_count),
 			_margin.left + _width, -_margin.top);
-	_window.force_redraw(all);
+	_redraw.invalidate(all);
 }
 
 /**
@@ -296,10 +350,17 @@ void ListView::refresh()
  */
 void ListView::inserted(unsigned int where, unsigned int how_many)
 {
+	int old_bottom = row_top(_count);
+	unsigned int old_width = _width;
+
 	if (_item_renderer != 0)
 	{
 		// Automatically set the height if not set
-		if (_height == 0) _height = _item_renderer->height(where);
+		if (_height == 0)
+		{
+			_height = _item_renderer->height(where);
+			if (_row_heights) _row_heights->default_height(_height);
+		}
 		if ((_flags & AUTO_SIZE))
 		{
 			// Auto size
@@ -308,16 +369,27 @@ void ListView::inserted(unsigned int where, unsigned int how_many)
 		}
 	}
 	_count += how_many;
+	if (_row_heights) _row_heights->inserted(where, how_many);
 	update_window_extent();
 
 	if (_selection) _selection->inserted(where, how_many);
 
-	//TODO: Use window block copy to update
-	BBox dirty(_margin.left,
-		- _count * _height - _margin.top,
-		_width + _margin.left,
-		- where * _height - _margin.top);
-	_window.force_redraw(dirty);
+	if (_width == old_width && where + how_many < _count)
+	{
+		// Move rows below the insertion down
+		BBox moving(_margin.left,
+			-old_bottom - _margin.top,
+			_width + _margin.left,
+			-row_top(where) - _margin.top);
+		_redraw.shift(moving, 0, row_top(where) - row_top(where + how_many));
+	} else
+	{
+		BBox dirty(_margin.left,
+			- row_top(_count) - _margin.top,
+			_width + _margin.left,
+			- row_top(where) - _margin.top);
+		_redraw.invalidate(dirty);
+	}
 }
 
 /**
@@ -359,7 +431,10 @@ void ListView::removed(unsigned int where, unsigned int how_many)
 		_flags |= WANT_AUTO_SIZE;
 	}
 	_flags &= ~ AUTO_SIZE_CHECKED;
+	int old_bottom = row_top(_count);
+	int removed_height = row_top(where + how_many) - row_top(where);
 	_count -= how_many;
+	if (_row_heights) _row_heights->removed(where, how_many);
 	unsigned int old_width = _width;
 	if (_flags & WANT_AUTO_SIZE)
 	{
@@ -367,14 +442,24 @@ void ListView::removed(unsigned int where, unsigned int how_many)
 		if (_count == 0) _width = 0;
 		else _width = check_width(0, _count);
 	}
-	//TODO: Use window block copy to update
-	BBox dirty(_margin.left,
-		-_count * _height - _margin.top,
-		old_width + _margin.left,
-		-where * _height - _margin.top);
+	if (_width == old_width && where < _count)
+	{
+		// Move rows below the removed rows up before the extent shrinks
+		BBox moving(_margin.left,
+			-old_bottom - _margin.top,
+			old_width + _margin.left,
+			-row_top(where) - removed_height - _margin.top);
+		_redraw.shift(moving, 0, removed_height);
+	} else
+	{
+		BBox dirty(_margin.left,
+			-old_bottom - _margin.top,
+			old_width + _margin.left,
+			-row_top(where) - _margin.top);
+		_redraw.invalidate(dirty);
+	}
 	if (_selection) _selection->removed(where, how_many);
 	update_window_extent();
-	_window.force_redraw(dirty);
 }
 
 /**
@@ -449,12 +534,32 @@ void ListView::changed(unsigned int where, unsigned int how_many)
 	}
 	_flags &= ~(AUTO_SIZE_CHECKED | WANT_AUTO_SIZE);
 
+	if (_row_heights && _item_renderer != 0)
+	{
+		// Measure rows again if they have already been shown
+		unsigned int old_total = _row_heights->total();
+		unsigned int changed_row = NO_INDEX;
+		for (unsigned int row = where; row < where + how_many; row++)
+		{
+			if (_row_heights->measured(row))
+			{
+				unsigned int height = _item_renderer->height(row);
+				if (height != _row_heights->height(row))
+				{
+					if (changed_row == NO_INDEX) changed_row = row;
+					_row_heights->height(row, height);
+				}
+			}
+		}
+		if (changed_row != NO_INDEX) rows_moved(changed_row, old_total);
+	}
+
 	int last_row = where + how_many;
 	BBox dirty(_margin.left,
-		-last_row * _height - _margin.top,
+		-row_top(last_row) - _margin.top,
 		_width + _margin.left,
-		-where * _height - _margin.top);
-	_window.force_redraw(dirty);
+		-row_top(where) - _margin.top);
+	_redraw.invalidate(dirty);
 }
 
 /**
@@ -466,6 +571,7 @@ void ListView::cleared()
 	{
 		refresh();
 		_count = 0;
+		if (_row_heights) _row_heights->clear();
 		if (_flags & AUTO_SIZE) _width = 0;
 		if (_selection) _selection->clear();
 		update_window_extent();
@@ -491,10 +597,10 @@ unsigned int ListView::insert_index(const Point &scr_pt) const
 	_window.get_state(state);
 
 	int work_y = state.visible_area().work_y(scr_pt.y) + _margin.top;
-	unsigned int row = (-work_y + _height/2) / _height;
+	unsigned int row = row_from_offset(-work_y);
+	if (row < _count && -work_y - row_top(row) >= (int)height_of_row(row)/2) row++;
 
-	if (row < 0) row = 0;
-	else if (row > _count) row = _count;
+	if (row > _count) row = _count;
 
 	return row;
 }
@@ -517,7 +623,7 @@ unsigned int ListView::screen_index(const Point &scr_pt) const
 		row = NO_INDEX;
 	} else
 	{
-		row = (-work_pt.y - _margin.top) / _height;
+		row = row_from_offset(-work_pt.y - _margin.top);
 		if (row >= _count) row = NO_INDEX;
 	}
 
@@ -548,7 +654,7 @@ unsigned int ListView::hit_test(const Point &scr_pt) const
 			index= NO_INDEX;
 		} else
 		{
-			index = (-work_pt.y - _margin.top) / _height;
+			index = row_from_offset(-work_pt.y - _margin.top);
 			if (index >= _count) index = NO_INDEX;
 		}
 		if (index != NO_INDEX)
@@ -558,7 +664,7 @@ unsigned int ListView::hit_test(const Point &scr_pt) const
 			Point in_item;
 			in_item.x = work_pt.x - bounds.min.x;
 			in_item.y = work_pt.y - bounds.min.y;
-			if (!_item_renderer->hit_test(index, Size(_width, _height), in_item))
+			if (!_item_renderer->hit_test(index, Size(_width, height_of_row(index)), in_item))
 				index = NO_INDEX;
 		}
 	}
@@ -573,8 +679,8 @@ void ListView::get_bounds(BBox &bounds, unsigned int index) const
 {
 	bounds.min.x = _margin.left;
 	bounds.max.x = bounds.min.x + _width;
-	bounds.max.y = -_margin.top - index * _height;
-	bounds.min.y = bounds.max.y - _height;
+	bounds.max.y = -_margin.top - row_top(index);
+	bounds.min.y = bounds.max.y - height_of_row(index);
 }
 
 /**
@@ -584,8 +690,8 @@ void ListView::get_bounds(BBox &bounds, unsigned int first, unsigned int last) c
 {
 	bounds.min.x = _margin.left;
 	bounds.max.x = bounds.min.x + _width;
-	bounds.max.y = -_margin.top - first * _height;
-	bounds.min.y =  -_margin.top - (last+1) * _height;
+	bounds.max.y = -_margin.top - row_top(first);
+	bounds.min.y =  -_margin.top - row_top(last+1);
 }
 
 /**
@@ -611,26 +717,30 @@ void ListView::process_drag_selection(const BBox &drag_box, bool adjust)
 	first_pt.y += _margin.top;
 	last_pt.y += _margin.top;
 
-	unsigned int first = -first_pt.y / _height;
+	unsigned int first = row_from_offset(-first_pt.y);
 	if (first >= _count) return;
-	unsigned int last = -last_pt.y / _height;
-	if (last < 0) return;
+	unsigned int last = row_from_offset(-last_pt.y);
 	if (last >= _count) last = _count - 1;
 
-	bool first_top = ((-first_pt.y  - (_height * first)) <= _height/2);
-	bool last_top = ((-last_pt.y - (_height * last)) <= _height/2);
+	Size first_size(_width, height_of_row(first));
+	Size last_size(_width, height_of_row(last));
 
-	Size line_size(_width, _height);
+	bool first_top = ((-first_pt.y  - row_top(first)) <= first_size.height/2);
+	bool last_top = ((-last_pt.y - row_top(last)) <= last_size.height/2);
 
 	if (!first_top)
 	{
 		first_pt.x -= _margin.left;
-		if (_item_renderer->hit_test(first, line_size, first_pt) == NO_INDEX) first++;
+		if (!_item_renderer->hit_test(first, first_size, first_pt)) first++;
 	}
 	if (last_top)
 	{
 		last_pt.x -= _margin.left;
-		if (_item_renderer->hit_test(last, line_size, last_pt) == NO_INDEX) last--;
+		if (!_item_renderer->hit_test(last, last_size, last_pt))
+		{
+			if (last == 0) return; // Nothing selected
+			last--;
+		}
 	}
 
 	if (first <= last)
@@ -640,6 +750,100 @@ void ListView::process_drag_selection(const BBox &drag_box, bool adjust)
 	}
 }
 
+/**
+ * Get the offset of the top of a row from the top of the first row
+ *
+ * @param row row to get the offset for (can be the row count for the end)
+ */
+int ListView::row_top(unsigned int row) const
+{
+	if (_row_heights) return _row_heights->top(row);
+	return row * _height;
+}
+
+/**
+ * Get the row at an offset from the top of the first row
+ *
+ * @param offset offset below the top of the first row
+ * @returns row at the offset or a value >= count() if it is below the last row
+ */
+unsigned int ListView::row_from_offset(int offset) const
+{
+	if (offset < 0) offset = 0;
+	if (_row_heights) return _row_heights->row_at(offset);
+	return (_height) ? offset / _height : 0;
+}
+
+/**
+ * Get the height of a row
+ */
+unsigned int ListView::height_of_row(unsigned int row) const
+{
+	if (_row_heights && row < _row_heights->count()) return _row_heights->height(row);
+	return _height;
+}
+
+/**
+ * Measure any rows between two offsets from the top of the first
+ * row that have not been measured.
+ *
+ * Measuring a row can move other rows into the range, so this
+ * continues until all the rows in the range have been measured.
+ *
+ * @param top offset of the top of the range
+ * @param bottom offset of the bottom of the range
+ * @returns first row that changed height or NO_INDEX if none changed
+ */
+unsigned int ListView::measure_rows(int top, int bottom)
+{
+	unsigned int changed_row = NO_INDEX;
+	bool measuring = (_count != 0);
+
+	while (measuring)
+	{
+		measuring = false;
+		unsigned int last = row_from_offset(bottom);
+		if (last >= _count) last = _count - 1;
+		for (unsigned int row = row_from_offset(top); row <= last; row++)
+		{
+			if (!_row_heights->measured(row))
+			{
+				unsigned int height = _item_renderer->height(row);
+				if (height != _row_heights->height(row))
+				{
+					if (row < changed_row) changed_row = row;
+					measuring = true;
+				}
+				_row_heights->height(row, height);
+			}
+		}
+	}
+
+	return changed_row;
+}
+
+/**
+ * Update the window after the height of rows has changed
+ *
+ * This is called from the redraw handler, so the new extent
+ * is set by the DeferredRedraw before the next poll.
+ *
+ * @param row first row that changed height
+ * @param old_total total height of all the rows before the change
+ */
+void ListView::rows_moved(unsigned int row, unsigned int old_total)
+{
+	unsigned int total = _row_heights->total();
+	if (total != old_total) _redraw.extent(window_extent());
+	if (old_total > total) total = old_total;
+
+	BBox dirty(_margin.left,
+		-(int)total - _margin.top,
+		_width + _margin.left,
+		-row_top(row) - _margin.top);
+	_redraw.invalidate(dirty);
+}
+
 // End of namespaces
 }
 }
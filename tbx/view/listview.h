@@ -33,6 +33,7 @@
 #define TBX_LISTVIEW_H_
 
 #include "itemview.h"
+#include "rowheights.h"
 
 namespace tbx {
 
@@ -49,6 +50,7 @@ protected:
 	ItemRenderer *_item_renderer; //!< Object used to render itesm
 	unsigned int _height;         //!< Height of one item
 	unsigned int _width;		  //!< Width of list view
+	RowHeights *_row_heights;     //!< Height of each row or 0 if all rows are the same height
 
 public:
 	ListView(tbx::Window window, ItemRenderer *item_renderer = 0);
@@ -63,6 +65,12 @@ public:
 	 */
 	unsigned int row_height() const {return _height;}
 
+	void variable_row_height(bool on);
+	/**
+	 * Check if rows can have different heights
+	 */
+	bool variable_row_height() const {return _row_heights != 0;}
+
 	virtual void auto_size(bool on);
 
 	void width(unsigned int width);
@@ -115,6 +123,13 @@ protected:
 	 */
 	virtual void process_drag_selection(const BBox &drag_box, bool adjust);
 
+	// Helpers
+	int row_top(unsigned int row) const;
+	unsigned int row_from_offset(int offset) const;
+	unsigned int height_of_row(unsigned int row) const;
+	unsigned int measure_rows(int top, int bottom);
+	void rows_moved(unsigned int row, unsigned int old_total);
+	BBox window_extent();
 };
 
 }
@@ -29,6 +29,7 @@
  */
 
 #include "reportview.h"
+#include "celllayouts.h"
 #include "../osgraphics.h"
 
 namespace tbx {
@@ -41,7 +42,8 @@ namespace view {
  * @param window Window displaying the report view
  */
 ReportView::ReportView(Window window) : ItemView(window),
-	    _height(0), _width(0), _column_gap(4)
+	    _height(0), _width(0), _column_gap(4),
+	    _row_heights(0)
 {
 }
 
@@ -51,6 +53,7 @@ ReportView::ReportView(Window window) : ItemView(window),
  */
 ReportView::~ReportView()
 {
+	delete _row_heights;
 }
 
 
@@ -61,6 +64,9 @@ ReportView::~ReportView()
  * the first item in the list. This is how the view
  * starts up.
  *
+ * When variable_row_height is on this is the height used
+ * for rows that have not been measured.
+ *
  * @param height new row height
  */
 void ReportView::row_height(unsigned int height)
@@ -71,6 +77,11 @@ void ReportView::row_height(unsigned int height)
 	}
 	if (height != _height)
 	{
+		if (_row_heights)
+		{
+			if (_count) refresh();
+			_row_heights->default_height(height);
+		}
 		_height = height;
 		if (_count)
 		{
@@ -81,46 +92,87 @@ void ReportView::row_height(unsigned int height)
 }
 
 /**
- * Calculate the row height from the first row of the report
+ * Calculate the row height from a row of the report
  *
+ * @param row row to measure (defaults to the first row)
  * @returns calculated row height
  */
-unsigned int ReportView::calc_row_height() const
+unsigned int ReportView::calc_row_height(unsigned int row /*= 0*/) const
 {
 	std::vector<ColInfo>::const_iterator i;
 	unsigned int height = 0;
 	for (i = _columns.begin(); i != _columns.end(); ++i)
 	{
-		unsigned int col_height = (*i).renderer->height(0);
+		unsigned int col_height = (*i).renderer->height(row);
 		if (col_height > height) height = col_height;
 	}
 
 	return height;
 }
 
+/**
+ * Turn on or off variable height rows.
+ *
+ * When on the height of each row is taken from the tallest cell
+ * in the row the first time the row is shown. Rows that have not
+ * been shown use the row_height() until they are measured.
+ *
+ * @param on true to allow rows to have different heights
+ */
+void ReportView::variable_row_height(bool on)
+{
+	if (on == (_row_heights != 0)) return;
+	if (_count) refresh();
+	if (on)
+	{
+		_row_heights = new RowHeights(_height, _count);
+	} else
+	{
+		delete _row_heights;
+		_row_heights = 0;
+	}
+	if (_count)
+	{
+		update_window_extent();
+		refresh();
+	}
+}
+
 /**
  * Turn on or off auto sizing.
  *
  * When auto sizing is on the item width is checked whenever an
- * item is added, changed or removed.
- *
- * To prevent a scan of the whole list on removal call the
- * removing method before actually doing a removal.
+ * item is added or changed. The widths of all the cells are kept
+ * so the columns can be resized when items are removed or changed
+ * without measuring all the other rows.
  *
  * @param on true to turn autosizing on
  */
 void ReportView::auto_size(bool on)
 {
+	std::vector<ColInfo>::iterator i;
 	if (on)
 	{
 		if ((_flags & AUTO_SIZE)==0)
 		{
-			size_all_to_width();
 			_flags |= AUTO_SIZE;
+			for (i = _columns.begin(); i != _columns.end(); ++i)
+			{
+				(*i).widths.measure((*i).renderer, _count);
+			}
+			if (update_auto_widths() && _count)
+			{
+				update_window_extent();
+				refresh();
+			}
 		}
-	} else
+	} else if (_flags & AUTO_SIZE)
 	{
 		_flags &= ~AUTO_SIZE;
+		for (i = _columns.begin(); i != _columns.end(); ++i)
+		{
+			(*i).widths.clear();
+		}
 	}
 }
 
@@ -152,9 +204,20 @@ void ReportView::column_gap(unsigned int gap)
  * Update the Window extent after a change in size.
  */
 void ReportView::update_window_extent()
+{
+	BBox extent = window_extent();
+	// Keep an extent waiting to be set by the redraw up to date
+	if (_redraw.extent_pending()) _redraw.extent(extent);
+	else _window.extent(extent);
+}
+
+/**
+ * Calculate the window extent needed for the view
+ */
+BBox ReportView::window_extent()
 {
 	int width = _width + _margin.left + _margin.right;
-	int height = _count * _height + _margin.top + _margin.bottom;
+	int height = row_top(_count) + _margin.top + _margin.bottom;
 
 	WindowState state;
 	_window.get_state(state);
@@ -164,8 +227,7 @@ void ReportView::update_window_extent()
 	if (height < state.visible_area().bounds().height())
 	   height = state.visible_area().bounds().height();
 
-	BBox extent(0,-height, width, 0);
-	_window.extent(extent);
+	return BBox(0,-height, width, 0);
 }
 
 /**
@@ -175,9 +237,9 @@ void ReportView::update_window_extent()
  */
 void ReportView::refresh()
 {
-	BBox all(_margin.left, -_margin.top - _count * _height,
+	BBox all(_margin.left, -_margin.top - row_top(_count),
 			_margin.left + _width, -_margin.top);
-	_window.force_redraw(all);
+	_redraw.invalidate(all);
 }
 
 
@@ -191,20 +253,18 @@ void ReportView::refresh()
  */
 unsigned int ReportView::add_column(ItemRenderer *cr, unsigned int width /*= 0*/)
 {
-	if (width > 0) _flags &=~AUTO_SIZE;
-	if ((_flags & AUTO_SIZE) && _count)
-	{
-		for(unsigned int row = 0; row < _count; row++)
-		{
-			unsigned int col_width = cr->width(row);
-			if (col_width > width) width = col_width;
-		}
-	}
+	if (width > 0) auto_size(false);
 	ColInfo ci;
 	ci.renderer = cr;
 	ci.width = width;
 	if (column_count()) _width += _column_gap;
 	_columns.push_back(ci);
+	if (_flags & AUTO_SIZE)
+	{
+		ColInfo &added = _columns.back();
+		added.widths.measure(cr, _count);
+		added.width = width = added.widths.max_width();
+	}
 	_width += width;
 	update_window_extent();
 	return column_count()-1;
@@ -218,12 +278,27 @@ unsigned int ReportView::add_column(ItemRenderer *cr, unsigned int width /*= 0*/
 void ReportView::remove_column(unsigned int column)
 {
 	if (column >= column_count()) return;
+	int left = x_from_column(column);
+	int removed_width = _columns[column].width + _column_gap;
+	int old_right = _margin.left + _width;
+	int top = -_margin.top;
+	int bottom = -row_top(_count) - _margin.top;
+
 	_width -= _columns[column].width;
 	_columns.erase(_columns.begin() + column);
 	if (column_count()) _width -= _column_gap;
-	update_window_extent();
 
-	refresh(); // TODO: Use window block copy instead
+	if (column < column_count())
+	{
+		// Move the columns to the right of the removed column left
+		BBox moving(left + removed_width, bottom, old_right, top);
+		_redraw.shift(moving, -removed_width, 0);
+	} else
+	{
+		// Last column removed so just redraw where it was
+		_redraw.invalidate(BBox(left - _column_gap, bottom, old_right, top));
+	}
+	update_window_extent();
 }
 
 /**
@@ -236,7 +311,7 @@ void ReportView::remove_column(unsigned int column)
  */
 void ReportView::column_width(unsigned int column, unsigned int width)
 {
-	if (width > 0) _flags &=~AUTO_SIZE;
+	if (width > 0) auto_size(false);
 	if (column >= column_count()) return;
 
 	if (_columns[column].width != width)
@@ -244,12 +319,24 @@ void ReportView::column_width(unsigned int column, unsigned int width)
 	    if (_columns[column].width > width) _width -= _columns[column].width - width;
 	    else _width += width - _columns[column].width;
 
+		int left = x_from_column(column);
+		int old_column_right = left + _columns[column].width;
+		int old_right = _margin.left + _width + _columns[column].width - width;
+		int top = -_margin.top;
+		int bottom = -row_top(_count) - _margin.top;
+		int dx = (int)width - (int)_columns[column].width;
+
 		_columns[column].width = width;
 		//TODO: remove gap for zero width columns
 		if (_count)
 		{
-			update_window_extent();
-			refresh(); //TODO: Use window block copy instead
+			// Extent must include the destination before moving right
+			if (dx > 0) update_window_extent();
+			BBox moving(old_column_right + _column_gap, bottom, old_right, top);
+			_redraw.shift(moving, dx, 0);
+			// Redraw the column itself
+			_redraw.invalidate(BBox(left, bottom, left + ((dx > 0) ? width : width - dx), top));
+			if (dx < 0) update_window_extent();
 		}
 	}
 }
@@ -326,16 +413,16 @@ void ReportView::size_all_to_width(unsigned int min_width /*= 0*/, unsigned int
 
 
 /**
- * Adjust column widths and total width if any items in the
- * given range exceed the current widths.
+ * Check if any of the column widths have been reduced and
+ * adjust columns if necessary
  *
- * Note: Does not refresh the display
+ * Measures from first to end-1
  *
- * @param start first row to check (inclusive)
- * @param end last row to check (not inclusive)
- * @returns true if any column was adjusted
+ *@param from first row to measure (inclusive)
+ *@param end last row to measure (not inclusive)
+ *@return true if any widths have changed.
  */
-bool ReportView::adjust_max_width(unsigned int start, unsigned int end)
+bool ReportView::adjust_min_width(unsigned int from, unsigned int end)
 {
 	std::vector<ColInfo>::iterator i;
 	bool changed = false;
@@ -344,17 +431,19 @@ bool ReportView::adjust_max_width(unsigned int start, unsigned int end)
 	{
 		unsigned int col_width = (*i).width;
 		ItemRenderer *renderer = (*i).renderer;
+		unsigned int max_col_width = 0;
 
-		for (unsigned int row = start; row < end; row++)
+		for (unsigned int row = from; row < end; row++)
 		{
 			unsigned int size = renderer->width(row);
-			if (size > col_width) col_width = size;
+			if (size > max_col_width) max_col_width = size;
+			if (size == col_width) break; // Don't need any more checks on this column
 		}
 
-		if (col_width > (*i).width)
+		if (max_col_width < col_width)
 		{
-			_width += col_width - (*i).width;
-			(*i).width = col_width;
+			_width -= col_width - max_col_width;
+			(*i).width = max_col_width;
 			changed = true;
 		}
 	}
@@ -363,37 +452,25 @@ bool ReportView::adjust_max_width(unsigned int start, unsigned int end)
 }
 
 /**
- * Check if any of the column widths have been reduced and
- * adjust columns if necessary
+ * Set the column widths to the widest item measured for
+ * each column when auto sizing
  *
- * Measures from first to end-1
+ * Note: Does not refresh the display
  *
- *@param from first row to measure (inclusive)
- *@param end last row to measure (not inclusive)
- *@return true if any widths have changed.
+ * @returns true if any column was adjusted
  */
-bool ReportView::adjust_min_width(unsigned int from, unsigned int end)
+bool ReportView::update_auto_widths()
 {
 	std::vector<ColInfo>::iterator i;
 	bool changed = false;
 
 	for (i = _columns.begin(); i != _columns.end(); ++i)
 	{
-		unsigned int col_width = (*i).width;
-		ItemRenderer *renderer = (*i).renderer;
-		unsigned int max_col_width = 0;
-
-		for (unsigned int row = from; row < end; row++)
+		unsigned int col_width = (*i).widths.max_width();
+		if (col_width != (*i).width)
 		{
-			unsigned int size = renderer->width(row);
-			if (size > max_col_width) max_col_width = size;
-			if (size == col_width) break; // Don't need any more checks on this column
-		}
-
-		if (max_col_width < col_width)
-		{
-			_width -= col_width - max_col_width;
-			(*i).width = max_col_width;
+			_width += col_width - (*i).width;
+			(*i).width = col_width;
 			changed = true;
 		}
 	}
@@ -412,66 +489,51 @@ bool ReportView::adjust_min_width(unsigned int from, unsigned int end)
 void ReportView::inserted(unsigned int where, unsigned int how_many)
 {
 	int first_row = where;
+	int old_bottom = row_top(_count);
+	unsigned int old_width = _width;
 
 	_count += how_many;
+	if (_row_heights) _row_heights->inserted(where, how_many);
 
 	if (column_count() != 0)
 	{
 		// Automatically set the height if not set
-		if (_height == 0) _height = calc_row_height();
+		if (_height == 0)
+		{
+			_height = calc_row_height();
+			if (_row_heights) _row_heights->default_height(_height);
+		}
 		if ((_flags & AUTO_SIZE))
 		{
 			// Auto size
-			if (adjust_max_width(where, where + how_many)) first_row = 0;
+			std::vector<ColInfo>::iterator i;
+			for (i = _columns.begin(); i != _columns.end(); ++i)
+			{
+				(*i).widths.inserted((*i).renderer, where, how_many);
+			}
+			if (update_auto_widths()) first_row = 0;
 		}
 	}
 
-	//TODO: Use window block copy to update
 	update_window_extent();
 
 	if (_selection) _selection->inserted(where, how_many);
 
-	BBox dirty(_margin.left,
-		-_count * _height - _margin.top,
-		_width + _margin.left,
-		-first_row * _height - _margin.top);
-	_window.force_redraw(dirty);
-}
-
-/**
-* Inform the view that items are about to be removed.
-*
-* This call is optional, but it stops the need for a full
-* scan every time something is removed when auto size is on.
-*
-* @param where location items will be removed from
-* @param how_many number of items that will be removed
-*/
-void ReportView::removing(unsigned int where, unsigned int how_many)
-{
-	_flags |= AUTO_SIZE_CHECKED;
-	if (_flags & AUTO_SIZE)
+	if (first_row == (int)where && _width == old_width && where + how_many < _count)
 	{
-		if (where == 0 && how_many >= _count) _flags |= WANT_AUTO_SIZE;
-		else if (column_count())
-		{
-			std::vector<ColInfo>::iterator i;
-			for (i = _columns.begin(); i != _columns.end(); ++i)
-			{
-				unsigned int col_width = (*i).width;
-				ItemRenderer *renderer = (*i).renderer;
-				for (unsigned int row = where; row < where + how_many; row++)
-				{
-					unsigned int item_width = renderer->width(row);
-					if (item_width == col_width)
-					{
-						_flags |= WANT_AUTO_SIZE;
-						break;
-					}
-				}
-				if (_flags & WANT_AUTO_SIZE) break;
-			}
-		}
+		// Move rows below the insertion down
+		BBox moving(_margin.left,
+			-old_bottom - _margin.top,
+			_width + _margin.left,
+			-row_top(where) - _margin.top);
+		_redraw.shift(moving, 0, row_top(where) - row_top(where + how_many));
+	} else
+	{
+		BBox dirty(_margin.left,
+			-row_top(_count) - _margin.top,
+			_width + _margin.left,
+			-row_top(first_row) - _margin.top);
+		_redraw.invalidate(dirty);
 	}
 }
 
@@ -485,71 +547,38 @@ void ReportView::removing(unsigned int where, unsigned int how_many)
 void ReportView::removed(unsigned int where, unsigned int how_many)
 {
 	unsigned int first = where;
-	if ((_flags & AUTO_SIZE) && !(_flags & AUTO_SIZE_CHECKED))
-	{
-		_flags |= WANT_AUTO_SIZE;
-	}
-	_flags &= ~ AUTO_SIZE_CHECKED;
+	int old_bottom = row_top(_count);
+	int removed_height = row_top(where + how_many) - row_top(where);
 	_count -= how_many;
+	if (_row_heights) _row_heights->removed(where, how_many);
 	unsigned int old_width = _width;
-	if (_flags & WANT_AUTO_SIZE)
-	{
-		_flags &= ~WANT_AUTO_SIZE;
-		if (_count == 0)
-		{
-			std::vector<ColInfo>::iterator i;
-			first = 0;
-			for (i = _columns.begin(); i != _columns.end(); ++i)
-			{
-				(*i).width = 0;
-			}
-			_width = 0;
-		} else if (adjust_min_width(0, _count)) first = 0;
-	}
-	//TODO: Use window block copy to update
-	BBox dirty(_margin.left,
-		-(_count + how_many) * _height - _margin.top,
-		old_width + _margin.left,
-		-first * _height - _margin.top);
-	if (_selection) _selection->removed(where, how_many);
-	update_window_extent();
-	_window.force_redraw(dirty);
-}
-
-/**
-* Inform the view that items are about to be changed
-*
-* This call is optional, but it stops the need for a full
-* scan every time something an item is changed when auto size is on.
-*
-* @param where location items will be changed from
-* @param how_many number of items that will be changed
-*/
-void ReportView::changing(unsigned int where, unsigned int how_many)
-{
-	_flags |= AUTO_SIZE_CHECKED;
 	if (_flags & AUTO_SIZE)
 	{
-		if (column_count())
+		std::vector<ColInfo>::iterator i;
+		for (i = _columns.begin(); i != _columns.end(); ++i)
 		{
-			std::vector<ColInfo>::iterator i;
-			for (i = _columns.begin(); i != _columns.end(); ++i)
-			{
-				unsigned int col_width = (*i).width;
-				ItemRenderer *renderer = (*i).renderer;
-				for (unsigned int row = where; row < where + how_many; row++)
-				{
-					unsigned int item_width = renderer->width(row);
-					if (item_width == col_width)
-					{
-						_flags |= WANT_AUTO_SIZE;
-						break;
-					}
-				}
-				if (_flags & WANT_AUTO_SIZE) break;
-			}
+			(*i).widths.removed(where, how_many);
 		}
+		if (update_auto_widths()) first = 0;
+	}
+	if (first == where && _width == old_width && where < _count)
+	{
+		// Move rows below the removed rows up before the extent shrinks
+		BBox moving(_margin.left,
+			-old_bottom - _margin.top,
+			old_width + _margin.left,
+			-row_top(where) - removed_height - _margin.top);
+		_redraw.shift(moving, 0, removed_height);
+	} else
+	{
+		BBox dirty(_margin.left,
+			-old_bottom - _margin.top,
+			old_width + _margin.left,
+			-row_top(first) - _margin.top);
+		_redraw.invalidate(dirty);
 	}
+	if (_selection) _selection->removed(where, how_many);
+	update_window_extent();
 }
 
 /**
@@ -566,53 +595,47 @@ void ReportView::changed(unsigned int where, unsigned int how_many)
 
 	if ((_flags & AUTO_SIZE) && column_count())
 	{
-		bool may_shrink = true;
-		if ((_flags & AUTO_SIZE_CHECKED) && ((_flags & WANT_AUTO_SIZE) == 0))
-		{
-			may_shrink = false;
-		}
-
 		std::vector<ColInfo>::iterator i;
-		bool col_shrinks = may_shrink;
 		for (i = _columns.begin(); i != _columns.end(); ++i)
 		{
-			unsigned int col_width = 0;
-			ItemRenderer *renderer = (*i).renderer;
-			for (unsigned int row = where; row < where + how_many; row++)
-			{
-				unsigned int item_width = renderer->width(row);
-				if (item_width >= col_width) col_width = item_width;
-			}
-
-			if ((*i).width != col_width)
-			{
-				if (col_width < (*i).width)
-				{
-					col_shrinks = may_shrink;
-				} else if (col_width > (*i).width)
-				{
-					_width += col_width - (*i).width;
-					(*i).width = col_width;
-					first  = 0;
-				}
-			}
+			(*i).widths.changed((*i).renderer, where, how_many);
 		}
 
-		if (col_shrinks && adjust_min_width(0, _count))
+		if (update_auto_widths())
 		{
+			// Columns have moved so redraw everything
 			first = 0;
 			last = _count;
+			update_window_extent();
 		}
-		if (old_width != _width) update_window_extent();
 		if (old_width < _width) old_width = _width;
 	}
 
-	_flags &= ~(AUTO_SIZE_CHECKED | WANT_AUTO_SIZE);
+	if (_row_heights && column_count())
+	{
+		// Measure rows again if they have already been shown
+		unsigned int old_total = _row_heights->total();
+		unsigned int changed_row = NO_INDEX;
+		for (unsigned int row = where; row < where + how_many; row++)
+		{
+			if (_row_heights->measured(row))
+			{
+				unsigned int height = calc_row_height(row);
+				if (height != _row_heights->height(row))
+				{
+					if (changed_row == NO_INDEX) changed_row = row;
+					_row_heights->height(row, height);
+				}
+			}
+		}
+		if (changed_row != NO_INDEX) rows_moved(changed_row, old_total);
+	}
+
 	BBox dirty(_margin.left,
-		-last * _height - _margin.top,
+		-row_top(last) - _margin.top,
 		old_width + _margin.left,
-		-where * _height - _margin.top);
-	_window.force_redraw(dirty);
+		-row_top(first) - _margin.top);
+	_redraw.invalidate(dirty);
 }
 
 /**
@@ -624,14 +647,15 @@ void ReportView::cleared()
 	{
 		refresh();
 		_count = 0;
+		if (_row_heights) _row_heights->clear();
 		if (_flags & AUTO_SIZE)
 		{
 			std::vector<ColInfo>::iterator i;
 			for (i = _columns.begin(); i != _columns.end(); ++i)
 			{
-				(*i).width = 0;
+				(*i).widths.clear();
 			}
-			_width = 0;
+			update_auto_widths();
 		}
 
 		if (_selection) _selection->clear();
@@ -649,30 +673,17 @@ void ReportView::cleared()
 }
 
 /**
-* Inform the view that one column has been changed
+* Inform the view that one column is about to be changed
 *
-* This call is optional, but it stops the need for a full
-* scan every time something an item is changed when auto size is on.
+* This call is no longer needed as the widths of all the cells
+* are remembered when auto size is on. It is kept so existing
+* code still compiles.
 *
 * @param index location of item that will be changed from
 * @param column The column that has been changed
 */
 void ReportView::cell_changing(unsigned int index, unsigned int column)
 {
-	_flags |= AUTO_SIZE_CHECKED;
-	if (_flags & AUTO_SIZE)
-	{
-		if (index < _count && column < column_count())
-		{
-			unsigned int col_width = _columns[column].width;
-			ItemRenderer *renderer = _columns[column].renderer;
-			unsigned int item_width = renderer->width(index);
-			if (item_width == col_width)
-			{
-				_flags |= WANT_AUTO_SIZE;
-			}
-		}
-	}
 }
 
 /**
@@ -689,33 +700,13 @@ void ReportView::cell_changed(unsigned int index, unsigned int column)
 
 	if ((_flags & AUTO_SIZE) && column < column_count())
 	{
-		bool may_shrink = true;
-		if ((_flags & AUTO_SIZE_CHECKED) && ((_flags & WANT_AUTO_SIZE) == 0))
-		{
-			may_shrink = false;
-		}
-
-		unsigned int col_width = _columns[column].width;
-		unsigned int old_width = col_width;
-		ItemRenderer *renderer = _columns[column].renderer;
-		unsigned int item_width = renderer->width(index);
-		if (item_width > col_width)
-		{
-			col_width = item_width;
-		} else if (item_width < col_width && may_shrink)
-		{
-			col_width = item_width;
-			for(unsigned int row = 0; row < _count; row++)
-			{
-				item_width = renderer->width(index);
-				if (item_width > col_width) col_width = item_width;
-				if (col_width == old_width) break;
-			}
-		}
-		if (col_width != old_width)
+		ColInfo &col_info = _columns[column];
+		col_info.widths.changed(col_info.renderer, index, 1);
+		unsigned int col_width = col_info.widths.max_width();
+		if (col_width != col_info.width)
 		{
-			_width += col_width - old_width;
-			_columns[column].width = col_width;
+			_width += col_width - col_info.width;
+			col_info.width = col_width;
 			first = 0;
 			last = _count;
 			if (last_col_pos < _margin.left + _width)
@@ -724,12 +715,11 @@ void ReportView::cell_changed(unsigned int index, unsigned int column)
 		}
 	}
 
-	_flags &= ~(AUTO_SIZE_CHECKED | WANT_AUTO_SIZE);
 	BBox dirty(x_from_column(column),
-		-last * _height - _margin.top,
+		-row_top(last) - _margin.top,
 		last_col_pos,
-		-first * _height - _margin.top);
-	_window.force_redraw(dirty);
+		-row_top(first) - _margin.top);
+	_redraw.invalidate(dirty);
 
 }
 
@@ -779,12 +769,18 @@ int ReportView::x_from_column(unsigned int column) const
 void ReportView::redraw(const RedrawEvent &event)
 {
 	BBox work_clip = event.visible_area().work(event.clip());
+	int top = -work_clip.max.y - _margin.top;
+	int bottom = -work_clip.min.y - _margin.top;
 
-	unsigned int first_row = (-work_clip.max.y - _margin.top) / _height;
-	unsigned int last_row =  (-work_clip.min.y - _margin.top) / _height;
+	if (_row_heights && column_count())
+	{
+		unsigned int old_total = _row_heights->total();
+		unsigned int changed_row = measure_rows(top, bottom);
+		if (changed_row != NO_INDEX) rows_moved(changed_row, old_total);
+	}
 
-	if (first_row < 0) first_row = 0;
-	if (last_row < 0) return; // Nothing to draw
+	unsigned int first_row = row_from_offset(top);
+	unsigned int last_row =  row_from_offset(bottom);
 
 	if (first_row >= _count) return; // Nothing to draw
 	if (last_row >= _count) last_row = _count - 1;
@@ -795,47 +791,50 @@ void ReportView::redraw(const RedrawEvent &event)
     if (first_col >= column_count()) return; // Nothing to redraw
     if (last_col >= column_count()) last_col = column_count() - 1;
 
-    ItemRenderer::Info cell_info(event);
+    Selection::Cursor selection_cursor(_selection);
+    const VisibleArea &visible_area = event.visible_area();
+    int top_y = -row_top(first_row) - _margin.top;
+    RowCellLayout layout(visible_area, first_row, top_y);
 
-	cell_info.bounds.max.y = -first_row * _height - _margin.top;
-	cell_info.screen.y = event.visible_area().screen_y(cell_info.bounds.max.y);
 	int first_col_x = x_from_column(first_col);
-	int first_col_scr_x = event.visible_area().screen_x(first_col_x);
+	int first_col_scr_x = visible_area.screen_x(first_col_x);
+	int sel_right;
+	if (last_col < column_count()-1) sel_right = x_from_column(last_col+1);
+	else sel_right = _width + _margin.left;
+
+	int screen_y = visible_area.screen_y(top_y);
 
+    // Fill selected backgrounds first so each column can be rendered together
     for (unsigned int row = first_row; row <= last_row; row++)
     {
-        cell_info.bounds.min.y = cell_info.bounds.max.y - _height;
-        cell_info.bounds.min.x = first_col_x;
-        cell_info.screen.y -= _height;
-        cell_info.screen.x = first_col_scr_x;
-        cell_info.index = row;
+        unsigned int height = height_of_row(row);
+        bool selected = selection_cursor.selected(row);
+        screen_y -= height;
 
-        cell_info.selected = (_selection != 0 && _selection->selected(row));
-
-        if (cell_info.selected)
+        if (selected)
         {
         	// Fill background with selected colour
-        	int sel_right;
-        	if (last_col < column_count()-1) sel_right = x_from_column(last_col+1);
-        	else sel_right = _width + _margin.left;
     		OSGraphics g;
     		g.foreground(Colour::black);
-    		g.fill_rectangle(first_col_scr_x, cell_info.screen.y,
+    		g.fill_rectangle(first_col_scr_x, screen_y,
     				first_col_scr_x + sel_right - first_col_x - 1,
-    				cell_info.screen.y + _height - 1);
+    				screen_y + height - 1);
         }
 
-        for (unsigned int col = first_col; col <= last_col; col++)
-        {
-			cell_info.bounds.max.x = cell_info.bounds.min.x + _columns[col].width;
-        	if (_columns[col].width > 0)
-        	{
-				_columns[col].renderer->render(cell_info);
-        	}
-			cell_info.screen.x += cell_info.bounds.max.x - cell_info.bounds.min.x + _column_gap;
-			cell_info.bounds.min.x = cell_info.bounds.max.x + _column_gap;
-        }
-        cell_info.bounds.max.y = cell_info.bounds.min.y;
+        layout.add_row(height, selected);
+    }
+
+    ItemRenderer::RangeInfo range(event, first_row, last_row, layout);
+    int col_x = first_col_x;
+    for (unsigned int col = first_col; col <= last_col; col++)
+    {
+    	int width = _columns[col].width;
+    	if (width > 0)
+    	{
+    		layout.columns(col_x, col_x + width);
+    		_columns[col].renderer->render_range(range);
+    	}
+    	col_x += width + _column_gap;
     }
 }
 
@@ -852,10 +851,10 @@ unsigned int ReportView::insert_index(const Point &scr_pt) const
 	_window.get_state(state);
 
 	int work_y = state.visible_area().work_y(scr_pt.y) + _margin.top;
-	unsigned int row = (-work_y + _height/2) / _height;
+	unsigned int row = row_from_offset(-work_y);
+	if (row < _count && -work_y - row_top(row) >= (int)height_of_row(row)/2) row++;
 
-	if (row < 0) row = 0;
-	else if (row > _count) row = _count;
+	if (row > _count) row = _count;
 
 	return row;
 
@@ -878,9 +877,9 @@ unsigned int ReportView::screen_index(const Point &scr_pt) const
 	int work_y = state.visible_area().work_y(scr_pt.y);
 	work_y += _margin.top;
 
-	unsigned int row = -work_y / _height;
+	unsigned int row = row_from_offset(-work_y);
 
-	if (row < 0 && row >= count()) row = NO_INDEX;
+	if (work_y > 0 || row >= count()) row = NO_INDEX;
 
 	return row;
 
@@ -912,7 +911,7 @@ unsigned int ReportView::hit_test(const Point &scr_pt) const
 			index= NO_INDEX;
 		} else
 		{
-			index = (-work_pt.y - _margin.top) / _height;
+			index = row_from_offset(-work_pt.y - _margin.top);
 			if (index >= _count) index = NO_INDEX;
 		}
 		if (index != NO_INDEX)
@@ -944,8 +943,8 @@ void ReportView::get_bounds(BBox &bounds, unsigned int index) const
 {
 	bounds.min.x = _margin.left;
 	bounds.max.x = bounds.min.x + _width;
-	bounds.max.y = -_margin.top - index * _height;
-	bounds.min.y = bounds.max.y - _height;
+	bounds.max.y = -_margin.top - row_top(index);
+	bounds.min.y = bounds.max.y - height_of_row(index);
 }
 
 /**
@@ -959,8 +958,8 @@ void ReportView::get_bounds(BBox &bounds, unsigned int first, unsigned int last)
 {
 	bounds.min.x = _margin.left;
 	bounds.max.x = bounds.min.x + _width;
-	bounds.max.y = -_margin.top - first * _height;
-	bounds.min.y = -_margin.top - (last + 1) * _height;
+	bounds.max.y = -_margin.top - row_top(first);
+	bounds.min.y = -_margin.top - row_top(last + 1);
 }
 
 /**
@@ -977,8 +976,8 @@ void ReportView::get_cell_bounds(BBox &bounds, unsigned int row, unsigned int co
 {
 	bounds.min.x = x_from_column(column);
 	bounds.max.x = bounds.min.x + _columns[column].width;
-	bounds.max.y = -_margin.top - row * _height;
-	bounds.min.y = bounds.max.y - _height;
+	bounds.max.y = -_margin.top - row_top(row);
+	bounds.min.y = bounds.max.y - height_of_row(row);
 }
 
 
@@ -1005,10 +1004,9 @@ void ReportView::process_drag_selection(const BBox &drag_box, bool adjust)
 	first_pt.y += _margin.top;
 	last_pt.y += _margin.top;
 
-	unsigned int first = -first_pt.y / _height;
+	unsigned int first = row_from_offset(-first_pt.y);
 	if (first >= _count) return;
-	unsigned int last = -last_pt.y / _height;
-	if (last < 0) return;
+	unsigned int last = row_from_offset(-last_pt.y);
 	if (last >= _count) last = _count - 1;
 
 	if (first <= last)
@@ -1018,6 +1016,100 @@ void ReportView::process_drag_selection(const BBox &drag_box, bool adjust)
 	}
 }
 
+/**
+ * Get the offset of the top of a row from the top of the first row
+ *
+ * @param row row to get the offset for (can be the row count for the end)
+ */
+int ReportView::row_top(unsigned int row) const
+{
+	if (_row_heights) return _row_heights->top(row);
+	return row * _height;
+}
+
+/**
+ * Get the row at an offset from the top of the first row
+ *
+ * @param offset offset below the top of the first row
+ * @returns row at the offset or a value >= row_count() if it is below the last row
+ */
+unsigned int ReportView::row_from_offset(int offset) const
+{
+	if (offset < 0) offset = 0;
+	if (_row_heights) return _row_heights->row_at(offset);
+	return (_height) ? offset / _height : 0;
+}
+
+/**
+ * Get the height of a row
+ */
+unsigned int ReportView::height_of_row(unsigned int row) const
+{
+	if (_row_heights && row < _row_heights->count()) return _row_heights->height(row);
+	return _height;
+}
+
+/**
+ * Measure any rows between two offsets from the top of the first
+ * row that have not been measured.
+ *
+ * Measuring a row can move other rows into the range, so this
+ * continues until all the rows in the range have been measured.
+ *
+ * @param top offset of the top of the range
+ * @param bottom offset of the bottom of the range
+ * @returns first row that changed height or NO_INDEX if none changed
+ */
+unsigned int ReportView::measure_rows(int top, int bottom)
+{
+	unsigned int changed_row = NO_INDEX;
+	bool measuring = (_count != 0);
+
+	while (measuring)
+	{
+		measuring = false;
+		unsigned int last = row_from_offset(bottom);
+		if (last >= _count) last = _count - 1;
+		for (unsigned int row = row_from_offset(top); row <= last; row++)
+		{
+			if (!_row_heights->measured(row))
+			{
+				unsigned int height = calc_row_height(row);
+				if (height != _row_heights->height(row))
+				{
+					if (row < changed_row) changed_row = row;
+					measuring = true;
+				}
+				_row_heights->height(row, height);
+			}
+		}
+	}
+
+	return changed_row;
+}
+
+/**
+ * Update the window after the height of rows has changed
+ *
+ * This is called from the redraw handler, so the new extent
+ * is set by the DeferredRedraw before the next poll.
+ *
+ * @param row first row that changed height
+ * @param old_total total height of all the rows before the change
+ */
+void ReportView::rows_moved(unsigned int row, unsigned int old_total)
+{
+	unsigned int total = _row_heights->total();
+	if (total != old_total) _redraw.extent(window_extent());
+	if (old_total > total) total = old_total;
+
+	BBox dirty(_margin.left,
+		-(int)total - _margin.top,
+		_width + _margin.left,
+		-row_top(row) - _margin.top);
+	_redraw.invalidate(dirty);
+}
+
 // End of namespaces
 }
 
@@ -33,6 +33,8 @@
 #define TBX_REPORTVIEW_H_
 
 #include "itemview.h"
+#include "widthtracker.h"
+#include "rowheights.h"
 
 namespace tbx {
 
@@ -53,8 +55,10 @@ private:
 	{
 			ItemRenderer *renderer;
 			unsigned int width;
+			WidthTracker widths; // Item widths used when auto sizing
 	};
 	std::vector<ColInfo> _columns;
+	RowHeights *_row_heights;
 
 public:
 	ReportView(tbx::Window window);
@@ -68,6 +72,12 @@ public:
 	 */
 	unsigned int row_height() const {return _height;}
 
+	void variable_row_height(bool on);
+	/**
+	 * Check if rows can have different heights
+	 */
+	bool variable_row_height() const {return _row_heights != 0;}
+
 	void column_gap(unsigned int gap);
 	/**
 	 * Get the gap between columns in the report
@@ -110,9 +120,7 @@ public:
 
 
 	virtual void inserted(unsigned int where, unsigned int how_many);
-	virtual void removing(unsigned int where, unsigned int how_many);
 	virtual void removed(unsigned int where, unsigned int how_many);
-	virtual void changing(unsigned int where, unsigned int how_many);
 	virtual void changed(unsigned int where, unsigned int how_many);
 	virtual void cleared();
 
@@ -147,9 +155,15 @@ protected:
 	virtual void process_drag_selection(const BBox &drag_box, bool adjust);
 
 	// Helpers
-	unsigned int calc_row_height() const;
-	bool adjust_max_width(unsigned int start, unsigned int end);
+	unsigned int calc_row_height(unsigned int row = 0) const;
 	bool adjust_min_width(unsigned int from, unsigned int end);
+	bool update_auto_widths();
+	int row_top(unsigned int row) const;
+	unsigned int row_from_offset(int offset) const;
+	unsigned int height_of_row(unsigned int row) const;
+	unsigned int measure_rows(int top, int bottom);
+	void rows_moved(unsigned int row, unsigned int old_total);
+	BBox window_extent();
 };
 
 }
@@ -0,0 +1,175 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "rowheights.h"
+
+namespace tbx {
+
+namespace view {
+
+/**
+ * Construct with all the rows unmeasured
+ *
+ * @param default_height height to use for rows that have not been measured
+ * @param count number of rows
+ */
+RowHeights::RowHeights(unsigned int default_height, unsigned int count) :
+	_default_height(default_height),
+	_heights(count, default_height),
+	_measured(count, false)
+{
+	rebuild();
+}
+
+/**
+ * Change the height used for rows that have not been measured
+ */
+void RowHeights::default_height(unsigned int height)
+{
+	if (height == _default_height) return;
+	_default_height = height;
+	for (unsigned int row = 0; row < _heights.size(); row++)
+	{
+		if (!_measured[row]) _heights[row] = height;
+	}
+	rebuild();
+}
+
+/**
+ * Add unmeasured rows
+ *
+ * @param where index of first row inserted
+ * @param how_many number of rows inserted
+ */
+void RowHeights::inserted(unsigned int where, unsigned int how_many)
+{
+	_heights.insert(_heights.begin() + where, how_many, _default_height);
+	_measured.insert(_measured.begin() + where, how_many, false);
+	rebuild();
+}
+
+/**
+ * Remove rows
+ *
+ * @param where index of first row removed
+ * @param how_many number of rows removed
+ */
+void RowHeights::removed(unsigned int where, unsigned int how_many)
+{
+	_heights.erase(_heights.begin() + where, _heights.begin() + where + how_many);
+	_measured.erase(_measured.begin() + where, _measured.begin() + where + how_many);
+	rebuild();
+}
+
+/**
+ * Remove all the rows
+ */
+void RowHeights::clear()
+{
+	_heights.clear();
+	_measured.clear();
+	rebuild();
+}
+
+/**
+ * Set the measured height of a row
+ *
+ * @param row row to set
+ * @param height height of the row
+ */
+void RowHeights::height(unsigned int row, unsigned int height)
+{
+	_measured[row] = true;
+	if (height == _heights[row]) return;
+
+	unsigned int old_height = _heights[row];
+	_heights[row] = height;
+	for (unsigned int i = row + 1; i < _tree.size(); i += i & (0-i))
+	{
+		_tree[i] += height - old_height; // Wraps correctly for a reduction
+	}
+}
+
+/**
+ * Get the offset of the top of a row from the top of the first row
+ *
+ * @param row row to get the position of (can be count() for the end)
+ * @returns total height of all the rows before this row
+ */
+unsigned int RowHeights::top(unsigned int row) const
+{
+	unsigned int total = 0;
+	for (unsigned int i = row; i > 0; i -= i & (0-i))
+	{
+		total += _tree[i];
+	}
+	return total;
+}
+
+/**
+ * Find the row at an offset from the top of the first row
+ *
+ * @param offset offset to find the row for
+ * @returns row containing the offset or count() if it is below the last row
+ */
+unsigned int RowHeights::row_at(unsigned int offset) const
+{
+	unsigned int size = _heights.size();
+	unsigned int step = 1;
+	while (step * 2 <= size) step *= 2;
+
+	unsigned int pos = 0;
+	for (; step > 0; step >>= 1)
+	{
+		if (pos + step <= size && _tree[pos + step] <= offset)
+		{
+			pos += step;
+			offset -= _tree[pos];
+		}
+	}
+
+	return pos;
+}
+
+/**
+ * Rebuild the tree from the row heights in linear time.
+ *
+ * Used after rows are inserted or removed as that moves the
+ * position of every row after them in the tree.
+ */
+void RowHeights::rebuild()
+{
+	unsigned int size = _heights.size();
+	_tree.assign(size + 1, 0);
+	for (unsigned int i = 1; i <= size; i++)
+	{
+		_tree[i] += _heights[i-1];
+		unsigned int parent = i + (i & (0-i));
+		if (parent <= size) _tree[parent] += _tree[i];
+	}
+}
+
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_ROWHEIGHTS_H_
+#define TBX_ROWHEIGHTS_H_
+
+#include <vector>
+
+namespace tbx {
+
+namespace view {
+
+//! @cond INTERNAL
+
+/**
+ * Class to store the heights of rows that can vary in height.
+ *
+ * The heights are held in a Fenwick (binary indexed) tree so the
+ * position of a row and the row at a position can be found in
+ * O(log N).
+ *
+ * Rows start off unmeasured and use the default height until the
+ * view measures them, so only the rows that are shown need to be
+ * measured.
+ *
+ * Inserting or removing rows rebuilds the tree, which is O(N) but
+ * does not measure any rows. Moving the stored heights along is
+ * O(N) anyway, so updating the tree in place would not save much.
+ */
+class RowHeights
+{
+	unsigned int _default_height;
+	std::vector<unsigned int> _heights;
+	std::vector<bool> _measured;
+	std::vector<unsigned int> _tree;
+
+public:
+	RowHeights(unsigned int default_height, unsigned int count);
+
+	void default_height(unsigned int height);
+	/**
+	 * Get the height used for rows that have not been measured
+	 */
+	unsigned int default_height() const {return _default_height;}
+
+	/**
+	 * Get the number of rows
+	 */
+	unsigned int count() const {return _heights.size();}
+
+	void inserted(unsigned int where, unsigned int how_many);
+	void removed(unsigned int where, unsigned int how_many);
+	void clear();
+
+	/**
+	 * Check if a row has been measured
+	 */
+	bool measured(unsigned int row) const {return _measured[row];}
+	/**
+	 * Get the height of a row
+	 *
+	 * @returns measured height or the default height if it has not been measured
+	 */
+	unsigned int height(unsigned int row) const {return _heights[row];}
+	void height(unsigned int row, unsigned int height);
+
+	unsigned int top(unsigned int row) const;
+	/**
+	 * Get the total height of all the rows
+	 */
+	unsigned int total() const {return top(_heights.size());}
+	unsigned int row_at(unsigned int offset) const;
+
+private:
+	void rebuild();
+};
+
+//! @endcond
+
+}
+
+}
+
+#endif
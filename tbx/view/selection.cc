@@ -48,6 +48,16 @@ void Selection::fire_event(const SelectionChangedEvent &event)
 	{
 		(*i)->selection_changed(event);
 	}
+	if (!_changes_listeners.empty())
+	{
+		std::vector<SelectionChangedEvent> changes(1, event);
+		SelectionChangesEvent changes_event(changes);
+		std::vector<SelectionChangesListener *>::iterator c;
+		for (c = _changes_listeners.begin(); c != _changes_listeners.end(); ++c)
+		{
+			(*c)->selection_changes(changes_event);
+		}
+	}
 }
 /**
  * Helper for subclasses to fire Selection Changed Events
@@ -66,6 +76,81 @@ void Selection::fire_event(unsigned int from, unsigned int to, bool selected, bo
 	fire_event(e);
 }
 
+/**
+ * Compare selection changes by their first index
+ */
+static bool change_first_less(const SelectionChangedEvent &lhs, const SelectionChangedEvent &rhs)
+{
+	return lhs.first() < rhs.first();
+}
+
+/**
+ * Helper for subclasses to fire all the changes caused by one action.
+ *
+ * Each change is sent to the selection listeners in turn with the
+ * final flag set on the last one. The changes listeners get a single
+ * event with the changes sorted and adjacent changes merged.
+ *
+ * @param changes list of changes. The changes must not overlap.
+ */
+void Selection::fire_changes(std::vector<SelectionChangedEvent> &changes)
+{
+	if (changes.empty()) return;
+
+	std::vector<SelectionChangedEvent>::iterator c;
+	for (c = changes.begin(); c != changes.end(); ++c)
+	{
+		c->final(false);
+	}
+	changes.back().final(true);
+
+	std::vector<SelectionListener *>::iterator i;
+	for (i = _listeners.begin(); i != _listeners.end(); ++i)
+	{
+		for (c = changes.begin(); c != changes.end(); ++c)
+		{
+			(*i)->selection_changed(*c);
+		}
+	}
+
+	if (!_changes_listeners.empty())
+	{
+		std::vector<SelectionChangedEvent> sorted(changes);
+		for (c = sorted.begin() + 1; c != sorted.end(); ++c)
+		{
+			if (c->first() < (c-1)->first())
+			{
+				std::sort(sorted.begin(), sorted.end(), change_first_less);
+				break;
+			}
+		}
+
+		std::vector<SelectionChangedEvent> merged;
+		merged.reserve(sorted.size());
+		for (c = sorted.begin(); c != sorted.end(); ++c)
+		{
+			if (!merged.empty()
+				&& merged.back().selected() == c->selected()
+				&& merged.back().last() + 1 == c->first())
+			{
+				merged.back().last(c->last());
+			} else
+			{
+				merged.push_back(*c);
+				merged.back().final(false);
+			}
+		}
+		merged.back().final(true);
+
+		SelectionChangesEvent changes_event(merged);
+		std::vector<SelectionChangesListener *>::iterator cl;
+		for (cl = _changes_listeners.begin(); cl != _changes_listeners.end(); ++cl)
+		{
+			(*cl)->selection_changes(changes_event);
+		}
+	}
+}
+
 /**
  * Add listener for selection changes
  */
@@ -87,6 +172,27 @@ void Selection::remove_listener(SelectionListener *listener)
 	}
 }
 
+/**
+ * Add listener for all the changes made by a single action
+ */
+void Selection::add_changes_listener(SelectionChangesListener *listener)
+{
+	_changes_listeners.push_back(listener);
+}
+
+/**
+ * Remove listener for all the changes made by a single action
+ */
+void Selection::remove_changes_listener(SelectionChangesListener *listener)
+{
+	std::vector<SelectionChangesListener *>::iterator found =
+			std::find(_changes_listeners.begin(), _changes_listeners.end(), listener);
+	if (found != _changes_listeners.end())
+	{
+		_changes_listeners.erase(found);
+	}
+}
+
 /**
  * Get iterator to first selected item
  *
@@ -107,6 +213,42 @@ Selection::Iterator Selection::end() const
 	return Iterator(0);
 }
 
+/**
+ * Get the run of items with the same selection state starting at an index.
+ *
+ * The default implementation returns a run of one item, subclasses
+ * should override this to return the whole run.
+ *
+ * @param index first index of the run
+ * @param last updated to the last index of the run
+ * @returns true if the items in the run are selected
+ */
+bool Selection::selected_run(unsigned int index, unsigned int &last) const
+{
+	last = index;
+	return selected(index);
+}
+
+/**
+ * Check if an index is selected.
+ *
+ * The index should be greater than or equal to the index of the
+ * previous call for the best performance.
+ *
+ * @param index to check
+ * @returns true if the index is selected
+ */
+bool Selection::Cursor::selected(unsigned int index)
+{
+	if (_selection == 0) return false;
+	if (index < _from || index > _to)
+	{
+		_from = index;
+		_selected = _selection->selected_run(index, _to);
+	}
+	return _selected;
+}
+
 /**
  * Copy constructor
  *
@@ -199,6 +341,28 @@ Selection::Iterator Selection::Iterator::operator++(int)
 }
 
 
+/**
+ * Get the run of items with the same selection state starting at an index
+ *
+ * @param index first index of the run
+ * @param last updated to the last index of the run
+ * @returns true if the items in the run are selected
+ */
+bool SingleSelection::selected_run(unsigned int index, unsigned int &last) const
+{
+	if (_selected == NO_SELECTION || index > _selected)
+	{
+		last = NO_SELECTION - 1;
+		return false;
+	} else if (index == _selected)
+	{
+		last = index;
+		return true;
+	}
+	last = _selected - 1;
+	return false;
+}
+
 /**
  * Called by the object selection is on when new items have
  * been inserted and selected item need to be moved
@@ -272,16 +436,16 @@ void SingleSelection::set(unsigned int index)
 {
    if (index != _selected)
    {
+		std::vector<SelectionChangedEvent> changes;
 		if (_selected != NO_SELECTION)
 		{
-			unsigned int old = _selected;
-			_selected = NO_SELECTION;
-			fire_event(old, false, false);
+			changes.push_back(SelectionChangedEvent(_selected, _selected, false, false));
 		}
 
 		_selected = index;
+		changes.push_back(SelectionChangedEvent(_selected, _selected, true, true));
 
-		fire_event(_selected, true, true);
+		fire_changes(changes);
    }
 }
 
@@ -373,390 +537,486 @@ void SingleSelection::toggle(unsigned int from, unsigned int to)
 
 
 /**
- * Find the first range where the last value is ge to the given index
+ * Copy constructor
  */
-MultiSelection::RangeIterator MultiSelection::find_last_ge(unsigned int index)
+MultiSelection::MultiSelection(const MultiSelection &other) : Selection(other),
+	_first(other._first), _last(other._last),
+	_root(copy_tree(other._root)), _seed(other._seed)
 {
-	if (_first == NO_SELECTION || index > _last) return _selected.end();
-	if (index <= _first) return _selected.begin();
-	RangeIterator i = _selected.begin();
-	while (index > i->second) i++;
-	return i;
 }
 
 /**
- * Fire events from an arrays of changes to the selection
- *
- * Also ensures last change is marked as final
+ * Destructor
  */
-void MultiSelection::fire_changes(std::vector<SelectionChangedEvent> &changes)
+MultiSelection::~MultiSelection()
 {
-	if (!changes.empty())
-	{
-		changes.back().final(true);
-		std::vector<SelectionChangedEvent>::iterator c;
-		for (c = changes.begin(); c != changes.end(); ++c)
-		{
-			fire_event(*c);
-		}
-	}
+	delete_tree(_root);
 }
 
 /**
- * Check if the given index is selected
+ * Assign the selected items from another selection.
  *
- * @param index to check
- * @return true if index is selected
+ * Listeners are not copied or informed of the change.
  */
-bool MultiSelection::selected(unsigned int index) const
+MultiSelection &MultiSelection::operator=(const MultiSelection &other)
 {
-	if (_first == NO_SELECTION || index < _first || index > _last) return false;
-
-	std::vector<Range>::const_iterator i;
-	for (i = _selected.begin(); i != _selected.end(); ++i)
+	if (this != &other)
 	{
-		if (index < (*i).first) return false;
-		if (index <= (*i).second) return true;
+		RangeNode *root = copy_tree(other._root);
+		delete_tree(_root);
+		_root = root;
+		_first = other._first;
+		_last = other._last;
 	}
+	return *this;
+}
 
-	return false;
+/**
+ * Create a new node with a random priority
+ */
+MultiSelection::RangeNode *MultiSelection::new_node(unsigned int gap, unsigned int length)
+{
+	// xorshift random number generator
+	_seed ^= _seed << 13;
+	_seed ^= _seed >> 17;
+	_seed ^= _seed << 5;
+
+	RangeNode *node = new RangeNode;
+	node->gap = gap;
+	node->length = length;
+	node->priority = _seed;
+	node->left = node->right = 0;
+	update(node);
+	return node;
 }
 
 /**
- * Count number of selected items
+ * Build a tree from a list of ranges in O(n) time
+ *
+ * @param ranges ranges in order that do not touch
+ * @param from position the tree will start from
+ * @returns root of new tree
  */
-unsigned int MultiSelection::count() const
+MultiSelection::RangeNode *MultiSelection::build(const std::vector<std::pair<unsigned int, unsigned int> > &ranges, unsigned int from)
 {
-	std::vector<Range>::const_iterator i;
-	unsigned int c = 0;
-	for (i = _selected.begin(); i != _selected.end(); ++i)
+	std::vector<RangeNode *> spine;
+	unsigned int pos = from;
+	for (std::vector<std::pair<unsigned int, unsigned int> >::const_iterator i = ranges.begin();
+		i != ranges.end(); ++i)
 	{
-		c += (*i).second - (*i).first + 1;
+		RangeNode *node = new_node(i->first - pos, i->second - i->first + 1);
+		pos = i->second + 1;
+
+		// Keep the right spine in priority order
+		RangeNode *last = 0;
+		while (!spine.empty() && spine.back()->priority < node->priority)
+		{
+			last = spine.back();
+			spine.pop_back();
+			update(last);
+		}
+		node->left = last;
+		if (!spine.empty()) spine.back()->right = node;
+		spine.push_back(node);
 	}
+	if (spine.empty()) return 0;
 
-	return c;
+	while (spine.size() > 1)
+	{
+		update(spine.back());
+		spine.pop_back();
+	}
+	update(spine.front());
+	return spine.front();
 }
 
 /**
- * Data has been inserted so adjust selection
+ * Update the totals of a node from its children
  */
-void MultiSelection::inserted(unsigned int index, unsigned int count)
+void MultiSelection::update(RangeNode *node)
 {
-	if (_first == NO_SELECTION || index > _last) return;
-
-	RangeIterator i = find_last_ge(index);
-	if (i != _selected.end())
+	node->span = node->gap + node->length;
+	node->count = node->length;
+	if (node->left)
 	{
-		if (i->first < index)
-		{
-			Range extra(i->first, index-1);
-			i->first = index;
-			i = _selected.insert(i, extra);
-			i++;
-		}
+		node->span += node->left->span;
+		node->count += node->left->count;
 	}
-	while (i != _selected.end())
+	if (node->right)
 	{
-		i->first += count;
-		i->second += count;
+		node->span += node->right->span;
+		node->count += node->right->count;
 	}
+}
 
-	if (index <= _first) _first += count;
-	_last += count;
+/**
+ * Delete a node and all its children
+ */
+void MultiSelection::delete_tree(RangeNode *node)
+{
+	while (node)
+	{
+		delete_tree(node->left);
+		RangeNode *right = node->right;
+		delete node;
+		node = right;
+	}
 }
 
 /**
- * Data has been removed so adjust selection
+ * Make a copy of a node and all its children
  */
-void MultiSelection::removed(unsigned int index, unsigned int count)
+MultiSelection::RangeNode *MultiSelection::copy_tree(const RangeNode *node)
 {
-	if (_first == NO_SELECTION || index > _last) return;
+	if (node == 0) return 0;
+	RangeNode *copy = new RangeNode(*node);
+	copy->left = copy_tree(node->left);
+	copy->right = copy_tree(node->right);
+	return copy;
+}
 
-	RangeIterator i = find_last_ge(index);
-	if (i != _selected.end())
+/**
+ * Join two trees.
+ *
+ * The first gap in the right tree must already be from the end of
+ * the left tree.
+ */
+MultiSelection::RangeNode *MultiSelection::merge(RangeNode *left, RangeNode *right)
+{
+	if (left == 0) return right;
+	if (right == 0) return left;
+	if (left->priority > right->priority)
 	{
-		if (i->first < index)
-		{
-			if (i->second < i->first + count) i->second = index-1;
-			else i->second -= count;
-			++i;
-		}
+		left->right = merge(left->right, right);
+		update(left);
+		return left;
+	} else
+	{
+		right->left = merge(left, right->left);
+		update(right);
+		return right;
 	}
-	while (i != _selected.end())
+}
+
+/**
+ * Split a tree into the items before a position and the items from it.
+ *
+ * A range that contains the position is cut in two. The first gap of
+ * the right tree is from the position.
+ *
+ * @param node root of tree to split
+ * @param pos position to split at from the start of the tree
+ * @param left updated to the tree before pos
+ * @param right updated to the tree from pos
+ */
+void MultiSelection::split(RangeNode *node, unsigned int pos, RangeNode *&left, RangeNode *&right)
+{
+	if (node == 0)
 	{
-		if (i->second < index + count) i = _selected.erase(i);
-		else
-		{
-			i->first -= count;
-			i->second -= count;
-			++i;
-		}
+		left = right = 0;
+		return;
 	}
 
-	if (_selected.empty())
+	unsigned int left_span = span(node->left);
+	if (pos <= left_span)
 	{
-		_first = _last = NO_SELECTION;
+		split(node->left, pos, left, node->left);
+		update(node);
+		right = node;
+	} else if (pos - left_span <= node->gap)
+	{
+		// Split in the gap before the range
+		left = node->left;
+		node->left = 0;
+		node->gap -= pos - left_span;
+		update(node);
+		right = node;
+	} else if (pos - left_span - node->gap < node->length)
+	{
+		// Split the range in two
+		unsigned int in_range = pos - left_span - node->gap;
+		RangeNode *tail = new RangeNode;
+		tail->gap = 0;
+		tail->length = node->length - in_range;
+		tail->priority = node->priority;
+		tail->left = 0;
+		tail->right = node->right;
+		update(tail);
+		node->length = in_range;
+		node->right = 0;
+		update(node);
+		left = node;
+		right = tail;
 	} else
 	{
-		_first = _selected.front().first;
-		_last = _selected.back().second;
+		split(node->right, pos - left_span - node->gap - node->length, node->right, right);
+		update(node);
+		left = node;
 	}
 }
 
 /**
- * Clear the selection
+ * Add to the gap before the first range in a tree
  */
-void MultiSelection::clear()
+void MultiSelection::add_first_gap(RangeNode *node, unsigned int diff)
 {
-	if (_first == NO_SELECTION) return;
-
-	std::vector<Range> old(_selected.begin(), _selected.end());
-	_selected.clear();
-	_first = _last = NO_SELECTION;
-	std::vector<Range>::iterator i = old.begin();
-	SelectionChangedEvent e;
-	e.selected(false);
-	e.final(false);
-	while (i != old.end())
+	while (node)
 	{
-		e.first(i->first);
-		e.last(i->second);
-		++i;
-		if (i == old.end()) e.final(true);
-		fire_event(e);
+		node->span += diff;
+		if (node->left == 0) node->gap += diff;
+		node = node->left;
 	}
 }
 
 /**
- * Modifiy the selection so it only consist of the given index
+ * Join a tree to the right of another, joining ranges that touch
  *
- * @param index new selection
+ * @param left tree to go first
+ * @param right tree to go second with its first gap from right_start
+ * @param right_start position of the start of the right tree
+ * from the start of the left tree.
+ * @returns root of the joined tree
  */
-void MultiSelection::set(unsigned int index)
+MultiSelection::RangeNode *MultiSelection::concat(RangeNode *left, RangeNode *right, unsigned int right_start)
 {
-	if (_first == NO_SELECTION)
-	{
-		_first = index;
-		_last = index;
-		_selected.push_back(Range(index, index));
-		fire_event(index, true, true);
-	} else
-	{
-		RangeIterator i = _selected.begin();
-		std::vector<SelectionChangedEvent> changes;
+	if (right == 0) return left;
+	add_first_gap(right, right_start - span(left));
+	if (left == 0) return right;
 
-		while (i != _selected.end())
-		{
-			if (i->first > index || i->second < index)
-			{
-				changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
-				i = _selected.erase(i);
-			} else
-			{
-				if (index > i->first)
-				{
-					changes.push_back(SelectionChangedEvent(i->first, index-1, false, false));
-					i->first = index;
-				}
-				if (index < i->second)
-				{
-					changes.push_back(SelectionChangedEvent(index+1, i->second, false, false));
-					i->second = index;
-				}
-				++i;
-			}
-		}
-		if (_selected.empty())
+	RangeNode *first = right;
+	while (first->left) first = first->left;
+	if (first->gap == 0)
+	{
+		// First range follows on from the last range on the left
+		unsigned int length = first->length;
+		RangeNode *rest;
+		split(right, length, first, rest);
+		delete_tree(first);
+
+		RangeNode *last = left;
+		while (last->right) last = last->right;
+		last->length += length;
+		for (RangeNode *node = left; node != last; node = node->right)
 		{
-			_selected.push_back(Range(index, index));
-			changes.push_back(SelectionChangedEvent(index, index, true, true));
+			node->span += length;
+			node->count += length;
 		}
-		_first = index;
-		_last = index;
-
-		fire_changes(changes);
+		update(last);
+		right = rest;
 	}
+
+	return merge(left, right);
 }
 
 /**
- * Add the index to the selection
+ * Add the ranges in a tree to a list
+ *
+ * @param node root of the tree
+ * @param start position of the start of the tree, updated to the end
+ * @param result list to add the first and last index of each range to
  */
-void MultiSelection::select(unsigned int index)
+void MultiSelection::ranges(const RangeNode *node, unsigned int &start, std::vector<std::pair<unsigned int, unsigned int> > &result)
 {
-	if (_first == NO_SELECTION)
-	{
-		_first = index;
-		_last = index;
-		_selected.push_back(Range(index, index));
-		fire_event(index, true, true);
-	} else if (index > _last)
+	while (node)
 	{
-		if (index == _last + 1)
-		{
-			_selected.back().second = index;
-		} else
-		{
-			_selected.push_back(Range(index, index));
-		}
-		_last = index;
-		fire_event(index, true, true);
-	} else if (index < _first)
+		ranges(node->left, start, result);
+		start += node->gap;
+		result.push_back(std::pair<unsigned int, unsigned int>(start, start + node->length - 1));
+		start += node->length;
+		node = node->right;
+	}
+}
+
+/**
+ * Update the first and last selected items from the ranges
+ */
+void MultiSelection::update_first_last()
+{
+	if (_root == 0)
 	{
-		if (index + 1 == _first)
-		{
-			_selected.front().first = index;
-		} else
-		{
-			_selected.insert(_selected.begin(), Range(index, index));
-		}
-		_first = index;
-		fire_event(index, true, true);
+		_first = _last = NO_SELECTION;
 	} else
 	{
-		RangeIterator i;
-		if (index == 0) i = _selected.begin();
-		else i = find_last_ge(index - 1);
-		// will never return _selected.end() as we've eliminated this above
-		if (index < i->first)
-		{
-			if (index + 1 == i->first)
-			{
-				i->first = index;
-			} else
-			{
-				_selected.insert(i, Range(index, index));
-			}
-			fire_event(index, true, true);
-		} else if (index == i->second + 1)
-		{
-			RangeIterator check(i);
-			++check;
-			if (index + 1 == check->first)
-			{
-				i->second = check->second;
-				_selected.erase(check);
-			} else
-			{
-				i->second = index;
-			}
-			fire_event(index, true, true);
-		}
+		const RangeNode *node = _root;
+		while (node->left) node = node->left;
+		_first = node->gap;
+		_last = _root->span - 1;
 	}
 }
 
 /**
- * Remove selection from given index
+ * Check if the given index is selected
+ *
+ * @param index to check
+ * @return true if index is selected
  */
-void MultiSelection::deselect(unsigned int index)
+bool MultiSelection::selected(unsigned int index) const
 {
-	RangeIterator i = find_last_ge(index);
-	if (i != _selected.end() && index >= i->first)
+	if (_first == NO_SELECTION || index < _first || index > _last) return false;
+
+	const RangeNode *node = _root;
+	unsigned int pos = index;
+	while (node)
 	{
-		if (i->first == index)
+		unsigned int left_span = span(node->left);
+		if (pos < left_span)
 		{
-			if (i->second == index)
-			{
-				_selected.erase(i);
-				if (_selected.empty())
-				{
-					_first = _last = NO_SELECTION;
-				} else
-				{
-					_first = _selected.front().first;
-					_last = _selected.back().second;
-				}
-			} else
-			{
-				i->first++;
-				if (_first == index) _first++;
-			}
-		} else if (i->second == index)
-		{
-			if (i->second == _last) _last--;
-			i->second--;
+			node = node->left;
 		} else
 		{
-			Range front(i->first, index - 1);
-			i->first = index + 1;
-			_selected.insert(i, front);
+			pos -= left_span;
+			if (pos < node->gap) return false;
+			pos -= node->gap;
+			if (pos < node->length) return true;
+			pos -= node->length;
+			node = node->right;
 		}
-		fire_event(index, false, true);
 	}
+
+	return false;
 }
 
 /**
- * Toggle the selected index
+ * Get the run of items with the same selection state starting at an index
+ *
+ * @param index first index of the run
+ * @param last updated to the last index of the run
+ * @returns true if the items in the run are selected
  */
-void MultiSelection::toggle(unsigned int index)
+bool MultiSelection::selected_run(unsigned int index, unsigned int &last) const
 {
-	if (_first == NO_SELECTION || index < _first || index > _last) select(index);
-	else if (index == _first)
+	if (_first == NO_SELECTION || index > _last)
+	{
+		last = NO_SELECTION - 1;
+		return false;
+	}
+
+	const RangeNode *node = _root;
+	unsigned int start = 0; // Position of the start of node
+	while (node)
 	{
-		if (index == _last)
+		unsigned int left_span = span(node->left);
+		if (index < start + left_span)
 		{
-			_selected.clear();
-			_first = _last = NO_SELECTION;
+			node = node->left;
 		} else
 		{
-			RangeIterator i = _selected.begin();
-			i->first++;
-			if (i->first > i->second) _selected.erase(i);
-			_first = _selected.front().first;
-		}
-		fire_event(index, false, true);
-	} else if (index == _last)
-	{
-		if (_selected.back().second == _selected.back().first) _selected.pop_back();
-		else _selected.back().second--;
-		_last = _selected.back().second;
-		fire_event(index, false, true);
-	} else
-	{
-		RangeIterator i;
-		if (index == 0) i = _selected.begin();
-		else i = find_last_ge(index - 1);
-
-		if (index < i->first)
-		{
-			if (index + 1 == i->first)
-			{
-				i->first = index;
-			} else
+			unsigned int range_first = start + left_span + node->gap;
+			if (index < range_first)
 			{
-				Range r(index, index);
-				_selected.insert(i, r);
+				last = range_first - 1;
+				return false;
 			}
-			fire_event(index, true, true);
-		} else if (index == i->second + 1)
-		{
-			RangeIterator check(i);
-			++check;
-			if (index + 1 == check->first)
-			{
-				i->second = check->second;
-				_selected.erase(check);
-			} else
+			if (index < range_first + node->length)
 			{
-				i->second = index;
+				last = range_first + node->length - 1;
+				return true;
 			}
-			fire_event(index, true, true);
-		} else if (index == i->first)
-		{
-			i->first++;
-			if (i->first > i->second) _selected.erase(i);
-			fire_event(index, false, true);
-		} else if (index == i->second)
-		{
-			i->second--;
-			fire_event(index, false, true);
-		} else
-		{
-			Range r(i->first, index - 1);
-			i->first = index + 1;
-			_selected.insert(i, r);
-			fire_event(index, false, true);
+			start = range_first + node->length;
+			node = node->right;
 		}
 	}
+
+	// Can't get here as index <= _last
+	last = NO_SELECTION - 1;
+	return false;
+}
+
+/**
+ * Count number of selected items
+ */
+unsigned int MultiSelection::count() const
+{
+	return _root ? _root->count : 0;
+}
+
+/**
+ * Data has been inserted so adjust selection
+ */
+void MultiSelection::inserted(unsigned int index, unsigned int count)
+{
+	if (_first == NO_SELECTION || index > _last || count == 0) return;
+
+	RangeNode *left, *right;
+	split(_root, index, left, right);
+	add_first_gap(right, count);
+	_root = concat(left, right, index);
+
+	update_first_last();
+}
+
+/**
+ * Data has been removed so adjust selection
+ */
+void MultiSelection::removed(unsigned int index, unsigned int count)
+{
+	if (_first == NO_SELECTION || index > _last || count == 0) return;
+
+	RangeNode *left, *rest, *middle, *right;
+	split(_root, index, left, rest);
+	split(rest, count, middle, right);
+	delete_tree(middle);
+	_root = concat(left, right, index);
+
+	update_first_last();
+}
+
+/**
+ * Clear the selection
+ */
+void MultiSelection::clear()
+{
+	if (_first == NO_SELECTION) return;
+
+	std::vector<std::pair<unsigned int, unsigned int> > selected;
+	unsigned int start = 0;
+	ranges(_root, start, selected);
+
+	std::vector<SelectionChangedEvent> changes;
+	changes.reserve(selected.size());
+	for (unsigned int j = 0; j < selected.size(); j++)
+	{
+		changes.push_back(SelectionChangedEvent(selected[j].first, selected[j].second, false, false));
+	}
+	delete_tree(_root);
+	_root = 0;
+	_first = _last = NO_SELECTION;
+
+	fire_changes(changes);
+}
+
+/**
+ * Modifiy the selection so it only consist of the given index
+ *
+ * @param index new selection
+ */
+void MultiSelection::set(unsigned int index)
+{
+	set(index, index);
+}
+
+/**
+ * Add the index to the selection
+ */
+void MultiSelection::select(unsigned int index)
+{
+	select(index, index);
+}
+
+/**
+ * Remove selection from given index
+ */
+void MultiSelection::deselect(unsigned int index)
+{
+	deselect(index, index);
+}
+
+/**
+ * Toggle the selected index
+ */
+void MultiSelection::toggle(unsigned int index)
+{
+	toggle(index, index);
 }
 
 /**
@@ -764,48 +1024,47 @@ void MultiSelection::toggle(unsigned int index)
  */
 void MultiSelection::set(unsigned int from, unsigned int to)
 {
-	if (_first == NO_SELECTION)
-	{
-		_first = from;
-		_last = to;
-		_selected.push_back(Range(from, to));
-		fire_event(from, to, true, true);
-	} else
-	{
-		RangeIterator i = _selected.begin();
-		std::vector<SelectionChangedEvent> changes;
+	std::vector<SelectionChangedEvent> changes;
+	std::vector<std::pair<unsigned int, unsigned int> > selected;
+	unsigned int start = 0;
+	ranges(_root, start, selected);
+	unsigned int next = from;
 
-		while (i != _selected.end())
+	for (std::vector<std::pair<unsigned int, unsigned int> >::iterator i = selected.begin(); i != selected.end(); ++i)
+	{
+		if (i->first < from)
 		{
-			if (i->first > to || i->second < from)
-			{
-				changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
-				i = _selected.erase(i);
-			} else
+			changes.push_back(SelectionChangedEvent(i->first, std::min(i->second, from-1), false, false));
+		}
+		if (i->first <= to && i->second >= from)
+		{
+			if (i->first > next)
 			{
-				if (from > i->first)
-				{
-					changes.push_back(SelectionChangedEvent(i->first, from-1, false, false));
-					i->first = from;
-				}
-				if (to < i->second)
-				{
-					changes.push_back(SelectionChangedEvent(to+1, i->second, false, false));
-					i->second = to;
-				}
-				++i;
+				changes.push_back(SelectionChangedEvent(next, i->first - 1, true, false));
 			}
+			next = std::min(i->second, to) + 1;
 		}
-		if (_selected.empty())
+		if (i->second > to)
 		{
-			_selected.push_back(Range(from, to));
-			changes.push_back(SelectionChangedEvent(from, to, true, true));
+			if (next <= to)
+			{
+				changes.push_back(SelectionChangedEvent(next, to, true, false));
+				next = to + 1;
+			}
+			changes.push_back(SelectionChangedEvent(std::max(i->first, to+1), i->second, false, false));
 		}
-		_first = from;
-		_last = to;
-
-		fire_changes(changes);
 	}
+	if (next <= to)
+	{
+		changes.push_back(SelectionChangedEvent(next, to, true, false));
+	}
+
+	delete_tree(_root);
+	_root = new_node(from, to - from + 1);
+	_first = from;
+	_last = to;
+
+	fire_changes(changes);
 }
 
 /**
@@ -813,78 +1072,39 @@ void MultiSelection::set(unsigned int from, unsigned int to)
  */
 void MultiSelection::select(unsigned int from, unsigned int to)
 {
-	if (_first == NO_SELECTION)
-	{
-		_first = from;
-		_last = to;
-		Range r(from,to);
-		_selected.push_back(r);
-		fire_event(from, to, true, true);
-	} else if (to < _first)
+	unsigned int run_last;
+	if (selected_run(from, run_last) && run_last >= to) return; // Already selected
+
+	RangeNode *left, *rest, *middle, *right;
+	split(_root, from, left, rest);
+	split(rest, to - from + 1, middle, right);
+
+	// Newly selected items are the gaps between the ranges
+	std::vector<std::pair<unsigned int, unsigned int> > selected;
+	unsigned int next = from;
+	ranges(middle, next, selected);
+	delete_tree(middle);
+
+	std::vector<SelectionChangedEvent> changes;
+	next = from;
+	for (std::vector<std::pair<unsigned int, unsigned int> >::iterator i = selected.begin(); i != selected.end(); ++i)
 	{
-		if (to + 1 == _first)
+		if (i->first > next)
 		{
-			_selected.front().first = from;
-		} else
-		{
-			Range r(from,to);
-			_selected.insert(_selected.begin(), r);
+			changes.push_back(SelectionChangedEvent(next, i->first - 1, true, false));
 		}
-		_first = from;
-		fire_event(from, to, true, true);
-	} else if (from > _last)
-	{
-		if (from == _last + 1)
-		{
-			_selected.back().second = to;
-		} else
-		{
-			Range r(from, to);
-			_selected.push_back(r);
-		}
-		_last = to;
-		fire_event(from, to, true, true);
-	} else
+		next = i->second + 1;
+	}
+	if (next <= to)
 	{
-		RangeIterator i;
-		std::vector<SelectionChangedEvent> changes;
+		changes.push_back(SelectionChangedEvent(next, to, true, false));
+	}
 
-		if (from == 0) i = _selected.begin();
-		else i= find_last_ge(from - 1);
+	middle = new_node(0, to - from + 1);
+	_root = concat(left, concat(middle, right, to - from + 1), from);
+	update_first_last();
 
-		if (from < i->first )
-		{
-			changes.push_back(SelectionChangedEvent(from, i->first-1, true, false));
-			i->first = from;
-			if (from < _first) _first = from;
-		}
-		if (to > i->second)
-		{
-			if (to > _last) _last = to;
-			unsigned int oldlast = i->second;
-			i->second = to;
-			RangeIterator check = i;
-			check++;
-			while (check != _selected.end() && check->first <= to)
-			{
-				changes.push_back(SelectionChangedEvent(oldlast+1, check->first-1, true, false));
-				oldlast= check->second;
-			}
-
-			if (oldlast > i->second) i->second = oldlast;
-			if (oldlast < to)
-			{
-				changes.push_back(SelectionChangedEvent(oldlast+1, to, true, false));
-			}
-			++i;
-			while (i != _selected.end() && i->second <= to)
-			{
-				i = _selected.erase(i);
-			}
-		}
-
-		fire_changes(changes);
-	}
+	fire_changes(changes);
 }
 
 /**
@@ -894,59 +1114,26 @@ void MultiSelection::deselect(unsigned int from, unsigned int to)
 {
 	if (_first == NO_SELECTION || from > _last || to < _first) return;
 
-	if (from <= _first && to >= _last)
-	{
-		std::vector<SelectionChangedEvent> changes;
-		for (RangeIterator i = _selected.begin(); i != _selected.end(); ++i)
-		{
-			changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
-		}
-		_selected.clear();
-		_first = _last = NO_SELECTION;
-		fire_changes(changes);
-	} else
-	{
-		if (from <= _first) _first = to + 1;
-		if (to >= _last) _last = from - 1;
+	RangeNode *left, *rest, *middle, *right;
+	split(_root, from, left, rest);
+	split(rest, to - from + 1, middle, right);
 
-		RangeIterator i = find_last_ge(from);
+	std::vector<std::pair<unsigned int, unsigned int> > selected;
+	unsigned int start = from;
+	ranges(middle, start, selected);
+	delete_tree(middle);
 
-		if (to >= i->first)
-		{
-			std::vector<SelectionChangedEvent> changes;
-			if (from > i->first)
-			{
-				if (to >= i->second)
-				{
-					changes.push_back(SelectionChangedEvent(from, i->second, false, false));
-					i->second = from - 1;
-					i++;
-				} else
-				{
-					changes.push_back(SelectionChangedEvent(to, from, false, false));
-					i = _selected.insert(i, Range(i->first, to-1));
-					i++;
-					i->first = from + 1;
-				}
-			}
+	std::vector<SelectionChangedEvent> changes;
+	changes.reserve(selected.size());
+	for (std::vector<std::pair<unsigned int, unsigned int> >::iterator i = selected.begin(); i != selected.end(); ++i)
+	{
+		changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
+	}
 
-			while (i != _selected.end() && i->second <= to)
-			{
-				changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
-				i = _selected.erase(i);
-			}
-			if (i != _selected.end())
-			{
-				if (i->second > to)
-				{
-					changes.push_back(SelectionChangedEvent(to, i->second, false, false));
-					i->second = to - 1;
-				}
-			}
+	_root = concat(left, right, to + 1);
+	update_first_last();
 
-			fire_changes(changes);
-		}
-	}
+	fire_changes(changes);
 }
 
 /**
@@ -954,87 +1141,50 @@ void MultiSelection::deselect(unsigned int from, unsigned int to)
  */
 void MultiSelection::toggle(unsigned int from, unsigned int to)
 {
-	if (_first == NO_SELECTION || to < _first || from > _last) select(from, to);
-	else
+	RangeNode *left, *rest, *middle, *right;
+	split(_root, from, left, rest);
+	split(rest, to - from + 1, middle, right);
+
+	std::vector<std::pair<unsigned int, unsigned int> > selected;
+	unsigned int start = from;
+	ranges(middle, start, selected);
+	delete_tree(middle);
+
+	// Selected ranges become the gaps between the old ones
+	std::vector<SelectionChangedEvent> changes;
+	std::vector<std::pair<unsigned int, unsigned int> > replace;
+	unsigned int next = from;
+	for (std::vector<std::pair<unsigned int, unsigned int> >::iterator i = selected.begin(); i != selected.end(); ++i)
 	{
-		RangeIterator i = find_last_ge(from);
-		std::vector<SelectionChangedEvent> changes;
-
-		if (to < i->first)
+		if (i->first > next)
 		{
-			changes.push_back(SelectionChangedEvent(from, to, true, false));
-			i = _selected.insert(i, Range(from, to));
-			++i;
-		} else if (from < i->first)
-		{
-			changes.push_back(SelectionChangedEvent(from, i->first-1, true, false));
-			i = _selected.insert(i, Range(from, i->first-1));
-			++i;
-		}
-		unsigned int last_second = i->second;
-
-		while (i != _selected.end() && i->first <= to)
-		{
-			if (i->first > last_second+1)
-			{
-				changes.push_back(SelectionChangedEvent(last_second+1, i->first-1, true, false));
-				i = _selected.insert(i, Range(last_second+1, i->first - 1));
-				++i;
-			}
-			last_second = i->second;
-			if (i->first < from)
-			{
-				if (i->second <= to)
-				{
-					changes.push_back(SelectionChangedEvent(from, i->second, false, false));
-					i->second = from-1;
-				} else
-				{
-					changes.push_back(SelectionChangedEvent(from, to, false, false));
-					i = _selected.insert(i, Range(i->first, from - 1));
-					i++;
-					i->first = to + 1;
-				}
-			} else if (i->second <= to)
-			{
-				changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
-				i = _selected.erase(i);
-			} else
-			{
-				changes.push_back(SelectionChangedEvent(i->first, to, false, false));
-				i->first = to + 1;
-				++i;
-			}
+			changes.push_back(SelectionChangedEvent(next, i->first - 1, true, false));
+			replace.push_back(std::pair<unsigned int, unsigned int>(next, i->first - 1));
 		}
+		changes.push_back(SelectionChangedEvent(i->first, i->second, false, false));
+		next = i->second + 1;
+	}
+	if (next <= to)
+	{
+		changes.push_back(SelectionChangedEvent(next, to, true, false));
+		replace.push_back(std::pair<unsigned int, unsigned int>(next, to));
+	}
 
-		if (to > last_second)
-		{
-			changes.push_back(SelectionChangedEvent(last_second+1, to, true, false));
-			i = _selected.insert(i, Range(last_second+1, to));
-		}
+	middle = build(replace, from);
+	_root = concat(left, concat(middle, right, to - from + 1), from);
+	update_first_last();
 
-		if (_selected.empty())
-		{
-			_first = _last = NO_SELECTION;
-		} else
-		{
-			_first = _selected.front().first;
-			_last = _selected.back().second;
-		}
-
-		fire_changes(changes);
-	}
+	fire_changes(changes);
 }
 
 /**
- * Construct iterator implementation from iterators
+ * Construct iterator implementation from the root of the ranges tree
  */
-MultiSelection::MultiIteratorImpl::MultiIteratorImpl(ConstRangeIterator start, ConstRangeIterator end)
+MultiSelection::MultiIteratorImpl::MultiIteratorImpl(const RangeNode *root)
 {
-	_current = start;
-	_end = end;
-	if (start == end) _index = NO_SELECTION;
-	else _index = (*start).first;
+	_range_end = 0;
+	for (const RangeNode *node = root; node; node = node->left) _stack.push_back(node);
+	next_range();
 }
 
 /**
@@ -1042,11 +1192,34 @@ MultiSelection::MultiIteratorImpl::MultiIteratorImpl(ConstRangeIterator start, C
  */
 Selection::IteratorImpl *MultiSelection::MultiIteratorImpl::clone()
 {
-	MultiIteratorImpl *copy = new MultiIteratorImpl(_current, _end);
+	MultiIteratorImpl *copy = new MultiIteratorImpl(0);
+	copy->_stack = _stack;
+	copy->_range_end = _range_end;
+	copy->_range_last = _range_last;
 	copy->_index = _index;
 	return copy;
 }
 
+/**
+ * Move to the first item of the next range
+ */
+void MultiSelection::MultiIteratorImpl::next_range()
+{
+	if (_stack.empty())
+	{
+		_index = NO_SELECTION;
+		return;
+	}
+
+	const RangeNode *range = _stack.back();
+	_stack.pop_back();
+	for (const RangeNode *node = range->right; node; node = node->left) _stack.push_back(node);
+
+	_index = _range_end + range->gap;
+	_range_last = _index + range->length - 1;
+	_range_end = _range_last + 1;
+}
+
 /**
  * Advance iterator
  */
@@ -1054,14 +1227,8 @@ void MultiSelection::MultiIteratorImpl::next()
 {
 	if (_index != NO_SELECTION)
 	{
-		if (_index == _current->second)
-		{
-			if (++_current == _end) _index = NO_SELECTION;
-			else _index = _current->first;
-		} else
-		{
-			_index++;
-		}
+		if (_index == _range_last) next_range();
+		else _index++;
 	}
 }
 
@@ -1070,7 +1237,7 @@ void MultiSelection::MultiIteratorImpl::next()
  */
 Selection::IteratorImpl *MultiSelection::get_iterator_impl() const
 {
-	return new MultiIteratorImpl(_selected.begin(), _selected.end());
+	return new MultiIteratorImpl(_root);
 }
 
 
@@ -138,6 +138,81 @@ public:
 	virtual void selection_changed(const SelectionChangedEvent &event) = 0;
 };
 
+/**
+ * Class with all the changes made to a selection by a single action.
+ *
+ * The changes are sorted by index, do not overlap and ranges next
+ * to each other with the same selected state are merged.
+ */
+class SelectionChangesEvent
+{
+	const std::vector<SelectionChangedEvent> &_changes;
+
+public:
+	/**
+	 * Construct from a list of merged changes
+	 *
+	 * @param changes sorted list of changes
+	 */
+	SelectionChangesEvent(const std::vector<SelectionChangedEvent> &changes) :
+		_changes(changes) {}
+
+	/**
+	 * Iterator to the changes
+	 */
+	typedef std::vector<SelectionChangedEvent>::const_iterator const_iterator;
+
+	/**
+	 * Returns number of changed ranges
+	 */
+	unsigned int size() const {return _changes.size();}
+
+	/**
+	 * Return a changed range
+	 *
+	 * @param index index of the change from 0 to size()-1.
+	 */
+	const SelectionChangedEvent &operator[](unsigned int index) const {return _changes[index];}
+
+	/**
+	 * Returns an iterator to the first change
+	 */
+	const_iterator begin() const {return _changes.begin();}
+
+	/**
+	 * Returns an iterator to the position after the last change
+	 */
+	const_iterator end() const {return _changes.end();}
+
+	/**
+	 * Returns the lowest index that was changed
+	 */
+	unsigned int first() const {return _changes.front().first();}
+
+	/**
+	 * Returns the highest index that was changed
+	 */
+	unsigned int last() const {return _changes.back().last();}
+};
+
+/**
+ * Listener for all the selection changes caused by a single action
+ *
+ * This is called once with all the changes, so is more efficient
+ * than a SelectionListener when a lot of changes are made at once.
+ */
+class SelectionChangesListener : public Listener
+{
+public:
+	SelectionChangesListener() {}
+	virtual ~SelectionChangesListener() {}
+
+	/**
+	 * Called with the changes to the selection
+	 */
+	virtual void selection_changes(const SelectionChangesEvent &event) = 0;
+};
+
 /**
  * Base class for selections of one or more indices from a zero based
  * range.
@@ -146,6 +221,7 @@ class Selection
 {
 private:
 	std::vector<SelectionListener *> _listeners;
+	std::vector<SelectionChangesListener *> _changes_listeners;
 
 protected:
 	/**
@@ -156,6 +232,7 @@ protected:
 	void fire_event(const SelectionChangedEvent &event);
 	void fire_event(unsigned int index, bool selected, bool final);
 	void fire_event(unsigned int from, unsigned int to, bool selected, bool final);
+	void fire_changes(std::vector<SelectionChangedEvent> &changes);
 
 public:
 	virtual ~Selection() {}
@@ -165,6 +242,8 @@ public:
 	 */
 	void add_listener(SelectionListener *listener);
 	void remove_listener(SelectionListener *listener);
+	void add_changes_listener(SelectionChangesListener *listener);
+	void remove_changes_listener(SelectionChangesListener *listener);
 
 	/**
 	 * Type of selection
@@ -213,6 +292,8 @@ public:
 	 */
 	virtual unsigned int count() const = 0;
 
+	virtual bool selected_run(unsigned int index, unsigned int &last) const;
+
 	/**
 	 * Override to return true if one or more items are selected
 	 */
@@ -403,6 +484,36 @@ public:
 	Iterator begin() const;
 	Iterator end() const;
 
+	/**
+	 * Class to check the selection state of a sequence of
+	 * increasing indices.
+	 *
+	 * The cursor remembers the run of items with the same selection
+	 * state as the last index checked, so the selection only needs
+	 * to be searched again when the index moves out of that run.
+	 * This makes it suitable for use in a redraw loop.
+	 *
+	 * The selection must not be changed while a cursor is in use.
+	 */
+	class Cursor
+	{
+		const Selection *_selection;
+		unsigned int _from;
+		unsigned int _to;
+		bool _selected;
+
+	public:
+		/**
+		 * Construct a cursor for the given selection
+		 *
+		 * @param selection selection to check or 0 if there is
+		 * no selection in which case nothing is selected.
+		 */
+		Cursor(const Selection *selection) : _selection(selection),
+			_from(NO_SELECTION), _to(0), _selected(false) {}
+
+		bool selected(unsigned int index);
+	};
 };
 
 /**
@@ -449,6 +560,8 @@ public:
 	 */
 	virtual unsigned int count() const {return (_selected == NO_SELECTION) ? 0 : 1;}
 
+	virtual bool selected_run(unsigned int index, unsigned int &last) const;
+
 	/**
 	 * Returns true if one or more items are selected
 	 */
@@ -518,18 +631,47 @@ protected:
 
 /**
  * Class to implement multiple selections
+ *
+ * The selected ranges are kept in a balanced tree (a treap) where
+ * each range is stored as the number of unselected items before it
+ * and its length. The position of a range is only known from the
+ * ranges before it, so inserting or removing items only changes the
+ * gap before the first range that moves.
+ *
+ * Checking if an item is selected and inserting or removing items take
+ * O(log R) time where R is the number of ranges. Selecting, deselecting
+ * or toggling a range takes O(log R + k) time where k is the number
+ * of ranges it changes.
  */
 class MultiSelection : public Selection
 {
-	typedef std::pair<unsigned int, unsigned int> Range;
+	//! @cond INTERNAL
+	/**
+	 * Node in the tree of selected ranges
+	 */
+	struct RangeNode
+	{
+		unsigned int gap;      // Unselected items since the end of the previous range
+		unsigned int length;   // Number of items in the range
+		unsigned int span;     // Total of gap + length for the subtree
+		unsigned int count;    // Total of length for the subtree
+		unsigned int priority; // Random priority to keep the tree balanced
+		RangeNode *left;
+		RangeNode *right;
+	};
+	//! @endcond
+
 	unsigned int _first;
 	unsigned int _last;
-	std::vector<Range> _selected;
-	typedef std::vector<Range>::iterator RangeIterator;
-	typedef std::vector<Range>::const_iterator ConstRangeIterator;
+	RangeNode *_root;
+	unsigned int _seed;
+
 public:
-	MultiSelection() : _first(NO_SELECTION), _last(NO_SELECTION) {}
-	virtual ~MultiSelection() {}
+	MultiSelection() : _first(NO_SELECTION), _last(NO_SELECTION), _root(0), _seed(0x9E3779B9u) {}
+	MultiSelection(const MultiSelection &other);
+	virtual ~MultiSelection();
+
+	MultiSelection &operator=(const MultiSelection &other);
 
 	/**
 	 * Returns the type of this selection class
@@ -564,6 +706,8 @@ public:
 	 */
 	virtual unsigned int count() const;
 
+	virtual bool selected_run(unsigned int index, unsigned int &last) const;
+
 	/**
 	 * Returns true if one or more items are selected
 	 */
@@ -600,12 +744,15 @@ protected:
 	 */
 	class MultiIteratorImpl : public IteratorImpl
 	{
-		ConstRangeIterator _current;
-		ConstRangeIterator _end;
+		std::vector<const RangeNode *> _stack;
+		unsigned int _range_end; // One after the last item of the current range
+		unsigned int _range_last;
 		unsigned int _index;
 
+		void next_range();
+
 	public:
-		MultiIteratorImpl(ConstRangeIterator start, ConstRangeIterator end);
+		MultiIteratorImpl(const RangeNode *root);
 		// Return a copy of the implementation
 		virtual IteratorImpl *clone();
 		// return the current index or NO_SELECTION if at end
@@ -617,8 +764,18 @@ protected:
 
 private:
 	// Helper functions
-	RangeIterator find_last_ge(unsigned int index);
-	void fire_changes(std::vector<SelectionChangedEvent> &changes);
+	void update_first_last();
+	RangeNode *new_node(unsigned int gap, unsigned int length);
+	RangeNode *build(const std::vector<std::pair<unsigned int, unsigned int> > &ranges, unsigned int from);
+	static unsigned int span(const RangeNode *node) {return node ? node->span : 0;}
+	static void update(RangeNode *node);
+	static void delete_tree(RangeNode *node);
+	static RangeNode *copy_tree(const RangeNode *node);
+	static RangeNode *merge(RangeNode *left, RangeNode *right);
+	static void split(RangeNode *node, unsigned int pos, RangeNode *&left, RangeNode *&right);
+	static void add_first_gap(RangeNode *node, unsigned int diff);
+	static RangeNode *concat(RangeNode *left, RangeNode *right, unsigned int right_start);
+	static void ranges(const RangeNode *node, unsigned int &start, std::vector<std::pair<unsigned int, unsigned int> > &result);
 
 };
 
@@ -51,6 +51,7 @@ const char ROW_HEIGHT = 40;
  */
 TextView::TextView(tbx::Window window, bool wrap /*= false*/) :
 	_window(window),
+	_redraw(window),
 	_wrap(wrap),
 	_text(0),
 	_size(0),
@@ -205,7 +206,7 @@ void TextView::refresh()
 {
 	BBox all(_margin.left, -_margin.top - _line_end.size() * ROW_HEIGHT,
 			_margin.left + _width, -_margin.top);
-	_window.force_redraw(all);
+	_redraw.invalidate(all);
 }
 
 /**
@@ -330,7 +331,7 @@ void TextView::recalc_layout(const BBox &visible_bounds)
 	if (_line_end.size() > refresh_lines) refresh_lines = _line_end.size();
 	BBox all(_margin.left, -_margin.top - refresh_lines * ROW_HEIGHT,
 			_margin.left + refresh_width, -_margin.top);
-	_window.force_redraw(all);
+	_redraw.invalidate(all);
 }
 
 /**
@@ -33,6 +33,7 @@
 #define TBX_TEXTVIEW_H_
 
 #include "../window.h"
+#include "../deferredredraw.h"
 #include "../redrawlistener.h"
 #include "../openwindowlistener.h"
 #include "../margin.h"
@@ -52,6 +53,7 @@ class TextView :
 {
 private:
 	tbx::Window _window;
+	tbx::DeferredRedraw _redraw;
 	tbx::Margin _margin;
 	bool _wrap;
 	char *_text;
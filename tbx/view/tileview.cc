@@ -30,6 +30,7 @@
  */
 
 #include "tileview.h"
+#include "celllayouts.h"
 
 namespace tbx {
 
@@ -204,35 +205,29 @@ void TileView::redraw(const RedrawEvent &event)
     if (last_col >= (int)_count) last_col = _count - 1;
     if (last_col >= _cols_per_row) last_col = _cols_per_row - 1;
 
-    ItemRenderer::Info cell_info(event);
+    GridCellLayout layout(event.visible_area(), cell_size, _cols_per_row,
+    		_margin.left, -_margin.top, _selection);
 
-	cell_info.bounds.max.y = -first_row * cell_size.height - _margin.top;
-	cell_info.screen.y = event.visible_area().screen_y(cell_info.bounds.max.y);
-	int first_col_x = first_col * cell_size.width + _margin.left;
-	int first_col_scr_x = event.visible_area().screen_x(first_col_x);
-
-    for (int row = first_row; row <= last_row; row++)
+    if (first_col == 0 && last_col == _cols_per_row - 1)
     {
-        cell_info.bounds.min.y = cell_info.bounds.max.y - cell_size.height;
-        cell_info.bounds.min.x = first_col_x;
-        cell_info.screen.y -= cell_size.height;
-        cell_info.screen.x = first_col_scr_x;
-        cell_info.index = row * _cols_per_row + first_col;
-
-        for (int col = first_col; col <= last_col; col++)
+    	// Whole rows visible so render them together
+    	unsigned int first = first_row * _cols_per_row;
+    	unsigned int last = (last_row + 1) * _cols_per_row - 1;
+    	if (last >= _count) last = _count - 1;
+    	if (first <= last)
+    	{
+    		_item_renderer->render_range(ItemRenderer::RangeInfo(event, first, last, layout));
+    	}
+    } else
+    {
+        for (int row = first_row; row <= last_row; row++)
         {
-           if (cell_info.index < _count)
-           {
-        	  cell_info.selected = (_selection) ? _selection->selected(cell_info.index) : false;
-              cell_info.bounds.max.x = cell_info.bounds.min.x + cell_size.width;
-
-              _item_renderer->render(cell_info);
-              cell_info.bounds.min.x = cell_info.bounds.max.x;
-              cell_info.screen.x += cell_size.width;
-              cell_info.index++;
-           }
+        	unsigned int first = row * _cols_per_row + first_col;
+        	unsigned int last = row * _cols_per_row + last_col;
+        	if (last >= _count) last = _count - 1;
+        	if (first > last) break;
+        	_item_renderer->render_range(ItemRenderer::RangeInfo(event, first, last, layout));
         }
-        cell_info.bounds.max.y = cell_info.bounds.min.y;
     }
 }
 
@@ -297,7 +292,7 @@ bool TileView::recalc_layout(const BBox &visible_area)
 
 void TileView::refresh()
 {
-	_window.force_redraw(_window.extent());
+	_redraw.invalidate_all();
 }
 
 /**
@@ -339,7 +334,7 @@ void TileView::inserted(unsigned int where, unsigned int how_many)
 		-last_row * _tile_size.height - _margin.top,
 		_cols_per_row * _tile_size.width + _margin.left,
 		-first_row * _tile_size.height - _margin.top);
-	_window.force_redraw(dirty);
+	_redraw.invalidate(dirty);
 }
 
 /**
@@ -404,7 +399,7 @@ void TileView::removed(unsigned int where, unsigned int how_many)
 		-last_row * old_size.height - _margin.top,
 		_cols_per_row * old_size.width + _margin.left,
 		-first_row * old_size.height - _margin.top);
-	_window.force_redraw(dirty);
+	_redraw.invalidate(dirty);
 }
 
 /**
@@ -492,7 +487,7 @@ void TileView::changed(unsigned int where, unsigned int how_many)
 		-last_row * _tile_size.height - _margin.top,
 		_cols_per_row * _tile_size.width + _margin.left,
 		-first_row * _tile_size.height - _margin.top);
-	_window.force_redraw(dirty);
+	_redraw.invalidate(dirty);
 }
 
 /**
@@ -25,6 +25,8 @@
 #ifndef TBX_VIEWVALUE_H
 #define TBX_VIEWVALUE_H
 
+#include <vector>
+
 namespace tbx
 {
 namespace view
@@ -46,6 +48,24 @@ template<class T> class ItemViewValue
        */
       virtual T value(unsigned int index) const = 0;
 
+      /**
+       * Provide the values for a range of items.
+       *
+       * The default calls value for each item. Override it if the
+       * values can be retrieved more efficiently together.
+       *
+       * @param first index of first value to return
+       * @param last index of last value to return
+       * @param result vector to receive the values, it is
+       * cleared before they are added.
+       */
+      virtual void values(unsigned int first, unsigned int last, std::vector<T> &result) const
+      {
+         result.clear();
+         result.reserve(last - first + 1);
+         for (unsigned int index = first; index <= last; index++)
+            result.push_back(value(index));
+      }
 };
 
 /**
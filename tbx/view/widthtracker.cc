@@ -0,0 +1,345 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "widthtracker.h"
+#include "itemrenderer.h"
+
+namespace tbx {
+
+namespace view {
+
+/**
+ * Construct a copy of another width tracker
+ */
+WidthTracker::WidthTracker(const WidthTracker &other) :
+	_root(copy_tree(other._root)),
+	_seed(other._seed),
+	_counts(other._counts)
+{
+}
+
+/**
+ * Destructor, deletes the stored widths
+ */
+WidthTracker::~WidthTracker()
+{
+	delete_tree(_root);
+}
+
+/**
+ * Assign from another width tracker
+ */
+WidthTracker &WidthTracker::operator=(const WidthTracker &other)
+{
+	if (this != &other)
+	{
+		WidthNode *root = copy_tree(other._root);
+		_counts = other._counts;
+		delete_tree(_root);
+		_root = root;
+		_seed = other._seed;
+	}
+	return *this;
+}
+
+/**
+ * Remove all the widths
+ */
+void WidthTracker::clear()
+{
+	delete_tree(_root);
+	_root = 0;
+	_counts.clear();
+}
+
+/**
+ * Measure all the items
+ *
+ * @param renderer renderer to measure the items
+ * @param count number of items
+ */
+void WidthTracker::measure(ItemRenderer *renderer, unsigned int count)
+{
+	clear();
+	inserted(renderer, 0, count);
+}
+
+/**
+ * Measure items that have been inserted
+ *
+ * @param renderer renderer to measure the items
+ * @param where index of first item inserted
+ * @param how_many number of items inserted
+ */
+void WidthTracker::inserted(ItemRenderer *renderer, unsigned int where, unsigned int how_many)
+{
+	if (how_many == 0) return;
+	WidthNode *middle = build(renderer, where, how_many);
+	WidthNode *left, *right;
+	split(_root, where, left, right);
+	_root = merge(merge(left, middle), right);
+}
+
+/**
+ * Remove the widths of items that have been removed
+ *
+ * @param where index of first item removed
+ * @param how_many number of items removed
+ */
+void WidthTracker::removed(unsigned int where, unsigned int how_many)
+{
+	if (how_many == 0) return;
+	WidthNode *left, *rest, *middle, *right;
+	split(_root, where, left, rest);
+	split(rest, how_many, middle, right);
+	remove_tree(middle);
+	_root = merge(left, right);
+}
+
+/**
+ * Measure items that have changed
+ *
+ * @param renderer renderer to measure the items
+ * @param where index of first item changed
+ * @param how_many number of items changed
+ */
+void WidthTracker::changed(ItemRenderer *renderer, unsigned int where, unsigned int how_many)
+{
+	if (how_many == 0) return;
+	WidthNode *middle = build(renderer, where, how_many);
+	WidthNode *left, *rest, *old, *right;
+	split(_root, where, left, rest);
+	split(rest, how_many, old, right);
+	remove_tree(old);
+	_root = merge(merge(left, middle), right);
+}
+
+/**
+ * Create a new node with a random priority
+ */
+WidthTracker::WidthNode *WidthTracker::new_node(unsigned int width, unsigned int length)
+{
+	// xorshift random number generator
+	_seed ^= _seed << 13;
+	_seed ^= _seed >> 17;
+	_seed ^= _seed << 5;
+
+	WidthNode *node = new WidthNode;
+	node->width = width;
+	node->length = length;
+	node->size = length;
+	node->priority = _seed;
+	node->left = node->right = 0;
+	return node;
+}
+
+/**
+ * Measure items and build a tree of their widths in O(n) time.
+ *
+ * The widths are added to the counts.
+ *
+ * @param renderer renderer to measure the items
+ * @param where index of first item to measure
+ * @param how_many number of items to measure, must not be 0
+ * @returns root of new tree
+ */
+WidthTracker::WidthNode *WidthTracker::build(ItemRenderer *renderer, unsigned int where, unsigned int how_many)
+{
+	std::vector<WidthNode *> spine;
+	unsigned int run_width = renderer->width(where);
+	unsigned int run_length = 1;
+
+	// Items of the same width next to each other share a node
+	for (unsigned int row = where + 1; row < where + how_many; row++)
+	{
+		unsigned int width = renderer->width(row);
+		if (width == run_width)
+		{
+			run_length++;
+		} else
+		{
+			add_run(spine, run_width, run_length);
+			run_width = width;
+			run_length = 1;
+		}
+	}
+	add_run(spine, run_width, run_length);
+
+	while (spine.size() > 1)
+	{
+		update(spine.back());
+		spine.pop_back();
+	}
+	update(spine.front());
+	return spine.front();
+}
+
+/**
+ * Add a run of widths to the end of a tree being built
+ *
+ * @param spine nodes down the right hand side of the tree
+ * @param width width of the items in the run
+ * @param length number of items in the run
+ */
+void WidthTracker::add_run(std::vector<WidthNode *> &spine, unsigned int width, unsigned int length)
+{
+	WidthNode *node = new_node(width, length);
+	_counts[width] += length;
+
+	// Keep the right spine in priority order
+	WidthNode *last = 0;
+	while (!spine.empty() && spine.back()->priority < node->priority)
+	{
+		last = spine.back();
+		spine.pop_back();
+		update(last);
+	}
+	node->left = last;
+	if (!spine.empty()) spine.back()->right = node;
+	spine.push_back(node);
+}
+
+/**
+ * Remove the widths in a tree from the counts and delete it
+ */
+void WidthTracker::remove_tree(WidthNode *node)
+{
+	while (node)
+	{
+		remove_tree(node->left);
+		std::map<unsigned int, unsigned int>::iterator found = _counts.find(node->width);
+		found->second -= node->length;
+		if (found->second == 0) _counts.erase(found);
+		WidthNode *right = node->right;
+		delete node;
+		node = right;
+	}
+}
+
+/**
+ * Update the total of a node from its children
+ */
+void WidthTracker::update(WidthNode *node)
+{
+	node->size = node->length + size(node->left) + size(node->right);
+}
+
+/**
+ * Delete a node and all its children
+ */
+void WidthTracker::delete_tree(WidthNode *node)
+{
+	while (node)
+	{
+		delete_tree(node->left);
+		WidthNode *right = node->right;
+		delete node;
+		node = right;
+	}
+}
+
+/**
+ * Make a copy of a node and all its children
+ */
+WidthTracker::WidthNode *WidthTracker::copy_tree(const WidthNode *node)
+{
+	if (node == 0) return 0;
+	WidthNode *copy = new WidthNode(*node);
+	copy->left = copy_tree(node->left);
+	copy->right = copy_tree(node->right);
+	return copy;
+}
+
+/**
+ * Join two trees with all the items in the left tree before
+ * the items in the right tree.
+ */
+WidthTracker::WidthNode *WidthTracker::merge(WidthNode *left, WidthNode *right)
+{
+	if (left == 0) return right;
+	if (right == 0) return left;
+	if (left->priority > right->priority)
+	{
+		left->right = merge(left->right, right);
+		update(left);
+		return left;
+	} else
+	{
+		right->left = merge(left, right->left);
+		update(right);
+		return right;
+	}
+}
+
+/**
+ * Split a tree into the items before a position and the items from it.
+ *
+ * A run that contains the position is cut in two.
+ *
+ * @param node root of tree to split
+ * @param pos position to split at from the start of the tree
+ * @param left updated to the tree before pos
+ * @param right updated to the tree from pos
+ */
+void WidthTracker::split(WidthNode *node, unsigned int pos, WidthNode *&left, WidthNode *&right)
+{
+	if (node == 0)
+	{
+		left = right = 0;
+		return;
+	}
+
+	unsigned int left_size = size(node->left);
+	if (pos <= left_size)
+	{
+		split(node->left, pos, left, node->left);
+		update(node);
+		right = node;
+	} else if (pos - left_size < node->length)
+	{
+		// Split the run in two
+		unsigned int in_run = pos - left_size;
+		WidthNode *tail = new WidthNode;
+		tail->width = node->width;
+		tail->length = node->length - in_run;
+		tail->priority = node->priority;
+		tail->left = 0;
+		tail->right = node->right;
+		update(tail);
+		node->length = in_run;
+		node->right = 0;
+		update(node);
+		left = node;
+		right = tail;
+	} else
+	{
+		split(node->right, pos - left_size - node->length, node->right, right);
+		update(node);
+		left = node;
+	}
+}
+
+}
+
+}
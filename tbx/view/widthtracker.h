@@ -0,0 +1,116 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef TBX_WIDTHTRACKER_H_
+#define TBX_WIDTHTRACKER_H_
+
+#include <map>
+#include <vector>
+
+namespace tbx {
+
+namespace view {
+
+class ItemRenderer;
+
+//! @cond INTERNAL
+
+/**
+ * Class to keep track of the widths of all the items in a view
+ * so the maximum width can be found without measuring all the
+ * items again.
+ *
+ * The widths are stored as runs of items with the same width in a
+ * tree ordered by position (a treap with random priorities to keep
+ * it balanced), along with a count of the items of each width.
+ * Only the items that are inserted or changed need to be measured.
+ *
+ * Inserting, removing or changing k items takes O(k + log N) time
+ * as the widths after them do not move. Finding the maximum width is
+ * O(log W), where W is the number of different widths.
+ */
+class WidthTracker
+{
+	/**
+	 * Node in the tree of runs of widths
+	 */
+	struct WidthNode
+	{
+		unsigned int width;    // Width of the items in the run
+		unsigned int length;   // Number of items in the run
+		unsigned int size;     // Total of length for the subtree
+		unsigned int priority; // Random priority to keep the tree balanced
+		WidthNode *left;
+		WidthNode *right;
+	};
+
+	WidthNode *_root;
+	unsigned int _seed;
+	std::map<unsigned int, unsigned int> _counts;
+
+public:
+	WidthTracker() : _root(0), _seed(0x9E3779B9u) {}
+	WidthTracker(const WidthTracker &other);
+	~WidthTracker();
+
+	WidthTracker &operator=(const WidthTracker &other);
+
+	void clear();
+	void measure(ItemRenderer *renderer, unsigned int count);
+	void inserted(ItemRenderer *renderer, unsigned int where, unsigned int how_many);
+	void removed(unsigned int where, unsigned int how_many);
+	void changed(ItemRenderer *renderer, unsigned int where, unsigned int how_many);
+
+	/**
+	 * Get the number of items tracked
+	 */
+	unsigned int count() const {return size(_root);}
+
+	/**
+	 * Get the width of the widest item
+	 *
+	 * @returns maximum width or 0 if there are no items
+	 */
+	unsigned int max_width() const {return _counts.empty() ? 0 : _counts.rbegin()->first;}
+
+private:
+	WidthNode *new_node(unsigned int width, unsigned int length);
+	WidthNode *build(ItemRenderer *renderer, unsigned int where, unsigned int how_many);
+	void add_run(std::vector<WidthNode *> &spine, unsigned int width, unsigned int length);
+	void remove_tree(WidthNode *node);
+	static unsigned int size(const WidthNode *node) {return node ? node->size : 0;}
+	static void update(WidthNode *node);
+	static void delete_tree(WidthNode *node);
+	static WidthNode *copy_tree(const WidthNode *node);
+	static WidthNode *merge(WidthNode *left, WidthNode *right);
+	static void split(WidthNode *node, unsigned int pos, WidthNode *&left, WidthNode *&right);
+};
+
+//! @endcond
+
+}
+
+}
+
+#endif
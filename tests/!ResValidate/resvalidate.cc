@@ -0,0 +1,271 @@
+/*
+ * tbx RISC OS toolbox library
+ *
+ * Copyright (C) 2012 Alan Buckley   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * resvalidate - check the structure of a number of resource files.
+ *
+ * The files are shared between a number of worker threads that
+ * each use their own ResValidator.
+ */
+
+#include "tbx/res/resvalidator.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <pthread.h>
+#if defined(__LP64__)
+#include <malloc.h>
+#endif
+
+using namespace tbx::res;
+using namespace std;
+
+/**
+ * Result of checking one file
+ */
+struct FileResult
+{
+	bool valid;
+	bool loaded;
+	int object_count;
+	vector<ResValidationIssue> issues;
+};
+
+/**
+ * Work shared between the threads
+ */
+struct WorkQueue
+{
+	const vector<string> *files;
+	vector<FileResult> *results;
+	unsigned int next;
+	pthread_mutex_t mutex;
+};
+
+void *validate_thread(void *param);
+bool read_list(const char *list_name, vector<string> &files);
+void write_report(ostream &os, const vector<string> &files, const vector<FileResult> &results);
+string json_string(const string &value);
+
+int main(int argc, char *argv[])
+{
+	int num_threads = 4;
+	const char *report_name = 0;
+	vector<string> files;
+
+#if defined(__LP64__)
+	// The resource structures hold pointers in 32 bits so keep
+	// all allocations in the main heap below 4GB on a 64 bit host
+	mallopt(M_MMAP_MAX, 0);
+	mallopt(M_ARENA_MAX, 1);
+#endif
+
+	for (int arg = 1; arg < argc; arg++)
+	{
+		string opt(argv[arg]);
+		if (opt.compare(0, 2, "-j") == 0 && (opt.size() > 2 || arg + 1 < argc))
+		{
+			// Accept both -j4 and -j 4
+			if (opt.size() > 2) num_threads = atoi(opt.c_str() + 2);
+			else num_threads = atoi(argv[++arg]);
+			if (num_threads < 1) num_threads = 1;
+		} else if (opt == "-o" && arg + 1 < argc)
+		{
+			report_name = argv[++arg];
+		} else if (opt == "-@" && arg + 1 < argc)
+		{
+			if (!read_list(argv[++arg], files))
+			{
+				cerr << "Unable to read file list " << argv[arg] << endl;
+				return 2;
+			}
+		} else if (opt.size() > 1 && opt[0] == '-')
+		{
+			cerr << "Unknown option " << opt << endl;
+			return 2;
+		} else
+		{
+			files.push_back(opt);
+		}
+	}
+
+	if (files.empty())
+	{
+		cout << "Usage: resvalidate [-j threads] [-o report] [-@ list] <filename> ..." << endl;
+		return 2;
+	}
+
+	vector<FileResult> results(files.size());
+	WorkQueue queue;
+	queue.files = &files;
+	queue.results = &results;
+	queue.next = 0;
+	pthread_mutex_init(&queue.mutex, 0);
+
+	if (num_threads > (int)files.size()) num_threads = (int)files.size();
+	vector<pthread_t> threads(num_threads);
+	int started = 0;
+	for (int t = 0; t < num_threads; t++)
+	{
+		if (pthread_create(&threads[started], 0, validate_thread, &queue) == 0)
+		{
+			started++;
+		}
+	}
+	// Use this thread if no others could be started
+	if (started == 0) validate_thread(&queue);
+	for (int t = 0; t < started; t++) pthread_join(threads[t], 0);
+
+	pthread_mutex_destroy(&queue.mutex);
+
+	int failed = 0;
+	for (unsigned int f = 0; f < files.size(); f++)
+	{
+		const FileResult &result = results[f];
+		if (result.valid) continue;
+		failed++;
+		for (unsigned int j = 0; j < result.issues.size(); j++)
+		{
+			const ResValidationIssue &issue = result.issues[j];
+			cerr << files[f] << ":" << issue.offset << ": ";
+			if (!issue.object.empty()) cerr << issue.object << ": ";
+			cerr << issue.message << endl;
+		}
+	}
+
+	if (report_name)
+	{
+		ofstream report(report_name);
+		if (!report)
+		{
+			cerr << "Unable to create report " << report_name << endl;
+			return 2;
+		}
+		write_report(report, files, results);
+	}
+
+	cout << files.size() << " files checked, " << failed << " failed" << endl;
+
+	return (failed == 0) ? 0 : 1;
+}
+
+/**
+ * Thread to take files from the queue and validate them until
+ * there are none left.
+ */
+void *validate_thread(void *param)
+{
+	WorkQueue *queue = reinterpret_cast<WorkQueue *>(param);
+	ResValidator validator;
+
+	while (true)
+	{
+		pthread_mutex_lock(&queue->mutex);
+		unsigned int index = queue->next++;
+		pthread_mutex_unlock(&queue->mutex);
+		if (index >= queue->files->size()) break;
+
+		// Each thread writes to a different result so no lock needed
+		FileResult &result = (*queue->results)[index];
+		result.valid = validator.validate((*queue->files)[index]);
+		result.loaded = validator.loaded();
+		result.object_count = validator.object_count();
+		result.issues = validator.issues();
+	}
+
+	return 0;
+}
+
+/**
+ * Read a list of file names, one per line
+ */
+bool read_list(const char *list_name, vector<string> &files)
+{
+	ifstream list(list_name);
+	if (!list) return false;
+
+	string line;
+	while (getline(list, line))
+	{
+		if (!line.empty() && line[line.size()-1] == '\r') line.erase(line.size()-1);
+		if (!line.empty()) files.push_back(line);
+	}
+
+	return true;
+}
+
+/**
+ * Write the results as a JSON array in the order the files were given
+ */
+void write_report(ostream &os, const vector<string> &files, const vector<FileResult> &results)
+{
+	os << "[" << endl;
+	for (unsigned int f = 0; f < files.size(); f++)
+	{
+		const FileResult &result = results[f];
+		os << "  {\"file\": " << json_string(files[f])
+			<< ", \"loaded\": " << (result.loaded ? "true" : "false")
+			<< ", \"valid\": " << (result.valid ? "true" : "false")
+			<< ", \"objects\": " << result.object_count
+			<< ", \"issues\": [";
+		for (unsigned int j = 0; j < result.issues.size(); j++)
+		{
+			const ResValidationIssue &issue = result.issues[j];
+			if (j) os << ",";
+			os << endl << "    {\"offset\": " << issue.offset
+				<< ", \"object\": " << json_string(issue.object)
+				<< ", \"message\": " << json_string(issue.message) << "}";
+		}
+		if (!result.issues.empty()) os << endl << "  ";
+		os << "]}";
+		if (f + 1 < files.size()) os << ",";
+		os << endl;
+	}
+	os << "]" << endl;
+}
+
+/**
+ * Convert a string to a quoted JSON string
+ */
+string json_string(const string &value)
+{
+	ostringstream ss;
+	ss << '"';
+	for (string::const_iterator i = value.begin(); i != value.end(); ++i)
+	{
+		unsigned char c = (unsigned char)*i;
+		if (c == '"' || c == '\\') ss << '\\' << c;
+		else if (c < 32)
+		{
+			const char *hex = "0123456789abcdef";
+			ss << "\\u00" << hex[c >> 4] << hex[c & 15];
+		} else ss << c;
+	}
+	ss << '"';
+	return ss.str();
+}
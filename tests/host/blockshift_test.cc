@@ -0,0 +1,181 @@
+/*
+ * Tests for the BlockShift geometry and its use by DeferredRedraw
+ * and ListView.
+ */
+
+#include "hosttest.h"
+#include "tbx/blockshift.h"
+#include "tbx/application.h"
+#include "tbx/deferredredraw.h"
+#include "tbx/window.h"
+#include "tbx/postpolllistener.h"
+#include "tbx/view/listview.h"
+#include "tbx/host/simulator.h"
+
+using namespace tbx;
+using namespace tbx::view;
+
+static host::Simulator sim;
+
+/**
+ * Stop the application when all the simulated events have been processed
+ */
+class QuitWhenIdle : public PostPollListener
+{
+	Application &_app;
+public:
+	QuitWhenIdle(Application &app) : _app(app) {}
+	virtual void post_poll(int, PollBlock &, IdBlock &, int)
+	{
+		if (sim.events_queued() == 0) _app.quit();
+	}
+};
+
+static void run_events(Application &app)
+{
+	QuitWhenIdle quit(app);
+	app.set_post_poll_listener(&quit);
+	app.run();
+	app.set_post_poll_listener(0);
+}
+
+static bool same(const BBox &a, int min_x, int min_y, int max_x, int max_y)
+{
+	return a.min.x == min_x && a.min.y == min_y && a.max.x == max_x && a.max.y == max_y;
+}
+
+static void test_geometry()
+{
+	// Move down leaving a strip at the top
+	BlockShift down(BBox(0,-400,100,-40), 0, -80);
+	HOST_CHECK(down.copy());
+	HOST_CHECK(down.to().x == 0 && down.to().y == -480);
+	HOST_CHECK(same(down.exposed(), 0,-120,100,-40));
+
+	// Move up leaving a strip at the bottom
+	BlockShift up(BBox(0,-400,100,-120), 0, 80);
+	HOST_CHECK(up.copy());
+	HOST_CHECK(same(up.destination(), 0,-320,100,-40));
+	HOST_CHECK(same(up.exposed(), 0,-400,100,-320));
+
+	// Move further than the height so nothing is copied
+	BlockShift far(BBox(0,-400,100,-360), 0, -80);
+	HOST_CHECK(!far.copy());
+	HOST_CHECK(same(far.exposed(), 0,-480,100,-360));
+
+	// Horizontal moves
+	BlockShift left(BBox(200,-400,500,0), -104, 0);
+	HOST_CHECK(left.copy());
+	HOST_CHECK(same(left.exposed(), 396,-400,500,0));
+	BlockShift right(BBox(200,-400,500,0), 50, 0);
+	HOST_CHECK(right.copy());
+	HOST_CHECK(same(right.exposed(), 200,-400,250,0));
+
+	// Nothing to move, or a diagonal move, is not copied
+	HOST_CHECK(!BlockShift(BBox(0,0,0,0), 0, 10).copy());
+	HOST_CHECK(!BlockShift(BBox(0,-10,10,0), 0, 0).copy());
+	BlockShift diagonal(BBox(0,0,10,10), 3, 3);
+	HOST_CHECK(!diagonal.copy());
+	HOST_CHECK(same(diagonal.exposed(), 0,0,13,13));
+}
+
+static void test_deferred_shift(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,400), BBox(0,-1000,400,0)));
+	DeferredRedraw redraw(window);
+
+	// Nothing pending so the area is copied at once
+	sim.clear_redraws();
+	redraw.shift(BBox(0,-400,400,-40), 0, -40);
+	HOST_CHECK(sim.block_copies().size() == 1);
+	if (sim.block_copies().size() == 1)
+	{
+		HOST_CHECK(same(sim.block_copies()[0].source, 0,-400,400,-40));
+		HOST_CHECK(sim.block_copies()[0].destination.y == -440);
+	}
+	run_events(app);
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(same(sim.forced_redraws()[0].work_area, 0,-80,400,-40));
+	}
+
+	// Part of the area is waiting to be redrawn so it is redrawn instead
+	sim.clear_redraws();
+	redraw.invalidate(BBox(0,-200,400,-160));
+	redraw.shift(BBox(0,-400,400,-40), 0, -40);
+	HOST_CHECK(sim.block_copies().empty());
+	run_events(app);
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(same(sim.forced_redraws()[0].work_area, 0,-440,400,-40));
+	}
+}
+
+/**
+ * Renderer for fixed size items
+ */
+class FixedRenderer : public ItemRenderer
+{
+public:
+	virtual void render(const ItemRenderer::Info &) {}
+	virtual unsigned int width(unsigned int) const {return 200;}
+	virtual unsigned int height(unsigned int) const {return 40;}
+	virtual Size size(unsigned int) const {return Size(200, 40);}
+};
+
+static void test_list_view(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,400), BBox(0,-400,400,0)));
+	FixedRenderer renderer;
+	ListView view(window, &renderer);
+	view.inserted(0, 20);
+	run_events(app);
+
+	// Removing rows copies the rows below up and redraws the end
+	sim.clear_redraws();
+	view.removing(3, 2);
+	view.removed(3, 2);
+	HOST_CHECK(sim.block_copies().size() == 1);
+	if (sim.block_copies().size() == 1)
+	{
+		HOST_CHECK(same(sim.block_copies()[0].source, 0,-800,200,-200));
+		HOST_CHECK(sim.block_copies()[0].destination.y == -720);
+	}
+	run_events(app);
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(same(sim.forced_redraws()[0].work_area, 0,-800,200,-720));
+	}
+
+	// Inserting rows copies the rows below down and redraws the new rows
+	sim.clear_redraws();
+	view.inserted(2, 1);
+	HOST_CHECK(sim.block_copies().size() == 1);
+	if (sim.block_copies().size() == 1)
+	{
+		HOST_CHECK(same(sim.block_copies()[0].source, 0,-720,200,-80));
+		HOST_CHECK(sim.block_copies()[0].destination.y == -760);
+	}
+	run_events(app);
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(same(sim.forced_redraws()[0].work_area, 0,-120,200,-80));
+	}
+}
+
+void run_test()
+{
+	test_geometry();
+
+	sim.install();
+	Application app("<Test$Dir>");
+
+	test_deferred_shift(app);
+	test_list_view(app);
+
+	HOST_CHECK(sim.unsupported_calls() == 0);
+}
@@ -0,0 +1,206 @@
+/*
+ * Tests for the DrawFile object index and clipped rendering
+ */
+
+#include "hosttest.h"
+#include "tbx/drawfile.h"
+#include "tbx/host/swibackend.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx;
+
+/**
+ * Build a draw file a word at a time
+ */
+class DrawBuilder
+{
+public:
+	std::vector<int> data;
+
+	DrawBuilder()
+	{
+		word(0x77617244); // "Draw"
+		word(201);
+		word(0);
+		word(0x20202020);
+		word(0x20202020);
+		word(0x20202020);
+		box(0, 0, 100000, 100000);
+	}
+
+	void word(int value) {data.push_back(value);}
+	void box(int min_x, int min_y, int max_x, int max_y)
+	{
+		word(min_x);
+		word(min_y);
+		word(max_x);
+		word(max_y);
+	}
+
+	/**
+	 * Start an object returning its position to pass to end
+	 */
+	int begin(int type)
+	{
+		int at = data.size();
+		word(type);
+		word(0);
+		return at;
+	}
+	void end(int at) {data[at + 1] = (data.size() - at) * 4;}
+
+	/**
+	 * Add a path with a single line
+	 */
+	void path(int x0, int y0, int x1, int y1)
+	{
+		int at = begin(2);
+		box(x0, y0, x1, y1);
+		word(0);  // fill colour
+		word(-1); // outline colour
+		word(0);  // outline width
+		word(0);  // style
+		word(2); word(x0); word(y0); // move
+		word(8); word(x1); word(y1); // draw
+		word(0);  // end
+		end(at);
+	}
+};
+
+/**
+ * SWI backend that records the objects passed to DrawFile_Render
+ */
+class RenderRecorder : public host::SwiBackend
+{
+public:
+	int calls;
+	std::vector<int> types;
+	std::vector<int> min_x;
+
+	RenderRecorder() : calls(0) {}
+
+	virtual _kernel_oserror *swi(int number, _kernel_swi_regs &regs)
+	{
+		if (number == 0x45540) // DrawFile_Render
+		{
+			calls++;
+			types.clear();
+			min_x.clear();
+			const char *data = reinterpret_cast<const char *>(regs.r[1]);
+			int size = regs.r[2];
+			int offset = 40;
+			while (offset < size)
+			{
+				const int *object = reinterpret_cast<const int *>(data + offset);
+				types.push_back(object[0]);
+				min_x.push_back(object[0] ? object[2] : 0);
+				offset += object[1];
+			}
+		}
+		return 0;
+	}
+};
+
+static bool overlaps(const BBox &a, const BBox &b)
+{
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+			&& a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+void run_test()
+{
+	DrawBuilder builder;
+	int fonts = builder.begin(0);
+	builder.word(0x65540201);
+	builder.word(0);
+	builder.end(fonts);
+	builder.path(0, 0, 100, 100);                 // 1
+	int group = builder.begin(6);                 // 2
+	builder.box(1000, 1000, 5000, 5000);
+	builder.word(0); builder.word(0); builder.word(0); // name
+	builder.path(1000, 1000, 2000, 2000);         // 3
+	int tagged = builder.begin(7);                // 4
+	builder.box(4000, 4000, 5000, 5000);
+	builder.word(42);
+	builder.path(4000, 4000, 5000, 5000);         // 5
+	builder.word(7); // Tagged object extra data
+	builder.end(tagged);
+	builder.end(group);
+	builder.path(0, 0, 100000, 100000);           // 6
+
+	std::srand(1);
+	for (int i = 0; i < 5000; i++)
+	{
+		int x = std::rand() % 99000, y = std::rand() % 99000;
+		builder.path(x, y, x + 500, y + 300);
+	}
+
+	DrawFile drawing;
+	HOST_CHECK(drawing.load(&builder.data[0], builder.data.size() * 4));
+	HOST_CHECK(drawing.object_count() == 5007);
+
+	// Object information including bounding boxes read from the file
+	HOST_CHECK(drawing.object(0).type == 0);
+	HOST_CHECK(drawing.object(2).type == 6);
+	HOST_CHECK(drawing.object(2).bounds.min.x == 1000);
+	HOST_CHECK(drawing.object(2).bounds.max.y == 5000);
+	HOST_CHECK(drawing.object(3).parent == 2);
+	HOST_CHECK(drawing.object(4).parent == 2);
+	HOST_CHECK(drawing.object(5).parent == 4);
+	HOST_CHECK(drawing.object(5).bounds.min.y == 4000);
+
+	// Index gives the same objects as checking them all
+	int mismatches = 0;
+	for (int q = 0; q < 2000; q++)
+	{
+		int x = std::rand() % 100000, y = std::rand() % 100000;
+		BBox area(x, y, x + std::rand() % 20000, y + std::rand() % 20000);
+		std::vector<unsigned int> found;
+		drawing.objects_in(area, found);
+
+		std::vector<unsigned int> expected;
+		for (unsigned int i = 0; i < drawing.object_count(); i++)
+		{
+			const DrawFile::ObjectInfo &info = drawing.object(i);
+			if (info.type == 0 || info.type == 6 || info.type == 7) continue;
+			if (overlaps(info.bounds, area)) expected.push_back(i);
+		}
+		if (found != expected) mismatches++;
+	}
+	HOST_CHECK(mismatches == 0);
+
+	// Clipped render only passes the font table and objects in the area
+	RenderRecorder recorder;
+	host::set_swi_backend(&recorder);
+	BBox clip(4500, 4500, 4600, 4600);
+	drawing.render(0, &clip);
+	HOST_CHECK(recorder.calls == 1);
+	HOST_CHECK(recorder.types.size() == 3);
+	if (recorder.types.size() == 3)
+	{
+		HOST_CHECK(recorder.types[0] == 0);
+		HOST_CHECK(recorder.types[1] == 2 && recorder.min_x[1] == 4000);
+		HOST_CHECK(recorder.types[2] == 2 && recorder.min_x[2] == 0);
+	}
+
+	// Clip is in screen units so is moved by the transform
+	DrawTransform transform;
+	transform.translate_os(10, 10);
+	clip = BBox(4500 + 2560, 4500 + 2560, 4600 + 2560, 4600 + 2560);
+	drawing.render(&transform, &clip);
+	HOST_CHECK(recorder.types.size() == 3);
+
+	// Copies keep the whole drawing
+	DrawFile copy(drawing);
+	copy.render(0, 0);
+	HOST_CHECK(recorder.types.size() == 5004);
+
+	BBox outside(-500, -500, -400, -400);
+	recorder.calls = 0;
+	drawing.render(0, &outside);
+	HOST_CHECK(recorder.calls == 0);
+
+	host::set_swi_backend(0);
+}
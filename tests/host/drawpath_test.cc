@@ -0,0 +1,312 @@
+/*
+ * Tests for the DrawPath geometry calculated without the Draw module
+ */
+
+#include "hosttest.h"
+#include "tbx/drawpath.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace tbx;
+
+/**
+ * Bounds of a bezier curve found by sampling it
+ */
+struct SampledBounds
+{
+	double min_x, min_y, max_x, max_y;
+
+	SampledBounds() : min_x(1e30), min_y(1e30), max_x(-1e30), max_y(-1e30) {}
+
+	void add(double x, double y)
+	{
+		if (x < min_x) min_x = x;
+		if (x > max_x) max_x = x;
+		if (y < min_y) min_y = y;
+		if (y > max_y) max_y = y;
+	}
+
+	/**
+	 * Add points along a curve, rotated by angle radians
+	 */
+	void add_curve(const double *xs, const double *ys, double angle = 0.0)
+	{
+		double cs = std::cos(angle), sn = std::sin(angle);
+		for (int j = 0; j <= 10000; j++)
+		{
+			double t = j / 10000.0;
+			double mt = 1.0 - t;
+			double a = mt * mt * mt, b = 3 * mt * mt * t, c = 3 * mt * t * t, d = t * t * t;
+			double x = a * xs[0] + b * xs[1] + c * xs[2] + d * xs[3];
+			double y = a * ys[0] + b * ys[1] + c * ys[2] + d * ys[3];
+			add(x * cs - y * sn, x * sn + y * cs);
+		}
+	}
+
+	/**
+	 * Check a box is within tolerance of the sampled bounds
+	 */
+	bool matches(const BBox &box, double tolerance) const
+	{
+		return std::fabs(box.min.x - min_x) <= tolerance
+			&& std::fabs(box.min.y - min_y) <= tolerance
+			&& std::fabs(box.max.x - max_x) <= tolerance
+			&& std::fabs(box.max.y - max_y) <= tolerance;
+	}
+};
+
+static bool inside(const BBox &inner, const BBox &outer)
+{
+	return inner.min.x >= outer.min.x && inner.min.y >= outer.min.y
+		&& inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+static void test_curve_bounds()
+{
+	// Arch whose control points are above its highest point
+	DrawPath arch;
+	arch.move(0, 0);
+	arch.bezier(0, 100, 100, 100, 100, 0);
+
+	BBox exact, control;
+	HOST_CHECK(arch.bounds(exact));
+	HOST_CHECK(arch.control_bounds(control));
+	HOST_CHECK(exact == BBox(0, 0, 100, 75));
+	HOST_CHECK(control == BBox(0, 0, 100, 100));
+
+	// Random curves against their sampled extremes
+	std::srand(23);
+	bool all_match = true, all_inside = true;
+	for (int n = 0; n < 200; n++)
+	{
+		double xs[4], ys[4];
+		for (int j = 0; j < 4; j++)
+		{
+			xs[j] = std::rand() % 20001 - 10000;
+			ys[j] = std::rand() % 20001 - 10000;
+		}
+		DrawPath path;
+		path.move((int)xs[0], (int)ys[0]);
+		path.bezier((int)xs[1], (int)ys[1], (int)xs[2], (int)ys[2], (int)xs[3], (int)ys[3]);
+
+		SampledBounds sampled;
+		sampled.add_curve(xs, ys);
+		path.bounds(exact);
+		path.control_bounds(control);
+		if (!sampled.matches(exact, 1.0)) all_match = false;
+		if (!inside(exact, control)) all_inside = false;
+	}
+	HOST_CHECK(all_match);
+	HOST_CHECK(all_inside);
+
+	// An empty path has no bounds
+	DrawPath empty;
+	HOST_CHECK(!empty.bounds(exact));
+	HOST_CHECK(exact == BBox(0, 0, 0, 0));
+	HOST_CHECK(!empty.control_bounds(control));
+}
+
+static void test_rotated_bounds()
+{
+	// Quarter turn maps (x, y) to (-y, x)
+	DrawPath rect;
+	rect.move(0, 0);
+	rect.line(100, 0);
+	rect.line(100, 50);
+	rect.line(0, 50);
+	rect.close_line();
+
+	DrawTransform quarter;
+	quarter.a = 0;
+	quarter.b = 1;
+	quarter.c = -1;
+	quarter.d = 0;
+	quarter.e = 1000;
+	quarter.f = 2000;
+
+	BBox box;
+	HOST_CHECK(rect.bounds(box, &quarter));
+	HOST_CHECK(box == BBox(950, 2000, 1000, 2100));
+	HOST_CHECK(rect.control_bounds(box, &quarter));
+	HOST_CHECK(box == BBox(950, 2000, 1000, 2100));
+
+	// Curve turned through 30 degrees against its rotated samples
+	double xs[4] = {0, -3000, 9000, 6000};
+	double ys[4] = {0, 8000, 8000, -2000};
+	DrawPath curve;
+	curve.move((int)xs[0], (int)ys[0]);
+	curve.bezier((int)xs[1], (int)ys[1], (int)xs[2], (int)ys[2], (int)xs[3], (int)ys[3]);
+
+	double angle = 3.14159265358979 / 6;
+	DrawTransform turn;
+	turn.a = std::cos(angle);
+	turn.b = std::sin(angle);
+	turn.c = -std::sin(angle);
+	turn.d = std::cos(angle);
+
+	SampledBounds sampled;
+	sampled.add_curve(xs, ys, angle);
+	HOST_CHECK(curve.bounds(box, &turn));
+	HOST_CHECK(sampled.matches(box, 2.0));
+
+	// Rotated exact bounds are inside the rotated control bounds
+	BBox control;
+	curve.control_bounds(control, &turn);
+	HOST_CHECK(inside(box, control));
+	HOST_CHECK(box != control);
+
+	// Bounds without the transform are not the cached rotated ones
+	BBox plain;
+	curve.bounds(plain);
+	SampledBounds unrotated;
+	unrotated.add_curve(xs, ys);
+	HOST_CHECK(unrotated.matches(plain, 1.0));
+	curve.bounds(box, &quarter);
+	HOST_CHECK(box.min.x == 1000 - plain.max.y);
+	HOST_CHECK(box.max.y == 2000 + plain.max.x);
+}
+
+/**
+ * Add a square subpath
+ *
+ * @param anticlockwise true to go anticlockwise, giving a winding
+ * number of +1 inside, false for clockwise giving -1.
+ */
+static void add_square(DrawPath &path, int x0, int y0, int x1, int y1, bool anticlockwise)
+{
+	path.move(x0, y0);
+	if (anticlockwise)
+	{
+		path.line(x1, y0);
+		path.line(x1, y1);
+		path.line(x0, y1);
+	} else
+	{
+		path.line(x0, y1);
+		path.line(x1, y1);
+		path.line(x1, y0);
+	}
+	path.close_line();
+}
+
+static void test_winding_rules()
+{
+	// Square with a hole going the same way
+	DrawPath same;
+	add_square(same, 0, 0, 100, 100, true);
+	add_square(same, 25, 25, 75, 75, true);
+
+	Point ring(10, 50), hole(50, 50), outside(150, 50);
+	HOST_CHECK(same.winding_number(ring) == 1);
+	HOST_CHECK(same.winding_number(hole) == 2);
+	HOST_CHECK(same.winding_number(outside) == 0);
+
+	HOST_CHECK(same.contains(ring, WINDING_NON_ZERO));
+	HOST_CHECK(same.contains(ring, WINDING_EVEN_ODD));
+	HOST_CHECK(same.contains(hole, WINDING_NON_ZERO));
+	HOST_CHECK(!same.contains(hole, WINDING_EVEN_ODD));
+	HOST_CHECK(same.contains(hole, WINDING_POSITIVE));
+	HOST_CHECK(!same.contains(hole, WINDING_NEGATIVE));
+	HOST_CHECK(!same.contains(outside, WINDING_NON_ZERO));
+
+	// Box in the hole, box across the edge of the hole and box outside
+	BBox in_hole(40, 40, 60, 60);
+	BBox across(20, 40, 30, 60);
+	BBox away(200, 200, 210, 210);
+	HOST_CHECK(same.contains(in_hole, WINDING_NON_ZERO));
+	HOST_CHECK(!same.contains(in_hole, WINDING_EVEN_ODD));
+	HOST_CHECK(same.intersects(in_hole, WINDING_NON_ZERO));
+	HOST_CHECK(!same.intersects(in_hole, WINDING_EVEN_ODD));
+	HOST_CHECK(!same.contains(across, WINDING_EVEN_ODD));
+	HOST_CHECK(same.intersects(across, WINDING_EVEN_ODD));
+	HOST_CHECK(!same.intersects(away, WINDING_NON_ZERO));
+
+	// Hole going the other way is a hole for both rules
+	DrawPath opposite;
+	add_square(opposite, 0, 0, 100, 100, true);
+	add_square(opposite, 25, 25, 75, 75, false);
+	HOST_CHECK(opposite.winding_number(ring) == 1);
+	HOST_CHECK(opposite.winding_number(hole) == 0);
+	HOST_CHECK(!opposite.contains(hole, WINDING_NON_ZERO));
+	HOST_CHECK(!opposite.contains(hole, WINDING_EVEN_ODD));
+	HOST_CHECK(!opposite.intersects(in_hole, WINDING_NON_ZERO));
+
+	// Clockwise path has negative winding numbers
+	DrawPath clockwise;
+	add_square(clockwise, 0, 0, 100, 100, false);
+	HOST_CHECK(clockwise.winding_number(hole) == -1);
+	HOST_CHECK(clockwise.contains(hole, WINDING_NEGATIVE));
+	HOST_CHECK(!clockwise.contains(hole, WINDING_POSITIVE));
+
+	// Internal moves do not affect the winding number
+	DrawPath internal;
+	add_square(internal, 0, 0, 100, 100, true);
+	internal.add(DrawElementMoveInternal(25, 25));
+	internal.line(75, 25);
+	internal.line(75, 75);
+	internal.line(25, 75);
+	internal.close_line();
+	HOST_CHECK(internal.winding_number(hole) == 1);
+}
+
+static void test_cache_invalidation()
+{
+	DrawPath path;
+	path.move(0, 0);
+	path.line(100, 0);
+	path.line(100, 100);
+
+	BBox box, control;
+	DrawTransform shift;
+	shift.e = 500;
+	path.bounds(box);
+	path.control_bounds(control);
+	HOST_CHECK(box == BBox(0, 0, 100, 100));
+	HOST_CHECK(path.bounds(box, &shift) && box == BBox(500, 0, 600, 100));
+	const DrawFlatPath &flat = path.flattened();
+	HOST_CHECK(flat.point_count() == 3);
+	HOST_CHECK(path.winding_number(Point(120, 75)) == 0);
+
+	// Line
+	path.line(200, 100);
+	path.bounds(box);
+	path.control_bounds(control);
+	HOST_CHECK(box == BBox(0, 0, 200, 100));
+	HOST_CHECK(control == BBox(0, 0, 200, 100));
+	HOST_CHECK(path.bounds(box, &shift) && box == BBox(500, 0, 700, 100));
+	HOST_CHECK(path.flattened().point_count() == 4);
+	HOST_CHECK(path.winding_number(Point(120, 75)) == -1);
+
+	// Bezier
+	path.bezier(200, 300, 0, 300, 0, 100);
+	path.bounds(box);
+	path.control_bounds(control);
+	HOST_CHECK(box == BBox(0, 0, 200, 250));
+	HOST_CHECK(control == BBox(0, 0, 200, 300));
+	HOST_CHECK(path.flattened().point_count() > 5);
+	HOST_CHECK(path.contains(Point(100, 200)));
+
+	// Added element
+	path.add(DrawElementLine(-50, 50));
+	path.bounds(box);
+	path.control_bounds(control);
+	HOST_CHECK(box == BBox(-50, 0, 200, 250));
+	HOST_CHECK(control == BBox(-50, 0, 200, 300));
+	HOST_CHECK(path.flattened().point(path.flattened().point_count() - 1) == Point(-50, 50));
+	HOST_CHECK(path.contains(Point(-10, 50)));
+
+	// Flattening with a different flatness replaces the cached path
+	unsigned int coarse = path.flattened(4096).point_count();
+	unsigned int fine = path.flattened(1).point_count();
+	HOST_CHECK(coarse < fine);
+	HOST_CHECK(path.flattened(4096).point_count() == coarse);
+}
+
+void run_test()
+{
+	test_curve_bounds();
+	test_rotated_bounds();
+	test_winding_rules();
+	test_cache_invalidation();
+}
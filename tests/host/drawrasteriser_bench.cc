@@ -0,0 +1,115 @@
+/*
+ * Benchmark of DrawRasteriser fills and strokes
+ */
+
+#include "hosttest.h"
+#include "tbx/drawrasteriser.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx;
+
+const int WIDTH = 1024;
+const int HEIGHT = 768;
+
+static void report(const char *name, double start, int runs, double pixels)
+{
+	double taken = (hosttest::seconds() - start) / runs;
+	std::printf("  %-30s %8.3f ms", name, taken * 1e3);
+	if (pixels) std::printf(" %8.1f Mpixels/s", pixels / taken / 1e6);
+	std::printf("\n");
+}
+
+static int count_set(const std::vector<unsigned int> &pixels)
+{
+	int count = 0;
+	for (unsigned int j = 0; j < pixels.size(); j++)
+	{
+		if (pixels[j]) count++;
+	}
+	return count;
+}
+
+void run_test()
+{
+	std::vector<unsigned int> pixels(WIDTH * HEIGHT);
+	DrawRasteriser raster(&pixels[0], WIDTH, HEIGHT);
+	raster.eig_factors(0, 0);
+	raster.pixel(0xFF0000FF);
+	DrawTransform os_units;
+	os_units.scale_os();
+	const int RUNS = 20;
+	double start;
+	int run;
+
+	std::printf("DrawRasteriser %dx%d 32bpp\n", WIDTH, HEIGHT);
+
+	// Span filling speed with a plain word loop for comparison
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++)
+	{
+		for (int y = 0; y < HEIGHT; y++)
+		{
+			unsigned int *row = &pixels[y * WIDTH];
+			for (int x = 0; x < WIDTH; x++) row[x] = 0xFF0000FF + run;
+		}
+	}
+	report("word loop full screen", start, RUNS, (double)WIDTH * HEIGHT);
+
+	DrawPath rect;
+	rect.move(0, 0);
+	rect.line(WIDTH, 0);
+	rect.line(WIDTH, HEIGHT);
+	rect.line(0, HEIGHT);
+	rect.close_line();
+	rect.end_path();
+	raster.clear();
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++) raster.fill(rect, WINDING_NON_ZERO, &os_units);
+	report("fill full screen rectangle", start, RUNS, (double)WIDTH * HEIGHT);
+	HOST_CHECK(count_set(pixels) == WIDTH * HEIGHT);
+
+	DrawPath circle;
+	circle.circle(WIDTH / 2, HEIGHT / 2, 300);
+	circle.end_path();
+	raster.clear();
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++) raster.fill(circle, WINDING_NON_ZERO, &os_units);
+	report("fill circle radius 300", start, RUNS, 3.14159 * 300 * 300);
+
+	DrawPath curves;
+	std::srand(2);
+	curves.move(1000, 700);
+	for (int j = 0; j < 2000; j++)
+	{
+		curves.bezier(std::rand() % 2000, std::rand() % 1500,
+			std::rand() % 2000, std::rand() % 1500,
+			std::rand() % 2000, std::rand() % 1500);
+	}
+	curves.close_line();
+	curves.end_path();
+	raster.clear();
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++) raster.fill(curves, WINDING_EVEN_ODD, &os_units);
+	report("fill 2000 random curves", start, RUNS, 0);
+
+	DrawPath lines;
+	lines.move(0, 0);
+	for (int j = 0; j < 2000; j++) lines.line(std::rand() % WIDTH, std::rand() % HEIGHT);
+	lines.end_path();
+	raster.clear();
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++) raster.stroke(lines, &os_units);
+	report("stroke 2000 thin lines", start, RUNS, 0);
+
+	DrawCapAndJoin round;
+	round.join(DrawCapAndJoin::ROUND_JOINS);
+	round.leading_cap(DrawCapAndJoin::ROUND_CAPS);
+	round.trailing_cap(DrawCapAndJoin::ROUND_CAPS);
+	raster.clear();
+	start = hosttest::seconds();
+	for (run = 0; run < RUNS; run++) raster.stroke(lines, &os_units, 0, 8, &round);
+	report("stroke 2000 thick round lines", start, RUNS, 0);
+}
@@ -0,0 +1,124 @@
+/*
+ * Tests for the DrawRasteriser winding rules and strokes
+ */
+
+#include "hosttest.h"
+#include "tbx/drawrasteriser.h"
+
+#include <vector>
+
+using namespace tbx;
+
+const int WIDTH = 64;
+const int HEIGHT = 32;
+
+static int count_set(const std::vector<unsigned int> &pixels)
+{
+	int count = 0;
+	for (unsigned int j = 0; j < pixels.size(); j++)
+	{
+		if (pixels[j]) count++;
+	}
+	return count;
+}
+
+/**
+ * Add a 10x10 square with a 4x4 hole to a path
+ *
+ * @param path path to add to
+ * @param same_direction true if the hole goes in the same direction as the outside
+ */
+static void square_with_hole(DrawPath &path, bool same_direction)
+{
+	path.move(2,2);
+	path.line(12,2);
+	path.line(12,12);
+	path.line(2,12);
+	path.close_line();
+	path.move(5,5);
+	if (same_direction)
+	{
+		path.line(9,5);
+		path.line(9,9);
+		path.line(5,9);
+	} else
+	{
+		path.line(5,9);
+		path.line(9,9);
+		path.line(9,5);
+	}
+	path.close_line();
+	path.end_path();
+}
+
+void run_test()
+{
+	std::vector<unsigned int> pixels(WIDTH * HEIGHT);
+	DrawRasteriser raster(&pixels[0], WIDTH, HEIGHT);
+	raster.eig_factors(0, 0);
+	DrawTransform os_units;
+	os_units.scale_os();
+
+	DrawPath opposite;
+	square_with_hole(opposite, false);
+	raster.clear();
+	raster.fill(opposite, WINDING_NON_ZERO, &os_units);
+	HOST_CHECK(count_set(pixels) == 84);
+
+	DrawPath same;
+	square_with_hole(same, true);
+	raster.clear();
+	raster.fill(same, WINDING_NON_ZERO, &os_units);
+	HOST_CHECK(count_set(pixels) == 100);
+	raster.clear();
+	raster.fill(same, WINDING_EVEN_ODD, &os_units);
+	HOST_CHECK(count_set(pixels) == 84);
+	raster.clear();
+	raster.fill(same, WINDING_POSITIVE, &os_units);
+	HOST_CHECK(count_set(pixels) == 100);
+	raster.clear();
+	raster.fill(same, WINDING_NEGATIVE, &os_units);
+	HOST_CHECK(count_set(pixels) == 0);
+
+	// Curves are flattened to within half a pixel by default so a
+	// circle is a little smaller than pi r squared
+	DrawPath circle;
+	circle.circle(32, 16, 12);
+	circle.end_path();
+	raster.clear();
+	raster.fill(circle, WINDING_NON_ZERO, &os_units);
+	int area = count_set(pixels);
+	HOST_CHECK(area > 410 && area <= 452);
+
+	// A smaller flatness (in draw units with no transform) is closer
+	DrawPath draw_circle;
+	draw_circle.circle(32 * 256, 16 * 256, 12 * 256);
+	draw_circle.end_path();
+	raster.clear();
+	raster.fill(draw_circle, WINDING_NON_ZERO, 0, 8);
+	int fine_area = count_set(pixels);
+	HOST_CHECK(fine_area > area && fine_area > 440 && fine_area < 465);
+
+	// Thin horizontal line sets one row of pixels
+	DrawPath line;
+	line.move(4,10);
+	line.line(40,10);
+	line.end_path();
+	raster.clear();
+	raster.stroke(line, &os_units);
+	int set = count_set(pixels);
+	HOST_CHECK(set >= 36 && set <= 37);
+	int rows = 0;
+	for (int y = 0; y < HEIGHT; y++)
+	{
+		if (pixels[y * WIDTH + 20]) rows++;
+	}
+	HOST_CHECK(rows == 1);
+
+	// Dashes leave gaps in the line
+	DrawDashPattern dash(0, 4, 2);
+	raster.clear();
+	raster.stroke(line, &os_units, 0, 0, 0, &dash);
+	int dashed = count_set(pixels);
+	HOST_CHECK(dashed > 0 && dashed < set);
+}
@@ -0,0 +1,133 @@
+/*
+ * Benchmark of toolbox event dispatch replaying streams of events
+ */
+
+#include "hosttest.h"
+#include "tbx/application.h"
+#include "tbx/command.h"
+#include "tbx/object.h"
+#include "tbx/eventtable.h"
+#include "tbx/postpolllistener.h"
+#include "tbx/host/simulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace tbx;
+
+static host::Simulator sim;
+
+/**
+ * Stop the application when all the simulated events have been processed
+ */
+class QuitWhenIdle : public PostPollListener
+{
+	Application &_app;
+public:
+	QuitWhenIdle(Application &app) : _app(app) {}
+	virtual void post_poll(int, PollBlock &, IdBlock &, int)
+	{
+		if (sim.events_queued() == 0) _app.quit();
+	}
+};
+
+class CountCommand : public Command
+{
+public:
+	int count;
+	CountCommand() : count(0) {}
+	virtual void execute() {count++;}
+};
+
+static void report(const char *name, double start, unsigned int ops)
+{
+	double taken = hosttest::seconds() - start;
+	std::printf("  %-34s %8.3f ms %8.1f ns/op\n", name, taken * 1e3, taken * 1e9 / ops);
+}
+
+const int OBJECTS = 5000;
+const int ACTIONS = 8;
+const unsigned int LOOKUPS = 10000000;
+
+/**
+ * Look up the same stream of keys in the EventTable and in a std::map
+ */
+static void bench_lookup(const std::vector<ObjectId> &ids)
+{
+	EventTable<int> table;
+	std::map<std::pair<ObjectId, int>, int> map;
+	for (int j = 0; j < OBJECTS; j++)
+	{
+		for (int a = 0; a < ACTIONS; a++)
+		{
+			table.insert(ids[j], 0x100 + a) = a;
+			map[std::make_pair(ids[j], 0x100 + a)] = a;
+		}
+	}
+
+	std::vector<ObjectId> stream_ids(4096);
+	std::vector<int> stream_codes(4096);
+	for (unsigned int j = 0; j < stream_ids.size(); j++)
+	{
+		stream_ids[j] = ids[std::rand() % OBJECTS];
+		// One in eight events has no listener
+		stream_codes[j] = 0x100 + std::rand() % (ACTIONS + 1);
+	}
+
+	int found = 0;
+	double start = hosttest::seconds();
+	for (unsigned int j = 0; j < LOOKUPS; j++)
+	{
+		if (table.find(stream_ids[j & 4095], stream_codes[j & 4095])) found++;
+	}
+	report("EventTable find", start, LOOKUPS);
+
+	int map_found = 0;
+	start = hosttest::seconds();
+	for (unsigned int j = 0; j < LOOKUPS; j++)
+	{
+		if (map.find(std::make_pair(stream_ids[j & 4095], stream_codes[j & 4095])) != map.end()) map_found++;
+	}
+	report("std::map find", start, LOOKUPS);
+	HOST_CHECK(found == map_found);
+}
+
+void run_test()
+{
+	sim.install();
+	Application app("<Test$Dir>");
+	std::srand(7);
+
+	std::printf("Toolbox event dispatch, %d objects with %d commands each\n", OBJECTS, ACTIONS);
+
+	std::vector<ObjectId> ids(OBJECTS);
+	CountCommand command;
+	for (int j = 0; j < OBJECTS; j++)
+	{
+		ids[j] = sim.create_object(0x82880);
+		Object object(ids[j]);
+		for (int a = 0; a < ACTIONS; a++) object.add_command(0x100 + a, &command);
+	}
+
+	bench_lookup(ids);
+
+	// Replay a stream of events through the event router
+	const int EVENTS = 200000;
+	for (int j = 0; j < EVENTS; j++)
+	{
+		sim.post_toolbox_event(ids[std::rand() % OBJECTS], -1, 0x100 + std::rand() % ACTIONS);
+	}
+	QuitWhenIdle quit(app);
+	app.set_post_poll_listener(&quit);
+	double start = hosttest::seconds();
+	app.run();
+	report("Replay toolbox events", start, EVENTS);
+	app.set_post_poll_listener(0);
+	HOST_CHECK(command.count == EVENTS);
+
+	start = hosttest::seconds();
+	for (int j = 0; j < OBJECTS; j++) Object(ids[j]).remove_all_listeners();
+	report("remove_all_listeners", start, OBJECTS);
+}
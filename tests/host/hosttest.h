@@ -0,0 +1,92 @@
+/*
+ * Simple support for the TBX host tests and benchmarks.
+ *
+ * Each test is a single program that defines run_test() and uses
+ * HOST_CHECK to check its results. The program exits with a non zero
+ * status if any check fails.
+ *
+ * TBX passes pointers in 32 bit registers so when the tests are built
+ * as a 64 bit program the test is run on a thread with a static stack
+ * and all allocations come from the main heap so all addresses stay
+ * below 4GB. This requires the program to be linked with -no-pie.
+ */
+
+#ifndef TBX_TESTS_HOSTTEST_H
+#define TBX_TESTS_HOSTTEST_H
+
+#include <cstdio>
+#include <ctime>
+
+#if defined(__LP64__)
+#include <malloc.h>
+#include <pthread.h>
+#endif
+
+namespace hosttest
+{
+	/**
+	 * Number of checks that have failed
+	 */
+	static int failures = 0;
+
+	/**
+	 * Record the result of a check
+	 */
+	inline void check(bool ok, const char *expr, const char *file, int line)
+	{
+		if (!ok)
+		{
+			std::printf("%s:%d: check failed: %s\n", file, line, expr);
+			failures++;
+		}
+	}
+
+	/**
+	 * Get a time in seconds for benchmarks
+	 */
+	inline double seconds()
+	{
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+}
+
+/**
+ * Check a condition, reporting the file and line if it fails
+ */
+#define HOST_CHECK(expr) hosttest::check((expr), #expr, __FILE__, __LINE__)
+
+/**
+ * Function defined by each test to run its checks
+ */
+void run_test();
+
+#if defined(__LP64__)
+static void *hosttest_thread(void *)
+{
+	run_test();
+	return 0;
+}
+#endif
+
+int main()
+{
+#if defined(__LP64__)
+	static char stack[8 << 20] __attribute__((aligned(16)));
+	mallopt(M_MMAP_MAX, 0);
+	mallopt(M_ARENA_MAX, 1);
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstack(&attr, stack, sizeof(stack));
+	pthread_t thread;
+	pthread_create(&thread, &attr, hosttest_thread, 0);
+	pthread_join(thread, 0);
+#else
+	run_test();
+#endif
+	if (hosttest::failures) std::printf("%d checks failed\n", hosttest::failures);
+	return (hosttest::failures == 0) ? 0 : 1;
+}
+
+#endif
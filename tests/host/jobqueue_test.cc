@@ -0,0 +1,347 @@
+/*
+ * Tests for the background job queue using a simulated clock
+ */
+
+#include "hosttest.h"
+#include "tbx/jobqueue.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace tbx;
+
+static unsigned int fake_time = 0;
+
+static unsigned int fake_clock()
+{
+	return fake_time;
+}
+
+/**
+ * Job that records its steps and moves the clock on by a
+ * fixed cost for each step
+ */
+class RecordJob : public BackgroundJob
+{
+public:
+	int id;
+	std::vector<int> *calls;
+	int steps;
+	unsigned int cost;
+	std::vector<int> percents;
+
+	RecordJob(int i, std::vector<int> *c, int s, unsigned int t = 0) :
+		id(i), calls(c), steps(s), cost(t) {}
+
+	virtual bool step()
+	{
+		calls->push_back(id);
+		fake_time += cost;
+		return (--steps > 0);
+	}
+
+	/**
+	 * Progress from the list of percentages, one for each step made
+	 */
+	virtual int progress() const
+	{
+		unsigned int done = 0;
+		for (unsigned int j = 0; j < calls->size(); j++)
+		{
+			if ((*calls)[j] == id) done++;
+		}
+		if (done == 0 || done > percents.size()) return -1;
+		return percents[done - 1];
+	}
+};
+
+/**
+ * Job that removes a job from the queue on its first step
+ */
+class RemoveJob : public RecordJob
+{
+public:
+	JobQueue &queue;
+	BackgroundJob *to_remove;
+
+	RemoveJob(JobQueue &q, BackgroundJob *r, int i, std::vector<int> *c, int s) :
+		RecordJob(i, c, s), queue(q), to_remove(r) {}
+
+	virtual bool step()
+	{
+		bool more = RecordJob::step();
+		if (to_remove)
+		{
+			queue.remove(to_remove);
+			to_remove = 0;
+		}
+		return more;
+	}
+};
+
+/**
+ * Job that throws an exception on every step
+ */
+class ThrowJob : public BackgroundJob
+{
+public:
+	int count;
+	ThrowJob() : count(0) {}
+	virtual bool step()
+	{
+		count++;
+		throw std::runtime_error("step failed");
+	}
+};
+
+/**
+ * Listener that records the progress and completion of jobs
+ */
+class RecordListener : public BackgroundJobListener
+{
+public:
+	std::vector<int> progress;
+	std::vector<BackgroundJob *> finished;
+
+	virtual void job_progress(BackgroundJob *, int percent)
+	{
+		progress.push_back(percent);
+	}
+	virtual void job_finished(BackgroundJob *job)
+	{
+		finished.push_back(job);
+	}
+};
+
+static bool calls_are(const std::vector<int> &calls, const int *expected, unsigned int count)
+{
+	if (calls.size() != count) return false;
+	for (unsigned int j = 0; j < count; j++)
+	{
+		if (calls[j] != expected[j]) return false;
+	}
+	return true;
+}
+
+static void test_priority()
+{
+	fake_time = 100;
+	JobQueue queue(fake_clock);
+	queue.budget(100);
+	std::vector<int> calls;
+	RecordJob low(1, &calls, 2), high(2, &calls, 2), middle(3, &calls, 1);
+
+	queue.add(&low, 0, 0);
+	queue.add(&high, 10, 0);
+	queue.add(&middle, 5, 0);
+	HOST_CHECK(queue.size() == 3);
+
+	// Steps take no time so everything runs in one go
+	queue.process();
+	const int expected[] = {2, 2, 3, 1, 1};
+	HOST_CHECK(calls_are(calls, expected, 5));
+	HOST_CHECK(queue.empty());
+
+	// Adding a job again changes its priority
+	calls.clear();
+	low.steps = 1;
+	high.steps = 1;
+	queue.add(&high, 10, 0);
+	queue.add(&low, 0, 0);
+	queue.add(&low, 20, 0);
+	HOST_CHECK(queue.size() == 2);
+	queue.process();
+	const int readded[] = {1, 2};
+	HOST_CHECK(calls_are(calls, readded, 2));
+}
+
+static void test_round_robin()
+{
+	fake_time = 0;
+	JobQueue queue(fake_clock);
+	queue.budget(100);
+	std::vector<int> calls;
+	RecordJob a(1, &calls, 3), b(2, &calls, 2), c(3, &calls, 3), other(4, &calls, 2);
+
+	queue.add(&a, 1, 0);
+	queue.add(&other, 0, 0);
+	queue.add(&b, 1, 0);
+	queue.add(&c, 1, 0);
+
+	queue.process();
+	const int expected[] = {1, 2, 3, 1, 2, 3, 1, 3, 4, 4};
+	HOST_CHECK(calls_are(calls, expected, 10));
+	HOST_CHECK(queue.empty());
+}
+
+static void test_budget()
+{
+	fake_time = 0xFFFFFFFE; // Check wrap around as well
+	JobQueue queue(fake_clock);
+	queue.budget(3);
+	std::vector<int> calls;
+	RecordJob job(1, &calls, 10, 1);
+
+	queue.add(&job, 0, 0);
+	queue.process();
+	HOST_CHECK(calls.size() == 3);
+	HOST_CHECK(queue.contains(&job));
+
+	// A step longer than the budget still runs once
+	calls.clear();
+	job.cost = 10;
+	queue.process();
+	HOST_CHECK(calls.size() == 1);
+
+	// So does a step with no budget
+	calls.clear();
+	job.cost = 0;
+	queue.budget(0);
+	queue.process();
+	HOST_CHECK(calls.size() == 1);
+
+	// Nothing to do with an empty queue
+	queue.remove(&job);
+	calls.clear();
+	queue.process();
+	HOST_CHECK(calls.empty());
+}
+
+static void test_progress()
+{
+	fake_time = 0;
+	JobQueue queue(fake_clock);
+	queue.budget(100);
+	std::vector<int> calls;
+	RecordListener listener;
+	RecordJob job(1, &calls, 6);
+	job.percents.push_back(-1);
+	job.percents.push_back(0);
+	job.percents.push_back(0);
+	job.percents.push_back(50);
+	job.percents.push_back(50);
+	job.percents.push_back(100);
+
+	queue.add(&job, 0, &listener);
+	queue.process();
+	HOST_CHECK(calls.size() == 6);
+	HOST_CHECK(listener.progress.size() == 3);
+	if (listener.progress.size() == 3)
+	{
+		HOST_CHECK(listener.progress[0] == 0);
+		HOST_CHECK(listener.progress[1] == 50);
+		HOST_CHECK(listener.progress[2] == 100);
+	}
+	HOST_CHECK(listener.finished.size() == 1);
+	HOST_CHECK(!listener.finished.empty() && listener.finished[0] == &job);
+
+	// Progress is reported again when the job is added again
+	calls.clear();
+	listener.progress.clear();
+	job.steps = 1;
+	job.percents.clear();
+	job.percents.push_back(0);
+	queue.add(&job, 0, &listener);
+	queue.process();
+	HOST_CHECK(listener.progress.size() == 1);
+}
+
+static void test_remove_in_step()
+{
+	fake_time = 0;
+	JobQueue queue(fake_clock);
+	queue.budget(100);
+	std::vector<int> calls;
+	RecordListener listener;
+
+	// Job that removes itself is not reported as finished
+	RemoveJob self(queue, 0, 1, &calls, 5);
+	self.to_remove = &self;
+	self.percents.push_back(10);
+	queue.add(&self, 0, &listener);
+	queue.process();
+	HOST_CHECK(calls.size() == 1);
+	HOST_CHECK(queue.empty());
+	HOST_CHECK(listener.progress.empty());
+	HOST_CHECK(listener.finished.empty());
+
+	// Job that removes the next job in the round
+	calls.clear();
+	RecordJob victim(2, &calls, 3), last(3, &calls, 2);
+	RemoveJob remover(queue, &victim, 1, &calls, 2);
+	queue.add(&remover, 0, &listener);
+	queue.add(&victim, 0, &listener);
+	queue.add(&last, 0, &listener);
+	queue.process();
+	const int expected[] = {1, 3, 1, 3};
+	HOST_CHECK(calls_are(calls, expected, 4));
+	HOST_CHECK(queue.empty());
+	HOST_CHECK(listener.finished.size() == 2);
+	HOST_CHECK(!queue.contains(&victim));
+
+	// Job that removes a job that has already had its turn
+	calls.clear();
+	listener.finished.clear();
+	RecordJob first(2, &calls, 3);
+	RemoveJob later(queue, &first, 1, &calls, 2);
+	queue.add(&first, 0, 0);
+	queue.add(&later, 0, 0);
+	queue.process();
+	const int after[] = {2, 1, 1};
+	HOST_CHECK(calls_are(calls, after, 3));
+	HOST_CHECK(queue.empty());
+}
+
+static void test_exception()
+{
+	fake_time = 0;
+	JobQueue queue(fake_clock);
+	queue.budget(100);
+	std::vector<int> calls;
+	ThrowJob thrower;
+	RecordJob other(1, &calls, 2);
+
+	queue.add(&thrower, 0, 0);
+	queue.add(&other, 0, 0);
+
+	bool thrown = false;
+	try
+	{
+		queue.process();
+	} catch(std::runtime_error &)
+	{
+		thrown = true;
+	}
+	HOST_CHECK(thrown);
+	HOST_CHECK(thrower.count == 1);
+	HOST_CHECK(queue.contains(&thrower));
+
+	// Failed job is moved behind the other job so it gets a turn
+	thrown = false;
+	try
+	{
+		queue.process();
+	} catch(std::runtime_error &)
+	{
+		thrown = true;
+	}
+	HOST_CHECK(thrown);
+	HOST_CHECK(calls.size() == 1);
+	HOST_CHECK(thrower.count == 2);
+
+	// The queue carries on once the failed job is removed
+	HOST_CHECK(queue.remove(&thrower));
+	queue.process();
+	HOST_CHECK(calls.size() == 2);
+	HOST_CHECK(queue.empty());
+}
+
+void run_test()
+{
+	test_priority();
+	test_round_robin();
+	test_budget();
+	test_progress();
+	test_remove_in_step();
+	test_exception();
+}
@@ -0,0 +1,111 @@
+/*
+ * Tests for reading JPEG headers and deferred JPEG loading
+ */
+
+#include "hosttest.h"
+#include "tbx/jpeg.h"
+#include "tbx/jpeginfo.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace tbx;
+
+/**
+ * Build a JFIF header followed by a baseline frame header
+ *
+ * @param units JFIF density units
+ * @param density horizontal and vertical density
+ */
+static std::string jfif_header(int units, int density, int width, int height)
+{
+	static const unsigned char start[] =
+	{
+		0xFF, 0xD8,                         // SOI
+		0xFF, 0xE0, 0x00, 0x10,             // APP0, length 16
+		'J', 'F', 'I', 'F', 0, 0x01, 0x02
+	};
+	std::string data(reinterpret_cast<const char *>(start), sizeof(start));
+	data += (char)units;
+	data += (char)(density >> 8);
+	data += (char)(density & 0xFF);
+	data += (char)(density >> 8);
+	data += (char)(density & 0xFF);
+	data += std::string(2, '\0');       // No thumbnail
+
+	static const unsigned char frame[] = {0xFF, 0xC0, 0x00, 0x11, 0x08};
+	data.append(reinterpret_cast<const char *>(frame), sizeof(frame));
+	data += (char)(height >> 8);
+	data += (char)(height & 0xFF);
+	data += (char)(width >> 8);
+	data += (char)(width & 0xFF);
+	data += (char)3;
+	for (int c = 1; c <= 3; c++)
+	{
+		data += (char)c;
+		data += (char)0x11;
+		data += (char)0;
+	}
+	data += (char)0xFF;
+	data += (char)0xD9;
+	return data;
+}
+
+static std::string write_temp(const std::string &data)
+{
+	char name[] = "/tmp/tbxjpegXXXXXX";
+	int fd = mkstemp(name);
+	if (fd < 0) return std::string();
+	ssize_t written = write(fd, data.data(), data.size());
+	close(fd);
+	return (written == (ssize_t)data.size()) ? name : std::string();
+}
+
+static void test_info()
+{
+	std::string data = jfif_header(2, 100, 64, 48);
+	JPEGInfo info;
+	HOST_CHECK(info.read(data.data(), data.size()));
+	HOST_CHECK(info.width() == 64);
+	HOST_CHECK(info.height() == 48);
+	HOST_CHECK(info.density_units() == JPEGInfo::DOTS_PER_CM);
+	HOST_CHECK(info.x_density() == 100);
+	HOST_CHECK(info.components() == 3);
+	HOST_CHECK(!info.progressive());
+}
+
+static void test_deferred_density()
+{
+	// Densities are given in dots per inch whatever the JFIF units
+	std::string cm_file = write_temp(jfif_header(2, 100, 64, 48));
+	std::string inch_file = write_temp(jfif_header(1, 90, 64, 48));
+	std::string ratio_file = write_temp(jfif_header(0, 2, 64, 48));
+	HOST_CHECK(!cm_file.empty() && !inch_file.empty() && !ratio_file.empty());
+
+	JPEG jpeg;
+	HOST_CHECK(jpeg.load(cm_file, true));
+	HOST_CHECK(!jpeg.is_loaded());
+	HOST_CHECK(jpeg.width() == 64);
+	HOST_CHECK(jpeg.x_density() == 254);
+	HOST_CHECK(jpeg.y_density() == 254);
+	HOST_CHECK(!jpeg.density_simple_ratio());
+
+	HOST_CHECK(jpeg.load(inch_file, true));
+	HOST_CHECK(jpeg.x_density() == 90);
+
+	HOST_CHECK(jpeg.load(ratio_file, true));
+	HOST_CHECK(jpeg.x_density() == 2);
+	HOST_CHECK(jpeg.density_simple_ratio());
+
+	std::remove(cm_file.c_str());
+	std::remove(inch_file.c_str());
+	std::remove(ratio_file.c_str());
+}
+
+void run_test()
+{
+	test_info();
+	test_deferred_density();
+}
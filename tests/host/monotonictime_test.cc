@@ -0,0 +1,68 @@
+/*
+ * Tests for the monotonic time comparisons across the wrap around
+ */
+
+#include "hosttest.h"
+#include "tbx/monotonictime.h"
+
+using namespace tbx;
+
+/**
+ * Check all four comparisons for two times where first is before second
+ */
+static void check_before(unsigned int first, unsigned int second)
+{
+	HOST_CHECK(monotonic_lt(first, second));
+	HOST_CHECK(monotonic_le(first, second));
+	HOST_CHECK(!monotonic_gt(first, second));
+	HOST_CHECK(!monotonic_ge(first, second));
+
+	HOST_CHECK(!monotonic_lt(second, first));
+	HOST_CHECK(!monotonic_le(second, first));
+	HOST_CHECK(monotonic_gt(second, first));
+	HOST_CHECK(monotonic_ge(second, first));
+}
+
+/**
+ * Check all four comparisons for equal times
+ */
+static void check_equal(unsigned int time)
+{
+	HOST_CHECK(!monotonic_lt(time, time));
+	HOST_CHECK(monotonic_le(time, time));
+	HOST_CHECK(!monotonic_gt(time, time));
+	HOST_CHECK(monotonic_ge(time, time));
+}
+
+void run_test()
+{
+	// Ordinary values
+	check_before(3, 10);
+	check_before(0, 1);
+
+	// Around the signed boundary
+	check_before(0x7FFFFFFE, 0x7FFFFFFF);
+	check_before(0x7FFFFFFF, 0x80000000);
+	check_before(0x7FFFFFFF, 0x80000001);
+	check_before(0x80000000, 0x80000001);
+
+	// Across the wrap from 0xFFFFFFFF to 0
+	check_before(0xFFFFFFFF, 0);
+	check_before(0xFFFFFFF0, 0x10);
+	check_before(0x80000001, 0);
+
+	// Up to just under half the range apart is still in order
+	check_before(0, 0x7FFFFFFF);
+	check_before(0xFFFFFFFF, 0x7FFFFFFE);
+
+	check_equal(0);
+	check_equal(0x7FFFFFFF);
+	check_equal(0x80000000);
+	check_equal(0xFFFFFFFF);
+
+	// Elapsed time counts across the wrap
+	HOST_CHECK(monotonic_elapsed(0xFFFFFFFF, 0) == 1);
+	HOST_CHECK(monotonic_elapsed(0x7FFFFFFF, 0x80000000) == 1);
+	HOST_CHECK(monotonic_elapsed(0xFFFFFFF0, 0x10) == 0x20);
+	HOST_CHECK(monotonic_elapsed(10, 3) == 0xFFFFFFF9);
+}
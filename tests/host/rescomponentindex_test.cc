@@ -0,0 +1,244 @@
+/*
+ * Tests for finding and editing the components of resource objects
+ * with the component index
+ */
+
+#include "hosttest.h"
+#include "tbx/res/rescomponentindex.h"
+#include "tbx/res/reswindow.h"
+#include "tbx/res/reslabel.h"
+#include "tbx/res/resbutton.h"
+#include "tbx/res/resmenu.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace tbx::res;
+
+static const int GADGETS = 20;
+
+static std::string numbered(const char *format, int value)
+{
+	char text[64];
+	std::sprintf(text, format, value);
+	return text;
+}
+
+/**
+ * Create a window with labels on the even IDs and buttons on the
+ * odd ones so the gadgets are different sizes
+ */
+static ResWindow create_window()
+{
+	ResWindow window("Gadgets");
+	for (int j = 0; j < GADGETS; j++)
+	{
+		if (j & 1)
+		{
+			ResButton button;
+			button.component_id(j);
+			button.value(numbered("Button %d", j));
+			window.add_gadget(button);
+		} else
+		{
+			ResLabel label;
+			label.component_id(j);
+			label.label(numbered("Label %d", j));
+			window.add_gadget(label);
+		}
+	}
+	return window;
+}
+
+/**
+ * Get the text of a label or button
+ */
+static std::string gadget_text(const ResWindow &window, int id)
+{
+	ResGadget gadget = window.gadget(id);
+	if (gadget.type() == ResButton::TYPE_ID) return ResButton(gadget).value();
+	return ResLabel(gadget).label();
+}
+
+/**
+ * Check all the gadgets can be found with the expected text
+ *
+ * @param erased ID of a gadget that has been erased or -1
+ * @param changed ID of a gadget with changed text or -1
+ * @param changed_text text of the changed gadget
+ */
+static bool gadgets_ok(const ResWindow &window, int erased, int changed, const std::string &changed_text)
+{
+	bool ok = true;
+	for (int j = 0; j < GADGETS; j++)
+	{
+		if (j == erased)
+		{
+			if (window.contains_gadget(j)) ok = false;
+			continue;
+		}
+		if (!window.contains_gadget(j)) return false;
+		std::string expected;
+		if (j == changed) expected = changed_text;
+		else expected = numbered((j & 1) ? "Button %d" : "Label %d", j);
+		if (gadget_text(window, j) != expected) ok = false;
+		if (window.gadget(j).component_id() != j) ok = false;
+	}
+	return ok;
+}
+
+static void test_index()
+{
+	ResComponentIndex index;
+	ResImpl *impl = new ResImpl(new char[16], 0, 16, 0);
+	HOST_CHECK(!index.valid(impl));
+
+	index.start(impl, 3);
+	index.add(10, 100);
+	index.add(20, 200);
+	index.add(10, 300); // Duplicate keeps the first
+	HOST_CHECK(index.valid(impl));
+	HOST_CHECK(index.find(10) == 100);
+	HOST_CHECK(index.find(20) == 200);
+	HOST_CHECK(index.find(30) == -1);
+
+	index.invalidate();
+	HOST_CHECK(!index.valid(impl));
+	index.validate(impl);
+	HOST_CHECK(index.valid(impl));
+
+	// An implementation created where a deleted one was is not the same
+	impl->release();
+	ResImpl *new_impl = new ResImpl(new char[16], 0, 16, 0);
+	HOST_CHECK(!index.valid(new_impl));
+	HOST_CHECK(new_impl->generation() != 0);
+
+	// Growing keeps all the keys
+	index.start(new_impl, 0);
+	for (int j = 0; j < 1000; j++) index.add(j * 7, j);
+	bool all_found = true;
+	for (int j = 0; j < 1000; j++)
+	{
+		if (index.find(j * 7) != j) all_found = false;
+	}
+	HOST_CHECK(all_found);
+	HOST_CHECK(index.find(1) == -1);
+	new_impl->release();
+}
+
+static int body_size(const ResObject &object)
+{
+	return object.object_header()->body_size;
+}
+
+static void test_window()
+{
+	ResWindow window = create_window();
+	HOST_CHECK(window.num_gadgets() == GADGETS);
+	HOST_CHECK(gadgets_ok(window, -1, -1, ""));
+	HOST_CHECK(window.find_gadget(GADGETS) == window.gadget_end());
+	int start_size = body_size(window);
+
+	// Replace with a bigger gadget moves the ones after it
+	ResButton bigger;
+	bigger.component_id(4);
+	bigger.value("Now a button");
+	window.replace_gadget(bigger);
+	HOST_CHECK(window.gadget(4).type() == ResButton::TYPE_ID);
+	HOST_CHECK(gadgets_ok(window, -1, 4, "Now a button"));
+	HOST_CHECK(body_size(window) == start_size + 16);
+
+	// and back to a smaller one
+	ResLabel smaller;
+	smaller.component_id(4);
+	smaller.label("Label 4");
+	window.replace_gadget(smaller);
+	HOST_CHECK(gadgets_ok(window, -1, -1, ""));
+	HOST_CHECK(body_size(window) == start_size);
+
+	// Same size replace using an iterator
+	ResLabel same;
+	same.component_id(6);
+	same.label("Same size");
+	window.replace_gadget(window.find_gadget(6), same);
+	HOST_CHECK(gadgets_ok(window, -1, 6, "Same size"));
+
+	window.erase_gadget(7);
+	HOST_CHECK(window.num_gadgets() == GADGETS - 1);
+	HOST_CHECK(gadgets_ok(window, 7, 6, "Same size"));
+	HOST_CHECK(body_size(window) == start_size - 56);
+
+	ResWindow::gadget_iterator next = window.erase_gadget(window.find_gadget(0));
+	HOST_CHECK((*next).component_id() == 1);
+	HOST_CHECK(!window.contains_gadget(0));
+	HOST_CHECK(gadget_text(window, GADGETS - 1) == numbered("Button %d", GADGETS - 1));
+
+	// Inserting at the start moves all the gadgets
+	ResLabel first;
+	first.component_id(100);
+	first.label("First");
+	window.insert_gadget(window.gadget_begin(), first);
+	HOST_CHECK(gadget_text(window, 100) == "First");
+	HOST_CHECK(gadget_text(window, 1) == "Button 1");
+	HOST_CHECK(gadget_text(window, GADGETS - 1) == numbered("Button %d", GADGETS - 1));
+
+	// Copies are edited separately
+	ResWindow copy(window);
+	copy.erase_gadget(100);
+	HOST_CHECK(window.contains_gadget(100));
+	HOST_CHECK(!copy.contains_gadget(100));
+	HOST_CHECK(gadget_text(copy, 1) == "Button 1");
+
+	// Assigning through the base class does not leave the index for
+	// the old layout in use
+	ResObject &base = window;
+	base = copy;
+	HOST_CHECK(!window.contains_gadget(100));
+	HOST_CHECK(gadget_text(window, 1) == "Button 1");
+	HOST_CHECK(gadget_text(window, 2) == "Label 2");
+}
+
+static void test_menu()
+{
+	ResMenu menu("Menu");
+	for (int j = 0; j < 10; j++)
+	{
+		ResMenuItem item;
+		item.component_id(j * 2);
+		item.text(numbered("Item %d", j * 2));
+		menu.add(item);
+	}
+	HOST_CHECK(menu.item_count() == 10);
+	HOST_CHECK(std::string(menu.item(8).text()) == "Item 8");
+	HOST_CHECK(!menu.contains(9));
+
+	ResMenuItem replacement;
+	replacement.component_id(8);
+	replacement.text("A much longer replacement item");
+	menu.replace(replacement);
+	HOST_CHECK(std::string(menu.item(8).text()) == "A much longer replacement item");
+	HOST_CHECK(std::string(menu.item(10).text()) == "Item 10");
+
+	menu.erase(4);
+	HOST_CHECK(menu.item_count() == 9);
+	HOST_CHECK(!menu.contains(4));
+	HOST_CHECK(std::string(menu.item(6).text()) == "Item 6");
+	HOST_CHECK(std::string(menu.item(18).text()) == "Item 18");
+	HOST_CHECK(std::string(menu.item_at(2).text()) == "Item 6");
+
+	ResMenuItem inserted;
+	inserted.component_id(1);
+	inserted.text("Inserted");
+	menu.insert(menu.begin(), inserted);
+	HOST_CHECK(std::string(menu.item(1).text()) == "Inserted");
+	HOST_CHECK(std::string(menu.item(0).text()) == "Item 0");
+	HOST_CHECK(menu.find(18) != menu.end());
+	HOST_CHECK(std::string(menu.item(18).text()) == "Item 18");
+}
+
+void run_test()
+{
+	test_index();
+	test_window();
+	test_menu();
+}
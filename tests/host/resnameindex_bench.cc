@@ -0,0 +1,73 @@
+/*
+ * Benchmark of finding objects by name in a resource file with and
+ * without the ResNameIndex
+ */
+
+#include "hosttest.h"
+#include "tbx/res/reseditor.h"
+#include "tbx/res/reswindow.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace tbx::res;
+
+static void report(const char *name, double start, unsigned int ops)
+{
+	double taken = hosttest::seconds() - start;
+	std::printf("  %-28s %8.3f ms %8.1f ns/op\n", name, taken * 1e3, taken * 1e9 / ops);
+}
+
+static std::string object_name(unsigned int index)
+{
+	char name[13];
+	std::sprintf(name, "Window%u", index);
+	return name;
+}
+
+void run_test()
+{
+	const unsigned int OBJECTS = 2000;
+	const unsigned int LOOKUPS = 50000;
+	std::srand(5);
+
+	std::printf("ResEditor find %u objects\n", OBJECTS);
+
+	ResEditor editor;
+	unsigned int j;
+	for (j = 0; j < OBJECTS; j++) editor.add(ResWindow(object_name(j)));
+	HOST_CHECK(editor.count() == OBJECTS);
+
+	std::vector<std::string> names(LOOKUPS);
+	for (j = 0; j < LOOKUPS; j++)
+	{
+		// One in eight lookups misses
+		unsigned int index = std::rand() % (OBJECTS + OBJECTS / 8);
+		names[j] = object_name(index);
+	}
+
+	unsigned int scan_found = 0;
+	double start = hosttest::seconds();
+	for (j = 0; j < LOOKUPS; j++)
+	{
+		if (editor.find(names[j]) != editor.end()) scan_found++;
+	}
+	report("linear scan", start, LOOKUPS);
+
+	start = hosttest::seconds();
+	editor.name_index(true);
+	report("build index", start, OBJECTS);
+
+	unsigned int index_found = 0;
+	start = hosttest::seconds();
+	for (j = 0; j < LOOKUPS; j++)
+	{
+		if (editor.find(names[j]) != editor.end()) index_found++;
+	}
+	report("indexed find", start, LOOKUPS);
+
+	HOST_CHECK(scan_found == index_found);
+	HOST_CHECK(editor.find(object_name(OBJECTS - 1))->name() == object_name(OBJECTS - 1));
+}
@@ -0,0 +1,49 @@
+/*
+ * Tests for the resource object name index
+ */
+
+#include "hosttest.h"
+#include "tbx/res/resnameindex.h"
+
+#include <cstdio>
+
+using namespace tbx::res;
+
+void run_test()
+{
+	ResNameIndex index;
+	index.add("Window", 0);
+	index.add("TwelveChars1", 1);
+	index.add("Window", 2);
+
+	HOST_CHECK(index.count() == 2);
+	HOST_CHECK(index.find("Window") == 0);
+	HOST_CHECK(index.find("TwelveChars1") == 1);
+	HOST_CHECK(index.find("TwelveChars12") == -1);
+	HOST_CHECK(index.find("TwelveChars") == -1);
+	HOST_CHECK(index.find("Win") == -1);
+
+	index.erase("TwelveChars12");
+	HOST_CHECK(index.find("TwelveChars1") == 1);
+
+	// Growing and erasing keep every name reachable
+	char name[16];
+	for (int j = 0; j < 1000; j++)
+	{
+		std::sprintf(name, "Obj%d", j);
+		index.add(name, j + 10);
+	}
+	for (int j = 0; j < 1000; j += 2)
+	{
+		std::sprintf(name, "Obj%d", j);
+		index.erase(name);
+	}
+	int bad = 0;
+	for (int j = 0; j < 1000; j++)
+	{
+		std::sprintf(name, "Obj%d", j);
+		if (index.find(name) != ((j & 1) ? j + 10 : -1)) bad++;
+	}
+	HOST_CHECK(bad == 0);
+	HOST_CHECK(index.find("TwelveChars1") == 1);
+}
@@ -0,0 +1,76 @@
+/*
+ * Benchmark of changing many labels in a window with and
+ * without a batch edit
+ */
+
+#include "hosttest.h"
+#include "tbx/res/reswindow.h"
+#include "tbx/res/reslabel.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace tbx::res;
+
+static void report(const char *name, double start, unsigned int ops)
+{
+	double taken = hosttest::seconds() - start;
+	std::printf("  %-28s %8.3f ms %8.1f us/op\n", name, taken * 1e3, taken * 1e6 / ops);
+}
+
+static ResWindow create_window(int labels)
+{
+	ResWindow window("Labels");
+	char text[32];
+	for (int j = 0; j < labels; j++)
+	{
+		ResLabel label;
+		label.component_id(j);
+		std::sprintf(text, "Label %d", j);
+		label.label(text);
+		window.add_gadget(label);
+	}
+	return window;
+}
+
+/**
+ * Change the label text of every label a number of times
+ */
+static void edit_labels(ResWindow &window, int labels, int passes)
+{
+	char text[32];
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (int j = 0; j < labels; j++)
+		{
+			ResLabel label = window.gadget(j);
+			std::sprintf(text, "Pass %d label %d", pass, j);
+			label.label(text);
+			window.replace_gadget(label);
+		}
+	}
+}
+
+void run_test()
+{
+	const int LABELS = 500;
+	const int PASSES = 20;
+	const unsigned int EDITS = LABELS * PASSES;
+
+	std::printf("ResWindow %u label edits on %d labels\n", EDITS, LABELS);
+
+	ResWindow single = create_window(LABELS);
+	double start = hosttest::seconds();
+	edit_labels(single, LABELS, PASSES);
+	report("one at a time", start, EDITS);
+
+	ResWindow batch = create_window(LABELS);
+	start = hosttest::seconds();
+	batch.begin_batch_edit();
+	edit_labels(batch, LABELS, PASSES);
+	batch.end_batch_edit();
+	report("batch edit", start, EDITS);
+
+	HOST_CHECK(std::string(ResLabel(batch.gadget(LABELS - 1)).label()) == "Pass 19 label 499");
+	HOST_CHECK(std::string(ResLabel(single.gadget(LABELS - 1)).label()) == "Pass 19 label 499");
+}
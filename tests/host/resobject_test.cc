@@ -0,0 +1,154 @@
+/*
+ * Tests for batch edits of resource objects
+ */
+
+#include "hosttest.h"
+#include "tbx/res/reswindow.h"
+#include "tbx/res/reslabel.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using namespace tbx::res;
+
+static const int LABELS = 50;
+
+/**
+ * Get the bytes of an object as they would be saved in a file
+ */
+static std::string saved_bytes(ResObject &object)
+{
+	std::ostringstream os;
+	object.save(os);
+	return os.str();
+}
+
+static std::string numbered(const char *format, int value)
+{
+	char text[64];
+	std::sprintf(text, format, value);
+	return text;
+}
+
+/**
+ * Get the saved bytes with the string and message tables in relocation
+ * order as they are after a batch edit. Tables changed one edit at a
+ * time have the text in the order it was edited.
+ */
+static std::string table_order_bytes(ResObject &object)
+{
+	ResObject copy(object);
+	copy.begin_batch_edit();
+	copy.end_batch_edit();
+	return saved_bytes(copy);
+}
+
+/**
+ * Create a window with a number of labels with help text
+ */
+static ResWindow create_window()
+{
+	ResWindow window("Labels");
+	window.title_text("Title");
+	for (int j = 0; j < LABELS; j++)
+	{
+		ResLabel label;
+		label.component_id(j);
+		label.label(numbered("Label %d", j));
+		if (j % 3 == 0) label.help_message(numbered("Help %d", j));
+		window.add_gadget(label);
+	}
+	return window;
+}
+
+/**
+ * Run the same sequence of edits with or without a batch edit
+ *
+ * @param window window to edit
+ * @param batch true to make the edits in a batch
+ * @param snapshot set to a copy of the window taken part way through
+ */
+static void edit_window(ResWindow &window, bool batch, std::string &snapshot)
+{
+	if (batch) window.begin_batch_edit();
+
+	for (int j = 0; j < LABELS; j++)
+	{
+		ResLabel label = window.gadget(j);
+		label.label(numbered("Renamed label %d with more text", j));
+		label.xmin(j * 4);
+		if (j % 5 == 0) label.help_message(0);
+		window.replace_gadget(label);
+	}
+
+	window.title_text("A longer title for the window");
+	window.help_message("Window help");
+	window.title_buflen(40);
+
+	window.erase_gadget(10);
+	window.erase_gadget(21);
+	window.erase_gadget(0);
+
+	// Copy taken during the batch has the edits so far
+	ResWindow copy(window);
+	HOST_CHECK(window.batch_edit() == batch);
+
+	for (int j = 30; j < 40; j++)
+	{
+		ResLabel label = window.gadget(j);
+		label.label("Short");
+		window.replace_gadget(label);
+	}
+	window.title_text(0);
+	window.erase_gadget(35);
+
+	if (batch) window.end_batch_edit();
+	HOST_CHECK(!window.batch_edit());
+
+	snapshot = table_order_bytes(copy);
+}
+
+void run_test()
+{
+	std::string single_snapshot, batch_snapshot;
+
+	ResWindow single = create_window();
+	edit_window(single, false, single_snapshot);
+
+	ResWindow batch = create_window();
+	edit_window(batch, true, batch_snapshot);
+
+	HOST_CHECK(batch.num_gadgets() == LABELS - 4);
+	HOST_CHECK(batch.title_text() == 0);
+	HOST_CHECK(std::string(batch.help_message()) == "Window help");
+	HOST_CHECK(batch.title_buflen() == 40);
+	HOST_CHECK(!batch.contains_gadget(35));
+	HOST_CHECK(std::string(ResLabel(batch.gadget(31)).label()) == "Short");
+	HOST_CHECK(std::string(ResLabel(batch.gadget(41)).label()) == "Renamed label 41 with more text");
+	HOST_CHECK(ResLabel(batch.gadget(41)).xmin() == 164);
+	HOST_CHECK(ResLabel(batch.gadget(5)).help_message() == 0);
+	HOST_CHECK(std::string(ResLabel(batch.gadget(3)).help_message()) == "Help 3");
+
+	HOST_CHECK(saved_bytes(batch) == table_order_bytes(single));
+	HOST_CHECK(saved_bytes(batch).size() == saved_bytes(single).size());
+	HOST_CHECK(batch_snapshot == single_snapshot);
+
+	// Saving part way through a batch ends it
+	batch.begin_batch_edit();
+	batch.title_text("Saved in batch");
+	HOST_CHECK(batch.batch_edit());
+	std::string saved = saved_bytes(batch);
+	HOST_CHECK(!batch.batch_edit());
+	single.title_text("Saved in batch");
+	HOST_CHECK(saved == table_order_bytes(single));
+
+	// Scoped batch edit
+	{
+		ResBatchEdit edit(batch);
+		HOST_CHECK(batch.batch_edit());
+		batch.title_text("Scoped");
+	}
+	HOST_CHECK(!batch.batch_edit());
+	HOST_CHECK(std::string(batch.title_text()) == "Scoped");
+}
@@ -0,0 +1,107 @@
+/*
+ * Benchmark of checking resource files with a number of threads
+ * as the resvalidate tool does.
+ */
+
+#include "hosttest.h"
+#include "tbx/res/resvalidator.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+using namespace tbx::res;
+
+/**
+ * Files shared between the threads
+ */
+struct WorkQueue
+{
+	const std::vector<std::string> *files;
+	unsigned int next;
+	unsigned int failed;
+	pthread_mutex_t mutex;
+};
+
+static void *validate_thread(void *param)
+{
+	WorkQueue *queue = reinterpret_cast<WorkQueue *>(param);
+	ResValidator validator;
+	unsigned int failed = 0;
+
+	while (true)
+	{
+		pthread_mutex_lock(&queue->mutex);
+		unsigned int index = queue->next++;
+		pthread_mutex_unlock(&queue->mutex);
+		if (index >= queue->files->size()) break;
+		if (!validator.validate((*queue->files)[index])) failed++;
+	}
+
+	pthread_mutex_lock(&queue->mutex);
+	queue->failed += failed;
+	pthread_mutex_unlock(&queue->mutex);
+
+	return 0;
+}
+
+/**
+ * Validate all the files with the given number of threads
+ *
+ * @returns time taken in seconds
+ */
+static double validate_all(const std::vector<std::string> &files, int num_threads, unsigned int &failed)
+{
+	WorkQueue queue;
+	queue.files = &files;
+	queue.next = 0;
+	queue.failed = 0;
+	pthread_mutex_init(&queue.mutex, 0);
+
+	double start = hosttest::seconds();
+	std::vector<pthread_t> threads(num_threads);
+	int started = 0;
+	for (int t = 0; t < num_threads; t++)
+	{
+		if (pthread_create(&threads[started], 0, validate_thread, &queue) == 0) started++;
+	}
+	if (started == 0) validate_thread(&queue);
+	for (int t = 0; t < started; t++) pthread_join(threads[t], 0);
+	double taken = hosttest::seconds() - start;
+
+	pthread_mutex_destroy(&queue.mutex);
+	failed = queue.failed;
+	return taken;
+}
+
+void run_test()
+{
+	const char *res_files[] =
+	{
+		"examples/!Graphics/Res,fae",
+		"examples/!IconView/Res,fae",
+		"examples/!StopWatch/Res,fae",
+		"examples/!TbxDocEx/Res,fae",
+		"examples/!TbxMin/Res,fae"
+	};
+	const unsigned int NUM_RES_FILES = sizeof(res_files) / sizeof(res_files[0]);
+	const unsigned int FILES = 2000;
+
+	std::vector<std::string> files;
+	for (unsigned int j = 0; j < FILES; j++) files.push_back(res_files[j % NUM_RES_FILES]);
+
+	std::printf("ResValidator %u files\n", FILES);
+
+	double single = 0.0;
+	for (int num_threads = 1; num_threads <= 8; num_threads *= 2)
+	{
+		unsigned int failed;
+		double taken = validate_all(files, num_threads, failed);
+		if (num_threads == 1) single = taken;
+		HOST_CHECK(failed == 0);
+		std::printf("  %d thread%s %8.3f ms %8.1f us/file  speed up %.2f\n",
+			num_threads, (num_threads == 1) ? " " : "s",
+			taken * 1e3, taken * 1e6 / FILES, single / taken);
+	}
+}
@@ -0,0 +1,136 @@
+/*
+ * Tests for checking resource files with the ResValidator
+ */
+
+#include "hosttest.h"
+#include "tbx/res/resvalidator.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace tbx::res;
+
+static const char *RES_FILE = "examples/!IconView/Res,fae";
+
+static std::vector<char> read_file(const char *file_name)
+{
+	std::ifstream file(file_name, std::ios::binary);
+	return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static int int_at(const std::vector<char> &data, int offset)
+{
+	int value;
+	std::memcpy(&value, &data[offset], 4);
+	return value;
+}
+
+static void set_int(std::vector<char> &data, int offset, int value)
+{
+	std::memcpy(&data[offset], &value, 4);
+}
+
+/**
+ * Check the data has a problem reported at the given offset
+ */
+static bool has_issue(const ResValidator &validator, int offset)
+{
+	for (unsigned int j = 0; j < validator.issues().size(); j++)
+	{
+		if (validator.issues()[j].offset == offset) return true;
+	}
+	return false;
+}
+
+void run_test()
+{
+	std::vector<char> good = read_file(RES_FILE);
+	HOST_CHECK(good.size() > 100);
+	if (good.size() <= 100) return;
+
+	ResValidator validator;
+	HOST_CHECK(validator.validate(&good[0], good.size()));
+	HOST_CHECK(validator.loaded());
+	HOST_CHECK(validator.file_name().empty());
+	HOST_CHECK(validator.issues().empty());
+	int object_count = validator.object_count();
+	HOST_CHECK(object_count > 1);
+
+	// The file check also loads it with ResFile
+	HOST_CHECK(validator.validate(std::string(RES_FILE)));
+	HOST_CHECK(validator.file_name() == RES_FILE);
+	HOST_CHECK(validator.object_count() == object_count);
+
+	HOST_CHECK(!validator.validate(std::string("NoSuchFile,fae")));
+	HOST_CHECK(!validator.loaded());
+
+	// Memory is not modified by the check
+	std::vector<char> copy(good);
+	validator.validate(&copy[0], copy.size());
+	HOST_CHECK(copy == good);
+
+	// Header problems
+	HOST_CHECK(!validator.validate(&good[0], 8));
+	HOST_CHECK(has_issue(validator, 0));
+	HOST_CHECK(validator.object_count() == 0);
+
+	std::vector<char> bad(good);
+	bad[0] = 'X';
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, 0));
+
+	bad = good;
+	set_int(bad, 8, bad.size() + 4);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, 8));
+
+	// Truncated in the middle of the first object
+	int first = int_at(good, 8);
+	HOST_CHECK(!validator.validate(&good[0], first + 20));
+	HOST_CHECK(has_issue(validator, first));
+
+	// The first object of the test file has a relocation table
+	int reloc_table = int_at(good, first + 8);
+	HOST_CHECK(reloc_table != -1);
+	if (reloc_table == -1) return;
+
+	bad = good;
+	set_int(bad, first + 8, 0x10000);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, first + 8));
+	HOST_CHECK(validator.issues()[0].object == "IconbarIcon");
+
+	int num_relocs = int_at(good, first + reloc_table);
+	HOST_CHECK(num_relocs > 0);
+	int reloc_pos = first + reloc_table + 4;
+
+	bad = good;
+	set_int(bad, first + reloc_table, 0x1000000);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, first + reloc_table));
+
+	bad = good;
+	set_int(bad, reloc_pos, 0x7FFF0000);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, reloc_pos));
+	// Later objects are still checked
+	HOST_CHECK(validator.object_count() == object_count);
+
+	bad = good;
+	set_int(bad, reloc_pos + 4, 99);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, reloc_pos + 4));
+
+	// Object total size
+	bad = good;
+	set_int(bad, first + 36, 4);
+	HOST_CHECK(!validator.validate(&bad[0], bad.size()));
+	HOST_CHECK(has_issue(validator, first + 36));
+
+	// Validator can be reused after a failure
+	HOST_CHECK(validator.validate(&good[0], good.size()));
+	HOST_CHECK(validator.object_count() == object_count);
+}
@@ -0,0 +1,82 @@
+/*
+ * Benchmark of MultiSelection with many ranges over a large list
+ */
+
+#include "hosttest.h"
+#include "tbx/view/selection.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx::view;
+
+static void report(const char *name, double start, unsigned int ops)
+{
+	double taken = hosttest::seconds() - start;
+	std::printf("  %-28s %8.3f ms %8.1f ns/op\n", name, taken * 1e3, taken * 1e9 / ops);
+}
+
+void run_test()
+{
+	const unsigned int ITEMS = 1000000;
+	const unsigned int RANGES = 100000;
+	const unsigned int QUERIES = 1000000;
+	std::srand(3);
+
+	std::printf("MultiSelection %u items, %u ranges\n", ITEMS, RANGES);
+
+	MultiSelection selection;
+	std::vector<unsigned int> starts(RANGES);
+	unsigned int j;
+	for (j = 0; j < RANGES; j++) starts[j] = std::rand() % (ITEMS - 8);
+
+	double start = hosttest::seconds();
+	for (j = 0; j < RANGES; j++) selection.select(starts[j], starts[j] + std::rand() % 8);
+	report("select ranges", start, RANGES);
+
+	unsigned int found = 0;
+	start = hosttest::seconds();
+	for (j = 0; j < QUERIES; j++)
+	{
+		if (selection.selected(std::rand() % ITEMS)) found++;
+	}
+	report("selected random", start, QUERIES);
+
+	// Scan as a redraw does
+	Selection::Cursor cursor(&selection);
+	unsigned int scanned = 0;
+	start = hosttest::seconds();
+	for (j = 0; j < ITEMS; j++)
+	{
+		if (cursor.selected(j)) scanned++;
+	}
+	report("cursor scan", start, ITEMS);
+	HOST_CHECK(scanned == selection.count());
+
+	start = hosttest::seconds();
+	for (j = 0; j < RANGES / 10; j++)
+	{
+		unsigned int from = std::rand() % (ITEMS - 100);
+		selection.toggle(from, from + std::rand() % 100);
+	}
+	report("toggle ranges", start, RANGES / 10);
+
+	start = hosttest::seconds();
+	for (j = 0; j < RANGES / 10; j++)
+	{
+		unsigned int from = std::rand() % (ITEMS - 100);
+		selection.deselect(from, from + std::rand() % 100);
+	}
+	report("deselect ranges", start, RANGES / 10);
+
+	start = hosttest::seconds();
+	for (j = 0; j < 1000; j++)
+	{
+		selection.inserted(std::rand() % ITEMS, 5);
+		selection.removed(std::rand() % ITEMS, 5);
+	}
+	report("insert and remove", start, 2000);
+
+	std::printf("  (%u of %u queries selected, %u selected)\n", found, QUERIES, selection.count());
+}
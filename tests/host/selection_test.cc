@@ -0,0 +1,239 @@
+/*
+ * Randomised test of MultiSelection against a bit vector
+ */
+
+#include "hosttest.h"
+#include "tbx/view/selection.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx::view;
+
+typedef std::vector<bool> Model;
+
+/**
+ * Listener that applies the changes it is sent to a copy of the model
+ */
+class MirrorListener : public SelectionListener
+{
+public:
+	Model mirror;
+
+	virtual void selection_changed(const SelectionChangedEvent &event)
+	{
+		for (unsigned int index = event.first(); index <= event.last(); index++)
+		{
+			mirror[index] = event.selected();
+		}
+	}
+};
+
+static unsigned int random_index(unsigned int size)
+{
+	return std::rand() % size;
+}
+
+/**
+ * Check every query on the selection gives the same result as the model
+ *
+ * @returns number of differences found
+ */
+static int compare(const MultiSelection &selection, const Model &model)
+{
+	int errors = 0;
+	unsigned int first = Selection::NO_SELECTION, last = Selection::NO_SELECTION;
+	unsigned int count = 0;
+	for (unsigned int index = 0; index < model.size(); index++)
+	{
+		if (selection.selected(index) != model[index]) errors++;
+		if (model[index])
+		{
+			if (first == Selection::NO_SELECTION) first = index;
+			last = index;
+			count++;
+		}
+	}
+	if (selection.first() != first) errors++;
+	if (selection.last() != last) errors++;
+	if (selection.count() != count) errors++;
+	if (selection.empty() != (count == 0)) errors++;
+	if (selection.one() != (count == 1)) errors++;
+	if (selection.many() != (count > 1)) errors++;
+
+	// Runs cover items with the same state and stop where it changes
+	unsigned int index = 0;
+	while (index < model.size())
+	{
+		unsigned int run_last;
+		bool state = selection.selected_run(index, run_last);
+		if (run_last < index) {errors++; break;}
+		if (state != model[index]) errors++;
+		unsigned int end = (run_last >= model.size()) ? model.size() - 1 : run_last;
+		for (unsigned int j = index; j <= end; j++)
+		{
+			if (model[j] != state) errors++;
+		}
+		if (end + 1 < model.size() && model[end + 1] == state) errors++;
+		index = end + 1;
+	}
+
+	// Iterator visits the selected items in order
+	unsigned int expected = 0;
+	for (Selection::Iterator i = selection.begin(); i != selection.end(); ++i)
+	{
+		while (expected < model.size() && !model[expected]) expected++;
+		if (*i != expected) errors++;
+		expected++;
+	}
+	while (expected < model.size() && !model[expected]) expected++;
+	if (expected != model.size()) errors++;
+
+	// A cursor gives the same results as selected
+	Selection::Cursor cursor(&selection);
+	for (index = 0; index < model.size(); index++)
+	{
+		if (cursor.selected(index) != model[index]) errors++;
+	}
+
+	return errors;
+}
+
+/**
+ * Check copies, iterator copies and indices near the end of the range
+ */
+static void test_copy_and_limits()
+{
+	MultiSelection selection;
+	selection.select(2, 4);
+	selection.select(10, 12);
+
+	MultiSelection copy(selection);
+	copy.deselect(3);
+	HOST_CHECK(selection.selected(3));
+	HOST_CHECK(!copy.selected(3));
+	HOST_CHECK(copy.count() == 5);
+
+	selection = copy;
+	HOST_CHECK(!selection.selected(3));
+	HOST_CHECK(selection.count() == 5);
+	selection.inserted(0, 1);
+	HOST_CHECK(copy.first() == 2);
+	HOST_CHECK(selection.first() == 3);
+
+	Selection::Iterator i = selection.begin();
+	++i;
+	Selection::Iterator j = i;
+	++j;
+	HOST_CHECK(*i == 5);
+	HOST_CHECK(*j == 11);
+
+	const unsigned int top = Selection::NO_SELECTION - 1;
+	MultiSelection high;
+	high.select(top - 10, top);
+	high.select(0);
+	HOST_CHECK(high.count() == 12);
+	HOST_CHECK(high.last() == top);
+	HOST_CHECK(high.selected(top));
+	high.toggle(top - 5, top);
+	HOST_CHECK(high.last() == top - 6);
+	high.removed(1, 10);
+	HOST_CHECK(high.first() == 0);
+	HOST_CHECK(high.last() == top - 16);
+	HOST_CHECK(high.count() == 6);
+}
+
+void run_test()
+{
+	test_copy_and_limits();
+
+	const unsigned int ITEMS = 300;
+	std::srand(11);
+
+	MultiSelection selection;
+	MirrorListener listener;
+	selection.add_listener(&listener);
+	Model model(ITEMS, false);
+	listener.mirror = model;
+
+	int errors = 0, event_errors = 0;
+	for (int step = 0; step < 20000 && errors == 0; step++)
+	{
+		unsigned int from = random_index(model.size());
+		unsigned int to = from + random_index(20);
+		if (to >= model.size()) to = model.size() - 1;
+		unsigned int j;
+		bool model_only = false;
+
+		switch (std::rand() % 12)
+		{
+		case 0:
+			selection.set(from);
+			for (j = 0; j < model.size(); j++) model[j] = (j == from);
+			break;
+		case 1:
+			selection.select(from);
+			model[from] = true;
+			break;
+		case 2:
+			selection.deselect(from);
+			model[from] = false;
+			break;
+		case 3:
+			selection.toggle(from);
+			model[from] = !model[from];
+			break;
+		case 4:
+			selection.set(from, to);
+			for (j = 0; j < model.size(); j++) model[j] = (j >= from && j <= to);
+			break;
+		case 5:
+		case 6:
+			selection.select(from, to);
+			for (j = from; j <= to; j++) model[j] = true;
+			break;
+		case 7:
+			selection.deselect(from, to);
+			for (j = from; j <= to; j++) model[j] = false;
+			break;
+		case 8:
+			selection.toggle(from, to);
+			for (j = from; j <= to; j++) model[j] = !model[j];
+			break;
+		case 9:
+			if (std::rand() % 50 == 0)
+			{
+				selection.clear();
+				model.assign(model.size(), false);
+			}
+			break;
+		case 10:
+			{
+				unsigned int count = random_index(10) + 1;
+				selection.inserted(from, count);
+				model.insert(model.begin() + from, count, false);
+				model_only = true;
+			}
+			break;
+		case 11:
+			if (model.size() > 50)
+			{
+				unsigned int count = to - from + 1;
+				selection.removed(from, count);
+				model.erase(model.begin() + from, model.begin() + from + count);
+				model_only = true;
+			}
+			break;
+		}
+
+		if (model_only) listener.mirror = model;
+		else if (listener.mirror != model) event_errors++;
+		errors += compare(selection, model);
+		if (errors) std::printf("Selection differs after step %d\n", step);
+	}
+	HOST_CHECK(errors == 0);
+	HOST_CHECK(event_errors == 0);
+
+	selection.remove_listener(&listener);
+}
@@ -0,0 +1,378 @@
+/*
+ * Tests for the Wimp/Toolbox simulator and TBX event handling,
+ * window redraws and data transfer protocols run on it.
+ */
+
+#include "hosttest.h"
+#include "tbx/application.h"
+#include "tbx/command.h"
+#include "tbx/timer.h"
+#include "tbx/window.h"
+#include "tbx/deferredredraw.h"
+#include "tbx/loader.h"
+#include "tbx/saver.h"
+#include "tbx/pointerinfo.h"
+#include "tbx/postpolllistener.h"
+#include "tbx/pollstats.h"
+#include "tbx/host/simulator.h"
+
+#include <cstring>
+#include <string>
+
+using namespace tbx;
+
+static host::Simulator sim;
+
+/**
+ * Stop the application when all the simulated events have been processed
+ */
+class QuitWhenIdle : public PostPollListener
+{
+	Application &_app;
+public:
+	QuitWhenIdle(Application &app) : _app(app) {}
+	virtual void post_poll(int, PollBlock &, IdBlock &, int)
+	{
+		if (sim.events_queued() == 0) _app.quit();
+	}
+};
+
+static void run_events(Application &app)
+{
+	QuitWhenIdle quit(app);
+	app.set_post_poll_listener(&quit);
+	app.run();
+	app.set_post_poll_listener(0);
+}
+
+class CountCommand : public Command
+{
+public:
+	int count;
+	CountCommand() : count(0) {}
+	virtual void execute() {count++;}
+};
+
+class CountTimer : public Timer
+{
+public:
+	int count;
+	CountTimer() : count(0) {}
+	virtual void timer(unsigned int) {count++;}
+};
+
+class MessageCounter : public WimpUserMessageListener
+{
+public:
+	int count;
+	int last_word;
+	MessageCounter() : count(0), last_word(0) {}
+	virtual void user_message(WimpMessageEvent &event)
+	{
+		count++;
+		last_word = event.message().word(5);
+	}
+};
+
+/**
+ * Listener that replies to a message by reusing the poll block
+ */
+class ReplyInPlace : public WimpUserMessageListener
+{
+public:
+	virtual void user_message(WimpMessageEvent &event)
+	{
+		WimpMessage &reply = const_cast<WimpMessage &>(event.message());
+		reply.your_ref(reply.my_ref());
+		reply.message_id(0x12399);
+		reply.send(WimpMessage::User, host::Simulator::REMOTE_TASK);
+	}
+};
+
+class TestLoader : public Loader
+{
+public:
+	int loaded;
+	std::string file_name;
+	int file_type;
+	TestLoader() : loaded(0), file_type(0) {}
+	virtual bool load_file(LoadEvent &event)
+	{
+		loaded++;
+		file_name = event.file_name();
+		file_type = event.file_type();
+		return true;
+	}
+};
+
+class TestSaveHandler :
+	public SaverSaveToFileHandler,
+	public SaverSaveCompletedHandler,
+	public SaverFinishedHandler
+{
+public:
+	std::string save_name;
+	int completed;
+	int finished;
+	bool saved;
+	TestSaveHandler() : completed(0), finished(0), saved(false) {}
+
+	virtual void saver_save_to_file(Saver saver, std::string file_name)
+	{
+		save_name = file_name;
+		saver.file_save_completed(true, file_name);
+	}
+	virtual void saver_save_completed(SaverSaveCompletedEvent &)
+	{
+		completed++;
+	}
+	virtual void saver_finished(const SaverFinishedEvent &event)
+	{
+		finished++;
+		saved = event.save_done();
+	}
+};
+
+/**
+ * Build the data for a DataSave or DataLoad message
+ */
+static int transfer_data(int *data, int window_handle, int file_type, const char *name)
+{
+	std::memset(data, 0, 200);
+	data[0] = window_handle;
+	data[1] = -1;   // icon
+	data[2] = 100;  // x
+	data[3] = 200;  // y
+	data[4] = 1234; // estimated size
+	data[5] = file_type;
+	std::strcpy(reinterpret_cast<char *>(data + 6), name);
+	return 24 + std::strlen(name) + 1;
+}
+
+static void test_events(Application &app)
+{
+	CountCommand command;
+	CountTimer timer;
+	app.add_command(0x100, &command);
+	app.add_timer(50, &timer);
+
+	int window_handle = sim.create_window(BBox(0,0,400,300), BBox(0,-1000,800,0));
+	sim.post_toolbox_event(window_handle, 5, 0x100);
+	sim.post_toolbox_event(window_handle, 5, 0x100);
+	unsigned int start = sim.time();
+	run_events(app);
+	HOST_CHECK(command.count == 2);
+
+	// Polling with no events moves the clock on to the next timer
+	for (int poll = 0; poll < 10 && timer.count < 3; poll++)
+	{
+		run_events(app);
+	}
+	HOST_CHECK(timer.count == 3);
+	HOST_CHECK(sim.time() - start >= 150);
+
+	app.remove_timer(&timer);
+	app.remove_command(0x100, &command);
+}
+
+static void test_window(Application &app)
+{
+	int window_handle = sim.create_window(BBox(0,0,400,300), BBox(0,-1000,800,0));
+	Window window(window_handle);
+
+	HOST_CHECK(window.extent().min.y == -1000);
+	window.extent(BBox(0,-2000,800,0));
+	HOST_CHECK(sim.extent(window_handle).min.y == -2000);
+
+	sim.clear_redraws();
+	window.force_redraw(BBox(0,-100,100,0));
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	HOST_CHECK(sim.forced_redraws()[0].work_area.max.x == 100);
+
+	// The redraw returns the invalid area in screen coordinates
+	sim.post_pending_redraws();
+	run_events(app);
+	HOST_CHECK(sim.rectangles().size() == 1);
+	if (sim.rectangles().size() == 1)
+	{
+		HOST_CHECK(sim.rectangles()[0].min.y == 200);
+		HOST_CHECK(sim.rectangles()[0].max.x == 100);
+	}
+}
+
+static void test_deferred_redraw(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,300), BBox(0,-1000,800,0)));
+	Window deleted(sim.create_window(BBox(0,0,400,300), BBox(0,-1000,800,0)));
+	DeferredRedraw redraw(window);
+	DeferredRedraw deleted_redraw(deleted);
+
+	sim.clear_redraws();
+	redraw.invalidate(BBox(0,-100,100,0));
+	redraw.invalidate(BBox(100,-100,200,0));
+	deleted_redraw.invalidate(BBox(0,-100,100,0));
+	deleted.delete_object();
+
+	// Areas for the deleted window are dropped without an error
+	sim.post_event(0);
+	run_events(app);
+	HOST_CHECK(!deleted_redraw.pending());
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(sim.forced_redraws()[0].window_handle == (int)window.handle());
+		HOST_CHECK(sim.forced_redraws()[0].work_area.max.x == 200);
+	}
+}
+
+static void test_messages(Application &app)
+{
+	MessageCounter counter;
+	app.add_user_message_listener(0x12345, &counter);
+	sim.clear_messages();
+
+	// Broadcasts are delivered to the sender as well
+	WimpMessage message(0x12345, 6);
+	message[5] = 42;
+	message.send(WimpMessage::User, 0);
+	run_events(app);
+	HOST_CHECK(counter.count == 1);
+	HOST_CHECK(counter.last_word == 42);
+	HOST_CHECK(sim.sent_messages().size() == 1);
+
+	// Messages to another task are only recorded
+	HOST_CHECK(message.send(WimpMessage::User, host::Simulator::REMOTE_TASK) == host::Simulator::REMOTE_TASK);
+	run_events(app);
+	HOST_CHECK(counter.count == 1);
+	HOST_CHECK(sim.sent_messages().size() == 2);
+
+	app.remove_user_message_listener(0x12345, &counter);
+}
+
+static unsigned int stats_time()
+{
+	return sim.time();
+}
+
+static void test_poll_stats(Application &app)
+{
+	PollStats stats(stats_time);
+	ReplyInPlace replier;
+	app.set_poll_stats(&stats);
+	app.add_user_message_listener(0x12346, &replier);
+
+	// Stats are recorded for the message received, not the reply
+	sim.post_remote_message(0x12346, 0, 0, 0, 17);
+	run_events(app);
+	HOST_CHECK(stats.item(PollStats::WIMP_MESSAGE, 0x12346) != 0);
+	HOST_CHECK(stats.item(PollStats::WIMP_MESSAGE, 0x12399) == 0);
+
+	app.remove_user_message_listener(0x12346, &replier);
+	app.set_poll_stats(0);
+}
+
+static void test_loader(Application &app)
+{
+	int window_handle = sim.create_window(BBox(0,0,400,300), BBox(0,-1000,800,0));
+	Window window(window_handle);
+	TestLoader loader;
+	window.add_loader(&loader, 0xFFF);
+	sim.clear_messages();
+
+	// Another task starts a save to the window
+	int data[64];
+	int size = transfer_data(data, window_handle, 0xFFF, "Text");
+	int save_ref = sim.post_remote_message(1, 0, data, size);
+	run_events(app);
+
+	HOST_CHECK(sim.sent_messages().size() == 1);
+	if (sim.sent_messages().size() != 1) return;
+	host::Simulator::MessageRecord ack = sim.sent_messages()[0];
+	HOST_CHECK(ack.action() == 2); // DataSaveAck
+	HOST_CHECK(ack.your_ref() == save_ref);
+	HOST_CHECK(ack.destination == host::Simulator::REMOTE_TASK);
+	HOST_CHECK(std::strcmp(ack.str(11), "<Wimp$Scrap>") == 0);
+
+	// Other task saves the file and tells us to load it
+	size = transfer_data(data, window_handle, 0xFFF, "<Wimp$Scrap>");
+	sim.post_remote_message(3, ack.my_ref(), data, size);
+	run_events(app);
+
+	HOST_CHECK(loader.loaded == 1);
+	HOST_CHECK(loader.file_name == "<Wimp$Scrap>");
+	HOST_CHECK(loader.file_type == 0xFFF);
+	HOST_CHECK(sim.sent_messages().size() == 2);
+	if (sim.sent_messages().size() == 2)
+	{
+		HOST_CHECK(sim.sent_messages()[1].action() == 4); // DataLoadAck
+	}
+
+	window.remove_loader(&loader, 0xFFF);
+}
+
+static void test_saver(Application &app)
+{
+	const int remote_window = 0x7777;
+	TestSaveHandler handler;
+	Saver saver;
+	saver.set_save_to_file_handler(&handler);
+	saver.set_save_completed_handler(&handler);
+	saver.set_finished_handler(&handler);
+	sim.clear_messages();
+
+	saver.save(PointerInfo(remote_window, -1, 100, 200, 0), "Leaf", 0xFFF, 100);
+	HOST_CHECK(sim.sent_messages().size() == 1);
+	if (sim.sent_messages().size() != 1) return;
+	host::Simulator::MessageRecord save = sim.sent_messages()[0];
+	HOST_CHECK(save.action() == 1); // DataSave
+	HOST_CHECK(save.reason == 18);
+	HOST_CHECK(std::strcmp(save.str(11), "Leaf") == 0);
+
+	// Other task asks for the file to be saved to a path
+	int data[64];
+	int size = transfer_data(data, remote_window, 0xFFF, "ADFS::Disc.$.Leaf");
+	int ack_ref = sim.post_remote_message(2, save.my_ref(), data, size, 17);
+	run_events(app);
+	HOST_CHECK(handler.save_name == "ADFS::Disc.$.Leaf");
+	HOST_CHECK(sim.sent_messages().size() == 2);
+	if (sim.sent_messages().size() != 2) return;
+	host::Simulator::MessageRecord load = sim.sent_messages()[1];
+	HOST_CHECK(load.action() == 3); // DataLoad
+	HOST_CHECK(load.your_ref() == ack_ref);
+
+	sim.post_remote_message(4, load.my_ref(), data, size, 17);
+	run_events(app);
+	HOST_CHECK(handler.completed == 1);
+	HOST_CHECK(handler.finished == 1);
+	HOST_CHECK(handler.saved);
+
+	// A save that the destination ignores comes back to the sender
+	TestSaveHandler ignored;
+	Saver saver2;
+	saver2.set_finished_handler(&ignored);
+	sim.clear_messages();
+	saver2.save(PointerInfo(remote_window, -1, 100, 200, 0), "Leaf", 0xFFF, 100);
+	HOST_CHECK(sim.sent_messages().size() == 1);
+	if (sim.sent_messages().size() != 1) return;
+	sim.bounce_message(sim.sent_messages()[0]);
+	run_events(app);
+	HOST_CHECK(ignored.finished == 1);
+	HOST_CHECK(!ignored.saved);
+}
+
+void run_test()
+{
+	sim.install();
+	Application app("<Test$Dir>");
+
+	test_events(app);
+	test_window(app);
+	test_deferred_redraw(app);
+	test_messages(app);
+	test_poll_stats(app);
+	test_loader(app);
+	test_saver(app);
+
+	HOST_CHECK(sim.unsupported_calls() == 0);
+	if (sim.unsupported_calls()) std::printf("Last unsupported SWI &%X\n", sim.last_unsupported());
+}
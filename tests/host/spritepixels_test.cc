@@ -0,0 +1,272 @@
+/*
+ * Tests for direct sprite pixel access against a reference
+ * implementation that reads single bits from the sprite data.
+ */
+
+#include "hosttest.h"
+#include "tbx/spritepixels.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx;
+
+/**
+ * Build a sprite in memory filled with random data
+ *
+ * @param mask true to add a mask
+ * @param new_mask true for a 1bpp mask, false for a mask the same as the image
+ * @param left_bit first bit used in each row
+ */
+static std::vector<int> make_sprite(int width, int height, int bpp, int mode, bool mask, bool new_mask, int left_bit = 0)
+{
+	int bits = left_bit + width * bpp;
+	int words = (bits + 31) / 32;
+	int image_size = words * 4 * height;
+	int mask_words = new_mask ? (width + 31) / 32 : words;
+	int mask_size = mask ? mask_words * 4 * height : 0;
+
+	std::vector<int> sprite(11 + (image_size + mask_size) / 4);
+	sprite[0] = sprite.size() * 4;
+	sprite[4] = words - 1;
+	sprite[5] = height - 1;
+	sprite[6] = left_bit;
+	sprite[7] = (bits - 1) & 31;
+	sprite[8] = 44;
+	sprite[9] = mask ? 44 + image_size : 44;
+	sprite[10] = mode;
+
+	unsigned char *data = reinterpret_cast<unsigned char *>(&sprite[11]);
+	for (int i = 0; i < image_size + mask_size; i++) data[i] = (unsigned char)std::rand();
+	return sprite;
+}
+
+/**
+ * Reference pixel read one bit at a time from the documented layout
+ */
+static unsigned int ref_pixel(const std::vector<int> &sprite, int x, int y, int bpp)
+{
+	int words = sprite[4] + 1;
+	int height = sprite[5] + 1;
+	const unsigned char *row = reinterpret_cast<const unsigned char *>(&sprite[0]) + sprite[8] + (height - 1 - y) * words * 4;
+	int bit = sprite[6] + x * bpp;
+	unsigned int value = 0;
+	for (int b = 0; b < bpp; b++)
+	{
+		int pos = bit + b;
+		value |= ((row[pos >> 3] >> (pos & 7)) & 1u) << b;
+	}
+	return value;
+}
+
+static int mode_word(int type)
+{
+	return (type << 27) | (90 << 1) | (90 << 14) | 1;
+}
+
+static void test_depth(int bpp, int type)
+{
+	const int width = 37, height = 9;
+	std::vector<int> sprite = make_sprite(width, height, bpp, mode_word(type), true, true);
+	SpritePixels pixels(reinterpret_cast<OsSpritePtr>(&sprite[0]));
+
+	HOST_CHECK(pixels.width() == width);
+	HOST_CHECK(pixels.height() == height);
+	HOST_CHECK(pixels.bits_per_pixel() == bpp);
+	HOST_CHECK(pixels.has_mask());
+	HOST_CHECK(pixels.mask_bits_per_pixel() == 1);
+
+	bool same = true;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (pixels.pixel(x, y) != ref_pixel(sprite, x, y, bpp)) same = false;
+	HOST_CHECK(same);
+
+	// Fill only changes the pixels in the area
+	std::vector<int> before = sprite;
+	unsigned int value = 0x12345678u & ((bpp == 32) ? 0xFFFFFFFFu : ((1u << bpp) - 1));
+	pixels.fill(3, 2, 29, 5, value);
+	same = true;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			bool in = (x >= 3 && x < 32 && y >= 2 && y < 7);
+			if (ref_pixel(sprite, x, y, bpp) != (in ? value : ref_pixel(before, x, y, bpp))) same = false;
+		}
+	HOST_CHECK(same);
+
+	// Overlapping copy in the same sprite
+	before = sprite;
+	SpritePixels original(reinterpret_cast<OsSpritePtr>(&before[0]));
+	pixels.copy(5, 1, pixels, 2, 0, 30, 7);
+	same = true;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+		{
+			bool in = (x >= 5 && x < 35 && y >= 1 && y < 8);
+			unsigned int expected = in ? original.pixel(x - 3, y - 1) : original.pixel(x, y);
+			if (ref_pixel(sprite, x, y, bpp) != expected) same = false;
+		}
+	HOST_CHECK(same);
+	pixels.copy(0, 0, pixels, 4, 3, 40, 40); // Clipped to the sprite
+
+	// Mask from colour
+	unsigned int key = pixels.pixel(10, 4);
+	pixels.mask_from_colour(key);
+	same = true;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (pixels.mask_pixel(x, y) != (pixels.pixel(x, y) != key)) same = false;
+	HOST_CHECK(same);
+
+	pixels.fill_mask(0, 0, width, height, false);
+	same = true;
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			if (pixels.mask_pixel(x, y)) same = false;
+	HOST_CHECK(same);
+}
+
+template<int BPP> static void test_row(int type, unsigned int value)
+{
+	const int width = 13;
+	std::vector<int> sprite = make_sprite(width, 3, BPP, mode_word(type), false, false);
+	SpritePixels pixels(reinterpret_cast<OsSpritePtr>(&sprite[0]));
+	SpriteRow<BPP> row = pixels.row<BPP>(1);
+
+	bool same = true;
+	for (int x = 0; x < width; x++)
+		if (row[x] != ref_pixel(sprite, x, 1, BPP)) same = false;
+	HOST_CHECK(same);
+
+	row.set(5, value);
+	HOST_CHECK(ref_pixel(sprite, 5, 1, BPP) == (value & SpriteRow<BPP>::value_mask()));
+	HOST_CHECK(row[5] == (value & SpriteRow<BPP>::value_mask()));
+}
+
+static void test_rows()
+{
+	HOST_CHECK(SpriteRow<1>::value_mask() == 1);
+	HOST_CHECK(SpriteRow<4>::value_mask() == 15);
+	HOST_CHECK(SpriteRow<16>::value_mask() == 0xFFFF);
+	HOST_CHECK(SpriteRow<32>::value_mask() == 0xFFFFFFFFu);
+
+	test_row<1>(1, 1);
+	test_row<2>(2, 0xFF);
+	test_row<4>(3, 9);
+	test_row<8>(4, 77);
+	test_row<16>(5, 0x12345);
+	test_row<32>(6, 0xFEDCBA98u);
+
+	// Wrong depth for the sprite
+	std::vector<int> sprite = make_sprite(8, 2, 8, mode_word(4), false, false);
+	SpritePixels pixels(reinterpret_cast<OsSpritePtr>(&sprite[0]));
+	bool threw = false;
+	try
+	{
+		pixels.row<2>(0);
+	} catch(SpriteException &)
+	{
+		threw = true;
+	}
+	HOST_CHECK(threw);
+}
+
+static void test_old_format()
+{
+	// Old format with a left bit offset and a mask the same depth as the image
+	std::vector<int> sprite = make_sprite(21, 5, 4, 9, true, false, 8);
+	SpritePixels pixels(reinterpret_cast<OsSpritePtr>(&sprite[0]));
+	HOST_CHECK(pixels.width() == 21);
+	HOST_CHECK(pixels.bits_per_pixel() == 4);
+	HOST_CHECK(pixels.mask_bits_per_pixel() == 4);
+
+	bool same = true;
+	for (int y = 0; y < 5; y++)
+		for (int x = 0; x < 21; x++)
+			if (pixels.pixel(x, y) != ref_pixel(sprite, x, y, 4)) same = false;
+	HOST_CHECK(same);
+
+	pixels.fill(1, 1, 17, 3, 0xA);
+	same = true;
+	for (int y = 1; y < 4; y++)
+		for (int x = 1; x < 18; x++)
+			if (ref_pixel(sprite, x, y, 4) != 0xA) same = false;
+	HOST_CHECK(same);
+
+	pixels.mask_from_colour(0xA);
+	HOST_CHECK(!pixels.mask_pixel(1, 1));
+	HOST_CHECK(pixels.mask_pixel(0, 0) == (pixels.pixel(0, 0) != 0xA));
+
+	// Mode 13 is a 256 colour mode with an odd mode number
+	std::vector<int> mode13 = make_sprite(10, 3, 8, 13, false, false);
+	HOST_CHECK(SpritePixels(reinterpret_cast<OsSpritePtr>(&mode13[0])).bits_per_pixel() == 8);
+}
+
+static void test_convert()
+{
+	std::vector<int> s8 = make_sprite(19, 4, 8, mode_word(4), false, false);
+	std::vector<int> s16 = make_sprite(19, 4, 16, mode_word(5), false, false);
+	std::vector<int> s32 = make_sprite(19, 4, 32, mode_word(6), false, false);
+	SpritePixels p8(reinterpret_cast<OsSpritePtr>(&s8[0]));
+	SpritePixels p16(reinterpret_cast<OsSpritePtr>(&s16[0]));
+	SpritePixels p32(reinterpret_cast<OsSpritePtr>(&s32[0]));
+
+	ColourPalette palette(256);
+	for (int j = 0; j < 256; j++) palette[j] = Colour(j, 255 - j, j / 2);
+
+	p8.convert(p32, &palette);
+	bool same = true;
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 19; x++)
+		{
+			unsigned int v = p8.pixel(x, y);
+			if (p32.pixel(x, y) != (v | ((255 - v) << 8) | ((v / 2) << 16))) same = false;
+		}
+	HOST_CHECK(same);
+
+	// Round trip through 32K colours loses the bottom 3 bits
+	p32.convert(p16);
+	p16.convert(p32);
+	same = true;
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 19; x++)
+		{
+			unsigned int v = p8.pixel(x, y);
+			unsigned int r = v & 0xF8, g = (255 - v) & 0xF8, b = (v / 2) & 0xF8;
+			unsigned int expected = (r | r >> 5) | ((g | g >> 5) << 8) | ((b | b >> 5) << 16);
+			if (p32.pixel(x, y) != expected) same = false;
+		}
+	HOST_CHECK(same);
+
+	unsigned int table[256];
+	for (int j = 0; j < 256; j++) table[j] = 255 - j;
+	std::vector<int> copy8 = s8;
+	SpritePixels original(reinterpret_cast<OsSpritePtr>(&copy8[0]));
+	p8.lookup(p8, table);
+	same = true;
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 19; x++)
+			if (p8.pixel(x, y) != 255 - original.pixel(x, y)) same = false;
+	HOST_CHECK(same);
+
+	bool threw = false;
+	try
+	{
+		p32.convert(p8);
+	} catch(SpriteException &)
+	{
+		threw = true;
+	}
+	HOST_CHECK(threw);
+}
+
+void run_test()
+{
+	std::srand(1);
+	static const int depths[] = {1, 2, 4, 8, 16, 32};
+	for (int i = 0; i < 6; i++) test_depth(depths[i], i + 1);
+	test_rows();
+	test_old_format();
+	test_convert();
+}
@@ -0,0 +1,110 @@
+/*
+ * Benchmark of reading and writing tag documents in the text
+ * and binary formats
+ */
+
+#include "hosttest.h"
+#include "tbx/tag.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using namespace tbx;
+
+static void report(const char *name, double start, unsigned int ops, std::string::size_type bytes)
+{
+	double taken = hosttest::seconds() - start;
+	std::printf("  %-16s %8.3f ms %8.1f us/doc %8.1f MB/s\n", name,
+		taken * 1e3, taken * 1e6 / ops, bytes * (double)ops / taken / 1e6);
+}
+
+/**
+ * Build a document like a small settings or project file
+ */
+static void build_doc(TagDoc &doc, unsigned int items)
+{
+	char number[16];
+	Tag *list = doc.add_child("items");
+	for (unsigned int j = 0; j < items; j++)
+	{
+		std::sprintf(number, "%u", j);
+		Tag *item = list->add_child("item");
+		item->attribute("id", number);
+		item->attribute("name", std::string("Item number ") + number);
+		if (j % 3 == 0) item->attribute("selected");
+		Tag *pos = item->add_child("position");
+		pos->attribute("x", number);
+		pos->attribute("y", number);
+		item->add_child("comment")->text("Some text & <markup> to escape");
+	}
+}
+
+static unsigned int count_tags(Tag *tag)
+{
+	unsigned int count = 0;
+	for (Tag *child = tag->first_child(); child; child = child->next())
+	{
+		count += 1 + count_tags(child);
+	}
+	return count;
+}
+
+void run_test()
+{
+	const unsigned int ITEMS = 1000;
+	const unsigned int REPEATS = 50;
+
+	TagDoc doc;
+	build_doc(doc, ITEMS);
+	unsigned int tags = count_tags(&doc);
+
+	std::ostringstream text_os, binary_os;
+	text_os << doc;
+	doc.write_binary(binary_os);
+	std::string text = text_os.str();
+	std::string binary = binary_os.str();
+
+	std::printf("TagDoc %u tags, text %u bytes, binary %u bytes\n", tags,
+		(unsigned int)text.size(), (unsigned int)binary.size());
+
+	unsigned int j;
+	double start = hosttest::seconds();
+	for (j = 0; j < REPEATS; j++)
+	{
+		std::ostringstream os;
+		os << doc;
+	}
+	report("write text", start, REPEATS, text.size());
+
+	start = hosttest::seconds();
+	for (j = 0; j < REPEATS; j++)
+	{
+		std::ostringstream os;
+		doc.write_binary(os);
+	}
+	report("write binary", start, REPEATS, binary.size());
+
+	bool same = true;
+	start = hosttest::seconds();
+	for (j = 0; j < REPEATS; j++)
+	{
+		std::istringstream is(text);
+		TagDoc read_doc;
+		is >> read_doc;
+		if (count_tags(&read_doc) != tags) same = false;
+	}
+	report("read text", start, REPEATS, text.size());
+
+	start = hosttest::seconds();
+	for (j = 0; j < REPEATS; j++)
+	{
+		std::istringstream is(binary);
+		TagDoc read_doc;
+		is >> read_doc;
+		if (count_tags(&read_doc) != tags) same = false;
+	}
+	report("read binary", start, REPEATS, binary.size());
+
+	HOST_CHECK(same);
+}
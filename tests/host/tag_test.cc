@@ -0,0 +1,329 @@
+/*
+ * Tests for tag documents, their child and attribute indexes and
+ * reading and writing them in the binary format
+ */
+
+#include "hosttest.h"
+#include "tbx/tag.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+using namespace tbx;
+
+/**
+ * Stream buffer over a string that can not seek
+ */
+class NoSeekBuf : public std::streambuf
+{
+	std::string _data;
+public:
+	NoSeekBuf(const std::string &data) : _data(data)
+	{
+		setg(&_data[0], &_data[0], &_data[0] + _data.size());
+	}
+};
+
+/**
+ * Check is_binary on some data and that it leaves the stream
+ * at the start of the data.
+ */
+static bool check_is_binary(const std::string &data, bool seekable)
+{
+	bool binary;
+	char first;
+	if (seekable)
+	{
+		std::istringstream is(data);
+		binary = TagDoc::is_binary(is);
+		HOST_CHECK(is.good());
+		first = (char)is.get();
+	} else
+	{
+		NoSeekBuf buf(data);
+		std::istream is(&buf);
+		binary = TagDoc::is_binary(is);
+		HOST_CHECK(is.good());
+		first = (char)is.get();
+	}
+	HOST_CHECK(first == data[0]);
+	return binary;
+}
+
+/**
+ * Binary document with tags nested to the given depth
+ */
+static std::string nested_binary(int depth)
+{
+	std::string data("\0TAG\1\1\1a\0\1", 10);
+	for (int j = 1; j < depth; j++) data.append("\0\0\0\1", 4);
+	data.append("\0\0\0\0", 4);
+	return data;
+}
+
+static TagException::Cause read_binary_cause(const std::string &data)
+{
+	std::istringstream is(data);
+	TagDoc doc;
+	try
+	{
+		is >> doc;
+	} catch(TagException &e)
+	{
+		return e.cause();
+	}
+	return TagException::None;
+}
+
+static void test_header()
+{
+	std::string header("\0TAG\1\0\0\0", 8);
+	HOST_CHECK(check_is_binary(header, true));
+	HOST_CHECK(check_is_binary(header, false));
+
+	std::string bad_id("\0TAX\1\0\0\0", 8);
+	HOST_CHECK(!check_is_binary(bad_id, true));
+	HOST_CHECK(!check_is_binary(bad_id, false));
+
+	std::string new_version("\0TAG\2\0\0\0", 8);
+	HOST_CHECK(!check_is_binary(new_version, true));
+	HOST_CHECK(!check_is_binary(new_version, false));
+
+	std::string short_header("\0TA", 3);
+	HOST_CHECK(!check_is_binary(short_header, true));
+	HOST_CHECK(!check_is_binary(short_header, false));
+
+	HOST_CHECK(!check_is_binary("<a/>", true));
+	HOST_CHECK(!check_is_binary("<a/>", false));
+
+	// Data starting with a 0 is rejected as binary, not parsed as text
+	HOST_CHECK(read_binary_cause(bad_id) == TagException::InvalidBinary);
+	HOST_CHECK(read_binary_cause(new_version) == TagException::InvalidBinary);
+	HOST_CHECK(read_binary_cause(header) == TagException::None);
+}
+
+static void test_depth()
+{
+	std::istringstream deepest(nested_binary(TagDoc::MAX_BINARY_DEPTH));
+	TagDoc doc;
+	deepest >> doc;
+	int depth = 0;
+	for (Tag *tag = doc.first_child(); tag; tag = tag->first_child()) depth++;
+	HOST_CHECK(depth == TagDoc::MAX_BINARY_DEPTH);
+
+	HOST_CHECK(read_binary_cause(nested_binary(TagDoc::MAX_BINARY_DEPTH + 1)) == TagException::InvalidBinary);
+}
+
+static const int NAMES = 5;
+
+static std::string name_of(int index)
+{
+	char name[8];
+	std::sprintf(name, "n%d", index);
+	return name;
+}
+
+/**
+ * Check the children found by id match a list of the children
+ */
+static bool children_match(TagDoc &doc, Tag *parent, const std::vector<Tag *> &children)
+{
+	if (parent->first_child() != (children.empty() ? 0 : children.front())) return false;
+	if (parent->last_child() != (children.empty() ? 0 : children.back())) return false;
+
+	for (int n = 0; n < NAMES; n++)
+	{
+		int id = doc.tag_id(name_of(n));
+		Tag *found = parent->find_child(id);
+		for (std::vector<Tag *>::const_iterator i = children.begin(); i != children.end(); ++i)
+		{
+			if ((*i)->id() != id) continue;
+			if (found != *i) return false;
+			found = parent->find_child(id, found);
+		}
+		if (found != 0) return false;
+	}
+
+	Tag *child = parent->first_child();
+	for (std::vector<Tag *>::const_iterator i = children.begin(); i != children.end(); ++i)
+	{
+		if (child != *i) return false;
+		child = child->next();
+	}
+	return child == 0;
+}
+
+/**
+ * Randomly add and delete children, checking they are found in
+ * the order they were added as the child index is built and kept.
+ */
+static void test_child_index(int storage)
+{
+	TagDoc doc(storage);
+	Tag *parent = doc.add_child("parent");
+	std::vector<Tag *> children;
+	bool match = true;
+
+	for (int step = 0; step < 2000 && match; step++)
+	{
+		if (children.empty() || std::rand() % 3 != 0)
+		{
+			children.push_back(parent->add_child(name_of(std::rand() % NAMES)));
+			children.back()->attribute("step", "x");
+		} else
+		{
+			// Delete first, last or any child
+			unsigned int pos;
+			switch(std::rand() % 3)
+			{
+			case 0: pos = 0; break;
+			case 1: pos = children.size() - 1; break;
+			default: pos = std::rand() % children.size(); break;
+			}
+			parent->delete_child(children[pos]);
+			children.erase(children.begin() + pos);
+		}
+		match = children_match(doc, parent, children);
+	}
+	HOST_CHECK(match);
+
+	// Delete every child with one id from an indexed parent
+	int id = doc.tag_id(name_of(0));
+	Tag *child;
+	while ((child = parent->find_child(id)) != 0)
+	{
+		parent->delete_child(child);
+		for (std::vector<Tag *>::iterator i = children.begin(); i != children.end(); ++i)
+		{
+			if (*i == child)
+			{
+				children.erase(i);
+				break;
+			}
+		}
+	}
+	HOST_CHECK(children_match(doc, parent, children));
+	parent->add_child(name_of(0));
+	HOST_CHECK(parent->find_child(id) == parent->last_child());
+}
+
+/**
+ * Randomly set and delete attributes, checking they are found
+ * as the attribute index is built and kept.
+ */
+static void test_attribute_index(int storage)
+{
+	const int ATTRIBUTES = 40;
+	TagDoc doc(storage);
+	Tag *tag = doc.add_child("tag");
+	std::map<int, std::string> model;
+	bool match = true;
+
+	for (int step = 0; step < 2000 && match; step++)
+	{
+		int att = std::rand() % ATTRIBUTES;
+		std::string name = name_of(att);
+		if (std::rand() % 3 != 0)
+		{
+			std::string value = name_of(step);
+			tag->attribute(name, value);
+			model[att] = value;
+		} else
+		{
+			tag->delete_attribute(name);
+			model.erase(att);
+		}
+
+		for (int j = 0; j < ATTRIBUTES && match; j++)
+		{
+			TagAttribute *found = tag->find_attribute(name_of(j));
+			std::map<int, std::string>::iterator expected = model.find(j);
+			if (expected == model.end()) match = (found == 0);
+			else match = (found != 0 && found->value() == expected->second && found->id() == doc.attribute_id(name_of(j)));
+		}
+		unsigned int count = 0;
+		for (TagAttribute *att = tag->first_attribute(); att; att = att->next()) count++;
+		if (count != model.size()) match = false;
+	}
+	HOST_CHECK(match);
+
+	// Attribute name added after the index was built
+	tag->attribute("later", "value");
+	HOST_CHECK(tag->attribute_value("later") == "value");
+	HOST_CHECK(tag->find_attribute("unknown") == 0);
+	HOST_CHECK(tag->find_attribute(-1) == 0);
+
+	// Clearing the tag removes the index with the attributes
+	Tag *copy = doc.add_child("copy");
+	for (int j = 0; j < ATTRIBUTES; j++) copy->attribute(name_of(j));
+	HOST_CHECK(copy->find_attribute(name_of(ATTRIBUTES - 1)) != 0);
+	doc.delete_child(copy);
+}
+
+void run_test()
+{
+	test_header();
+	test_depth();
+
+	std::srand(7);
+	int storage[4] = {TagDoc::HEAP, TagDoc::ARENA, TagDoc::CHILD_INDEX, TagDoc::ARENA | TagDoc::CHILD_INDEX};
+	for (int j = 0; j < 4; j++)
+	{
+		test_child_index(storage[j]);
+		test_attribute_index(storage[j]);
+	}
+
+	std::string long_text(1000, 'x');
+	TagDoc doc;
+	Tag *child = doc.add_child("item");
+	child->attribute("text", long_text);
+	child->add_child("sub")->attribute("empty", "");
+
+	std::ostringstream os;
+	doc.write_binary(os);
+
+	TagDoc read_doc;
+	std::istringstream is(os.str());
+	HOST_CHECK(TagDoc::is_binary(is));
+	read_doc.read_binary(is);
+	Tag *item = read_doc.first_child();
+	HOST_CHECK(item != 0 && item->name() == "item");
+	if (item)
+	{
+		TagAttribute *text = item->find_attribute(read_doc.attribute_id("text"));
+		HOST_CHECK(text != 0 && text->value() == long_text);
+		HOST_CHECK(item->first_child() != 0 && item->first_child()->name() == "sub");
+	}
+
+	// Truncated data fails while reading a string
+	std::string truncated = os.str().substr(0, os.str().size() - 500);
+	std::istringstream short_is(truncated);
+	TagDoc short_doc;
+	TagException::Cause cause = TagException::None;
+	try
+	{
+		short_doc.read_binary(short_is);
+	} catch(TagException &e)
+	{
+		cause = e.cause();
+	}
+	HOST_CHECK(cause == TagException::ErrorReading);
+
+	// A corrupt string length fails without trying to allocate it
+	std::string corrupt("\0TAG\1\1\xFF\xFF\xFF\xFF\x0Fitem", 15);
+	std::istringstream corrupt_is(corrupt);
+	TagDoc corrupt_doc;
+	cause = TagException::None;
+	try
+	{
+		corrupt_doc.read_binary(corrupt_is);
+	} catch(TagException &e)
+	{
+		cause = e.cause();
+	}
+	HOST_CHECK(cause == TagException::ErrorReading);
+}
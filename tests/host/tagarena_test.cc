@@ -0,0 +1,64 @@
+/*
+ * Tests for the TagArena used to allocate tags and attributes
+ */
+
+#include "hosttest.h"
+#include "tbx/tagarena.h"
+
+#include <cstring>
+#include <set>
+#include <vector>
+
+using namespace tbx;
+
+/**
+ * Allocate items across several blocks and check they are aligned,
+ * do not overlap and are reused after they are released.
+ */
+static void test_allocate(unsigned int item_size)
+{
+	const unsigned int BLOCK_ITEMS = 16;
+	const unsigned int ITEMS = BLOCK_ITEMS * 5 + 3;
+	TagArena arena(item_size, BLOCK_ITEMS);
+	std::vector<unsigned char *> items;
+	unsigned int j;
+
+	for (j = 0; j < ITEMS; j++)
+	{
+		unsigned char *item = static_cast<unsigned char *>(arena.allocate());
+		std::memset(item, (int)(j & 0xFF), item_size);
+		items.push_back(item);
+	}
+
+	// Filling an item does not change any other item
+	bool aligned = true, kept = true;
+	std::set<unsigned char *> distinct(items.begin(), items.end());
+	for (j = 0; j < ITEMS; j++)
+	{
+		if ((reinterpret_cast<unsigned long>(items[j]) & 7) != 0) aligned = false;
+		for (unsigned int b = 0; b < item_size; b++)
+		{
+			if (items[j][b] != (j & 0xFF)) kept = false;
+		}
+	}
+	HOST_CHECK(distinct.size() == ITEMS);
+	HOST_CHECK(aligned);
+	HOST_CHECK(kept);
+
+	// Released items are reused, most recently released first
+	arena.release(items[3]);
+	arena.release(items[40]);
+	HOST_CHECK(arena.allocate() == items[40]);
+	HOST_CHECK(arena.allocate() == items[3]);
+
+	// Then new items come from the end of the last block
+	unsigned char *fresh = static_cast<unsigned char *>(arena.allocate());
+	HOST_CHECK(distinct.count(fresh) == 0);
+}
+
+void run_test()
+{
+	test_allocate(1);
+	test_allocate(12);
+	test_allocate(40);
+}
@@ -0,0 +1,458 @@
+/*
+ * Tests for the streaming TagReader and the TagDoc text reader
+ * built on it
+ */
+
+#include "hosttest.h"
+#include "tbx/tagreader.h"
+#include "tbx/tag.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace tbx;
+
+/**
+ * Handler that records each part it is given as a string and can
+ * stop the reader after a number of parts
+ */
+class RecordHandler : public TagReadHandler
+{
+public:
+	std::vector<std::string> parts;
+	unsigned int stop_after;
+
+	RecordHandler(unsigned int stop = 0xFFFFFFFF) : stop_after(stop) {}
+
+	virtual bool start_tag(const std::string &name) {return add("start " + name);}
+	virtual bool attribute(const std::string &name, const std::string &value, bool has_value)
+	{
+		return add(has_value ? ("att " + name + "=" + value) : ("att " + name));
+	}
+	virtual bool text(const std::string &text) {return add("text " + text);}
+	virtual bool end_tag(const std::string &name) {return add("end " + name);}
+
+	/**
+	 * Check the parts recorded match a list ending with a null pointer
+	 */
+	bool parts_are(const char **expected) const
+	{
+		unsigned int j = 0;
+		while (expected[j])
+		{
+			if (j >= parts.size() || parts[j] != expected[j]) return false;
+			j++;
+		}
+		return (j == parts.size());
+	}
+
+private:
+	bool add(const std::string &part)
+	{
+		parts.push_back(part);
+		return (parts.size() < stop_after);
+	}
+};
+
+static bool read_parts(const std::string &data, const char **expected)
+{
+	std::istringstream is(data);
+	TagReader reader(is);
+	RecordHandler handler;
+	bool read = reader.read(handler);
+	return read && handler.parts_are(expected);
+}
+
+static void test_nested()
+{
+	const char *nested[] = {"start a", "start b", "start c", "end c", "end b",
+		"start d", "end d", "start e", "end e", "end a", 0};
+	HOST_CHECK(read_parts("<a><b><c/></b><d></d><e /></a>", nested));
+	HOST_CHECK(read_parts("<a>\n   <b>\n      <c/>\n   </b>\n   <d>  </d>\n   <e/>\n</a>\n", nested));
+
+	// End tags may have a space before the >
+	const char *spaced[] = {"start a", "end a", 0};
+	HOST_CHECK(read_parts("<a></a >", spaced));
+
+	// Several top level tags
+	const char *several[] = {"start a", "end a", "start b", "start c", "end c", "end b", 0};
+	HOST_CHECK(read_parts("<a/>\n<b><c/></b>\n\n", several));
+
+	// read_tag reads one top level tag at a time
+	std::istringstream is("<a><b/></a><c/>");
+	TagReader reader(is);
+	RecordHandler handler;
+	HOST_CHECK(reader.read_tag(handler));
+	HOST_CHECK(handler.parts.size() == 4);
+	HOST_CHECK(reader.read_tag(handler));
+	HOST_CHECK(handler.parts.size() == 6);
+	HOST_CHECK(reader.depth() == 0);
+}
+
+static void test_attributes()
+{
+	const char *atts[] = {"start a", "att x=1", "att flag", "att y=two words",
+		"att z=", "end a", 0};
+	HOST_CHECK(read_parts("<a x = \"1\" flag y=\"two words\" z = \"\"/>", atts));
+	HOST_CHECK(read_parts("<a x=\"1\" flag y = \"two words\" z=\"\"></a>", atts));
+
+	const char *entities[] = {"start a", "att v=<&>\"'", "att last", "end a", 0};
+	HOST_CHECK(read_parts("<a v=\"&lt;&amp;&gt;&quot;&apos;\" last/>", entities));
+
+	// Attributes with no values followed by other attributes
+	const char *flags[] = {"start a", "att one", "att two", "text x", "end a", 0};
+	HOST_CHECK(read_parts("<a one two>x</a>", flags));
+	HOST_CHECK(read_parts("<a one two >x</a>", flags));
+	const char *closed[] = {"start a", "att one", "att two", "att three", "end a", 0};
+	HOST_CHECK(read_parts("<a one two three/>", closed));
+	const char *mixed[] = {"start a", "att one", "att two", "att x=1", "att three", "end a", 0};
+	HOST_CHECK(read_parts("<a one two x=\"1\" three/>", mixed));
+	HOST_CHECK(read_parts("<a one two x = \"1\" three />", mixed));
+}
+
+static void test_text()
+{
+	const char *around[] = {"start a", "text before", "start b", "end b",
+		"text middle", "start c", "text inner", "end c", "text after ", "end a", 0};
+	HOST_CHECK(read_parts("<a>before<b/>middle<c>inner</c>after </a>", around));
+
+	const char *entities[] = {"start a", "text 1 < 2 & \"3\" > 'x'", "end a", 0};
+	HOST_CHECK(read_parts("<a>1 &lt; 2 &amp; &quot;3&quot; &gt; &apos;x&apos;</a>", entities));
+
+	// TagDoc joins the text around the children
+	std::istringstream is("<a>before<b/>middle<c>inner</c>after</a>");
+	TagDoc doc;
+	is >> doc;
+	Tag *a = doc.first_child();
+	HOST_CHECK(a != 0 && a->text() == "beforemiddleafter");
+	HOST_CHECK(a != 0 && a->find_child("c") && a->find_child("c")->text() == "inner");
+
+	// Text is not cleared by whitespace after a child
+	std::istringstream spaced("<a>kept<b x=\"1\"/>\n   <c/>\n</a>");
+	TagDoc spaced_doc;
+	spaced >> spaced_doc;
+	HOST_CHECK(spaced_doc.first_child()->text() == "kept");
+}
+
+static TagException::Cause read_cause(const std::string &data)
+{
+	std::istringstream is(data);
+	TagReader reader(is);
+	RecordHandler handler;
+	try
+	{
+		reader.read(handler);
+	} catch(TagException &e)
+	{
+		return e.cause();
+	}
+	return TagException::None;
+}
+
+static void test_malformed()
+{
+	HOST_CHECK(read_cause("") == TagException::None);
+	HOST_CHECK(read_cause("x") == TagException::InvalidTagStartChar);
+	HOST_CHECK(read_cause("<a></b>") == TagException::EndTagNotMatch);
+	HOST_CHECK(read_cause("</a>") == TagException::EndTagNotMatch);
+	HOST_CHECK(read_cause("<a><b></a>") == TagException::EndTagNotMatch);
+	HOST_CHECK(read_cause("<a></a x>") == TagException::InvalidTagEndChar);
+	HOST_CHECK(read_cause("<a/x>") == TagException::InvalidTagEndChar);
+	HOST_CHECK(read_cause("<a=>") == TagException::InvalidNameEnd);
+	HOST_CHECK(read_cause("<>") == TagException::MissingTagName);
+	HOST_CHECK(read_cause("<a x=1/>") == TagException::InvalidStringStart);
+	HOST_CHECK(read_cause("<a x=\"1</a>") == TagException::InvalidStringEnd);
+	HOST_CHECK(read_cause("<a>&bad;</a>") == TagException::InvalidEntity);
+	HOST_CHECK(read_cause("<a>&amp</a>") == TagException::InvalidEntityEnd);
+	HOST_CHECK(read_cause("<a>") == TagException::ErrorReading);
+	HOST_CHECK(read_cause("<a><b/>") == TagException::ErrorReading);
+
+	// TagDoc reports an empty file
+	std::istringstream is("   ");
+	TagDoc doc;
+	TagException::Cause cause = TagException::None;
+	try
+	{
+		doc.read_tag(is);
+	} catch(TagException &e)
+	{
+		cause = e.cause();
+	}
+	HOST_CHECK(cause == TagException::EmptyFile);
+}
+
+static void test_stop()
+{
+	std::istringstream is("<a x=\"1\"><b/><c/></a><d/>");
+	TagReader reader(is);
+	RecordHandler handler(3);
+	HOST_CHECK(!reader.read(handler));
+	HOST_CHECK(reader.stopped());
+	HOST_CHECK(handler.parts.size() == 3);
+	HOST_CHECK(handler.parts.back() == "start b");
+	HOST_CHECK(reader.depth() == 2);
+
+	// Once stopped the reader does no more
+	HOST_CHECK(!reader.read_tag(handler));
+	HOST_CHECK(handler.parts.size() == 3);
+}
+
+//! Names and text used to build random documents
+static const char *words[] = {"item", "name", "value", "a", "x_y", "Long.Name", "t1", "&<>\"'"};
+
+static std::string random_text()
+{
+	std::string text;
+	int count = std::rand() % 4;
+	for (int j = 0; j < count; j++)
+	{
+		if (j) text += ' ';
+		text += words[std::rand() % 8];
+	}
+	return text;
+}
+
+/**
+ * Add random children to a tag.
+ *
+ * Only tags without children are given text as write_tag puts
+ * the line break and indent of the children in the text.
+ */
+static void add_random(Tag *tag, int depth)
+{
+	int children = (depth < 4) ? std::rand() % 4 : 0;
+	for (int j = 0; j < children; j++)
+	{
+		Tag *child = tag->add_child(words[std::rand() % 7]);
+		int atts = std::rand() % 4;
+		for (int k = 0; k < atts; k++)
+		{
+			const char *name = words[std::rand() % 7];
+			if (std::rand() % 3) child->attribute(name, random_text());
+			else child->attribute(name);
+		}
+		add_random(child, depth + 1);
+		if (child->first_child() == 0) child->text(random_text());
+	}
+}
+
+/**
+ * The TagDoc text reader from before it used TagReader, with the
+ * parsing fixes made since. A tag with no attributes can be closed
+ * with "/>", empty text does not replace text already read and an
+ * attribute with no value can be followed by any other attribute.
+ */
+static void old_read_tag(TagDoc &doc, std::istream &is)
+{
+	Tag *tag = &doc;
+	std::string tag_name;
+	std::string att_name, next_att_name;
+	std::string att_value;
+	std::string text;
+	bool start_tag = false;
+	char c;
+
+	is.setf(std::ios::skipws);
+
+	do
+	{
+		if (start_tag)
+		{
+			c = TagReader::read_string(is, text);
+			if (!text.empty()) tag->text(text);
+			start_tag = false;
+		} else
+		{
+			is >> c;
+		}
+		if (!is)
+		{
+			if (tag == &doc) throw TagException(TagException::EmptyFile,"");
+			else throw TagException(TagException::ErrorReading, "");
+		}
+
+		if (c != '<') throw TagException(TagException::InvalidTagStartChar, c);
+		c = TagReader::read_name(is, tag_name);
+
+		if (c == '/' && tag_name.empty())
+		{
+			c = TagReader::read_name(is, tag_name);
+			if (tag->name() != tag_name) throw TagException(TagException::EndTagNotMatch, tag_name);
+			if (c == ' ') is >> c;
+			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
+			tag = tag->parent();
+		} else if (c != '>' && c != ' ' && c != '/') throw TagException(TagException::InvalidNameEnd, c);
+		else
+		{
+			if (tag_name.empty()) throw TagException(TagException::MissingTagName,"");
+			tag = tag->add_child(tag_name);
+			start_tag = true;
+
+			next_att_name.erase();
+
+			while (((c != '>' && c != '/') || !next_att_name.empty()) && is)
+			{
+				if (!next_att_name.empty())
+				{
+					att_name = next_att_name;
+					next_att_name.erase();
+				} else c = TagReader::read_name(is, att_name);
+
+				if (c == ' ') c = TagReader::read_name(is, next_att_name);
+
+				if (c == '=' && next_att_name.empty())
+				{
+					is >> c;
+					if (c != '\"') throw TagException(TagException::InvalidStringStart,c);
+					c = TagReader::read_string(is, att_value);
+					if (c != '\"') throw TagException(TagException::InvalidStringEnd,c);
+					tag->attribute(att_name, att_value);
+				} else if (!att_name.empty())
+					tag->attribute(att_name);
+			}
+
+			if (c == '/')
+			{
+				is >> c;
+				tag = tag->parent();
+			}
+			if (c != '>') throw TagException(TagException::InvalidTagEndChar, c);
+		}
+
+	} while (tag != &doc);
+}
+
+static unsigned int attribute_count(Tag *tag)
+{
+	unsigned int count = 0;
+	for (TagAttribute *att = tag->first_attribute(); att; att = att->next()) count++;
+	return count;
+}
+
+/**
+ * Check two tags have the same name, attributes, text and children.
+ *
+ * Attributes are matched by name as they are not read back in the
+ * order they were written.
+ */
+static bool same_tags(Tag *a, Tag *b)
+{
+	if (a->name() != b->name() || a->text() != b->text()) return false;
+
+	if (attribute_count(a) != attribute_count(b)) return false;
+	for (TagAttribute *att_a = a->first_attribute(); att_a; att_a = att_a->next())
+	{
+		TagAttribute *att_b = b->find_attribute(a->doc()->attribute_name(att_a->id()));
+		if (att_b == 0
+			|| att_a->has_value() != att_b->has_value()
+			|| (att_a->has_value() && att_a->value() != att_b->value()))
+		{
+			return false;
+		}
+	}
+
+	Tag *child_a = a->first_child();
+	Tag *child_b = b->first_child();
+	while (child_a && child_b)
+	{
+		if (!same_tags(child_a, child_b)) return false;
+		child_a = child_a->next();
+		child_b = child_b->next();
+	}
+	return (child_a == 0 && child_b == 0);
+}
+
+static bool same_docs(TagDoc &a, TagDoc &b)
+{
+	Tag *child_a = a.first_child();
+	Tag *child_b = b.first_child();
+	while (child_a && child_b)
+	{
+		if (!same_tags(child_a, child_b)) return false;
+		child_a = child_a->next();
+		child_b = child_b->next();
+	}
+	return (child_a == 0 && child_b == 0);
+}
+
+static void test_round_trip()
+{
+	std::srand(8);
+	bool all_same = true, all_old = true;
+	for (int n = 0; n < 100; n++)
+	{
+		TagDoc doc;
+		Tag *root = doc.add_child("root");
+		add_random(root, 0);
+
+		std::ostringstream os;
+		os << doc;
+
+		std::istringstream is(os.str());
+		TagDoc read_doc;
+		is >> read_doc;
+		if (!same_docs(doc, read_doc)) all_same = false;
+
+		std::istringstream old_is(os.str());
+		TagDoc old_doc;
+		old_read_tag(old_doc, old_is);
+		if (!same_docs(read_doc, old_doc)) all_old = false;
+	}
+	HOST_CHECK(all_same);
+	HOST_CHECK(all_old);
+
+	// Text of a tag with no children and the output reads back the
+	// same. Reading reverses the order of the attributes so it takes
+	// two round trips to get back to the original output.
+	bool same_output = true;
+	for (int n = 0; n < 20; n++)
+	{
+		TagDoc doc;
+		add_random(doc.add_child("root"), 0);
+		std::ostringstream os;
+		os << doc;
+		std::istringstream is(os.str());
+		TagDoc read_doc;
+		is >> read_doc;
+		std::ostringstream again;
+		again << read_doc;
+		std::istringstream again_is(again.str());
+		TagDoc again_doc;
+		again_is >> again_doc;
+		std::ostringstream third;
+		third << again_doc;
+		if (third.str() != os.str()) same_output = false;
+	}
+	HOST_CHECK(same_output);
+
+	// Text with children reads the same as the old reader
+	TagDoc doc;
+	Tag *parent = doc.add_child("parent");
+	parent->text("some text");
+	parent->add_child("child")->attribute("a", "1");
+	parent->add_child("child")->text("inner");
+	std::ostringstream os;
+	os << doc;
+
+	std::istringstream is(os.str());
+	TagDoc read_doc;
+	is >> read_doc;
+	std::istringstream old_is(os.str());
+	TagDoc old_doc;
+	old_read_tag(old_doc, old_is);
+	HOST_CHECK(same_docs(read_doc, old_doc));
+	HOST_CHECK(read_doc.first_child()->text().compare(0, 9, "some text") == 0);
+}
+
+void run_test()
+{
+	test_nested();
+	test_attributes();
+	test_text();
+	test_malformed();
+	test_stop();
+	test_round_trip();
+}
@@ -0,0 +1,158 @@
+/*
+ * Tests for the timer queue using a simulated clock
+ */
+
+#include "hosttest.h"
+#include "tbx/timerqueue.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace tbx;
+
+static unsigned int fake_time = 0;
+
+static unsigned int fake_clock()
+{
+	return fake_time;
+}
+
+/**
+ * Timer that records when it is called
+ */
+class RecordTimer : public Timer
+{
+public:
+	int id;
+	std::vector<int> *calls;
+	std::vector<unsigned int> lateness;
+
+	RecordTimer(int i, std::vector<int> *c) : id(i), calls(c) {}
+	virtual void timer(unsigned int elapsed)
+	{
+		calls->push_back(id);
+		lateness.push_back(elapsed);
+	}
+};
+
+/**
+ * Timer that throws an exception when it is called
+ */
+class ThrowTimer : public Timer
+{
+public:
+	int count;
+	ThrowTimer() : count(0) {}
+	virtual void timer(unsigned int)
+	{
+		count++;
+		throw std::runtime_error("timer failed");
+	}
+};
+
+/**
+ * Timer that adds another timer when it is called
+ */
+class AddTimer : public Timer
+{
+public:
+	TimerQueue &queue;
+	Timer *to_add;
+	AddTimer(TimerQueue &q, Timer *add) : queue(q), to_add(add) {}
+	virtual void timer(unsigned int)
+	{
+		queue.add(0, to_add, false);
+	}
+};
+
+static void test_order()
+{
+	fake_time = 0xFFFFFF00; // Check wrap around as well
+	TimerQueue queue(fake_clock);
+	std::vector<int> calls;
+	RecordTimer t1(1, &calls), t2(2, &calls), t3(3, &calls);
+
+	queue.add(30, &t3, false);
+	queue.add(10, &t1, true);
+	queue.add(20, &t2, false);
+	HOST_CHECK(queue.size() == 3);
+	HOST_CHECK(queue.next_due() == fake_time + 10);
+
+	fake_time += 25;
+	queue.process();
+	HOST_CHECK(calls.size() == 2);
+	if (calls.size() == 2)
+	{
+		HOST_CHECK(calls[0] == 1);
+		HOST_CHECK(calls[1] == 2);
+	}
+	HOST_CHECK(t1.lateness[0] == 15);
+	HOST_CHECK(queue.size() == 2);
+
+	// Repeating timer skips the calls it missed
+	calls.clear();
+	fake_time += 100;
+	queue.process();
+	HOST_CHECK(calls.size() == 2);
+	HOST_CHECK(queue.size() == 1);
+	HOST_CHECK(queue.next_due() == 0xFFFFFF00 + 130);
+
+	HOST_CHECK(queue.remove(&t1));
+	HOST_CHECK(queue.empty());
+}
+
+static void test_added_in_callback()
+{
+	fake_time = 1000;
+	TimerQueue queue(fake_clock);
+	std::vector<int> calls;
+	RecordTimer added(2, &calls);
+	AddTimer adder(queue, &added);
+
+	queue.add(0, &adder, false);
+	queue.process();
+	HOST_CHECK(calls.empty());
+	HOST_CHECK(queue.size() == 1);
+
+	fake_time++;
+	queue.process();
+	HOST_CHECK(calls.size() == 1);
+}
+
+static void test_exception()
+{
+	fake_time = 5000;
+	TimerQueue queue(fake_clock);
+	std::vector<int> calls;
+	ThrowTimer thrower;
+	RecordTimer later(1, &calls);
+
+	queue.add(10, &thrower, true);
+	fake_time += 10;
+	bool thrown = false;
+	try
+	{
+		queue.process();
+	} catch(std::runtime_error &)
+	{
+		thrown = true;
+	}
+	HOST_CHECK(thrown);
+	HOST_CHECK(thrower.count == 1);
+
+	// Repeating timer that threw is still rescheduled
+	HOST_CHECK(queue.size() == 1);
+	HOST_CHECK(queue.next_due() == fake_time + 10);
+
+	// Queue is no longer processing so a timer due now runs
+	queue.add(0, &later, false);
+	queue.process();
+	HOST_CHECK(calls.size() == 1);
+}
+
+void run_test()
+{
+	test_order();
+	test_added_in_callback();
+	test_exception();
+}
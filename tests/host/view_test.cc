@@ -0,0 +1,416 @@
+/*
+ * Tests for the item views run on the Wimp/Toolbox simulator
+ */
+
+#include "hosttest.h"
+#include "tbx/application.h"
+#include "tbx/window.h"
+#include "tbx/postpolllistener.h"
+#include "tbx/view/listview.h"
+#include "tbx/view/selection.h"
+#include "tbx/view/iconitemrenderer.h"
+#include "tbx/sprite.h"
+#include "tbx/colour.h"
+#include "tbx/host/simulator.h"
+#include "tbx/host/swis.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace tbx;
+using namespace tbx::view;
+
+static host::Simulator sim;
+
+/**
+ * Stop the application when all the simulated events have been processed
+ */
+class QuitWhenIdle : public PostPollListener
+{
+	Application &_app;
+public:
+	QuitWhenIdle(Application &app) : _app(app) {}
+	virtual void post_poll(int, PollBlock &, IdBlock &, int)
+	{
+		if (sim.events_queued() == 0) _app.quit();
+	}
+};
+
+static void run_events(Application &app)
+{
+	QuitWhenIdle quit(app);
+	app.set_post_poll_listener(&quit);
+	app.run();
+	app.set_post_poll_listener(0);
+}
+
+/**
+ * Renderer for fixed size items that records what it draws
+ */
+class TestRenderer : public ItemRenderer
+{
+public:
+	std::vector<unsigned int> rendered;
+
+	virtual void render(const ItemRenderer::Info &info) {rendered.push_back(info.index);}
+	virtual unsigned int width(unsigned int) const {return 200;}
+	virtual unsigned int height(unsigned int) const {return 40;}
+	virtual Size size(unsigned int) const {return Size(200, 40);}
+};
+
+/**
+ * List view that records the selection changes it is sent
+ */
+class TestListView : public ListView
+{
+public:
+	std::vector<SelectionChangedEvent> changes;
+
+	TestListView(Window window, ItemRenderer *renderer) : ListView(window, renderer) {}
+
+	virtual void selection_changed(const SelectionChangedEvent &event)
+	{
+		changes.push_back(event);
+		ListView::selection_changed(event);
+	}
+};
+
+static void test_selection_changed(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,400), BBox(0,-400,400,0)));
+	TestRenderer renderer;
+	TestListView view(window, &renderer);
+	MultiSelection *selection = new MultiSelection();
+	view.selection(selection);
+	view.inserted(0, 20);
+	run_events(app);
+
+	// Overrides of selection_changed are called for each change
+	selection->select(2, 4);
+	HOST_CHECK(view.changes.size() == 1);
+	if (view.changes.size() == 1)
+	{
+		HOST_CHECK(view.changes[0].first() == 2);
+		HOST_CHECK(view.changes[0].last() == 4);
+		HOST_CHECK(view.changes[0].selected());
+	}
+
+	view.changes.clear();
+	selection->set(5);
+	HOST_CHECK(view.changes.size() == 2);
+
+	// All the changes are redrawn in one area before the next poll
+	sim.clear_redraws();
+	run_events(app);
+	HOST_CHECK(sim.forced_redraws().size() == 1);
+	if (sim.forced_redraws().size() == 1)
+	{
+		HOST_CHECK(sim.forced_redraws()[0].work_area.max.y == -80);
+		HOST_CHECK(sim.forced_redraws()[0].work_area.min.y == -240);
+	}
+}
+
+/**
+ * Value provider that counts how the values are retrieved
+ */
+class CountingValue : public ItemViewValue<std::string>
+{
+public:
+	mutable int value_calls;
+	mutable int values_calls;
+	CountingValue() : value_calls(0), values_calls(0) {}
+
+	virtual std::string value(unsigned int index) const
+	{
+		value_calls++;
+		return std::string(1, 'A' + index % 26);
+	}
+	virtual void values(unsigned int first, unsigned int last, std::vector<std::string> &result) const
+	{
+		values_calls++;
+		result.clear();
+		for (unsigned int index = first; index <= last; index++)
+			result.push_back(std::string(1, 'A' + index % 26));
+	}
+};
+
+/**
+ * Subclass of a renderer that has a render_range override
+ * which replaces the drawing of each item.
+ */
+class OverrideRenderer : public WimpFontItemRenderer
+{
+public:
+	std::vector<unsigned int> rendered;
+	std::string texts;
+
+	OverrideRenderer(ItemViewValue<std::string> *vv) : WimpFontItemRenderer(vv) {}
+
+	virtual void render(const ItemRenderer::Info &info)
+	{
+		rendered.push_back(info.index);
+		texts += value(info.index);
+	}
+};
+
+static void test_render_override(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,200), BBox(0,-400,400,0)));
+	CountingValue values;
+	OverrideRenderer renderer(&values);
+	ListView view(window, &renderer);
+	view.inserted(0, 10);
+	run_events(app);
+
+	// Visible area shows rows 0 to 4, its bottom edge is the top of row 5
+	values.value_calls = 0;
+	sim.post_redraw(window.handle());
+	run_events(app);
+	HOST_CHECK(renderer.rendered.size() == 6);
+	HOST_CHECK(renderer.texts == "ABCDEF");
+	HOST_CHECK(values.values_calls == 1);
+	HOST_CHECK(values.value_calls == 0);
+}
+
+/**
+ * Backend that records the graphics calls made by the renderers
+ * and passes all calls on to the simulator.
+ */
+class RecordingBackend : public host::SwiBackend
+{
+public:
+	std::vector<unsigned int> font_colours; // Foreground of each colour change
+	int pix_trans;
+	int sprite_plots;
+	std::vector<std::string> icons;
+
+	RecordingBackend() : pix_trans(0), sprite_plots(0) {}
+
+	virtual _kernel_oserror *swi(int number, _kernel_swi_regs &regs)
+	{
+		switch(number)
+		{
+		case Wimp_TextOp:
+			if ((regs.r[0] & 0xFF) == 0) font_colours.push_back((unsigned int)regs.r[1]);
+			break;
+		case Wimp_ReadPixTrans:
+			pix_trans++;
+			break;
+		case Wimp_SpriteOp:
+			if ((regs.r[0] & 0xFF) == 52) sprite_plots++;
+			break;
+		case Wimp_PlotIcon:
+			icons.push_back(describe_icon(reinterpret_cast<const int *>(regs.r[1])));
+			break;
+		}
+		return sim.swi(number, regs);
+	}
+
+	static std::string describe_icon(const int *icon)
+	{
+		char buffer[64];
+		std::sprintf(buffer, "%d,%d,%d,%d,%X:", icon[0], icon[1], icon[2], icon[3], icon[4]);
+		std::string desc(buffer);
+		if (icon[4] & 1)
+		{
+			desc += reinterpret_cast<const char *>(icon[5]);
+			desc += "/";
+			desc += reinterpret_cast<const char *>(icon[6]);
+		} else
+		{
+			desc += std::string(reinterpret_cast<const char *>(icon[5]), icon[7]);
+		}
+		return desc;
+	}
+};
+
+/**
+ * Redraw a window with the graphics calls recorded
+ */
+static void recorded_redraw(Application &app, Window &window, RecordingBackend &record)
+{
+	run_events(app);
+	host::set_swi_backend(&record);
+	sim.post_redraw(window.handle());
+	run_events(app);
+	sim.install();
+}
+
+static void test_font_colours(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,200), BBox(0,-400,400,0)));
+	CountingValue values;
+	WimpFontItemRenderer renderer(&values);
+	ListView view(window, &renderer);
+	MultiSelection *selection = new MultiSelection();
+	view.selection(selection);
+	view.inserted(0, 10);
+	selection->select(2, 3);
+
+	// Colours are only set when the selected state changes
+	RecordingBackend record;
+	recorded_redraw(app, window, record);
+	HOST_CHECK(record.font_colours.size() == 3);
+	if (record.font_colours.size() == 3)
+	{
+		HOST_CHECK(record.font_colours[0] == (unsigned int)Colour::black);
+		HOST_CHECK(record.font_colours[1] == (unsigned int)Colour::white);
+		HOST_CHECK(record.font_colours[2] == (unsigned int)Colour::black);
+	}
+}
+
+/**
+ * Value provider that returns the first sprite for the first
+ * three items and the second sprite for the rest.
+ */
+class TwoSprites : public ItemViewValue<Sprite *>
+{
+public:
+	WimpSprite first;
+	WimpSprite second;
+	TwoSprites() : first("file_fff"), second("file_ffd") {}
+	virtual Sprite *value(unsigned int index) const
+	{
+		return const_cast<WimpSprite *>(index < 3 ? &first : &second);
+	}
+};
+
+/**
+ * Sprite renderer with a fixed cell size and a render override
+ */
+class CountingSpriteRenderer : public SpriteItemRenderer
+{
+public:
+	int renders;
+	CountingSpriteRenderer(ItemViewValue<Sprite *> *vv) : SpriteItemRenderer(vv), renders(0) {}
+	virtual void render(const ItemRenderer::Info &info)
+	{
+		renders++;
+		SpriteItemRenderer::render(info);
+	}
+	virtual unsigned int width(unsigned int) const {return 68;}
+	virtual unsigned int height(unsigned int) const {return 40;}
+	virtual Size size(unsigned int) const {return Size(68, 40);}
+};
+
+static void test_sprite_setup(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,200), BBox(0,-400,400,0)));
+	TwoSprites sprites;
+	CountingSpriteRenderer renderer(&sprites);
+	ListView view(window, &renderer);
+	view.inserted(0, 10);
+
+	// Scale factors are read once for each change of sprite. There
+	// is no translation table to read for the simulated 32bpp screen.
+	RecordingBackend record;
+	recorded_redraw(app, window, record);
+	HOST_CHECK(renderer.renders == 6);
+	HOST_CHECK(record.sprite_plots == 6);
+	HOST_CHECK(record.pix_trans == 2);
+}
+
+/**
+ * Icon renderer with a fixed cell size
+ */
+class FixedIconRenderer : public IconItemRenderer
+{
+public:
+	FixedIconRenderer(ItemViewValue<std::string> *vv, bool use_client) : IconItemRenderer(vv, use_client) {}
+	virtual unsigned int width(unsigned int) const {return 176;}
+	virtual unsigned int height(unsigned int) const {return 124;}
+	virtual Size size(unsigned int) const {return Size(176, 124);}
+};
+
+/**
+ * Icon renderer that renders a range without setting up the
+ * painters once for the range.
+ */
+class PerItemIconRenderer : public FixedIconRenderer
+{
+public:
+	PerItemIconRenderer(ItemViewValue<std::string> *vv, bool use_client) : FixedIconRenderer(vv, use_client) {}
+	virtual void render_range(const ItemRenderer::RangeInfo &range)
+	{
+		ItemRenderer::render_range(range);
+	}
+};
+
+static std::vector<std::string> icons_drawn(Application &app, IconItemRenderer &renderer)
+{
+	Window window(sim.create_window(BBox(0,0,400,400), BBox(0,-800,400,0)));
+	ListView view(window, &renderer);
+	MultiSelection *selection = new MultiSelection();
+	view.selection(selection);
+	view.inserted(0, 10);
+	selection->select(1, 2);
+
+	RecordingBackend record;
+	recorded_redraw(app, window, record);
+	return record.icons;
+}
+
+static void test_icon_painters(Application &app)
+{
+	CountingValue values;
+	for (int use_client = 0; use_client < 2; use_client++)
+	{
+		FixedIconRenderer range_renderer(&values, use_client != 0);
+		PerItemIconRenderer item_renderer(&values, use_client != 0);
+		std::vector<std::string> range_icons = icons_drawn(app, range_renderer);
+		std::vector<std::string> item_icons = icons_drawn(app, item_renderer);
+
+		// Painters set up for the range draw the same icons as
+		// painters set up for each item
+		HOST_CHECK(range_icons.size() == (use_client ? 8u : 4u));
+		HOST_CHECK(range_icons == item_icons);
+	}
+}
+
+/**
+ * Renderer with rows after the first two taller than the first
+ */
+class TallRenderer : public TestRenderer
+{
+public:
+	virtual unsigned int height(unsigned int index) const {return (index < 2) ? 40 : 80;}
+};
+
+static void test_variable_row_height(Application &app)
+{
+	Window window(sim.create_window(BBox(0,0,400,400), BBox(0,-400,400,0)));
+	TallRenderer renderer;
+	ListView view(window, &renderer);
+	view.variable_row_height(true);
+	view.inserted(0, 20);
+	run_events(app);
+	HOST_CHECK(sim.extent(window.handle()).min.y == -800);
+
+	// Rows are measured as they are redrawn and the extent is
+	// changed before the next poll after the redraw.
+	sim.clear_redraws();
+	sim.post_redraw(window.handle());
+	run_events(app);
+	HOST_CHECK(sim.extent(window.handle()).min.y == -800);
+	run_events(app);
+	HOST_CHECK(sim.extent(window.handle()).min.y < -800);
+	HOST_CHECK(!sim.forced_redraws().empty());
+	HOST_CHECK(view.row_height() == 40);
+}
+
+void run_test()
+{
+	sim.install();
+	Application app("<Test$Dir>");
+
+	test_selection_changed(app);
+	test_render_override(app);
+	test_font_colours(app);
+	test_sprite_setup(app);
+	test_icon_painters(app);
+	test_variable_row_height(app);
+
+	HOST_CHECK(sim.unsupported_calls() == 0);
+	if (sim.unsupported_calls()) std::printf("Last unsupported SWI &%X\n", sim.last_unsupported());
+}
@@ -0,0 +1,178 @@
+/*
+ * Tests for WidthTracker against a vector of the item widths
+ */
+
+#include "hosttest.h"
+#include "tbx/view/widthtracker.h"
+#include "tbx/view/itemrenderer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace tbx;
+using namespace tbx::view;
+
+/**
+ * Renderer that returns widths from a vector and counts how
+ * many items it has measured
+ */
+class WidthRenderer : public ItemRenderer
+{
+public:
+	std::vector<unsigned int> widths;
+	mutable unsigned int measured;
+
+	WidthRenderer() : measured(0) {}
+
+	virtual void render(const ItemRenderer::Info &) {}
+	virtual unsigned int width(unsigned int index) const
+	{
+		measured++;
+		return widths[index];
+	}
+	virtual unsigned int height(unsigned int) const {return 44;}
+	virtual Size size(unsigned int index) const {return Size(width(index), 44);}
+
+	unsigned int max_width() const
+	{
+		return widths.empty() ? 0 : *std::max_element(widths.begin(), widths.end());
+	}
+
+	void insert(unsigned int where, const unsigned int *values, unsigned int how_many)
+	{
+		widths.insert(widths.begin() + where, values, values + how_many);
+	}
+};
+
+static void test_max_width()
+{
+	WidthRenderer renderer;
+	WidthTracker tracker;
+	HOST_CHECK(tracker.max_width() == 0);
+
+	const unsigned int start[] = {100, 300, 200, 300, 50};
+	renderer.insert(0, start, 5);
+	tracker.measure(&renderer, 5);
+	HOST_CHECK(tracker.max_width() == 300);
+	HOST_CHECK(tracker.count() == 5);
+	HOST_CHECK(renderer.measured == 5);
+
+	// Insert only measures the new items
+	renderer.measured = 0;
+	const unsigned int wider[] = {80, 400};
+	renderer.insert(2, wider, 2);
+	tracker.inserted(&renderer, 2, 2);
+	HOST_CHECK(renderer.measured == 2);
+	HOST_CHECK(tracker.max_width() == 400);
+
+	// Removing the widest goes back to the next widest
+	renderer.widths.erase(renderer.widths.begin() + 3);
+	tracker.removed(3, 1);
+	HOST_CHECK(tracker.max_width() == 300);
+
+	// Both items at 300 have to go before the maximum drops
+	renderer.widths.erase(renderer.widths.begin() + 1);
+	tracker.removed(1, 1);
+	HOST_CHECK(tracker.max_width() == 300);
+	renderer.widths.erase(renderer.widths.begin() + 3);
+	tracker.removed(3, 1);
+	HOST_CHECK(tracker.max_width() == 200);
+	HOST_CHECK(tracker.count() == 4);
+
+	// Changing an item to be narrower or wider
+	renderer.widths[2] = 10;
+	renderer.measured = 0;
+	tracker.changed(&renderer, 2, 1);
+	HOST_CHECK(renderer.measured == 1);
+	HOST_CHECK(tracker.max_width() == 100);
+	renderer.widths[3] = 500;
+	tracker.changed(&renderer, 3, 1);
+	HOST_CHECK(tracker.max_width() == 500);
+
+	// Copies are independent
+	WidthTracker copy(tracker);
+	tracker.removed(3, 1);
+	HOST_CHECK(tracker.max_width() == 100);
+	HOST_CHECK(copy.max_width() == 500);
+	HOST_CHECK(copy.count() == 4);
+	copy = tracker;
+	HOST_CHECK(copy.max_width() == 100);
+	HOST_CHECK(copy.count() == 3);
+
+	tracker.clear();
+	HOST_CHECK(tracker.max_width() == 0);
+	HOST_CHECK(tracker.count() == 0);
+	HOST_CHECK(copy.count() == 3);
+}
+
+/**
+ * Random inserts, removes and changes checked against the widths
+ * in the renderer. A small set of widths gives runs of the same width
+ * that are split and joined.
+ */
+static void test_random()
+{
+	std::srand(9);
+	WidthRenderer renderer;
+	WidthTracker tracker;
+	bool all_match = true, counts_match = true, measured_match = true;
+
+	for (int n = 0; n < 5000; n++)
+	{
+		unsigned int size = renderer.widths.size();
+		unsigned int where = size ? std::rand() % (size + 1) : 0;
+		unsigned int how_many = std::rand() % 20 + 1;
+		int op = std::rand() % 3;
+		if (size > 2000) op = 1;
+
+		renderer.measured = 0;
+		if (op == 0 || size == 0)
+		{
+			std::vector<unsigned int> values;
+			for (unsigned int j = 0; j < how_many; j++) values.push_back((std::rand() % 8) * 16);
+			renderer.insert(where, &values[0], how_many);
+			tracker.inserted(&renderer, where, how_many);
+			if (renderer.measured != how_many) measured_match = false;
+		} else
+		{
+			if (where == size) where--;
+			if (where + how_many > size) how_many = size - where;
+			if (op == 1)
+			{
+				renderer.widths.erase(renderer.widths.begin() + where, renderer.widths.begin() + where + how_many);
+				tracker.removed(where, how_many);
+				if (renderer.measured != 0) measured_match = false;
+			} else
+			{
+				for (unsigned int j = where; j < where + how_many; j++) renderer.widths[j] = (std::rand() % 8) * 16;
+				tracker.changed(&renderer, where, how_many);
+				if (renderer.measured != how_many) measured_match = false;
+			}
+		}
+
+		if (tracker.max_width() != renderer.max_width()) all_match = false;
+		if (tracker.count() != renderer.widths.size()) counts_match = false;
+	}
+	HOST_CHECK(all_match);
+	HOST_CHECK(counts_match);
+	HOST_CHECK(measured_match);
+
+	// Remove everything a piece at a time from the middle
+	while (!renderer.widths.empty())
+	{
+		unsigned int where = renderer.widths.size() / 2;
+		renderer.widths.erase(renderer.widths.begin() + where);
+		tracker.removed(where, 1);
+		if (tracker.max_width() != renderer.max_width()) all_match = false;
+	}
+	HOST_CHECK(all_match);
+	HOST_CHECK(tracker.count() == 0);
+	HOST_CHECK(tracker.max_width() == 0);
+}
+
+void run_test()
+{
+	test_max_width();
+	test_random();
+}